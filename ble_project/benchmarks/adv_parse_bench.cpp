@@ -0,0 +1,188 @@
+// Advertising data benchmark - parse every advert vs skip unchanged ones
+// Usage: ./adv_parse_bench [adverts] [devices]
+//
+// Generates a stream of legacy adverts from a mix of iBeacons, Eddystone
+// beacons and sensors whose manufacturer data carries a counter that
+// changes now and then. Every advert is parsed with ble::AdData and its
+// name, manufacturer data, service UUIDs and service data are extracted,
+// once for every advert and once only when ble::AdvertCache reports a
+// changed payload. Exits non-zero if the two paths end with a different
+// view of any device or the parser misreads the reference payloads.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "ble_adv_data.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static const ble_uuid_t kEddystone = ble_uuid_from16(0xFEAA);
+
+struct Stream {
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> offset;
+    std::vector<uint8_t> len;
+    std::vector<uint32_t> device;
+};
+
+static size_t put_ibeacon(uint8_t* p, uint32_t id) {
+    static const uint8_t head[] = {0x02, 0x01, 0x06, 0x1A, 0xFF, 0x4C, 0x00, 0x02, 0x15};
+    memcpy(p, head, sizeof(head));
+    for (int i = 0; i < 16; i++) p[9 + i] = (uint8_t)(0xE2 + i);
+    p[25] = 0; p[26] = (uint8_t)(id >> 8);              // major
+    p[27] = (uint8_t)id; p[28] = 0;                     // minor
+    p[29] = 0xC5;                                       // measured power
+    return 30;
+}
+
+static size_t put_eddystone(uint8_t* p, uint32_t id) {
+    static const uint8_t head[] = {0x02, 0x01, 0x06, 0x03, 0x03, 0xAA, 0xFE,
+                                   0x15, 0x16, 0xAA, 0xFE, 0x00, 0xEE};
+    memcpy(p, head, sizeof(head));
+    for (int i = 0; i < 16; i++) p[13 + i] = (uint8_t)(id >> (i % 4 * 8));
+    return 29;
+}
+
+static size_t put_sensor(uint8_t* p, uint32_t id, uint16_t counter) {
+    size_t n = 0;
+    p[n++] = 0x02; p[n++] = 0x01; p[n++] = 0x06;
+    p[n++] = 0x05; p[n++] = 0x03; p[n++] = 0x0D; p[n++] = 0x18; p[n++] = 0x0F; p[n++] = 0x18;
+    p[n++] = 0x07; p[n++] = 0x09;
+    n += (size_t)snprintf((char*)p + n, 7, "S%05u", id % 100000);
+    p[n++] = 0x07; p[n++] = 0xFF; p[n++] = 0x59; p[n++] = 0x00;
+    p[n++] = (uint8_t)counter; p[n++] = (uint8_t)(counter >> 8);
+    p[n++] = (uint8_t)id; p[n++] = (uint8_t)(id >> 8);
+    return n;
+}
+
+static Stream make_stream(size_t adverts, uint32_t devices) {
+    Stream s;
+    std::mt19937 rng(1);
+    std::vector<uint16_t> counter(devices, 0);
+    s.bytes.resize(adverts * 31);
+    for (size_t i = 0; i < adverts; i++) {
+        uint32_t d = rng() % devices;
+        uint8_t* p = &s.bytes[i * 31];
+        size_t n;
+        switch (d % 3) {
+        case 0: n = put_ibeacon(p, d); break;
+        case 1: n = put_eddystone(p, d); break;
+        default:
+            if (rng() % 50 == 0) counter[d]++;
+            n = put_sensor(p, d, counter[d]);
+            break;
+        }
+        s.offset.push_back((uint32_t)(i * 31));
+        s.len.push_back((uint8_t)n);
+        s.device.push_back(d);
+    }
+    return s;
+}
+
+// Folds everything a scanner would extract into one value per device
+static uint64_t extract(const ble::AdData& ad) {
+    uint64_t h = 0;
+    auto mix = [&h](const uint8_t* p, size_t n) { h = ble::ad_hash(p, n) ^ (h * 31); };
+
+    ble::ByteView name = ad.local_name();
+    if (name.data) mix(name.data, name.len);
+    uint16_t company;
+    ble::ByteView data;
+    if (ad.manufacturer_data(&company, &data)) {
+        h += company;
+        mix(data.data, data.len);
+    }
+    ble_uuid_t uuids[8];
+    size_t n = ad.service_uuids(uuids, 8);
+    for (size_t i = 0; i < n && i < 8; i++) h += uuids[i].hi ^ uuids[i].lo;
+    ad.for_each_service_data([&](const ble_uuid_t& uuid, ble::ByteView d) {
+        h += uuid.hi;
+        mix(d.data, d.len);
+    });
+    return h;
+}
+
+static size_t check_reference() {
+    size_t errors = 0;
+    uint8_t p[31];
+    uint16_t company;
+    ble::ByteView data;
+    uint8_t flags;
+
+    ble::AdData ibeacon(p, put_ibeacon(p, 0x1234));
+    errors += !ibeacon.valid() || ibeacon.size() != 2;
+    errors += !ibeacon.flags(&flags) || flags != 0x06;
+    errors += !ibeacon.manufacturer_data(&company, &data) || company != 0x004C || data.len != 23 ||
+              data.data[0] != 0x02 || data.data[20] != 0x34;
+    errors += ibeacon.local_name().data != nullptr;
+    // 0xFF shares its presence bit with 0x00 and every type from 64 up
+    errors += !ibeacon.has(0xFF) || ibeacon.has(0x00) || ibeacon.has(0x40) || ibeacon.find(0x40);
+
+    ble::AdData eddystone(p, put_eddystone(p, 7));
+    errors += !eddystone.has_service(kEddystone) || eddystone.has_service(ble_uuid_from16(0x180D));
+    errors += !eddystone.service_data(kEddystone, &data) || data.len != 18 || data.data[0] != 0x00;
+
+    ble::AdData sensor(p, put_sensor(p, 42, 0x0102));
+    bool complete;
+    ble::ByteView name = sensor.local_name(&complete);
+    errors += !complete || name.len != 6 || memcmp(name.data, "S00042", 6) != 0;
+    ble_uuid_t uuids[4];
+    errors += sensor.service_uuids(uuids, 4) != 2 || ble_uuid_sig_value(&uuids[1]) != 0x180F;
+    errors += !sensor.manufacturer_data(&company, &data) || company != 0x0059 || data.data[0] != 0x02;
+
+    // A length running past the end keeps the structures before it
+    const uint8_t truncated[] = {0x02, 0x01, 0x06, 0x09, 0x09, 'a', 'b'};
+    ble::AdData bad(truncated, sizeof(truncated));
+    errors += bad.valid() || bad.size() != 1 || !bad.flags(&flags);
+
+    uint8_t uuid128[] = {0x11, 0x07, 0x9E, 0xCA, 0xDC, 0x24, 0x0E, 0xE5, 0xA9, 0xE0,
+                         0x93, 0xF3, 0xA3, 0xB5, 0x01, 0x00, 0x40, 0x6E};
+    ble::AdData nus(uuid128, sizeof(uuid128));
+    errors += nus.service_uuids(uuids, 4) != 1 ||
+              uuids[0].hi != 0x6e400001b5a3f393ULL || uuids[0].lo != 0xe0a9e50e24dcca9eULL;
+    return errors;
+}
+
+int main(int argc, char* argv[]) {
+    size_t adverts = argc > 1 ? (size_t)atol(argv[1]) : 2000000;
+    uint32_t devices = argc > 2 ? (uint32_t)atol(argv[2]) : 5000;
+    if (devices == 0) devices = 1;
+    Stream s = make_stream(adverts, devices);
+
+    // Parse every advert
+    std::vector<uint64_t> full(devices, 0);
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < adverts; i++) {
+        ble::AdData ad(&s.bytes[s.offset[i]], s.len[i]);
+        full[s.device[i]] = extract(ad);
+    }
+    double full_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Parse only changed payloads
+    std::vector<uint64_t> cached(devices, 0);
+    ble::AdvertCache cache(devices);
+    start = Clock::now();
+    for (size_t i = 0; i < adverts; i++) {
+        const uint8_t* payload = &s.bytes[s.offset[i]];
+        ble_addr_t addr = {0xC00000000000ULL | s.device[i]};
+        if (!cache.update(addr, false, payload, s.len[i])) continue;
+        ble::AdData ad(payload, s.len[i]);
+        cached[s.device[i]] = extract(ad);
+    }
+    double cached_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    size_t mismatches = check_reference();
+    for (uint32_t d = 0; d < devices; d++) mismatches += full[d] != cached[d];
+
+    ble::AdvertCacheStats stats = cache.stats();
+    printf("Advertising data (%zu adverts from %u devices, %.1f%% changed)\n\n", adverts, devices,
+           100.0 * stats.changed / stats.seen);
+    printf("%-14s %14s %10s\n", "", "adverts/s", "ns/advert");
+    printf("%-14s %14.0f %10.1f\n", "parse all", adverts / full_s, full_s * 1e9 / adverts);
+    printf("%-14s %14.0f %10.1f\n", "skip unchanged", adverts / cached_s, cached_s * 1e9 / adverts);
+    printf("\nspeedup %.1fx, %zu mismatches\n", full_s / cached_s, mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,419 @@
+// GATT server load benchmark - concurrent ReadValue/WriteValue/GetManagedObjects
+// Usage: ./ble_bench [--bus ADDRESS] [--calls N] [--concurrency N] [--connections N]
+//                    [--mix READ:WRITE:OBJECTS] [--max-p99 MS] [--min-rate CALLS_PER_S]
+//
+// Plays bluetoothd against a peripheral registered with mock_bluez: asks
+// mock_bluez (org.bluez.Mock1) for the first registered application, reads
+// its object tree, then keeps --concurrency calls in flight, spread over
+// --connections bus connections, until --calls have completed. Reports
+// throughput and p50/p99/p999 latency per method. Exits non-zero on any
+// failed call or when a --max-p99 / --min-rate threshold is missed, so it
+// can gate builds. Afterwards, an Execute Write whose second fragment has
+// a bad offset must leave a read/write characteristic unchanged.
+
+#include <gio/gio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "ble_dbus.h"
+
+#define CALL_TIMEOUT_MS 10000
+#define WRITE_LEN       20
+
+using Clock = std::chrono::steady_clock;
+
+enum Op { OP_READ, OP_WRITE, OP_OBJECTS, OP_COUNT };
+
+static const char *op_names[OP_COUNT] = {"ReadValue", "WriteValue", "GetManagedObjects"};
+
+struct Options {
+    const char *bus_address = NULL;
+    long calls = 100000;
+    int concurrency = 1000;
+    int connections = 4;
+    unsigned mix[OP_COUNT] = {8, 1, 1};
+    double max_p99_ms = 0;
+    double min_rate = 0;
+};
+
+struct Target {
+    std::string owner;
+    std::string app_path;
+    std::vector<std::string> readable;
+    std::vector<std::string> writable;
+};
+
+struct OpStats {
+    std::vector<uint32_t> latency_ns;
+    long errors = 0;
+    std::string first_error;
+};
+
+struct Bench {
+    Options options;
+    Target target;
+    std::vector<GDBusConnection *> connections;
+    std::vector<Op> schedule;          ///< One round of the mix, interleaved
+    OpStats stats[OP_COUNT];
+    long issued = 0;
+    long completed = 0;
+    GVariant *read_options = NULL;
+    GVariant *write_options = NULL;
+    GMainLoop *loop = NULL;
+};
+
+struct Call {
+    Bench *bench;
+    Op op;
+    GDBusConnection *conn;
+    Clock::time_point start;
+};
+
+// =============================================================================
+// Target Discovery
+// =============================================================================
+
+static bool has_flag(GVariant *props, const char *flag) {
+    const gchar **flags = NULL;
+    if (!g_variant_lookup(props, "Flags", "^a&s", &flags)) return false;
+    bool found = g_strv_contains(flags, flag);
+    g_free(flags);
+    return found;
+}
+
+static bool find_target(GDBusConnection *conn, Target *target, GError **error) {
+    GVariant *apps = g_dbus_connection_call_sync(conn, "org.bluez", ble_dbus_adapter_path(),
+        "org.bluez.Mock1", "GetApplications", NULL, G_VARIANT_TYPE("(a(so))"),
+        G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, error);
+    if (!apps) return false;
+
+    GVariantIter *iter;
+    const gchar *owner, *path;
+    g_variant_get(apps, "(a(so))", &iter);
+    if (g_variant_iter_next(iter, "(&s&o)", &owner, &path)) {
+        target->owner = owner;
+        target->app_path = path;
+    }
+    g_variant_iter_free(iter);
+    g_variant_unref(apps);
+    if (target->owner.empty()) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "No GATT application registered");
+        return false;
+    }
+
+    GVariant *objects = g_dbus_connection_call_sync(conn, target->owner.c_str(),
+        target->app_path.c_str(), "org.freedesktop.DBus.ObjectManager", "GetManagedObjects",
+        NULL, G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS,
+        NULL, error);
+    if (!objects) return false;
+
+    GVariant *interfaces;
+    g_variant_get(objects, "(a{oa{sa{sv}}})", &iter);
+    while (g_variant_iter_next(iter, "{&o@a{sa{sv}}}", &path, &interfaces)) {
+        GVariant *props = g_variant_lookup_value(interfaces, "org.bluez.GattCharacteristic1",
+                                                 G_VARIANT_TYPE("a{sv}"));
+        if (props) {
+            if (has_flag(props, "read")) target->readable.push_back(path);
+            if (has_flag(props, "write")) target->writable.push_back(path);
+            g_variant_unref(props);
+        }
+        g_variant_unref(interfaces);
+    }
+    g_variant_iter_free(iter);
+    g_variant_unref(objects);
+    return true;
+}
+
+// =============================================================================
+// Load Generation
+// =============================================================================
+
+static void issue(Bench *bench, GDBusConnection *conn);
+
+static void on_reply(GObject *source, GAsyncResult *res, gpointer user_data) {
+    Call *call = (Call *)user_data;
+    Bench *bench = call->bench;
+    GError *error = NULL;
+    GVariant *result = g_dbus_connection_call_finish(call->conn, res, &error);
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - call->start).count();
+
+    OpStats &stats = bench->stats[call->op];
+    if (result) {
+        stats.latency_ns.push_back((uint32_t)std::min<uint64_t>(ns, UINT32_MAX));
+        g_variant_unref(result);
+    } else {
+        if (stats.errors++ == 0) stats.first_error = error->message;
+        g_error_free(error);
+    }
+
+    GDBusConnection *conn = call->conn;
+    delete call;
+    if (++bench->completed == bench->options.calls) {
+        g_main_loop_quit(bench->loop);
+    } else {
+        issue(bench, conn);
+    }
+}
+
+static void issue(Bench *bench, GDBusConnection *conn) {
+    if (bench->issued == bench->options.calls) return;
+    long n = bench->issued++;
+    Op op = bench->schedule[n % bench->schedule.size()];
+    const Target &target = bench->target;
+
+    const char *path, *iface, *method;
+    GVariant *params;
+    const GVariantType *reply_type;
+    if (op == OP_READ) {
+        path = target.readable[n % target.readable.size()].c_str();
+        iface = "org.bluez.GattCharacteristic1";
+        method = "ReadValue";
+        params = g_variant_new("(@a{sv})", bench->read_options);
+        reply_type = G_VARIANT_TYPE("(ay)");
+    } else if (op == OP_WRITE) {
+        char value[WRITE_LEN + 1];
+        snprintf(value, sizeof(value), "bench %013ld", n);
+        path = target.writable[n % target.writable.size()].c_str();
+        iface = "org.bluez.GattCharacteristic1";
+        method = "WriteValue";
+        params = g_variant_new("(@ay@a{sv})",
+            g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, value, WRITE_LEN, 1),
+            bench->write_options);
+        reply_type = NULL;
+    } else {
+        path = target.app_path.c_str();
+        iface = "org.freedesktop.DBus.ObjectManager";
+        method = "GetManagedObjects";
+        params = NULL;
+        reply_type = G_VARIANT_TYPE("(a{oa{sa{sv}}})");
+    }
+
+    Call *call = new Call{bench, op, conn, Clock::now()};
+    g_dbus_connection_call(conn, target.owner.c_str(), path, iface, method, params,
+        reply_type, G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, on_reply, call);
+}
+
+// =============================================================================
+// Reliable Write
+// =============================================================================
+
+static GVariant *call_options(const char *type, guint16 offset) {
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&builder, "{sv}", "offset", g_variant_new_uint16(offset));
+    g_variant_builder_add(&builder, "{sv}", "device",
+                          g_variant_new_object_path("/org/bluez/hci0/dev_00_00_00_00_00_01"));
+    if (type) g_variant_builder_add(&builder, "{sv}", "type", g_variant_new_string(type));
+    return g_variant_builder_end(&builder);
+}
+
+// Returns the D-Bus error name, or "" on success
+static std::string write_value(GDBusConnection *conn, const Target &target, const char *path,
+                               const char *type, guint16 offset, const char *value) {
+    GError *error = NULL;
+    GVariant *reply = g_dbus_connection_call_sync(conn, target.owner.c_str(), path,
+        "org.bluez.GattCharacteristic1", "WriteValue",
+        g_variant_new("(@ay@a{sv})",
+            g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, value, strlen(value), 1),
+            call_options(type, offset)),
+        NULL, G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, &error);
+    if (reply) {
+        g_variant_unref(reply);
+        return "";
+    }
+    gchar *name = g_dbus_error_get_remote_error(error);
+    std::string result = name ? name : error->message;
+    g_free(name);
+    g_error_free(error);
+    return result;
+}
+
+static std::string read_value(GDBusConnection *conn, const Target &target, const char *path) {
+    GVariant *reply = g_dbus_connection_call_sync(conn, target.owner.c_str(), path,
+        "org.bluez.GattCharacteristic1", "ReadValue", g_variant_new("(@a{sv})", call_options(NULL, 0)),
+        G_VARIANT_TYPE("(ay)"), G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, NULL);
+    if (!reply) return "<read failed>";
+    gsize len;
+    GVariant *bytes = g_variant_get_child_value(reply, 0);
+    const char *data = (const char *)g_variant_get_fixed_array(bytes, &len, 1);
+    std::string value(data, len);
+    g_variant_unref(bytes);
+    g_variant_unref(reply);
+    return value;
+}
+
+static bool check_reliable(GDBusConnection *conn, const Target &target) {
+    const char *path = NULL;
+    for (const std::string &w : target.writable) {
+        if (std::find(target.readable.begin(), target.readable.end(), w) != target.readable.end()) {
+            path = w.c_str();
+            break;
+        }
+    }
+    if (!path) return true;
+
+    bool ok = write_value(conn, target, path, "request", 0, "before") == "";
+    ok = ok && write_value(conn, target, path, "reliable", 0, "AAAA") == "";
+    ok = ok && write_value(conn, target, path, "reliable", 9, "BB") == "org.bluez.Error.InvalidOffset";
+    ok = ok && write_value(conn, target, path, "reliable", 4, "CC") == "org.bluez.Error.InvalidOffset";
+    // The read ends the Execute Write; nothing of it may have landed
+    ok = ok && read_value(conn, target, path) == "before";
+    if (!ok) printf("\nA failed reliable write changed %s", path);
+    return ok;
+}
+
+// =============================================================================
+// Report
+// =============================================================================
+
+static double percentile_ms(const std::vector<uint32_t> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+    return sorted[i] / 1e6;
+}
+
+static void print_row(const char *name, std::vector<uint32_t> &latency, long errors,
+                      double seconds, double *p99) {
+    std::sort(latency.begin(), latency.end());
+    *p99 = percentile_ms(latency, 0.99);
+    printf("%-18s %9zu %7ld %11.0f %9.3f %9.3f %9.3f %9.3f\n", name, latency.size(), errors,
+           (latency.size() + errors) / seconds, percentile_ms(latency, 0.50), *p99,
+           percentile_ms(latency, 0.999), latency.empty() ? 0 : latency.back() / 1e6);
+}
+
+static bool parse_args(int argc, char *argv[], Options *options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char *flag = argv[i], *value = argv[i + 1];
+        if (strcmp(flag, "--bus") == 0) options->bus_address = value;
+        else if (strcmp(flag, "--calls") == 0) options->calls = atol(value);
+        else if (strcmp(flag, "--concurrency") == 0) options->concurrency = atoi(value);
+        else if (strcmp(flag, "--connections") == 0) options->connections = atoi(value);
+        else if (strcmp(flag, "--max-p99") == 0) options->max_p99_ms = atof(value);
+        else if (strcmp(flag, "--min-rate") == 0) options->min_rate = atof(value);
+        else if (strcmp(flag, "--mix") == 0) {
+            if (sscanf(value, "%u:%u:%u", &options->mix[0], &options->mix[1], &options->mix[2]) != 3) {
+                return false;
+            }
+        }
+        else return false;
+    }
+    return (argc % 2) == 1 && options->calls > 0 && options->concurrency > 0 &&
+           options->connections > 0 && options->mix[0] + options->mix[1] + options->mix[2] > 0;
+}
+
+int main(int argc, char *argv[]) {
+    Bench bench;
+    GError *error = NULL;
+
+    if (!parse_args(argc, argv, &bench.options)) {
+        fprintf(stderr, "Usage: %s [--bus ADDRESS] [--calls N] [--concurrency N] "
+                "[--connections N] [--mix READ:WRITE:OBJECTS] [--max-p99 MS] "
+                "[--min-rate CALLS_PER_S]\n", argv[0]);
+        return 2;
+    }
+    const Options &options = bench.options;
+
+    for (int i = 0; i < options.connections; i++) {
+        GDBusConnection *conn = ble_dbus_connect(options.bus_address, &error);
+        if (!conn) {
+            fprintf(stderr, "Failed to connect to D-Bus: %s\n", error->message);
+            return 1;
+        }
+        bench.connections.push_back(conn);
+    }
+    if (!find_target(bench.connections[0], &bench.target, &error)) {
+        fprintf(stderr, "No target: %s\n", error->message);
+        return 1;
+    }
+
+    // Interleave the mix so each window of calls has the same proportions
+    unsigned rounds = *std::max_element(options.mix, options.mix + OP_COUNT);
+    for (unsigned round = 0; round < rounds; round++) {
+        for (int op = 0; op < OP_COUNT; op++) {
+            if (round < options.mix[op]) bench.schedule.push_back((Op)op);
+        }
+    }
+    if ((options.mix[OP_READ] && bench.target.readable.empty()) ||
+        (options.mix[OP_WRITE] && bench.target.writable.empty())) {
+        fprintf(stderr, "%s %s has no readable or writable characteristic for this mix\n",
+                bench.target.owner.c_str(), bench.target.app_path.c_str());
+        return 1;
+    }
+
+    // Options as bluetoothd sends them for a remote read/write request
+    for (GVariant **opts : {&bench.read_options, &bench.write_options}) {
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+        g_variant_builder_add(&builder, "{sv}", "offset", g_variant_new_uint16(0));
+        g_variant_builder_add(&builder, "{sv}", "mtu", g_variant_new_uint16(247));
+        g_variant_builder_add(&builder, "{sv}", "device",
+                              g_variant_new_object_path("/org/bluez/hci0/dev_00_00_00_00_00_00"));
+        if (opts == &bench.write_options) {
+            g_variant_builder_add(&builder, "{sv}", "type", g_variant_new_string("request"));
+        }
+        *opts = g_variant_ref_sink(g_variant_builder_end(&builder));
+    }
+
+    for (int op = 0; op < OP_COUNT; op++) {
+        bench.stats[op].latency_ns.reserve(options.calls * options.mix[op] / bench.schedule.size() + 1);
+    }
+
+    printf("GATT server load: %ld calls, %d in flight over %d connections\n", options.calls,
+           options.concurrency, options.connections);
+    printf("Target %s %s (%zu readable, %zu writable characteristics)\n\n",
+           bench.target.owner.c_str(), bench.target.app_path.c_str(),
+           bench.target.readable.size(), bench.target.writable.size());
+
+    bench.loop = g_main_loop_new(NULL, FALSE);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < options.concurrency; i++) {
+        issue(&bench, bench.connections[i % bench.connections.size()]);
+    }
+    g_main_loop_run(bench.loop);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    printf("%-18s %9s %7s %11s %9s %9s %9s %9s\n", "method", "ok", "errors", "calls/s",
+           "p50 ms", "p99 ms", "p999 ms", "max ms");
+    std::vector<uint32_t> all;
+    long errors = 0;
+    double p99 = 0;     // of the last row printed, the total
+    for (int op = 0; op < OP_COUNT; op++) {
+        OpStats &stats = bench.stats[op];
+        if (stats.latency_ns.empty() && !stats.errors) continue;
+        all.insert(all.end(), stats.latency_ns.begin(), stats.latency_ns.end());
+        errors += stats.errors;
+        print_row(op_names[op], stats.latency_ns, stats.errors, seconds, &p99);
+    }
+    print_row("total", all, errors, seconds, &p99);
+
+    bool ok = true;
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (bench.stats[op].errors) {
+            printf("\n%s: %ld failed, first error: %s", op_names[op], bench.stats[op].errors,
+                   bench.stats[op].first_error.c_str());
+            ok = false;
+        }
+    }
+    double rate = options.calls / seconds;
+    if (options.max_p99_ms > 0 && p99 > options.max_p99_ms) {
+        printf("\np99 %.3f ms exceeds --max-p99 %.3f ms", p99, options.max_p99_ms);
+        ok = false;
+    }
+    if (options.min_rate > 0 && rate < options.min_rate) {
+        printf("\n%.0f calls/s is below --min-rate %.0f", rate, options.min_rate);
+        ok = false;
+    }
+    ok = check_reliable(bench.connections[0], bench.target) && ok;
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+
+    g_variant_unref(bench.read_options);
+    g_variant_unref(bench.write_options);
+    g_main_loop_unref(bench.loop);
+    for (GDBusConnection *conn : bench.connections) g_object_unref(conn);
+    return ok ? 0 : 1;
+}
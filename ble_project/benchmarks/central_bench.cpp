@@ -0,0 +1,282 @@
+// Central pipeline benchmark against the simulated gattlib backend
+// Usage: ./central_bench [--devices N] [--seconds S] [--adv-interval MS] [--parallel N]
+//                        [--connect-failures RATE] [--notify-devices N] [--notify-interval MS]
+//
+// Needs -DGATTLIB_BACKEND=sim. Runs three phases against --devices virtual
+// peripherals (default 10000):
+//   scan     ScanIngest fed by gattlib scan callbacks; adverts per second,
+//            ring drops and distinct devices seen
+//   connect  ConnectionManager bringing every device to Ready with discovery
+//            and injected connect failures; links per second and
+//            Connecting -> Ready latency
+//   notify   NotificationIngest on Battery Level from --notify-devices
+//            links; notifications per second, latency, drops and gaps
+// Exits non-zero if a device never reaches Ready or a notification is lost.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+#include <gattlib.h>
+#include "gattlib_sim.h"
+#include "ble_common.h"
+#include "ble_connection_manager.hpp"
+#include "ble_gattlib.hpp"
+#include "ble_notification_ingest.hpp"
+#include "ble_scan_ingest.hpp"
+#include "ble_time.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    unsigned devices = 10000;
+    unsigned seconds = 3;
+    unsigned adv_interval_ms = 0;
+    size_t parallel = 256;
+    double connect_failures = 0.01;
+    unsigned notify_devices = 256;
+    unsigned notify_interval_ms = 10;
+};
+
+struct BenchArgs {
+    Options options;
+    bool ok = true;
+};
+
+static double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static double percentile_ms(const std::vector<uint64_t> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+    return sorted[i] / 1e6;
+}
+
+static gattlib_adapter_t *open_sim(const gattlib_sim_config_t &config) {
+    gattlib_adapter_t *adapter = NULL;
+    if (gattlib_sim_configure(&config) != GATTLIB_SUCCESS ||
+        gattlib_adapter_open(NULL, &adapter) != GATTLIB_SUCCESS) {
+        fprintf(stderr, "Failed to open the simulated adapter\n");
+        return NULL;
+    }
+    return adapter;
+}
+
+static unsigned device_index(ble_addr_t address) {
+    return (unsigned)(ble_addr_bits(address) & 0xFFFFFF);
+}
+
+// =============================================================================
+// Scan
+// =============================================================================
+
+static void on_advert(gattlib_adapter_t *, const char *addr, const char *name, void *user_data) {
+    ble::ScanIngest *ingest = (ble::ScanIngest *)user_data;
+    ble::ScanRecord record;
+    if (ble::scan_record_make(addr, name, BLE_RSSI_UNKNOWN, &record)) ingest->submit(record);
+}
+
+static bool run_scan(const Options &options) {
+    gattlib_sim_config_t config;
+    gattlib_sim_config_default(&config);
+    config.devices = options.devices;
+    config.adv_interval_ms = options.adv_interval_ms;
+    gattlib_adapter_t *adapter = open_sim(config);
+    if (!adapter) return false;
+
+    ble::ScanIngest ingest;
+    ingest.start(std::chrono::milliseconds(1000), [](const ble::ScanIngest &, uint32_t) {});
+    Clock::time_point start = Clock::now();
+    gattlib_adapter_scan_enable(adapter, on_advert, options.seconds, &ingest);
+    double elapsed = seconds_since(start);
+    ingest.stop();
+    gattlib_adapter_close(adapter);
+
+    ble::ScanStats stats = ingest.stats();
+    size_t seen = ingest.devices().size();
+    printf("scan     %10.0f adverts/s  %llu received, %llu dropped, %zu/%u devices seen\n",
+           (stats.received + stats.dropped) / elapsed, (unsigned long long)stats.received,
+           (unsigned long long)stats.dropped, seen, options.devices);
+    return seen == options.devices;
+}
+
+// =============================================================================
+// Connect
+// =============================================================================
+
+static bool run_connect(const Options &options) {
+    gattlib_sim_config_t config;
+    gattlib_sim_config_default(&config);
+    config.devices = options.devices;
+    config.connect_failure_rate = options.connect_failures;
+    gattlib_adapter_t *adapter = open_sim(config);
+    if (!adapter) return false;
+
+    // on_state runs on the manager's scheduler thread only
+    std::vector<uint64_t> connecting_ns(options.devices), latency_ns;
+    latency_ns.reserve(options.devices);
+    unsigned attempts = 0;
+
+    ble::ConnectionOptions connect_options;
+    connect_options.max_parallel = options.parallel;
+    connect_options.backoff_initial = std::chrono::milliseconds(50);
+    ble::ConnectionManager manager(adapter, connect_options);
+    manager.on_state([&](const ble::LinkStatus &status) {
+        unsigned index = device_index(status.address);
+        if (status.state == ble::LinkState::Connecting) {
+            connecting_ns[index] = ble::monotonic_ns();
+            attempts++;
+        } else if (status.state == ble::LinkState::Ready) {
+            latency_ns.push_back(ble::monotonic_ns() - connecting_ns[index]);
+        }
+    });
+
+    Clock::time_point start = Clock::now();
+    manager.start();
+    std::vector<std::shared_future<ble::LinkStatus>> ready;
+    ready.reserve(options.devices);
+    for (unsigned i = 0; i < options.devices; i++) {
+        char mac[BLE_ADDR_SIZE];
+        gattlib_sim_device_address(i, mac);
+        ready.push_back(manager.add(mac));
+    }
+    unsigned failed = 0;
+    for (auto &future : ready) {
+        if (future.get().state != ble::LinkState::Ready) failed++;
+    }
+    double elapsed = seconds_since(start);
+    manager.stop();
+    gattlib_adapter_close(adapter);
+
+    gattlib_sim_stats_t stats;
+    gattlib_sim_get_stats(&stats);
+    std::sort(latency_ns.begin(), latency_ns.end());
+    printf("connect  %10.0f links/s    %u ready in %.2f s, %u attempts, %llu injected failures, "
+           "%u failed\n", (options.devices - failed) / elapsed, options.devices - failed, elapsed,
+           attempts, (unsigned long long)stats.connect_failures, failed);
+    printf("         Connecting -> Ready p50 %.1f ms  p99 %.1f ms  max %.1f ms\n",
+           percentile_ms(latency_ns, 0.50), percentile_ms(latency_ns, 0.99),
+           latency_ns.empty() ? 0 : latency_ns.back() / 1e6);
+    return failed == 0;
+}
+
+// =============================================================================
+// Notify
+// =============================================================================
+
+static bool run_notify(const Options &options) {
+    unsigned devices = std::min<unsigned>(options.notify_devices,
+                                          ble::NotificationIngest::kMaxSources);
+    gattlib_sim_config_t config;
+    gattlib_sim_config_default(&config);
+    config.devices = devices;
+    config.notify_interval_ms = options.notify_interval_ms;
+    gattlib_adapter_t *adapter = open_sim(config);
+    if (!adapter) return false;
+
+    // Battery Level notifications start with a 16-bit sequence number
+    ble::NotificationIngestOptions ingest_options;
+    ingest_options.sequence.offset = 0;
+    ingest_options.sequence.width = 2;
+    ble::NotificationIngest ingest(ingest_options,
+                                   [](const ble::NotificationRecord *, size_t) {});
+    ingest.start();
+
+    uuid_t battery = ble::to_gattlib(ble::uuid16(0x2A19));
+    std::atomic<unsigned> subscribed{0};
+    ble::ConnectionOptions connect_options;
+    connect_options.max_parallel = devices;
+    connect_options.discover = false;
+    connect_options.reconnect = false;
+    ble::ConnectionManager manager(adapter, connect_options);
+    manager.on_setup([&](ble_addr_t address, gattlib_connection_t *connection) {
+        if (ingest.attach(connection, address) >= 0 &&
+            gattlib_notification_start(connection, &battery) == GATTLIB_SUCCESS) {
+            subscribed++;
+        }
+        return GATTLIB_SUCCESS;
+    });
+    manager.on_state([&](const ble::LinkStatus &status) {
+        if (status.state == ble::LinkState::Backoff || status.state == ble::LinkState::Failed) {
+            ingest.detach(status.address, false);
+        }
+    });
+    manager.start();
+    std::vector<std::shared_future<ble::LinkStatus>> ready;
+    for (unsigned i = 0; i < devices; i++) {
+        char mac[BLE_ADDR_SIZE];
+        gattlib_sim_device_address(i, mac);
+        ready.push_back(manager.add(mac));
+    }
+    for (auto &future : ready) future.wait();
+
+    ble::NotificationIngestStats before = ingest.stats();
+    Clock::time_point start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+    ble::NotificationIngestStats after = ingest.stats();
+    double elapsed = seconds_since(start);
+    // While the links are still open; stop() disconnects them
+    for (const ble::LinkStatus &status : manager.snapshot()) {
+        ingest.detach(status.address, status.state == ble::LinkState::Ready);
+    }
+    manager.stop();
+    ingest.stop();
+    gattlib_adapter_close(adapter);
+
+    ble::NotificationIngestStats total = ingest.stats();
+    printf("notify   %10.0f notif/s    %u/%u links, latency avg %.3f ms max %.3f ms, "
+           "%llu dropped, %llu gaps\n", (after.delivered - before.delivered) / elapsed,
+           subscribed.load(), devices, total.latency_avg_ns / 1e6, total.latency_max_ns / 1e6, (unsigned long long)total.dropped,
+           (unsigned long long)total.gaps);
+    return subscribed == devices && total.dropped == 0 && total.gaps == 0;
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+static void *bench_task(void *arg) {
+    BenchArgs *args = (BenchArgs *)arg;
+    const Options &options = args->options;
+    printf("Simulated central: %u devices, adverts every %u ms, %zu parallel connects, "
+           "%.1f%% connect failures\n\n", options.devices, options.adv_interval_ms,
+           options.parallel, options.connect_failures * 100);
+    args->ok = run_scan(options);
+    args->ok = run_connect(options) && args->ok;
+    args->ok = run_notify(options) && args->ok;
+    return NULL;
+}
+
+static bool parse_args(int argc, char *argv[], Options *options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char *flag = argv[i], *value = argv[i + 1];
+        if (strcmp(flag, "--devices") == 0) options->devices = (unsigned)atol(value);
+        else if (strcmp(flag, "--seconds") == 0) options->seconds = (unsigned)atol(value);
+        else if (strcmp(flag, "--adv-interval") == 0) options->adv_interval_ms = (unsigned)atol(value);
+        else if (strcmp(flag, "--parallel") == 0) options->parallel = (size_t)atol(value);
+        else if (strcmp(flag, "--connect-failures") == 0) options->connect_failures = atof(value);
+        else if (strcmp(flag, "--notify-devices") == 0) options->notify_devices = (unsigned)atol(value);
+        else if (strcmp(flag, "--notify-interval") == 0) options->notify_interval_ms = (unsigned)atol(value);
+        else return false;
+    }
+    return (argc % 2) == 1 && options->devices > 0 && options->seconds > 0 &&
+           options->parallel > 0 && options->notify_devices > 0;
+}
+
+int main(int argc, char *argv[]) {
+    BenchArgs args;
+    if (!parse_args(argc, argv, &args.options)) {
+        fprintf(stderr, "Usage: %s [--devices N] [--seconds S] [--adv-interval MS] [--parallel N] "
+                "[--connect-failures RATE] [--notify-devices N] [--notify-interval MS]\n", argv[0]);
+        return 2;
+    }
+    gattlib_mainloop(bench_task, &args);
+    printf("\n%s\n", args.ok ? "PASS" : "FAIL");
+    return args.ok ? 0 : 1;
+}
@@ -0,0 +1,396 @@
+// Coroutine central benchmark - CoroRuntime sessions vs thread per device
+// Usage: ./coro_bench [--devices N] [--notifications N] [--att-latency US]
+//                     [--blocking-threads N]
+//
+// Needs -DGATTLIB_BACKEND=sim. Every device gets one session: connect,
+// discover, read Device Name and Battery Level, subscribe to Battery Level,
+// wait for --notifications notifications, disconnect. Runs the sessions as
+// coroutines on the main thread's GLib context, then as one blocking
+// thread per device (a condition variable per callback, as the examples
+// did before), and reports wall time, session latency and the process's
+// peak thread count. Then checks timeouts, cancellation, a connect that
+// completes after its timeout, and calls on a closed link. Exits non-zero
+// if a session fails or a check is off.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gattlib.h>
+#include "gattlib_sim.h"
+#include "ble_common.h"
+#include "ble_coro.hpp"
+#include "ble_gattlib.hpp"
+#include "ble_time.hpp"
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+struct Options {
+    unsigned devices = 500;
+    unsigned notifications = 5;
+    unsigned att_latency_us = 1000;
+    unsigned blocking_threads = 16;
+};
+
+struct RunStats {
+    unsigned ok = 0;
+    unsigned failed = 0;
+    unsigned peak_threads = 0;
+    double seconds = 0;
+    std::vector<uint64_t> latency_ns;
+};
+
+static const uuid_t kDeviceName = ble::to_gattlib(ble::uuid16(0x2A00));
+static const uuid_t kBatteryLevel = ble::to_gattlib(ble::uuid16(0x2A19));
+
+static unsigned process_threads() {
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return 0;
+    char line[128];
+    unsigned threads = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "Threads: %u", &threads) == 1) break;
+    }
+    fclose(f);
+    return threads;
+}
+
+static bool expect_name(const std::vector<uint8_t> &value, unsigned index) {
+    char name[16];
+    snprintf(name, sizeof(name), "Sim-%05u", index);
+    return value.size() == strlen(name) && memcmp(value.data(), name, value.size()) == 0;
+}
+
+static double percentile_ms(const std::vector<uint64_t> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+    return sorted[i] / 1e6;
+}
+
+// =============================================================================
+// Coroutine sessions
+// =============================================================================
+
+static ble::Task<bool> coro_session_steps(ble::CoroRuntime &rt, gattlib_connection_t *connection,
+                                          unsigned index, unsigned notifications) {
+    ble::Result<ble::GattTable> table = co_await rt.discover(connection);
+    if (!table.ok() || table.value.characteristics.empty()) co_return false;
+    ble::Result<std::vector<uint8_t>> name = co_await rt.read(connection, kDeviceName);
+    if (!name.ok() || !expect_name(name.value, index)) co_return false;
+    ble::Result<std::vector<uint8_t>> level = co_await rt.read(connection, kBatteryLevel);
+    if (!level.ok() || level.value.empty()) co_return false;
+    if (!(co_await rt.subscribe(connection, kBatteryLevel)).ok()) co_return false;
+
+    for (unsigned i = 0; i < notifications; i++) {
+        ble::Result<ble::Notification> n = co_await rt.notification(connection, {milliseconds(2000)});
+        if (!n.ok() || gattlib_uuid_cmp(&n.value.uuid, &kBatteryLevel) != 0) co_return false;
+    }
+    co_return true;
+}
+
+static ble::Task<> coro_session(ble::CoroRuntime &rt, unsigned index, const Options &options,
+                                RunStats &stats) {
+    char address[BLE_ADDR_SIZE];
+    gattlib_sim_device_address(index, address);
+    uint64_t start = ble::monotonic_ns();
+
+    ble::Result<gattlib_connection_t *> link = co_await rt.connect(address);
+    bool ok = link.ok();
+    if (ok) {
+        ok = co_await coro_session_steps(rt, link.value, index, options.notifications);
+        ok = (co_await rt.disconnect(link.value)).ok() && ok;
+    }
+    if (ok) {
+        stats.ok++;
+        stats.latency_ns.push_back(ble::monotonic_ns() - start);
+    } else {
+        stats.failed++;
+    }
+}
+
+static ble::Task<> sample_threads(ble::CoroRuntime &rt, const Options &options, RunStats &stats) {
+    while (stats.ok + stats.failed < options.devices) {
+        stats.peak_threads = std::max(stats.peak_threads, process_threads());
+        co_await rt.sleep(milliseconds(10));
+    }
+}
+
+static RunStats run_coro(gattlib_adapter_t *adapter, const Options &options) {
+    RunStats stats;
+    ble::CoroOptions coro_options;
+    coro_options.blocking_threads = options.blocking_threads;
+    ble::CoroRuntime rt(adapter, coro_options);
+
+    Clock::time_point start = Clock::now();
+    for (unsigned i = 0; i < options.devices; i++) rt.spawn(coro_session(rt, i, options, stats));
+    rt.spawn(sample_threads(rt, options, stats));
+    rt.run();
+    stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
+
+// =============================================================================
+// Thread per device
+// =============================================================================
+
+struct BlockingSession {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> notifications;
+};
+
+static void on_blocking_connect(gattlib_adapter_t *, const char *, gattlib_connection_t *connection,
+                                int error, void *user_data) {
+    std::promise<gattlib_connection_t *> *done = (std::promise<gattlib_connection_t *> *)user_data;
+    done->set_value(error == GATTLIB_SUCCESS ? connection : NULL);
+}
+
+static void on_blocking_notification(const uuid_t *, const uint8_t *data, size_t len,
+                                     void *user_data) {
+    BlockingSession *session = (BlockingSession *)user_data;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    session->notifications.emplace_back(data, data + len);
+    session->changed.notify_one();
+}
+
+static bool blocking_read(gattlib_connection_t *connection, uuid_t uuid, std::vector<uint8_t> *out) {
+    void *buffer = NULL;
+    size_t len = 0;
+    if (gattlib_read_char_by_uuid(connection, &uuid, &buffer, &len) != GATTLIB_SUCCESS) return false;
+    out->assign((uint8_t *)buffer, (uint8_t *)buffer + len);
+    gattlib_characteristic_free_value(buffer);
+    return true;
+}
+
+static bool blocking_session(gattlib_adapter_t *adapter, unsigned index, const Options &options,
+                             BlockingSession &session) {
+    char address[BLE_ADDR_SIZE];
+    gattlib_sim_device_address(index, address);
+    std::promise<gattlib_connection_t *> connected;
+    std::future<gattlib_connection_t *> pending = connected.get_future();
+    if (gattlib_connect(adapter, address, GATTLIB_CONNECTION_OPTIONS_NONE, on_blocking_connect,
+                        &connected) != GATTLIB_SUCCESS) {
+        return false;
+    }
+    gattlib_connection_t *connection = pending.get();
+    if (!connection) return false;
+
+    gattlib_register_notification(connection, on_blocking_notification, &session);
+    gattlib_primary_service_t *services = NULL;
+    gattlib_characteristic_t *chars = NULL;
+    int count = 0;
+    bool ok = gattlib_discover_primary(connection, &services, &count) == GATTLIB_SUCCESS;
+    free(services);
+    ok = ok && gattlib_discover_char(connection, &chars, &count) == GATTLIB_SUCCESS && count > 0;
+    free(chars);
+
+    std::vector<uint8_t> value;
+    ok = ok && blocking_read(connection, kDeviceName, &value) && expect_name(value, index);
+    ok = ok && blocking_read(connection, kBatteryLevel, &value) && !value.empty();
+    ok = ok && gattlib_notification_start(connection, &kBatteryLevel) == GATTLIB_SUCCESS;
+    {
+        std::unique_lock<std::mutex> lock(session.mutex);
+        ok = ok && session.changed.wait_for(lock, milliseconds(2000), [&] {
+            return session.notifications.size() >= options.notifications;
+        });
+    }
+    ok = gattlib_disconnect(connection, true) == GATTLIB_SUCCESS && ok;
+    return ok;
+}
+
+static RunStats run_threads(gattlib_adapter_t *adapter, const Options &options) {
+    RunStats stats;
+    std::mutex mutex;
+    std::atomic<unsigned> finished{0};
+    std::vector<std::thread> threads;
+    threads.reserve(options.devices);
+    // Outlive the threads: a notification may still be in its handler at disconnect
+    std::vector<BlockingSession> sessions(options.devices);
+
+    Clock::time_point start = Clock::now();
+    for (unsigned i = 0; i < options.devices; i++) {
+        threads.emplace_back([&, i] {
+            uint64_t begin = ble::monotonic_ns();
+            bool ok = blocking_session(adapter, i, options, sessions[i]);
+            uint64_t latency = ble::monotonic_ns() - begin;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ok) {
+                stats.ok++;
+                stats.latency_ns.push_back(latency);
+            } else {
+                stats.failed++;
+            }
+            finished++;
+        });
+    }
+    while (finished < options.devices) {
+        stats.peak_threads = std::max(stats.peak_threads, process_threads());
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    for (std::thread &t : threads) t.join();
+    stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
+
+// =============================================================================
+// Timeouts and cancellation
+// =============================================================================
+
+struct Checks {
+    bool timeout = false;
+    bool cancel = false;
+    bool late_connect = false;
+    bool closed_link = false;
+    bool unknown_device = false;
+    double cancel_ms = 0;       ///< cancel() -> last waiter resumed
+};
+
+struct Parked {
+    unsigned connected = 0;
+    unsigned settled = 0;       ///< Connected or failed to
+    unsigned cancelled = 0;
+    unsigned finished = 0;
+};
+
+static ble::Task<> park(ble::CoroRuntime &rt, unsigned index, const ble::CancelToken &cancel,
+                        Parked &parked) {
+    char address[BLE_ADDR_SIZE];
+    gattlib_sim_device_address(index, address);
+    ble::Result<gattlib_connection_t *> link = co_await rt.connect(address);
+    parked.settled++;
+    if (link.ok()) {
+        parked.connected++;
+        // Nothing is subscribed, so only the token ends this wait
+        ble::Result<ble::Notification> n = co_await rt.notification(link.value, {milliseconds(0), &cancel});
+        if (n.error == ble::kGattCancelled) parked.cancelled++;
+        co_await rt.disconnect(link.value);
+    }
+    parked.finished++;
+}
+
+static ble::Task<> run_checks(ble::CoroRuntime &rt, const Options &options, Checks &checks) {
+    char address[BLE_ADDR_SIZE];
+    gattlib_sim_device_address(0, address);
+
+    // A connect that gives up before the link comes up; the late link is closed
+    ble::Result<gattlib_connection_t *> early = co_await rt.connect(address, {milliseconds(1)});
+    co_await rt.sleep(milliseconds(200));
+    ble::Result<gattlib_connection_t *> link = co_await rt.connect(address);
+    checks.late_connect = early.error == GATTLIB_TIMEOUT && link.ok();
+    if (!link.ok()) co_return;
+
+    uint64_t start = ble::monotonic_ns();
+    ble::Result<ble::Notification> quiet = co_await rt.notification(link.value, {milliseconds(20)});
+    double waited_ms = (ble::monotonic_ns() - start) / 1e6;
+    checks.timeout = quiet.error == GATTLIB_TIMEOUT && waited_ms >= 19 && waited_ms < 200;
+
+    // Many sessions parked on other links, one token for all of them
+    unsigned sessions = std::min(options.devices - 1, 200u);
+    ble::CancelToken cancel = ble::CancelToken::make();
+    Parked parked;
+    for (unsigned i = 1; i <= sessions; i++) rt.spawn(park(rt, i, cancel, parked));
+    while (parked.settled < sessions) co_await rt.sleep(milliseconds(5));
+    co_await rt.sleep(milliseconds(50));
+    start = ble::monotonic_ns();
+    cancel.cancel();
+    while (parked.cancelled < parked.connected && ble::monotonic_ns() - start < 1000000000ULL) {
+        co_await rt.sleep(milliseconds(1));
+    }
+    checks.cancel_ms = (ble::monotonic_ns() - start) / 1e6;
+    ble::Result<ble::Notification> after = co_await rt.notification(link.value, {milliseconds(0), &cancel});
+    checks.cancel = parked.connected == sessions && parked.cancelled == sessions &&
+                    after.error == ble::kGattCancelled;
+    while (parked.finished < sessions) co_await rt.sleep(milliseconds(5));
+
+    co_await rt.disconnect(link.value);
+    ble::Result<std::vector<uint8_t>> read = co_await rt.read(link.value, kBatteryLevel);
+    ble::Result<ble::Notification> closed = co_await rt.notification(link.value);
+    checks.closed_link = read.error == GATTLIB_DEVICE_NOT_CONNECTED &&
+                         closed.error == GATTLIB_DEVICE_DISCONNECTED;
+
+    ble::Result<gattlib_connection_t *> unknown = co_await rt.connect("C0:00:FF:00:00:00");
+    checks.unknown_device = unknown.error == GATTLIB_NOT_FOUND;
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+static void print_run(const char *name, RunStats &stats) {
+    std::sort(stats.latency_ns.begin(), stats.latency_ns.end());
+    printf("%-18s %6u %6u %9.2f %10.1f %10.1f %8u\n", name, stats.ok, stats.failed, stats.seconds,
+           percentile_ms(stats.latency_ns, 0.50), percentile_ms(stats.latency_ns, 0.99),
+           stats.peak_threads);
+}
+
+static bool parse_args(int argc, char *argv[], Options *options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char *flag = argv[i], *value = argv[i + 1];
+        if (strcmp(flag, "--devices") == 0) options->devices = (unsigned)atol(value);
+        else if (strcmp(flag, "--notifications") == 0) options->notifications = (unsigned)atol(value);
+        else if (strcmp(flag, "--att-latency") == 0) options->att_latency_us = (unsigned)atol(value);
+        else if (strcmp(flag, "--blocking-threads") == 0) options->blocking_threads = (unsigned)atol(value);
+        else return false;
+    }
+    return (argc % 2) == 1 && options->devices > 1 && options->blocking_threads > 0;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parse_args(argc, argv, &options)) {
+        fprintf(stderr, "Usage: %s [--devices N] [--notifications N] [--att-latency US] "
+                "[--blocking-threads N]\n", argv[0]);
+        return 2;
+    }
+
+    gattlib_sim_config_t config;
+    gattlib_sim_config_default(&config);
+    config.devices = options.devices;
+    config.att_latency_us = options.att_latency_us;
+    config.notify_interval_ms = 50;
+    gattlib_adapter_t *adapter = NULL;
+    if (gattlib_sim_configure(&config) != GATTLIB_SUCCESS ||
+        gattlib_adapter_open(NULL, &adapter) != GATTLIB_SUCCESS) {
+        fprintf(stderr, "Failed to open the simulated adapter\n");
+        return 1;
+    }
+
+    printf("%u sessions: connect, discover, 2 reads, subscribe, %u notifications (every %u ms), "
+           "disconnect; ATT round trip %u us\n\n", options.devices, options.notifications,
+           config.notify_interval_ms, options.att_latency_us);
+    printf("%-18s %6s %6s %9s %10s %10s %8s\n", "model", "ok", "failed", "wall s", "p50 ms",
+           "p99 ms", "threads");
+    RunStats coro = run_coro(adapter, options);
+    char name[32];
+    snprintf(name, sizeof(name), "coroutines (%u)", options.blocking_threads);
+    print_run(name, coro);
+    RunStats threads = run_threads(adapter, options);
+    print_run("thread per device", threads);
+
+    Checks checks;
+    {
+        ble::CoroRuntime rt(adapter);
+        rt.spawn(run_checks(rt, options, checks));
+        rt.run();
+    }
+    printf("\ntimeout %s, cancel %s (%.2f ms for all waiters), late connect %s, closed link %s, "
+           "unknown device %s\n", checks.timeout ? "ok" : "FAILED", checks.cancel ? "ok" : "FAILED",
+           checks.cancel_ms, checks.late_connect ? "ok" : "FAILED",
+           checks.closed_link ? "ok" : "FAILED", checks.unknown_device ? "ok" : "FAILED");
+    gattlib_adapter_close(adapter);
+
+    bool ok = coro.failed == 0 && threads.failed == 0 && checks.timeout && checks.cancel &&
+              checks.late_connect && checks.closed_link && checks.unknown_device;
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
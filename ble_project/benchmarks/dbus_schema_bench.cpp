@@ -0,0 +1,267 @@
+// D-Bus schema benchmark - introspection XML vs constexpr schema
+// Usage: ./dbus_schema_bench [startups] [lookups]
+//
+// Startup: parses the GATT and advertisement introspection XML the
+// peripherals used to parse at every start, against taking the static
+// GDBusInterfaceInfo that DBusInterface generates at compile time. Both
+// must describe the same members, arguments and properties.
+//
+// Dispatch: maps property and method names, as BlueZ sends them, to the
+// handler's case with the strcmp() chain the handlers used, and with the
+// schema's NameIndex. Exits non-zero if the two disagree anywhere.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "ble_dbus_schema.hpp"
+#include "ble_gatt_database.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static const char gatt_xml[] =
+    "<node>"
+    "  <interface name='org.freedesktop.DBus.ObjectManager'>"
+    "    <method name='GetManagedObjects'>"
+    "      <arg type='a{oa{sa{sv}}}' direction='out'/>"
+    "    </method>"
+    "    <signal name='InterfacesAdded'>"
+    "      <arg type='o'/>"
+    "      <arg type='a{sa{sv}}'/>"
+    "    </signal>"
+    "    <signal name='InterfacesRemoved'>"
+    "      <arg type='o'/>"
+    "      <arg type='as'/>"
+    "    </signal>"
+    "  </interface>"
+    "  <interface name='org.bluez.GattService1'>"
+    "    <property name='UUID' type='s' access='read'/>"
+    "    <property name='Primary' type='b' access='read'/>"
+    "    <property name='Characteristics' type='ao' access='read'/>"
+    "  </interface>"
+    "  <interface name='org.bluez.GattCharacteristic1'>"
+    "    <method name='ReadValue'>"
+    "      <arg type='a{sv}' direction='in'/>"
+    "      <arg type='ay' direction='out'/>"
+    "    </method>"
+    "    <method name='WriteValue'>"
+    "      <arg type='ay' direction='in'/>"
+    "      <arg type='a{sv}' direction='in'/>"
+    "    </method>"
+    "    <method name='AcquireWrite'>"
+    "      <arg type='a{sv}' direction='in'/>"
+    "      <arg type='h' direction='out'/>"
+    "      <arg type='q' direction='out'/>"
+    "    </method>"
+    "    <method name='AcquireNotify'>"
+    "      <arg type='a{sv}' direction='in'/>"
+    "      <arg type='h' direction='out'/>"
+    "      <arg type='q' direction='out'/>"
+    "    </method>"
+    "    <method name='StartNotify'/>"
+    "    <method name='StopNotify'/>"
+    "    <property name='UUID' type='s' access='read'/>"
+    "    <property name='Service' type='o' access='read'/>"
+    "    <property name='Flags' type='as' access='read'/>"
+    "    <property name='Descriptors' type='ao' access='read'/>"
+    "    <property name='Value' type='ay' access='read'/>"
+    "    <property name='Notifying' type='b' access='read'/>"
+    "    <property name='WriteAcquired' type='b' access='read'/>"
+    "    <property name='NotifyAcquired' type='b' access='read'/>"
+    "  </interface>"
+    "  <interface name='org.bluez.GattDescriptor1'>"
+    "    <method name='ReadValue'>"
+    "      <arg type='a{sv}' direction='in'/>"
+    "      <arg type='ay' direction='out'/>"
+    "    </method>"
+    "    <method name='WriteValue'>"
+    "      <arg type='ay' direction='in'/>"
+    "      <arg type='a{sv}' direction='in'/>"
+    "    </method>"
+    "    <property name='UUID' type='s' access='read'/>"
+    "    <property name='Characteristic' type='o' access='read'/>"
+    "    <property name='Flags' type='as' access='read'/>"
+    "  </interface>"
+    "</node>";
+
+static const char advert_xml[] =
+    "<node>"
+    "  <interface name='org.bluez.LEAdvertisement1'>"
+    "    <method name='Release'/>"
+    "    <property name='Type' type='s' access='read'/>"
+    "    <property name='ServiceUUIDs' type='as' access='read'/>"
+    "    <property name='LocalName' type='s' access='read'/>"
+    "    <property name='Includes' type='as' access='read'/>"
+    "  </interface>"
+    "</node>";
+
+static constexpr ble::InterfaceSchema<1, 4> kAdvertSchema = {
+    "org.bluez.LEAdvertisement1",
+    {{{"Release"}}},
+    {{{"Type", "s"}, {"ServiceUUIDs", "as"}, {"LocalName", "s"}, {"Includes", "as"}}},
+};
+using Advert = ble::DBusInterface<kAdvertSchema>;
+using Char = ble::GattCharacteristicInterface;
+
+static GDBusInterfaceInfo *schema_infos[] = {
+    ble::ObjectManagerInterface::info(), ble::GattServiceInterface::info(),
+    Char::info(), ble::GattDescriptorInterface::info(), Advert::info(),
+};
+
+// ---------------------------------------------------------------------------
+// Equivalence
+// ---------------------------------------------------------------------------
+
+static bool same_args(GDBusArgInfo **a, GDBusArgInfo **b) {
+    for (; *a && *b; a++, b++) {
+        if (strcmp((*a)->signature, (*b)->signature) != 0) return false;
+    }
+    return !*a && !*b;
+}
+
+static bool same_interface(const GDBusInterfaceInfo *a, const GDBusInterfaceInfo *b) {
+    if (strcmp(a->name, b->name) != 0) return false;
+
+    GDBusMethodInfo **ma = a->methods, **mb = b->methods;
+    for (; *ma && *mb; ma++, mb++) {
+        if (strcmp((*ma)->name, (*mb)->name) != 0 || !same_args((*ma)->in_args, (*mb)->in_args) ||
+            !same_args((*ma)->out_args, (*mb)->out_args)) return false;
+    }
+    if (*ma || *mb) return false;
+
+    GDBusSignalInfo **sa = a->signals, **sb = b->signals;
+    for (; *sa && *sb; sa++, sb++) {
+        if (strcmp((*sa)->name, (*sb)->name) != 0 || !same_args((*sa)->args, (*sb)->args)) return false;
+    }
+    if (*sa || *sb) return false;
+
+    GDBusPropertyInfo **pa = a->properties, **pb = b->properties;
+    for (; *pa && *pb; pa++, pb++) {
+        if (strcmp((*pa)->name, (*pb)->name) != 0 ||
+            strcmp((*pa)->signature, (*pb)->signature) != 0 || (*pa)->flags != (*pb)->flags) {
+            return false;
+        }
+    }
+    return !*pa && !*pb;
+}
+
+// ---------------------------------------------------------------------------
+// Dispatch: the handlers' if/else chains
+// ---------------------------------------------------------------------------
+
+static int advert_chain(const char *name) {
+    if (g_strcmp0(name, "Type") == 0) return 0;
+    else if (g_strcmp0(name, "ServiceUUIDs") == 0) return 1;
+    else if (g_strcmp0(name, "LocalName") == 0) return 2;
+    else if (g_strcmp0(name, "Includes") == 0) return 3;
+    return -1;
+}
+
+static int char_property_chain(const char *name) {
+    static const char *names[] = {"UUID", "Service", "Flags", "Descriptors", "Value",
+                                  "Notifying", "WriteAcquired", "NotifyAcquired"};
+    for (int i = 0; i < 8; i++) {
+        if (strcmp(names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+static int char_method_chain(const char *name) {
+    if (g_strcmp0(name, "ReadValue") == 0) return 0;
+    else if (g_strcmp0(name, "WriteValue") == 0) return 1;
+    else if (g_strcmp0(name, "AcquireWrite") == 0) return 2;
+    else if (g_strcmp0(name, "AcquireNotify") == 0) return 3;
+    else if (g_strcmp0(name, "StartNotify") == 0) return 4;
+    else if (g_strcmp0(name, "StopNotify") == 0) return 5;
+    return -1;
+}
+
+struct Case {
+    const char *label;
+    int (*chain)(const char *);
+    int (*index)(const char *);
+    std::vector<std::string> names;
+};
+
+template <typename Fn>
+static double ns_per_lookup(const std::vector<const char *> &names, size_t lookups, Fn fn,
+                            long *checksum) {
+    long sum = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < lookups; i++) sum += fn(names[i % names.size()]);
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    *checksum = sum;
+    return ns / lookups;
+}
+
+int main(int argc, char *argv[]) {
+    size_t startups = argc > 1 ? (size_t)atol(argv[1]) : 2000;
+    size_t lookups = argc > 2 ? (size_t)atol(argv[2]) : 20000000;
+    if (startups == 0 || lookups == 0) {
+        fprintf(stderr, "Usage: %s [startups] [lookups]\n", argv[0]);
+        return 2;
+    }
+    bool ok = true;
+
+    // Startup
+    GDBusNodeInfo *gatt = g_dbus_node_info_new_for_xml(gatt_xml, NULL);
+    GDBusNodeInfo *advert = g_dbus_node_info_new_for_xml(advert_xml, NULL);
+    GDBusInterfaceInfo *parsed[] = {gatt->interfaces[0], gatt->interfaces[1], gatt->interfaces[2],
+                                    gatt->interfaces[3], advert->interfaces[0]};
+    for (size_t i = 0; i < 5; i++) {
+        if (!same_interface(parsed[i], schema_infos[i])) {
+            printf("%s: schema differs from the XML\n", parsed[i]->name);
+            ok = false;
+        }
+    }
+    g_dbus_node_info_unref(gatt);
+    g_dbus_node_info_unref(advert);
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < startups; i++) {
+        g_dbus_node_info_unref(g_dbus_node_info_new_for_xml(gatt_xml, NULL));
+        g_dbus_node_info_unref(g_dbus_node_info_new_for_xml(advert_xml, NULL));
+    }
+    double xml_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / startups;
+
+    // The schema side is static data; nothing runs at startup
+    printf("Introspection for 5 interfaces, per start (%zu starts)\n\n", startups);
+    printf("%-30s %10.2f us\n", "g_dbus_node_info_new_for_xml", xml_us);
+    printf("%-30s %10s\n\n", "DBusInterface::info()", "static");
+
+    // Dispatch
+    Case cases[] = {
+        {"advert property", advert_chain, Advert::find_property,
+         {"Type", "ServiceUUIDs", "LocalName", "Includes"}},
+        {"characteristic property", char_property_chain, Char::find_property,
+         {"UUID", "Service", "Flags", "Descriptors", "Value", "Notifying", "WriteAcquired",
+          "NotifyAcquired"}},
+        {"characteristic method", char_method_chain, Char::find_method,
+         {"ReadValue", "WriteValue", "AcquireWrite", "AcquireNotify", "StartNotify", "StopNotify"}},
+    };
+
+    printf("%-26s %14s %14s %10s\n", "Lookup", "strcmp ns", "NameIndex ns", "Speedup");
+    for (Case &c : cases) {
+        // Names arrive in message buffers, not as our literals
+        std::vector<const char *> names;
+        for (const std::string &n : c.names) names.push_back(n.c_str());
+        for (const char *n : names) {
+            if (c.chain(n) != c.index(n)) {
+                printf("%s: %s maps to %d, expected %d\n", c.label, n, c.index(n), c.chain(n));
+                ok = false;
+            }
+        }
+        if (c.index("Unknown") != -1) ok = false;
+
+        long chain_sum, index_sum;
+        double chain_ns = ns_per_lookup(names, lookups, c.chain, &chain_sum);
+        double index_ns = ns_per_lookup(names, lookups, c.index, &index_sum);
+        if (chain_sum != index_sum) ok = false;
+        printf("%-26s %14.2f %14.2f %9.1fx\n", c.label, chain_ns, index_ns, chain_ns / index_ns);
+    }
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
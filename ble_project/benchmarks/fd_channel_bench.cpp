@@ -0,0 +1,197 @@
+// AcquireWrite/AcquireNotify data path benchmark over a local socketpair
+// Usage: ./fd_channel_bench [packets]
+//
+// A thread on the far end of a SOCK_SEQPACKET socketpair stands in for
+// BlueZ. "write" streams packets into FdChannel::receive() (AcquireWrite);
+// "notify" pushes them out through queue()/flush() (AcquireNotify). Each
+// direction runs against a one-syscall-per-packet baseline, and every
+// packet carries a sequence number that the receiver checks. Finally, a
+// send to a closed peer must drop the queue and close the channel.
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <thread>
+#include "ble_fd_channel.hpp"
+#include "ble_time.hpp"
+
+static void wait_fd(int fd, short events) {
+    struct pollfd pfd = {fd, events, 0};
+    poll(&pfd, 1, 1000);
+}
+
+static void fill_packet(uint8_t *buf, size_t len, uint32_t seq) {
+    memset(buf, (int)(seq & 0xFF), len);
+    memcpy(buf, &seq, sizeof(seq));
+}
+
+static uint32_t packet_seq(const uint8_t *buf) {
+    uint32_t seq;
+    memcpy(&seq, buf, sizeof(seq));
+    return seq;
+}
+
+// Peer side: sendmmsg() in batches, like BlueZ forwarding write commands
+static void peer_send(int fd, size_t payload, long packets) {
+    std::vector<uint8_t> buf(ble::FdChannel::kBatch * payload);
+    struct iovec iov[ble::FdChannel::kBatch];
+    struct mmsghdr msgs[ble::FdChannel::kBatch];
+    memset(msgs, 0, sizeof(msgs));
+
+    long seq = 0;
+    while (seq < packets) {
+        size_t n = 0;
+        for (; n < ble::FdChannel::kBatch && seq + (long)n < packets; n++) {
+            fill_packet(&buf[n * payload], payload, (uint32_t)(seq + n));
+            iov[n].iov_base = &buf[n * payload];
+            iov[n].iov_len = payload;
+            msgs[n].msg_hdr.msg_iov = &iov[n];
+            msgs[n].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = sendmmsg(fd, msgs, n, 0);
+        if (sent < 0) return;
+        seq += sent;
+    }
+}
+
+// Peer side: recvmmsg() in batches, like BlueZ draining notifications
+static long peer_receive(int fd, size_t mtu, long packets) {
+    std::vector<uint8_t> buf(ble::FdChannel::kBatch * mtu);
+    struct iovec iov[ble::FdChannel::kBatch];
+    struct mmsghdr msgs[ble::FdChannel::kBatch];
+    memset(msgs, 0, sizeof(msgs));
+    for (size_t i = 0; i < ble::FdChannel::kBatch; i++) {
+        iov[i].iov_base = &buf[i * mtu];
+        iov[i].iov_len = mtu;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    long received = 0, errors = 0;
+    while (received < packets) {
+        int n = recvmmsg(fd, msgs, ble::FdChannel::kBatch, 0, NULL);
+        if (n <= 0) break;
+        for (int i = 0; i < n; i++) {
+            if (packet_seq((const uint8_t *)iov[i].iov_base) != (uint32_t)received) errors++;
+            received++;
+        }
+    }
+    return errors;
+}
+
+static double bench_write(size_t payload, long packets, bool batched, long *errors) {
+    int remote_fd;
+    std::unique_ptr<ble::FdChannel> channel = ble::FdChannel::socketpair(247, &remote_fd);
+    long received = 0;
+    *errors = 0;
+
+    uint64_t start = ble::monotonic_ns();
+    std::thread peer(peer_send, remote_fd, payload, packets);
+
+    if (batched) {
+        channel->set_handlers([&](const uint8_t *data, size_t len) {
+            if (len != payload || packet_seq(data) != (uint32_t)received) (*errors)++;
+            received++;
+        });
+        while (received < packets) {
+            if (channel->receive() == 0) wait_fd(channel->fd(), POLLIN);
+        }
+    } else {
+        std::vector<uint8_t> buf(channel->mtu());
+        while (received < packets) {
+            ssize_t n = recv(channel->fd(), buf.data(), buf.size(), MSG_DONTWAIT);
+            if (n < 0) { wait_fd(channel->fd(), POLLIN); continue; }
+            if ((size_t)n != payload || packet_seq(buf.data()) != (uint32_t)received) (*errors)++;
+            received++;
+        }
+    }
+
+    double elapsed_s = (ble::monotonic_ns() - start) / 1e9;
+    peer.join();
+    close(remote_fd);
+    return packets / elapsed_s;
+}
+
+static double bench_notify(size_t payload, long packets, bool batched, long *errors) {
+    int remote_fd;
+    std::unique_ptr<ble::FdChannel> channel = ble::FdChannel::socketpair(247, &remote_fd);
+    std::vector<uint8_t> buf(payload);
+
+    uint64_t start = ble::monotonic_ns();
+    std::thread peer([&] { *errors = peer_receive(remote_fd, channel->mtu(), packets); });
+
+    for (long seq = 0; seq < packets; seq++) {
+        fill_packet(buf.data(), payload, (uint32_t)seq);
+        if (batched) {
+            while (!channel->queue(buf.data(), payload)) wait_fd(channel->fd(), POLLOUT);
+        } else {
+            while (send(channel->fd(), buf.data(), payload, MSG_DONTWAIT) < 0) {
+                wait_fd(channel->fd(), POLLOUT);
+            }
+        }
+    }
+    while (channel->pending()) {
+        if (channel->flush() == 0) wait_fd(channel->fd(), POLLOUT);
+    }
+
+    peer.join();
+    double elapsed_s = (ble::monotonic_ns() - start) / 1e9;
+    close(remote_fd);
+    return packets / elapsed_s;
+}
+
+// A send error other than EAGAIN drops the queue and closes the channel,
+// through on_close when attached
+static bool check_send_error() {
+    bool ok = true;
+    for (bool attached : {false, true}) {
+        int remote_fd;
+        std::unique_ptr<ble::FdChannel> channel = ble::FdChannel::socketpair(247, &remote_fd);
+        GMainContext *context = g_main_context_new();
+        bool closed = false;
+        if (attached) {
+            channel->set_handlers(nullptr, [&] { closed = true; });
+            channel->attach(context);
+        }
+        uint8_t buf[20] = {};
+        channel->queue(buf, sizeof(buf));
+        channel->queue(buf, sizeof(buf));
+        close(remote_fd);
+        ok = ok && channel->flush() == 0 && channel->pending() == 0 &&
+             channel->stats().tx_dropped == 2;
+        for (int i = 0; attached && !closed && i < 100; i++) g_main_context_iteration(context, FALSE);
+        ok = ok && !channel->is_open() && closed == attached;
+        channel->detach();
+        g_main_context_unref(context);
+    }
+    if (!ok) printf("A failed send left the queue or the channel open\n");
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    long packets = argc > 1 ? atol(argv[1]) : 1000000;
+    const size_t payloads[] = {20, 244};
+
+    printf("FdChannel over socketpair, MTU 247 (%ld packets)\n\n", packets);
+    printf("%-8s %8s %18s %18s %8s\n", "path", "bytes", "per-packet (p/s)", "batched (p/s)", "speedup");
+
+    long errors = 0, e;
+    for (size_t payload : payloads) {
+        double before = bench_write(payload, packets, false, &e); errors += e;
+        double after = bench_write(payload, packets, true, &e); errors += e;
+        printf("%-8s %8zu %18.0f %18.0f %7.1fx\n", "write", payload, before, after, after / before);
+    }
+    for (size_t payload : payloads) {
+        double before = bench_notify(payload, packets, false, &e); errors += e;
+        double after = bench_notify(payload, packets, true, &e); errors += e;
+        printf("%-8s %8zu %18.0f %18.0f %7.1fx\n", "notify", payload, before, after, after / before);
+    }
+
+    if (errors) {
+        printf("\n%ld packets arrived out of order or with the wrong size\n", errors);
+        return 1;
+    }
+    return check_send_error() ? 0 : 1;
+}
@@ -0,0 +1,534 @@
+// Handler pool benchmark - inline vs worker-pool GATT handlers behind a slow one
+// Usage: ./handler_pool_bench [--bus ADDRESS] [--reads N] [--slow-ms MS] [--workers N]
+//                             [--queue-depth N]
+//
+// Exports a GattDatabase from its own thread and bus connection: one
+// characteristic whose WriteValue handler sleeps --slow-ms, and four whose
+// ReadValue handlers answer at once. A second connection keeps two slow
+// writes in flight while it makes --reads ReadValue calls, 16 at a time,
+// on the fast characteristics. That runs once with the handlers inline on
+// the server's loop and once on a HandlerPool, and read latency is
+// reported for both.
+//
+// Writes carry sequence numbers: exits non-zero if a handler sees one out
+// of order, two handlers for one characteristic overlap, or replies
+// arrive out of order. A last phase sends 4 * --queue-depth slow writes at
+// once and checks that the pool takes --queue-depth and fails the rest
+// with org.bluez.Error.InProgress well before a handler could finish.
+// Finally a characteristic is added and removed on a registered database,
+// and the service's Characteristics must follow in PropertiesChanged.
+
+#include <gio/gio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ble_dbus.h"
+#include "ble_gatt_database.hpp"
+#include "ble_gatt_value.h"
+#include "ble_handler_pool.hpp"
+#include "ble_uuid.hpp"
+
+#define APP_PATH        "/org/example/handler_bench"
+#define CALL_TIMEOUT_MS 30000
+#define FAST_CHARS      4
+#define READS_IN_FLIGHT 16
+#define SLOW_IN_FLIGHT  2
+
+using Clock = std::chrono::steady_clock;
+using namespace ble::literals;
+using Char = ble::GattCharacteristicInterface;
+
+struct Options {
+    const char *bus_address = NULL;
+    long reads = 2000;
+    unsigned slow_ms = 20;
+    unsigned workers = 4;
+    size_t queue_depth = 8;
+};
+
+// =============================================================================
+// Server
+// =============================================================================
+
+struct CharState {
+    GBytes *value = NULL;           ///< ReadValue reply
+    unsigned sleep_ms = 0;
+    std::atomic<int> running{0};
+    std::atomic<uint32_t> last_seq{0};
+    std::atomic<long> overlaps{0};
+    std::atomic<long> disorder{0};
+};
+
+struct Server {
+    ble::GattDatabase db{APP_PATH};
+    std::string slow_path;
+    std::vector<std::string> fast_paths;
+    CharState slow, fast[FAST_CHARS];
+
+    GMainContext *context = NULL;
+    GMainLoop *loop = NULL;
+    GDBusConnection *conn = NULL;
+    std::string name;
+    std::thread thread;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool ready = false;
+    std::string error;
+};
+
+static void handle_char_method_call(GDBusConnection *conn, const gchar *sender,
+                                    const gchar *object_path, const gchar *interface_name,
+                                    const gchar *method_name, GVariant *parameters,
+                                    GDBusMethodInvocation *invocation, gpointer user_data) {
+    CharState *state = (CharState *)user_data;
+    if (state->running.fetch_add(1) > 0) state->overlaps++;
+
+    switch (Char::find_method(method_name)) {
+    case Char::method("ReadValue"):
+        g_dbus_method_invocation_return_value(invocation, ble_gatt_value_reply(state->value));
+        break;
+    case Char::method("WriteValue"): {
+        GBytes *value = ble_gatt_value_from_write(parameters, NULL);
+        uint32_t seq = 0;
+        gsize len;
+        const void *data = g_bytes_get_data(value, &len);
+        if (len == sizeof(seq)) memcpy(&seq, data, sizeof(seq));
+        g_bytes_unref(value);
+        // Rejected writes leave gaps; accepted ones must still arrive in order
+        if (seq <= state->last_seq.exchange(seq)) state->disorder++;
+        if (state->sleep_ms) usleep(state->sleep_ms * 1000);
+        g_dbus_method_invocation_return_value(invocation, NULL);
+        break;
+    }
+    default:
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_NOT_SUPPORTED,
+                                              "Method %s not supported", method_name);
+    }
+    state->running--;
+}
+
+static bool server_setup(Server *server, const Options &options, ble::HandlerPool *pool) {
+    GError *error = NULL;
+    server->conn = ble_dbus_connect(options.bus_address, &error);
+    if (!server->conn) {
+        server->error = error->message;
+        g_error_free(error);
+        return false;
+    }
+    server->name = g_dbus_connection_get_unique_name(server->conn);
+
+    std::string service = server->db.add_service("12345678-1234-5678-1234-56789abcdef0"_uuid);
+    server->slow.sleep_ms = options.slow_ms;
+    server->slow_path = server->db.add_characteristic(service,
+        "12345678-1234-5678-1234-56789abcdef1"_uuid, {"write"}, handle_char_method_call,
+        &server->slow);
+    for (int i = 0; i < FAST_CHARS; i++) {
+        server->fast[i].value = g_bytes_new_static("handler pool bench..", 20);
+        server->fast_paths.push_back(server->db.add_characteristic(service,
+            "12345678-1234-5678-1234-56789abcdef2"_uuid, {"read"}, handle_char_method_call,
+            &server->fast[i]));
+    }
+    server->db.set_handler_pool(pool);
+    if (!server->db.register_objects(server->conn, &error)) {
+        server->error = error->message;
+        g_error_free(error);
+        return false;
+    }
+    return true;
+}
+
+// Serves the database from its own thread, like an AdapterShard
+static void server_start(Server *server, const Options &options, ble::HandlerPool *pool) {
+    server->context = g_main_context_new();
+    server->loop = g_main_loop_new(server->context, FALSE);
+    server->thread = std::thread([server, &options, pool] {
+        g_main_context_push_thread_default(server->context);
+        bool ok = server_setup(server, options, pool);
+        {
+            std::lock_guard<std::mutex> lock(server->mutex);
+            server->ready = true;
+        }
+        server->cond.notify_one();
+        if (ok) g_main_loop_run(server->loop);
+        server->db.unregister_objects();
+        if (server->conn) g_object_unref(server->conn);
+        g_main_context_pop_thread_default(server->context);
+    });
+    std::unique_lock<std::mutex> lock(server->mutex);
+    server->cond.wait(lock, [server] { return server->ready; });
+}
+
+static void server_stop(Server *server) {
+    g_main_loop_quit(server->loop);
+    server->thread.join();
+    g_main_loop_unref(server->loop);
+    g_main_context_unref(server->context);
+    for (CharState &s : server->fast) {
+        if (s.value) g_bytes_unref(s.value);
+    }
+}
+
+// =============================================================================
+// Client
+// =============================================================================
+
+struct Client {
+    GDBusConnection *conn;
+    Server *server;
+    GMainLoop *loop;
+    GVariant *options;              ///< Empty a{sv}
+
+    long reads = 0;                 ///< To make
+    long reads_issued = 0;
+    long reads_done = 0;
+    std::vector<uint32_t> read_ns;
+
+    bool writing = true;            ///< Keep slow writes in flight
+    int writes_in_flight = 0;
+    uint32_t next_seq = 1;
+    uint32_t last_reply_seq = 0;
+    long writes_ok = 0;
+    long replies_disordered = 0;
+
+    long rejected = 0;
+    uint32_t max_reject_ns = 0;
+    long errors = 0;
+    std::string first_error;
+};
+
+struct Call {
+    Client *client;
+    Clock::time_point start;
+    uint32_t seq;                   ///< 0 for reads
+};
+
+static void issue_read(Client *client);
+static void issue_write(Client *client);
+
+static bool client_done(const Client *client) {
+    return client->reads_done == client->reads && client->writes_in_flight == 0;
+}
+
+static void on_reply(GObject *source, GAsyncResult *res, gpointer user_data) {
+    Call *call = (Call *)user_data;
+    Client *client = call->client;
+    GError *error = NULL;
+    GVariant *result = g_dbus_connection_call_finish(client->conn, res, &error);
+    uint32_t ns = (uint32_t)std::min<int64_t>(UINT32_MAX,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - call->start).count());
+
+    if (!result) {
+        gchar *remote = g_dbus_error_get_remote_error(error);
+        if (call->seq && g_strcmp0(remote, "org.bluez.Error.InProgress") == 0) {
+            client->rejected++;
+            client->max_reject_ns = std::max(client->max_reject_ns, ns);
+        } else if (client->errors++ == 0) {
+            client->first_error = error->message;
+        }
+        g_free(remote);
+        g_error_free(error);
+    } else if (call->seq) {
+        if (call->seq <= client->last_reply_seq) client->replies_disordered++;
+        client->last_reply_seq = call->seq;
+        client->writes_ok++;
+        g_variant_unref(result);
+    } else {
+        client->read_ns.push_back(ns);
+        g_variant_unref(result);
+    }
+
+    if (call->seq) {
+        client->writes_in_flight--;
+        if (client->writing) issue_write(client);
+    } else {
+        client->reads_done++;
+        if (client->reads_done == client->reads) client->writing = false;
+        issue_read(client);
+    }
+    delete call;
+    if (client_done(client)) g_main_loop_quit(client->loop);
+}
+
+static void issue_read(Client *client) {
+    if (client->reads_issued == client->reads) return;
+    const Server *server = client->server;
+    const std::string &path = server->fast_paths[client->reads_issued++ % FAST_CHARS];
+    g_dbus_connection_call(client->conn, server->name.c_str(), path.c_str(), Char::name(),
+        "ReadValue", g_variant_new("(@a{sv})", client->options), G_VARIANT_TYPE("(ay)"),
+        G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, on_reply,
+        new Call{client, Clock::now(), 0});
+}
+
+static void issue_write(Client *client) {
+    uint32_t seq = client->next_seq++;
+    client->writes_in_flight++;
+    g_dbus_connection_call(client->conn, client->server->name.c_str(),
+        client->server->slow_path.c_str(), Char::name(), "WriteValue",
+        g_variant_new("(@ay@a{sv})",
+            g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, &seq, sizeof(seq), 1), client->options),
+        NULL, G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, on_reply,
+        new Call{client, Clock::now(), seq});
+}
+
+// =============================================================================
+// Phases
+// =============================================================================
+
+static double percentile_ms(const std::vector<uint32_t> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+    return sorted[i] / 1e6;
+}
+
+static long server_errors(const Server &server) {
+    long errors = server.slow.overlaps + server.slow.disorder;
+    for (const CharState &s : server.fast) errors += s.overlaps;
+    return errors;
+}
+
+struct Result {
+    double seconds;
+    std::vector<uint32_t> read_ns;
+    long writes;
+    long errors;
+};
+
+// Fast reads alongside a stream of slow writes
+static bool run_mixed(const Options &options, GDBusConnection *conn, GVariant *call_options,
+                      ble::HandlerPool *pool, Result *result) {
+    Server server;
+    server_start(&server, options, pool);
+    if (!server.error.empty()) {
+        fprintf(stderr, "Server: %s\n", server.error.c_str());
+        server_stop(&server);
+        return false;
+    }
+
+    Client client{conn, &server, g_main_loop_new(NULL, FALSE), call_options};
+    client.reads = options.reads;
+    client.read_ns.reserve(options.reads);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < SLOW_IN_FLIGHT; i++) issue_write(&client);
+    for (int i = 0; i < READS_IN_FLIGHT; i++) issue_read(&client);
+    g_main_loop_run(client.loop);
+    result->seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    g_main_loop_unref(client.loop);
+    server_stop(&server);
+
+    std::sort(client.read_ns.begin(), client.read_ns.end());
+    result->read_ns = std::move(client.read_ns);
+    result->writes = client.writes_ok;
+    result->errors = client.errors + client.rejected + client.replies_disordered +
+                     server_errors(server);
+    if (client.errors) fprintf(stderr, "First error: %s\n", client.first_error.c_str());
+    return true;
+}
+
+// A burst of slow writes past the queue depth
+static bool run_saturated(const Options &options, GDBusConnection *conn, GVariant *call_options,
+                          ble::HandlerPool *pool, Client *out) {
+    Server server;
+    server_start(&server, options, pool);
+    if (!server.error.empty()) {
+        fprintf(stderr, "Server: %s\n", server.error.c_str());
+        server_stop(&server);
+        return false;
+    }
+
+    Client client{conn, &server, g_main_loop_new(NULL, FALSE), call_options};
+    client.writing = false;
+    for (size_t i = 0; i < 4 * options.queue_depth; i++) issue_write(&client);
+    g_main_loop_run(client.loop);
+    g_main_loop_unref(client.loop);
+    server_stop(&server);
+
+    client.errors += server_errors(server);
+    client.server = NULL;
+    client.loop = NULL;
+    *out = client;
+    return true;
+}
+
+// =============================================================================
+// Child lists
+// =============================================================================
+
+static void on_tree_signal(GDBusConnection *, const gchar *, const gchar *object_path,
+                           const gchar *, const gchar *signal_name, GVariant *parameters,
+                           gpointer user_data) {
+    std::vector<std::string> *seen = (std::vector<std::string> *)user_data;
+    if (strcmp(signal_name, "PropertiesChanged") == 0) {
+        GVariant *changed = g_variant_get_child_value(parameters, 1);
+        GVariant *list = g_variant_lookup_value(changed, "Characteristics", G_VARIANT_TYPE("ao"));
+        if (list) {
+            seen->push_back(std::string(object_path) + " Characteristics " +
+                            std::to_string(g_variant_n_children(list)));
+            g_variant_unref(list);
+        }
+        g_variant_unref(changed);
+    } else if (strcmp(signal_name, "InterfacesAdded") == 0 ||
+               strcmp(signal_name, "InterfacesRemoved") == 0) {
+        GVariant *path = g_variant_get_child_value(parameters, 0);
+        seen->push_back(std::string(signal_name) + " " + g_variant_get_string(path, NULL));
+        g_variant_unref(path);
+    }
+}
+
+// A characteristic added or removed after registration changes its
+// service's Characteristics; BlueZ must hear of it after the object itself
+static bool check_child_lists(const Options &options, GDBusConnection *client) {
+    GError *error = NULL;
+    GDBusConnection *conn = ble_dbus_connect(options.bus_address, &error);
+    if (!conn) {
+        fprintf(stderr, "Failed to connect to D-Bus: %s\n", error->message);
+        g_error_free(error);
+        return false;
+    }
+    std::vector<std::string> seen;
+    guint watch = g_dbus_connection_signal_subscribe(client, g_dbus_connection_get_unique_name(conn),
+        NULL, NULL, NULL, NULL, G_DBUS_SIGNAL_FLAGS_NONE, on_tree_signal, &seen, NULL);
+    // A round trip, so the bus has the match rule before anything is emitted
+    GVariant *id = g_dbus_connection_call_sync(client, "org.freedesktop.DBus",
+        "/org/freedesktop/DBus", "org.freedesktop.DBus", "GetId", NULL, NULL,
+        G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, NULL);
+    if (id) g_variant_unref(id);
+
+    std::vector<std::string> expected;
+    {
+        ble::GattDatabase db{APP_PATH};
+        std::string service = db.add_service("12345678-1234-5678-1234-56789abcdef0"_uuid);
+        db.add_characteristic(service, "12345678-1234-5678-1234-56789abcdef1"_uuid, {"read"},
+                              nullptr, nullptr);
+        if (db.register_objects(conn, &error)) {
+            std::string added = db.add_characteristic(service,
+                "12345678-1234-5678-1234-56789abcdef2"_uuid, {"read"}, nullptr, nullptr);
+            db.remove(added);
+            expected = {"InterfacesAdded " + added, service + " Characteristics 2",
+                        "InterfacesRemoved " + added, service + " Characteristics 1"};
+        } else {
+            g_error_free(error);
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (seen.size() < expected.size() && std::chrono::steady_clock::now() < deadline) {
+            if (!g_main_context_iteration(NULL, FALSE)) usleep(1000);
+        }
+    }
+    g_dbus_connection_signal_unsubscribe(client, watch);
+    g_object_unref(conn);
+
+    bool ok = !expected.empty() && seen == expected;
+    if (!ok) {
+        printf("Characteristics not signalled after a runtime add/remove:\n");
+        for (const std::string &s : seen) printf("  %s\n", s.c_str());
+    }
+    return ok;
+}
+
+static bool parse_args(int argc, char *argv[], Options *options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char *flag = argv[i], *value = argv[i + 1];
+        if (strcmp(flag, "--bus") == 0) options->bus_address = value;
+        else if (strcmp(flag, "--reads") == 0) options->reads = atol(value);
+        else if (strcmp(flag, "--slow-ms") == 0) options->slow_ms = (unsigned)atoi(value);
+        else if (strcmp(flag, "--workers") == 0) options->workers = (unsigned)atoi(value);
+        else if (strcmp(flag, "--queue-depth") == 0) options->queue_depth = (size_t)atol(value);
+        else return false;
+    }
+    return (argc % 2) == 1 && options->reads > 0 && options->slow_ms > 0 &&
+           options->workers > 0 && options->queue_depth > 0;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parse_args(argc, argv, &options)) {
+        fprintf(stderr, "Usage: %s [--bus ADDRESS] [--reads N] [--slow-ms MS] [--workers N] "
+                "[--queue-depth N]\n", argv[0]);
+        return 2;
+    }
+
+    GError *error = NULL;
+    GDBusConnection *conn = ble_dbus_connect(options.bus_address, &error);
+    if (!conn) {
+        fprintf(stderr, "Failed to connect to D-Bus: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    GVariant *call_options = g_variant_ref_sink(g_variant_new("a{sv}", NULL));
+
+    // Room for the mixed phase: every read and slow write in flight
+    ble::HandlerPoolOptions mixed_options;
+    mixed_options.threads = options.workers;
+    mixed_options.queue_depth = READS_IN_FLIGHT + SLOW_IN_FLIGHT;
+    ble::HandlerPool pool;
+    std::string pool_error;
+    if (!pool.start(mixed_options, &pool_error)) {
+        fprintf(stderr, "Handler pool: %s\n", pool_error.c_str());
+        return 1;
+    }
+
+    printf("%ld reads (%d in flight, %d characteristics) beside %d WriteValue calls "
+           "in flight taking %u ms\n\n", options.reads, READS_IN_FLIGHT, FAST_CHARS,
+           SLOW_IN_FLIGHT, options.slow_ms);
+    printf("%-18s %9s %9s %10s %9s %9s %9s\n", "handlers", "reads/s", "writes", "p50 ms",
+           "p99 ms", "max ms", "errors");
+
+    Result inline_result, pool_result;
+    bool ok = run_mixed(options, conn, call_options, NULL, &inline_result) &&
+              run_mixed(options, conn, call_options, &pool, &pool_result);
+    pool.stop();
+    if (!ok) return 1;
+
+    char label[32];
+    snprintf(label, sizeof(label), "%u workers", options.workers);
+    for (const auto &row : {std::make_pair("inline", &inline_result),
+                            std::make_pair((const char *)label, &pool_result)}) {
+        const Result &r = *row.second;
+        printf("%-18s %9.0f %9ld %10.3f %9.3f %9.3f %9ld\n", row.first,
+               r.read_ns.size() / r.seconds, r.writes, percentile_ms(r.read_ns, 0.50),
+               percentile_ms(r.read_ns, 0.99), r.read_ns.empty() ? 0 : r.read_ns.back() / 1e6,
+               r.errors);
+    }
+
+    // Saturation: queue_depth slow writes are taken, the rest refused at once
+    ble::HandlerPoolOptions burst_options;
+    burst_options.threads = options.workers;
+    burst_options.queue_depth = options.queue_depth;
+    ble::HandlerPool burst_pool;
+    burst_pool.start(burst_options, &pool_error);
+    Client burst{};
+    ok = run_saturated(options, conn, call_options, &burst_pool, &burst);
+    ble::HandlerPoolStats stats = burst_pool.stats();
+    burst_pool.stop();
+    if (!ok) return 1;
+
+    printf("\n%zu WriteValue calls at once, queue depth %zu: %ld done, %ld rejected "
+           "(slowest rejection %.3f ms), %ld errors\n", 4 * options.queue_depth,
+           options.queue_depth, burst.writes_ok, burst.rejected, burst.max_reject_ns / 1e6,
+           burst.errors + burst.replies_disordered);
+
+    double pool_p99 = percentile_ms(pool_result.read_ns, 0.99);
+    ok = inline_result.errors == 0 && pool_result.errors == 0 &&
+         (long)inline_result.read_ns.size() == options.reads &&
+         (long)pool_result.read_ns.size() == options.reads &&
+         pool_p99 < options.slow_ms &&
+         burst.errors == 0 && burst.replies_disordered == 0 &&
+         burst.writes_ok >= (long)options.queue_depth && burst.rejected > 0 &&
+         burst.writes_ok + burst.rejected == (long)(4 * options.queue_depth) &&
+         stats.rejected == (uint64_t)burst.rejected && burst.max_reject_ns / 1e6 < options.slow_ms;
+    ok = check_child_lists(options, conn) && ok;
+
+    g_variant_unref(call_options);
+    g_object_unref(conn);
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
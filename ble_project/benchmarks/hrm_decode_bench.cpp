@@ -0,0 +1,121 @@
+// Heart Rate Measurement decode benchmark - per-packet parser vs batch decoder
+// Usage: ./hrm_decode_bench [packets]
+//
+// Generates a recording with every flag combination (8/16-bit BPM, energy
+// expended, 0-8 RR intervals) in random order, decodes it packet by packet
+// with hrm_decode() and in batches with hrm_decode_batch(), and checks that
+// both agree before reporting packets per second.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "ble_heart_rate.hpp"
+
+#define BATCH 1024
+
+using Clock = std::chrono::steady_clock;
+
+struct Recording {
+    std::vector<uint8_t> bytes;
+    std::vector<const uint8_t*> payloads;
+    std::vector<uint16_t> lens;
+};
+
+static Recording make_recording(size_t packets) {
+    Recording rec;
+    std::mt19937 rng(1);
+    std::vector<size_t> offsets;
+    rec.bytes.reserve(packets * 20);
+
+    for (size_t i = 0; i < packets; i++) {
+        uint8_t flags = (uint8_t)(rng() & 0x1F);
+        offsets.push_back(rec.bytes.size());
+        rec.bytes.push_back(flags);
+        uint16_t bpm = (uint16_t)(50 + rng() % 150);
+        rec.bytes.push_back((uint8_t)bpm);
+        if (flags & ble::kHrmBpm16) rec.bytes.push_back((uint8_t)(bpm >> 8));
+        if (flags & ble::kHrmEnergyPresent) {
+            rec.bytes.push_back((uint8_t)i);
+            rec.bytes.push_back((uint8_t)(i >> 8));
+        }
+        if (flags & ble::kHrmRrPresent) {
+            size_t n = rng() % 9;
+            for (size_t k = 0; k < n; k++) {
+                uint16_t rr = (uint16_t)(600 + rng() % 400);
+                rec.bytes.push_back((uint8_t)rr);
+                rec.bytes.push_back((uint8_t)(rr >> 8));
+            }
+        }
+        rec.lens.push_back((uint16_t)(rec.bytes.size() - offsets.back()));
+    }
+    for (size_t off : offsets) rec.payloads.push_back(&rec.bytes[off]);
+    return rec;
+}
+
+int main(int argc, char* argv[]) {
+    size_t packets = argc > 1 ? (size_t)atol(argv[1]) : 2000000;
+    Recording rec = make_recording(packets);
+
+    // Per-packet reference
+    ble::HeartRateAggregator scalar_agg;
+    uint16_t rr[16];    // a 20-byte payload carries at most 9
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < packets; i++) {
+        ble::HrmSample sample;
+        if (!ble::hrm_decode(rec.payloads[i], rec.lens[i], &sample, rr, sizeof(rr) / sizeof(rr[0]))) {
+            continue;
+        }
+        scalar_agg.add_bpm(sample.bpm);
+        for (uint16_t k = 0; k < sample.rr_count; k++) scalar_agg.add_rr(rr[k]);
+    }
+    double scalar_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Batches
+    ble::HrmBatch batch(BATCH);
+    ble::HeartRateAggregator batch_agg;
+    start = Clock::now();
+    for (size_t i = 0; i < packets; i += BATCH) {
+        size_t n = std::min<size_t>(BATCH, packets - i);
+        ble::hrm_decode_batch(&rec.payloads[i], &rec.lens[i], n, &batch);
+        batch_agg.add(batch);
+    }
+    double batch_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Both paths must agree field by field
+    size_t mismatches = 0;
+    for (size_t i = 0; i < packets; i += BATCH) {
+        size_t n = std::min<size_t>(BATCH, packets - i);
+        ble::hrm_decode_batch(&rec.payloads[i], &rec.lens[i], n, &batch);
+        for (size_t j = 0; j < n; j++) {
+            ble::HrmSample s;
+            bool ok = ble::hrm_decode(rec.payloads[i + j], rec.lens[i + j], &s, rr,
+                                      sizeof(rr) / sizeof(rr[0]));
+            if (ok != (bool)batch.valid[j] ||
+                (ok && (s.bpm != batch.bpm[j] || s.energy_kj != batch.energy_kj[j] ||
+                        s.rr_count != batch.rr_count[j]))) {
+                mismatches++;
+                continue;
+            }
+            for (uint16_t k = 0; ok && k < s.rr_count; k++) {
+                if (rr[k] != batch.rr[batch.rr_begin[j] + k]) { mismatches++; break; }
+            }
+        }
+    }
+
+    printf("Heart Rate Measurement decode (%zu packets, %zu bytes)\n\n", packets, rec.bytes.size());
+    printf("%-12s %14s %10s %10s\n", "", "packets/s", "bpm", "rmssd ms");
+    printf("%-12s %14.0f %10.1f %10.1f\n", "per-packet", packets / scalar_s,
+           scalar_agg.bpm(), scalar_agg.rmssd_ms());
+    printf("%-12s %14.0f %10.1f %10.1f\n", "batch", packets / batch_s,
+           batch_agg.bpm(), batch_agg.rmssd_ms());
+    // Full-scale jumps between 0 and 0xFFFF must not overflow the squares
+    ble::HeartRateAggregator extreme(10, 4);
+    for (int i = 0; i < 8; i++) extreme.add_rr(i % 2 ? 0xFFFF : 0);
+    mismatches += std::fabs(extreme.rmssd_ms() - 65535 * 1000.0 / 1024.0) > 1e-6;
+
+    printf("\nspeedup %.1fx, %zu mismatches\n", scalar_s / batch_s, mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+// Metrics overhead benchmark - Counter::inc, Histogram::record, ScopedTimer
+// Usage: ./metrics_bench [records_per_thread] [max_threads]
+//
+// Records from 1, 2, 4 ... max_threads threads at once and reports the
+// cost per operation in thread CPU time, so time slices lost to other
+// threads do not count. A scraper thread renders the Prometheus text in a
+// loop meanwhile, as a busy endpoint would. Exits non-zero if the merged
+// totals after the threads exit differ from what was recorded.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "ble_metrics.hpp"
+
+enum Op { OP_COUNTER, OP_HISTOGRAM, OP_TIMER, OP_COUNT };
+
+static const char *op_names[OP_COUNT] = {"Counter::inc", "Histogram::record", "ScopedTimer"};
+
+static ble::Counter g_counter;
+static ble::Histogram g_histogram;
+static ble::Histogram g_timer;
+
+static double thread_cpu_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double run(Op op, size_t threads, uint64_t records) {
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    std::vector<double> ns_per_op(threads);
+
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            while (!go.load(std::memory_order_acquire)) {}
+            double start = thread_cpu_ns();
+            for (uint64_t i = 0; i < records; i++) {
+                switch (op) {
+                case OP_COUNTER: g_counter.inc(); break;
+                case OP_HISTOGRAM: g_histogram.record((i * 2654435761u) & 0xFFFFFF); break;
+                case OP_TIMER: { ble::ScopedTimer timer(g_timer); } break;
+                default: break;
+                }
+            }
+            ns_per_op[t] = (thread_cpu_ns() - start) / records;
+        });
+    }
+    go.store(true, std::memory_order_release);
+    for (std::thread &w : workers) w.join();
+
+    double sum = 0;
+    for (double ns : ns_per_op) sum += ns;
+    return sum / threads;
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t records = argc > 1 ? strtoull(argv[1], NULL, 10) : 20000000;
+    size_t max_threads = argc > 2 ? (size_t)atol(argv[2]) : std::thread::hardware_concurrency();
+    if (max_threads == 0) max_threads = 1;
+
+    ble::Metrics &metrics = ble::Metrics::global();
+    g_counter = metrics.counter("bench_ops_total", "", "Benchmark counter");
+    g_histogram = metrics.histogram("bench_value_seconds", "", "Benchmark histogram");
+    g_timer = metrics.histogram("bench_timer_seconds", "", "Benchmark timer");
+
+    std::atomic<bool> scraping{true};
+    std::atomic<uint64_t> scrapes{0};
+    std::thread scraper([&] {
+        while (scraping.load(std::memory_order_relaxed)) {
+            metrics.prometheus();
+            scrapes++;
+        }
+    });
+
+    printf("%-18s %8s %12s\n", "Operation", "Threads", "ns/op");
+    uint64_t expected[OP_COUNT] = {0};
+    for (int op = 0; op < OP_COUNT; op++) {
+        for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+            printf("%-18s %8zu %12.2f\n", op_names[op], threads, run((Op)op, threads, records));
+            expected[op] += records * threads;
+        }
+    }
+    scraping = false;
+    scraper.join();
+
+    ble::MetricsSnapshot snap = metrics.snapshot();
+    uint64_t got[OP_COUNT] = {snap.counters[0].value, snap.histograms[0].count,
+                              snap.histograms[1].count};
+    bool ok = true;
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (got[op] != expected[op]) {
+            printf("%s: merged %llu, recorded %llu\n", op_names[op], (unsigned long long)got[op],
+                   (unsigned long long)expected[op]);
+            ok = false;
+        }
+    }
+    printf("\n%llu scrapes during the run; ScopedTimer p50 %llu ns p99 %llu ns\n",
+           (unsigned long long)scrapes.load(),
+           (unsigned long long)snap.histograms[1].percentile(0.50),
+           (unsigned long long)snap.histograms[1].percentile(0.99));
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+// ReadValue reply benchmark - per-byte GVariantBuilder vs GBytes-backed reply
+// Usage: ./read_value_bench [iterations]
+//
+// Each iteration builds the "(ay)" reply for one characteristic read and
+// serializes it into a D-Bus method-return message, which is what
+// g_dbus_method_invocation_return_value() costs on the GATT server side.
+
+#include <gio/gio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "ble_gatt_value.h"
+
+typedef GVariant *(*reply_fn)(GBytes *value);
+
+// The pre-GBytes implementation: one builder call per byte
+static GVariant *reply_per_byte(GBytes *value) {
+    gsize len;
+    const guchar *data = (const guchar *)g_bytes_get_data(value, &len);
+
+    GVariantBuilder *builder = g_variant_builder_new(G_VARIANT_TYPE("ay"));
+    for (gsize i = 0; i < len; i++) {
+        g_variant_builder_add(builder, "y", data[i]);
+    }
+    GVariant *result = g_variant_new("(ay)", builder);
+    g_variant_builder_unref(builder);
+    return result;
+}
+
+static double run(reply_fn fn, GBytes *value, GDBusMessage *call, long iterations) {
+    gint64 start = g_get_monotonic_time();
+
+    for (long i = 0; i < iterations; i++) {
+        GDBusMessage *reply = g_dbus_message_new_method_reply(call);
+        g_dbus_message_set_body(reply, fn(value));
+
+        gsize size;
+        guchar *blob = g_dbus_message_to_blob(reply, &size, G_DBUS_CAPABILITY_FLAGS_NONE, NULL);
+        g_free(blob);
+        g_object_unref(reply);
+    }
+
+    gint64 elapsed_us = g_get_monotonic_time() - start;
+    return iterations / (elapsed_us / 1e6);
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : 200000;
+    const gsize sizes[] = {20, 128, 244, 512};
+
+    GDBusMessage *call = g_dbus_message_new_method_call(
+        ":1.1", "/org/bluez/example/service0/char0",
+        "org.bluez.GattCharacteristic1", "ReadValue");
+    g_dbus_message_set_serial(call, 1);
+
+    printf("ReadValue reply construction + serialization (%ld iterations)\n\n", iterations);
+    printf("%8s %16s %16s %8s\n", "bytes", "per-byte (r/s)", "GBytes (r/s)", "speedup");
+
+    for (gsize s = 0; s < G_N_ELEMENTS(sizes); s++) {
+        guint8 *data = (guint8 *)g_malloc(sizes[s]);
+        for (gsize i = 0; i < sizes[s]; i++) data[i] = (guint8)i;
+        GBytes *value = g_bytes_new_take(data, sizes[s]);
+
+        double before = run(reply_per_byte, value, call, iterations);
+        double after = run(ble_gatt_value_reply, value, call, iterations);
+        printf("%8zu %16.0f %16.0f %7.1fx\n", sizes[s], before, after, after / before);
+
+        g_bytes_unref(value);
+    }
+
+    g_object_unref(call);
+    return 0;
+}
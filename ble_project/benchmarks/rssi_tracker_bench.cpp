@@ -0,0 +1,321 @@
+// RSSI tracker benchmark - SoA ring and filters vs recomputing from raw samples
+// Usage: ./rssi_tracker_bench [--devices N] [--capacity N] [--samples N] [--threshold DBM]
+//
+// Streams --samples (4M) synthetic sightings of --devices (100000) devices,
+// 100 us apart, into an RssiTracker of --capacity (65536) slots and into a
+// baseline that keeps every raw sample per device in an unordered_map and
+// recomputes the filters on each query, as the scan log tools did. Reports
+// samples per second, memory, and the cost of "which devices are above
+// --threshold (-70 dBm)" for each filter. Exits non-zero if a tracked
+// device's history or filter values differ from a recomputation over its
+// raw samples, the wrong devices were evicted or expired, or above()
+// disagrees with a scalar loop.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ble_rssi_tracker.hpp"
+
+struct Options {
+    unsigned devices = 100000;
+    size_t capacity = 65536;
+    size_t samples = 4000000;
+    float threshold = -70.0f;
+};
+
+struct Sample {
+    ble_addr_t address;
+    int16_t rssi;
+    uint64_t timestamp_ns;
+};
+
+struct Raw {
+    std::vector<int8_t> rssi;
+    uint64_t last_seen_ns = 0;
+};
+
+struct Filtered {
+    float last, ewma, kalman, median;
+};
+
+static const char *filter_names[] = {"last", "ewma", "kalman", "median"};
+
+static double now_s() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static std::vector<Sample> make_samples(const Options &options) {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 4.0f);
+    std::vector<Sample> samples(options.samples);
+    uint64_t ts = 1000000000ULL;
+    for (Sample &s : samples) {
+        unsigned device = rng() % options.devices;
+        // Each device has its own mean, from -40 to -99 dBm
+        float rssi = -40.0f - (float)(device % 60) + noise(rng);
+        s.address = ble_addr_t{0xC0DE00000000ULL + device};
+        s.rssi = (int16_t)std::max(-127.0f, std::min(20.0f, roundf(rssi)));
+        s.timestamp_ns = ts;
+        ts += 100000;
+    }
+    return samples;
+}
+
+// The filters over a sample sequence, written out plainly
+static Filtered recompute(const int8_t *rssi, size_t n, const ble::RssiTrackerOptions &options) {
+    Filtered f;
+    f.last = f.ewma = f.kalman = rssi[0];
+    float p = options.kalman_r;
+    for (size_t i = 1; i < n; i++) {
+        f.ewma += options.ewma_alpha * (rssi[i] - f.ewma);
+        p += options.kalman_q;
+        float gain = p / (p + options.kalman_r);
+        f.kalman += gain * (rssi[i] - f.kalman);
+        p *= 1 - gain;
+        f.last = rssi[i];
+    }
+    size_t m = std::min<size_t>(n, options.median_window);
+    std::vector<int8_t> tail(rssi + n - m, rssi + n);
+    std::sort(tail.begin(), tail.end());
+    f.median = m % 2 ? tail[m / 2] : (tail[m / 2 - 1] + tail[m / 2]) / 2.0f;
+    return f;
+}
+
+static float pick(const Filtered &f, int filter) {
+    const float values[] = {f.last, f.ewma, f.kalman, f.median};
+    return values[filter];
+}
+
+static float pick(const ble::RssiSummary &s, int filter) {
+    const float values[] = {s.last, s.ewma, s.kalman, s.median};
+    return values[filter];
+}
+
+static bool near(float a, float b) {
+    return fabsf(a - b) <= 1e-3f * std::max(1.0f, fabsf(b));
+}
+
+// Baseline query: every device's filter recomputed from all of its samples
+static size_t baseline_above(const std::unordered_map<uint64_t, Raw> &raw, int filter, float threshold,
+                             const ble::RssiTrackerOptions &options, std::vector<ble_addr_t> *out) {
+    for (const auto &entry : raw) {
+        const Raw &r = entry.second;
+        if (pick(recompute(r.rssi.data(), r.rssi.size(), options), filter) > threshold) {
+            out->push_back(ble_addr_t{entry.first});
+        }
+    }
+    return out->size();
+}
+
+static bool check_tracked(const ble::RssiTracker &tracker, const std::unordered_map<uint64_t, Raw> &raw,
+                          const ble::RssiTrackerOptions &options) {
+    bool ok = true;
+    size_t bad = 0;
+    int8_t rssi[128];
+    uint64_t ts[128];
+    tracker.for_each([&](const ble::RssiSummary &s) {
+        auto it = raw.find(s.address.value);
+        if (it == raw.end() || s.samples > it->second.rssi.size()) {
+            bad++;
+            return;
+        }
+        // Samples since the device was last inserted are a suffix of its raw samples
+        const std::vector<int8_t> &all = it->second.rssi;
+        const int8_t *since = all.data() + all.size() - s.samples;
+        Filtered f = recompute(since, s.samples, options);
+        size_t kept = tracker.history(s.address, rssi, ts, 128);
+        bool same = kept == std::min<size_t>(s.samples, options.window) &&
+                    memcmp(rssi, all.data() + all.size() - kept, kept) == 0 &&
+                    ts[kept - 1] == s.last_seen_ns && s.last_seen_ns == it->second.last_seen_ns;
+        for (size_t i = 1; i < kept; i++) same = same && ts[i - 1] <= ts[i];
+        for (int filter = 0; filter < 4; filter++) same = same && near(pick(s, filter), pick(f, filter));
+        if (!same) bad++;
+    });
+    if (bad) {
+        printf("%zu tracked devices differ from their raw samples\n", bad);
+        ok = false;
+    }
+    return ok;
+}
+
+// The tracker must hold exactly the capacity most recently seen devices
+static bool check_lru(const ble::RssiTracker &tracker, const std::unordered_map<uint64_t, Raw> &raw) {
+    std::vector<std::pair<uint64_t, uint64_t>> by_age;
+    for (const auto &entry : raw) by_age.emplace_back(entry.second.last_seen_ns, entry.first);
+    std::sort(by_age.rbegin(), by_age.rend());
+    size_t expected = std::min(tracker.capacity(), by_age.size());
+    size_t missing = 0;
+    ble::RssiSummary s;
+    for (size_t i = 0; i < expected; i++) {
+        if (!tracker.find(ble_addr_t{by_age[i].second}, &s)) missing++;
+    }
+    if (tracker.size() != expected || missing) {
+        printf("LRU: %zu tracked, expected %zu; %zu of the most recent missing\n", tracker.size(),
+               expected, missing);
+        return false;
+    }
+    return true;
+}
+
+static bool check_above(const ble::RssiTracker &tracker, float threshold) {
+    bool ok = true;
+    for (int filter = 0; filter < 4; filter++) {
+        for (float thr : {threshold - 20, threshold, threshold + 20}) {
+            std::unordered_set<uint64_t> expected;
+            tracker.for_each([&](const ble::RssiSummary &s) {
+                if (pick(s, filter) > thr) expected.insert(s.address.value);
+            });
+            std::vector<ble_addr_t> got;
+            size_t n = tracker.above((ble::RssiFilter)filter, thr, &got);
+            bool same = n == expected.size() && got.size() == n &&
+                        tracker.count_above((ble::RssiFilter)filter, thr) == n;
+            for (ble_addr_t a : got) same = same && expected.count(a.value);
+            if (!same) {
+                printf("above(%s, %.0f): %zu devices, scalar loop %zu\n", filter_names[filter], thr, n,
+                       expected.size());
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+static bool check_expire(ble::RssiTracker &tracker, uint64_t now_ns, uint64_t max_age_ns) {
+    size_t stale = 0;
+    tracker.for_each([&](const ble::RssiSummary &s) { stale += s.last_seen_ns < now_ns - max_age_ns; });
+    size_t before = tracker.size();
+    size_t expired = tracker.expire(now_ns);
+    size_t old = 0;
+    tracker.for_each([&](const ble::RssiSummary &s) { old += s.last_seen_ns < now_ns - max_age_ns; });
+    if (expired != stale || old || tracker.size() != before - expired || tracker.stats().expired != expired) {
+        printf("expire: dropped %zu of %zu stale, %zu stale left\n", expired, stale, old);
+        return false;
+    }
+    printf("expire(): dropped %zu of %zu devices unseen for %.0f s\n", expired, before, max_age_ns / 1e9);
+    return true;
+}
+
+// A full tracker with free slots in the middle of the columns
+static bool check_reuse(const ble::RssiTrackerOptions &base) {
+    ble::RssiTrackerOptions options = base;
+    options.capacity = 1000;
+    options.max_age_ns = 1000;
+    ble::RssiTracker tracker(options);
+    for (uint64_t i = 0; i < 1000; i += 2) tracker.add(ble_addr_t{i}, -50, 1);
+    for (uint64_t i = 1; i < 1000; i += 2) tracker.add(ble_addr_t{i}, -50, 10000);
+    size_t expired = tracker.expire(1500);
+    for (uint64_t i = 1000; i < 1250; i++) tracker.add(ble_addr_t{i}, -30, 20000);
+    std::vector<ble_addr_t> strong;
+    bool ok = expired == 500 && tracker.size() == 750 && !tracker.add(ble_addr_t{1}, BLE_RSSI_UNKNOWN, 1) &&
+              tracker.above(ble::RssiFilter::Last, -40, &strong) == 250 &&
+              tracker.count_above(ble::RssiFilter::Kalman, -60) == 750;
+    ble::RssiSummary s;
+    for (uint64_t i = 0; i < 1000; i++) ok = ok && tracker.find(ble_addr_t{i}, &s) == (i % 2 == 1);
+    if (!ok) printf("slot reuse after expire() is wrong\n");
+    return ok;
+}
+
+// median_window of 0 is clamped to 1 and an even one rounded down to odd
+static bool check_median_window() {
+    const int8_t rssi[] = {-40, -70, -50, -45};
+    bool ok = true;
+    for (unsigned window : {0u, 1u, 4u, 40u}) {
+        ble::RssiTrackerOptions options;
+        options.median_window = window;
+        ble::RssiTracker tracker(options);
+        for (uint64_t i = 0; i < 4; i++) tracker.add(ble_addr_t{1}, rssi[i], i + 1);
+        ble::RssiSummary s;
+        float expected = window <= 1 ? -45 : window == 4 ? -50 : -47.5f;
+        ok = ok && tracker.find(ble_addr_t{1}, &s) && s.median == expected;
+    }
+    if (!ok) printf("median_window clamping is wrong\n");
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--devices") options.devices = (unsigned)atol(argv[i + 1]);
+        else if (arg == "--capacity") options.capacity = (size_t)atol(argv[i + 1]);
+        else if (arg == "--samples") options.samples = (size_t)atol(argv[i + 1]);
+        else if (arg == "--threshold") options.threshold = (float)atof(argv[i + 1]);
+        else {
+            fprintf(stderr, "Usage: %s [--devices N] [--capacity N] [--samples N] [--threshold DBM]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!options.devices || !options.samples) return 1;
+
+    std::vector<Sample> samples = make_samples(options);
+    ble::RssiTrackerOptions tracker_options;
+    tracker_options.capacity = options.capacity;
+    tracker_options.max_age_ns = 5000000000ULL;
+    ble::RssiTracker tracker(tracker_options);
+    std::unordered_map<uint64_t, Raw> raw;
+
+    double start = now_s();
+    for (const Sample &s : samples) tracker.add(s.address, s.rssi, s.timestamp_ns);
+    double tracker_s = now_s() - start;
+    start = now_s();
+    for (const Sample &s : samples) {
+        Raw &r = raw[s.address.value];
+        r.rssi.push_back((int8_t)s.rssi);
+        r.last_seen_ns = s.timestamp_ns;
+    }
+    double raw_s = now_s() - start;
+
+    size_t raw_bytes = raw.bucket_count() * sizeof(void *);
+    for (const auto &entry : raw) raw_bytes += sizeof(entry) + 2 * sizeof(void *) + entry.second.rssi.capacity();
+
+    printf("%zu samples from %zu devices, %zu tracked (%llu evicted)\n\n", samples.size(), raw.size(),
+           tracker.size(), (unsigned long long)tracker.stats().evicted);
+    printf("%-22s %14s %12s\n", "Ingest", "samples/s", "memory MB");
+    printf("%-22s %14.0f %12.1f\n", "RssiTracker", samples.size() / tracker_s, tracker.memory_bytes() / 1e6);
+    printf("%-22s %14.0f %12.1f\n", "raw samples (map)", samples.size() / raw_s, raw_bytes / 1e6);
+
+    printf("\n%-22s %8s %12s %12s %9s\n", "Query above threshold", "filter", "tracker us", "raw us", "devices");
+    std::vector<ble_addr_t> out;
+    out.reserve(raw.size());
+    for (int filter = 0; filter < 4; filter++) {
+        const int reps = 200;
+        size_t found = 0;
+        start = now_s();
+        for (int r = 0; r < reps; r++) {
+            out.clear();
+            found = tracker.above((ble::RssiFilter)filter, options.threshold, &out);
+        }
+        double tracker_us = (now_s() - start) / reps * 1e6;
+        out.clear();
+        start = now_s();
+        baseline_above(raw, filter, options.threshold, tracker_options, &out);
+        double raw_us = (now_s() - start) * 1e6;
+        printf("%-22s %8s %12.1f %12.0f %9zu\n", "", filter_names[filter], tracker_us, raw_us, found);
+    }
+    const int reps = 200;
+    size_t counted = 0;
+    start = now_s();
+    for (int r = 0; r < reps; r++) counted += tracker.count_above(ble::RssiFilter::Kalman, options.threshold - r % 2);
+    printf("%-22s %8s %12.1f %12s %9zu\n\n", "count_above()", "kalman", (now_s() - start) / reps * 1e6, "-",
+           counted / reps);
+
+    bool ok = check_tracked(tracker, raw, tracker_options);
+    ok = check_lru(tracker, raw) && ok;
+    ok = check_above(tracker, options.threshold) && ok;
+    ok = check_expire(tracker, samples.back().timestamp_ns, tracker_options.max_age_ns) && ok;
+    ok = check_above(tracker, options.threshold) && ok;
+    ok = check_reuse(tracker_options) && ok;
+    ok = check_median_window() && ok;
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+// Scan log benchmark - binary scan log append, size and read-back
+// Usage: ./scan_log_bench [--adverts N] [--devices N] [--segment BYTES]
+//
+// Appends a synthetic scan (default 2M sightings of 20000 devices, a
+// quarter named by the scan callback and the rest carrying AD payloads
+// whose counter changes now and then) to a ScanLogWriter in a temporary
+// directory, then reads every segment back with ScanLogReader. Reports
+// append and read rates and bytes per advert against the CSV that
+// `ble_scan --dump` prints for the same sightings. Exits non-zero if any
+// sighting reads back differently.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "ble_scan_log.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t adverts = 2000000;
+    unsigned devices = 20000;
+    size_t segment_bytes = 4 << 20;
+};
+
+static bool parse_args(int argc, char *argv[], Options *options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char *flag = argv[i], *value = argv[i + 1];
+        if (strcmp(flag, "--adverts") == 0) options->adverts = (size_t)atol(value);
+        else if (strcmp(flag, "--devices") == 0) options->devices = (unsigned)atol(value);
+        else if (strcmp(flag, "--segment") == 0) options->segment_bytes = (size_t)atol(value);
+        else return false;
+    }
+    return argc % 2 == 1 && options->devices > 0;
+}
+
+static std::vector<ble::ScanRecord> make_scan(const Options &options) {
+    std::mt19937 rng(1);
+    std::vector<uint16_t> counter(options.devices, 0);
+    std::vector<ble::ScanRecord> records(options.adverts);
+    uint64_t ts = 1000000000ULL;
+    for (ble::ScanRecord &r : records) {
+        ts += 1000 + rng() % 40000;
+        unsigned device = (unsigned)(rng() % options.devices);
+        ble_addr_t addr = ble_addr_make(0xC00000000000ULL | device, BLE_ADDR_RANDOM);
+        int16_t rssi = device % 50 == 0 ? BLE_RSSI_UNKNOWN : (int16_t)(-40 - (int)(rng() % 50));
+        if (device % 4 == 0) {
+            char name[24];
+            snprintf(name, sizeof(name), "Sensor-%05u", device);
+            ble::scan_record_make(ble::to_string(addr).data(), name, rssi, &r);
+            r.timestamp_ns = ts;
+            continue;
+        }
+        if (rng() % 100 == 0) counter[device]++;
+        uint8_t ad[31];
+        size_t n = 0;
+        ad[n++] = 0x02; ad[n++] = 0x01; ad[n++] = 0x06;
+        ad[n++] = 0x09; ad[n++] = 0x09;
+        n += (size_t)snprintf((char *)ad + n, 9, "Dev%05u", device % 100000);
+        ad[n++] = 0x05; ad[n++] = 0xFF; ad[n++] = 0x59; ad[n++] = 0x00;
+        ad[n++] = (uint8_t)counter[device]; ad[n++] = (uint8_t)(counter[device] >> 8);
+        ble::scan_record_make(addr, rssi, ad, n, rng() % 4 == 0, ts, &r);
+    }
+    return records;
+}
+
+// What `ble_scan --dump` prints for one sighting
+static size_t csv_line(const ble::ScanRecord &r, int64_t offset_ns, char *out, size_t size) {
+    int n = snprintf(out, size, "%llu,%s,", (unsigned long long)((r.timestamp_ns + offset_ns) / 1000),
+                     ble::to_string(r.address).data());
+    if (r.rssi != BLE_RSSI_UNKNOWN) n += snprintf(out + n, size - n, "%d", r.rssi);
+    n += snprintf(out + n, size - n, ",%.*s,", (int)r.name_len, r.name);
+    for (size_t i = 0; i < r.ad_len; i++) n += snprintf(out + n, size - n, "%02x", r.ad[i]);
+    return (size_t)n + 1;
+}
+
+static bool same(const ble::ScanRecord &r, int64_t offset_ns, const ble::ScanLogEntry &e) {
+    return e.timestamp_us == (r.timestamp_ns + offset_ns) / 1000 &&
+           ble_addr_equal(e.address, r.address) && e.rssi == r.rssi &&
+           e.scan_response == r.scan_response && e.name.len == r.name_len &&
+           memcmp(e.name.data, r.name, r.name_len) == 0 && e.ad.len == r.ad_len &&
+           memcmp(e.ad.data, r.ad, r.ad_len) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parse_args(argc, argv, &options)) {
+        fprintf(stderr, "Usage: %s [--adverts N] [--devices N] [--segment BYTES]\n", argv[0]);
+        return 2;
+    }
+
+    char dir[] = "/tmp/scan_log_bench.XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::vector<ble::ScanRecord> records = make_scan(options);
+
+    ble::ScanLogOptions log_options;
+    log_options.directory = dir;
+    log_options.segment_bytes = options.segment_bytes;
+    log_options.clock_offset_ns = 1700000000LL * 1000000000LL;
+
+    ble::ScanLogWriter writer;
+    std::string error;
+    if (!writer.open(log_options, &error)) {
+        fprintf(stderr, "%s: %s\n", dir, error.c_str());
+        return 1;
+    }
+    auto start = Clock::now();
+    for (const ble::ScanRecord &r : records) writer.append(r);
+    writer.close();
+    double append_s = std::chrono::duration<double>(Clock::now() - start).count();
+    ble::ScanLogStats stats = writer.stats();
+
+    size_t text_bytes = 0;
+    char line[256];
+    for (const ble::ScanRecord &r : records) {
+        text_bytes += csv_line(r, log_options.clock_offset_ns, line, sizeof(line));
+    }
+
+    size_t read = 0, mismatches = 0;
+    std::vector<std::string> segments = ble::scan_log_segments(dir);
+    start = Clock::now();
+    for (const std::string &path : segments) {
+        ble::ScanLogReader reader;
+        if (!reader.open(path.c_str(), &error)) {
+            fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+            return 1;
+        }
+        ble::ScanLogEntry e;
+        while (reader.next(&e)) {
+            if (read >= records.size() || !same(records[read], log_options.clock_offset_ns, e)) {
+                mismatches++;
+            }
+            read++;
+        }
+    }
+    double read_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (const std::string &path : segments) unlink(path.c_str());
+    rmdir(dir);
+
+    printf("%zu adverts from %u devices, %zu segments of %zu bytes\n\n", records.size(),
+           options.devices, segments.size(), options.segment_bytes);
+    printf("%-10s %14s %14s %10s\n", "", "adverts/s", "bytes", "B/advert");
+    printf("%-10s %14.0f %14llu %10.1f\n", "append", records.size() / append_s,
+           (unsigned long long)stats.bytes, (double)stats.bytes / records.size());
+    printf("%-10s %14.0f %14s %10s\n", "read", read / read_s, "", "");
+    printf("%-10s %14s %14zu %10.1f\n", "csv", "", text_bytes, (double)text_bytes / records.size());
+    printf("\n%llu name and %llu payload definitions, %.1fx smaller than CSV\n",
+           (unsigned long long)stats.names, (unsigned long long)stats.payloads,
+           (double)text_bytes / stats.bytes);
+
+    bool ok = read == records.size() && mismatches == 0 && stats.records == records.size();
+    if (!ok) printf("%zu read back, %zu mismatches\n", read, mismatches);
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,281 @@
+// Scan replay benchmark - btsnoop capture -> ScanIngest, 1..N threads
+// Usage: ./scan_replay_bench [--capture FILE] [--write FILE] [--adverts N] [--devices N]
+//                            [--threads N]
+//
+// Without --capture, writes a synthetic btmon capture (default 2M LE
+// Advertising Reports from 20000 devices, interleaved with other events,
+// some as extended reports and scan responses) to --write or a temporary
+// file. The capture is then replayed at full speed into one ScanIngest per
+// thread for 1, 2, 4 ... --threads threads, and reports per second are
+// printed. Exits non-zero if a synthetic replay loses a report or sees the
+// wrong number of devices, if paced replay of a capture whose clock steps
+// back stalls, or if devices unseen for expire_after() stay in the table
+// or the advert cache. The written file also works with `ble_scan --replay`.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "ble_btsnoop.hpp"
+#include "ble_scan_ingest.hpp"
+
+struct Options {
+    const char *capture = NULL;
+    const char *write = NULL;
+    size_t adverts = 2000000;
+    unsigned devices = 20000;
+    size_t threads = std::thread::hardware_concurrency();
+};
+
+static void put_be32(std::vector<uint8_t> &out, uint32_t v) {
+    for (int i = 3; i >= 0; i--) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+static void put_record(FILE *f, uint16_t opcode, uint64_t timestamp_us, const uint8_t *data, size_t len) {
+    const uint64_t epoch_delta = 0x00dcddb30f2f8000ULL;
+    std::vector<uint8_t> header;
+    put_be32(header, (uint32_t)len);
+    put_be32(header, (uint32_t)len);
+    put_be32(header, opcode);                   // adapter index 0
+    put_be32(header, 0);
+    uint64_t ts = timestamp_us + epoch_delta;
+    put_be32(header, (uint32_t)(ts >> 32));
+    put_be32(header, (uint32_t)ts);
+    fwrite(header.data(), 1, header.size(), f);
+    fwrite(data, 1, len, f);
+}
+
+// Flags, a complete name and manufacturer data with a counter
+static size_t put_payload(uint8_t *p, unsigned device, uint16_t counter) {
+    size_t n = 0;
+    p[n++] = 0x02; p[n++] = 0x01; p[n++] = 0x06;
+    p[n++] = 0x09; p[n++] = 0x09;
+    n += (size_t)snprintf((char *)p + n, 9, "Dev%05u", device % 100000);
+    p[n++] = 0x05; p[n++] = 0xFF; p[n++] = 0x59; p[n++] = 0x00;
+    p[n++] = (uint8_t)counter; p[n++] = (uint8_t)(counter >> 8);
+    return n;
+}
+
+// Returns the number of distinct devices written, 0 on error
+static size_t write_capture(const char *path, const Options &options) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    const uint8_t header[16] = {'b', 't', 's', 'n', 'o', 'o', 'p', 0, 0, 0, 0, 1, 0, 0, 0x07, 0xD1};
+    fwrite(header, 1, sizeof(header), f);
+
+    std::mt19937 rng(1);
+    std::vector<uint16_t> counter(options.devices, 0);
+    std::vector<bool> seen(options.devices, false);
+    size_t distinct = 0;
+    uint64_t ts = 1700000000ULL * 1000000;
+    const uint8_t command_complete[] = {0x0E, 0x04, 0x01, 0x0C, 0x20, 0x00};
+    for (size_t i = 0; i < options.adverts; i++) {
+        ts += 20;
+        if (rng() % 20 == 0) put_record(f, 3, ts, command_complete, sizeof(command_complete));
+
+        unsigned device = (unsigned)(rng() % options.devices);
+        if (!seen[device]) distinct++;
+        seen[device] = true;
+        if (rng() % 100 == 0) counter[device]++;
+        uint8_t ad[31];
+        size_t ad_len = put_payload(ad, device, counter[device]);
+        bool extended = device % 8 == 0;
+        bool scan_response = rng() % 4 == 0;
+        uint8_t addr[6] = {(uint8_t)device, (uint8_t)(device >> 8), (uint8_t)(device >> 16), 0, 0, 0xC0};
+        int8_t rssi = (int8_t)(-40 - (int)(rng() % 50));
+
+        uint8_t event[64];
+        size_t n = 0;
+        event[n++] = 0x3E;
+        n++;                                    // parameter length
+        if (!extended) {
+            event[n++] = 0x02; event[n++] = 1;
+            event[n++] = scan_response ? 0x04 : 0x00; event[n++] = 0x01;
+            memcpy(event + n, addr, 6); n += 6;
+            event[n++] = (uint8_t)ad_len;
+            memcpy(event + n, ad, ad_len); n += ad_len;
+            event[n++] = (uint8_t)rssi;
+        } else {
+            event[n++] = 0x0D; event[n++] = 1;
+            uint16_t type = scan_response ? 0x001B : 0x0013;
+            event[n++] = (uint8_t)type; event[n++] = (uint8_t)(type >> 8);
+            event[n++] = 0x01;
+            memcpy(event + n, addr, 6); n += 6;
+            event[n++] = 1; event[n++] = 0; event[n++] = 0xFF;    // PHYs, SID
+            event[n++] = 0x7F; event[n++] = (uint8_t)rssi;         // TX power, RSSI
+            event[n++] = 0; event[n++] = 0;                        // periodic interval
+            event[n++] = 0; memset(event + n, 0, 6); n += 6;       // direct address
+            event[n++] = (uint8_t)ad_len;
+            memcpy(event + n, ad, ad_len); n += ad_len;
+        }
+        event[1] = (uint8_t)(n - 2);
+        put_record(f, 3, ts, event, n);
+    }
+    return fclose(f) == 0 ? distinct : 0;
+}
+
+// A host clock step back mid-capture must not stall paced replay
+static bool check_clock_step() {
+    const char *path = "/tmp/scan_replay_bench_step.btsnoop";
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    const uint8_t header[16] = {'b', 't', 's', 'n', 'o', 'o', 'p', 0, 0, 0, 0, 1, 0, 0, 0x07, 0xD1};
+    fwrite(header, 1, sizeof(header), f);
+    const uint64_t base = 1700000000ULL * 1000000;
+    const uint64_t timestamps[] = {base, base + 1000, base - 3600ULL * 1000000, base + 2000};
+    for (unsigned i = 0; i < 4; i++) {
+        uint8_t ad[31];
+        size_t ad_len = put_payload(ad, i, 0);
+        uint8_t event[64];
+        size_t n = 0;
+        event[n++] = 0x3E;
+        n++;
+        event[n++] = 0x02; event[n++] = 1; event[n++] = 0x00; event[n++] = 0x01;
+        const uint8_t addr[6] = {(uint8_t)i, 0, 0, 0, 0, 0xC0};
+        memcpy(event + n, addr, 6); n += 6;
+        event[n++] = (uint8_t)ad_len;
+        memcpy(event + n, ad, ad_len); n += ad_len;
+        event[n++] = (uint8_t)-60;
+        event[1] = (uint8_t)(n - 2);
+        put_record(f, 3, timestamps[i], event, n);
+    }
+    fclose(f);
+
+    ble::BtsnoopFile file;
+    std::string error;
+    bool ok = file.open(path, &error);
+    if (ok) {
+        ble::ReplayOptions replay;
+        replay.speed = 1.0;
+        ble::ReplayStats stats = ble::replay_adv_reports(file, replay,
+            [](size_t, const ble::AdvReport &) {});
+        ok = stats.reports == 4 && stats.seconds < 1.0;
+        printf("Clock step back: %llu of 4 reports in %.3f s at 1x\n",
+               (unsigned long long)stats.reports, stats.seconds);
+    }
+    unlink(path);
+    return ok;
+}
+
+// Devices unseen for expire_after() leave the table and the advert cache
+static bool check_expiry() {
+    ble::ScanIngest ingest;
+    ingest.expire_after(std::chrono::seconds(15));
+    std::atomic<unsigned> reports{0};
+    ingest.start(std::chrono::milliseconds(1), [&](const ble::ScanIngest &, uint32_t) { reports++; });
+
+    // Waves of 100 new devices 10 s apart; the last wave repeats the first
+    auto wave = [&](unsigned w, unsigned first) {
+        for (unsigned d = first; d < first + 100; d++) {
+            uint8_t ad[31];
+            size_t ad_len = put_payload(ad, d, 0);
+            ble::ScanRecord record;
+            ble::scan_record_make(ble_addr_make(0xC00000000000ULL | d, BLE_ADDR_RANDOM), -60, ad,
+                                  ad_len, false, (uint64_t)w * 10000000000ULL, &record);
+            ingest.submit_wait(record);
+        }
+    };
+    for (unsigned w = 0; w < 10; w++) wave(w, w * 100);
+    // Two reports later the consumer has drained those and expired waves 0-7
+    unsigned seen = reports;
+    while (reports < seen + 2) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    wave(10, 0);
+    ingest.stop();
+
+    // Waves 0-8 expired; wave 10 was parsed again, so the cache forgot wave 0
+    ble::ScanStats stats = ingest.stats();
+    bool ok = ingest.devices().size() == 200 && stats.expired == 900 && stats.ad_parsed == 1100;
+    printf("Expiry: %zu devices kept, %llu expired, %llu payloads parsed\n", ingest.devices().size(),
+           (unsigned long long)stats.expired, (unsigned long long)stats.ad_parsed);
+    return ok;
+}
+
+static bool parse_args(int argc, char *argv[], Options *options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char *flag = argv[i], *value = argv[i + 1];
+        if (strcmp(flag, "--capture") == 0) options->capture = value;
+        else if (strcmp(flag, "--write") == 0) options->write = value;
+        else if (strcmp(flag, "--adverts") == 0) options->adverts = (size_t)atol(value);
+        else if (strcmp(flag, "--devices") == 0) options->devices = (unsigned)atol(value);
+        else if (strcmp(flag, "--threads") == 0) options->threads = (size_t)atol(value);
+        else return false;
+    }
+    if (options->threads == 0) options->threads = 1;
+    return argc % 2 == 1 && options->devices > 0;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parse_args(argc, argv, &options)) {
+        fprintf(stderr, "Usage: %s [--capture FILE] [--write FILE] [--adverts N] [--devices N] "
+                "[--threads N]\n", argv[0]);
+        return 2;
+    }
+
+    std::string path = options.capture ? options.capture : "";
+    bool synthetic = !options.capture;
+    size_t expected_devices = 0;
+    if (synthetic) {
+        path = options.write ? options.write : "/tmp/scan_replay_bench.btsnoop";
+        expected_devices = write_capture(path.c_str(), options);
+        if (!expected_devices) {
+            perror(path.c_str());
+            return 1;
+        }
+    }
+
+    ble::BtsnoopFile file;
+    std::string error;
+    if (!file.open(path.c_str(), &error)) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+        return 1;
+    }
+    printf("Replaying %s: %zu records\n\n", path.c_str(), file.records());
+    printf("%8s %12s %14s %10s %10s\n", "Threads", "reports", "reports/s", "devices", "parsed");
+
+    bool ok = true;
+    for (size_t threads = 1; threads <= options.threads; threads *= 2) {
+        std::vector<std::unique_ptr<ble::ScanIngest>> shards;
+        for (size_t i = 0; i < threads; i++) {
+            shards.emplace_back(new ble::ScanIngest);
+            shards[i]->start(std::chrono::seconds(1), nullptr);
+        }
+        ble::ReplayOptions replay;
+        replay.threads = threads;
+        ble::ReplayStats stats = ble::replay_adv_reports(file, replay,
+            [&](size_t shard, const ble::AdvReport &r) {
+                ble::ScanRecord record;
+                ble::scan_record_make(r.address, r.rssi, r.data, r.data_len, r.scan_response,
+                                      r.timestamp_us * 1000, &record);
+                shards[shard]->submit_wait(record);
+            });
+
+        std::unordered_set<ble_addr_t> devices;
+        uint64_t received = 0, parsed = 0;
+        for (auto &shard : shards) {
+            shard->stop();
+            shard->devices().for_each([&](const ble::DeviceEntry &e) { devices.insert(e.device.address); });
+            received += shard->stats().received;
+            parsed += shard->stats().ad_parsed;
+        }
+        printf("%8zu %12llu %14.0f %10zu %10llu\n", threads, (unsigned long long)stats.reports,
+               stats.reports / stats.seconds, devices.size(), (unsigned long long)parsed);
+        if (received != stats.reports) ok = false;
+        if (synthetic && (stats.reports != options.adverts || devices.size() != expected_devices)) ok = false;
+    }
+
+    if (synthetic && !options.write) unlink(path.c_str());
+    printf("\n");
+    ok = check_clock_step() && ok;
+    ok = check_expiry() && ok;
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
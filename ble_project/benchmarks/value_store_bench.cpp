@@ -0,0 +1,258 @@
+// Value store benchmark - seqlock ValueStore vs mutex-guarded GBytes
+// Usage: ./value_store_bench [--values N] [--readers N] [--writers N] [--seconds S]
+//
+// Writer threads stand in for sensors: they replace random values (64 to
+// 512 bytes, every 8-byte word stamped with the value and a counter) as
+// fast as they can, while reader threads stand in for BlueZ and read
+// random values whole. Runs against ValueStore and against a mutex
+// around a refcounted GBytes, as simple_peripheral kept its value, and
+// reports reads and writes per second. Every read checks that all words
+// come from one write; exits non-zero on a torn read or if long-write,
+// offset or prepared-write semantics are off.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "ble_value_store.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t values = 64;
+    unsigned readers = 2;
+    unsigned writers = 2;
+    double seconds = 2;
+};
+
+struct Result {
+    double reads_per_s;
+    double writes_per_s;
+    uint64_t torn;
+};
+
+// Value @p id at write @p counter: 64..512 bytes of identical words
+static size_t make_value(uint32_t id, uint64_t counter, uint64_t *words) {
+    size_t len = 64 * (1 + counter % 8);
+    uint64_t stamp = (uint64_t)id << 48 | (counter & 0xFFFFFFFFFFFFULL);
+    for (size_t i = 0; i < len / 8; i++) words[i] = stamp;
+    return len;
+}
+
+static bool check_value(uint32_t id, const uint8_t *data, size_t len) {
+    if (len < 8 || len % 8) return false;
+    uint64_t first;
+    memcpy(&first, data, 8);
+    if (first >> 48 != id || len != 64 * (1 + (first & 0xFFFFFFFFFFFFULL) % 8)) return false;
+    for (size_t i = 8; i < len; i += 8) {
+        if (memcmp(data + i, &first, 8) != 0) return false;
+    }
+    return true;
+}
+
+// =============================================================================
+// Stores
+// =============================================================================
+
+// How simple_peripheral kept its value: writers swap in a new GBytes
+struct MutexStore {
+    struct Slot {
+        std::mutex mutex;
+        GBytes *value = NULL;
+    };
+    std::unique_ptr<Slot[]> slots;
+
+    explicit MutexStore(size_t n) : slots(new Slot[n]) {
+        uint64_t words[64];
+        for (size_t i = 0; i < n; i++) {
+            slots[i].value = g_bytes_new(words, make_value((uint32_t)i, 0, words));
+        }
+    }
+    MutexStore(const MutexStore &) = delete;
+
+    void destroy(size_t n) {
+        for (size_t i = 0; i < n; i++) g_bytes_unref(slots[i].value);
+    }
+
+    void set(uint32_t id, const void *data, size_t len) {
+        GBytes *value = g_bytes_new(data, len);
+        std::lock_guard<std::mutex> lock(slots[id].mutex);
+        std::swap(value, slots[id].value);
+        g_bytes_unref(value);
+    }
+
+    bool read_check(uint32_t id) {
+        GBytes *value;
+        {
+            std::lock_guard<std::mutex> lock(slots[id].mutex);
+            value = g_bytes_ref(slots[id].value);
+        }
+        gsize len;
+        const uint8_t *data = (const uint8_t *)g_bytes_get_data(value, &len);
+        bool ok = check_value(id, data, len);
+        g_bytes_unref(value);
+        return ok;
+    }
+};
+
+struct SeqlockStore {
+    ble::ValueStore store;
+
+    explicit SeqlockStore(size_t n) : store(n) {
+        uint64_t words[64];
+        for (size_t i = 0; i < n; i++) {
+            ble::ValueStore::Id id;
+            store.add(words, make_value((uint32_t)i, 0, words), &id);
+        }
+    }
+
+    void destroy(size_t) {}
+
+    void set(uint32_t id, const void *data, size_t len) {
+        store.set(id, data, len);
+    }
+
+    bool read_check(uint32_t id) {
+        ble::ValueSnapshot snapshot;
+        store.read(id, &snapshot);
+        return check_value(id, snapshot.data, snapshot.len);
+    }
+};
+
+template <typename Store>
+static Result run(const Options &options) {
+    Store store(options.values);
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0}, writes{0}, torn{0};
+    std::vector<std::thread> threads;
+
+    for (unsigned w = 0; w < options.writers; w++) {
+        threads.emplace_back([&, w] {
+            std::mt19937 rng(100 + w);
+            uint64_t words[64];
+            uint64_t n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                uint32_t id = (uint32_t)(rng() % options.values);
+                // Counters differ per writer so lengths keep changing
+                size_t len = make_value(id, ++n * options.writers + w, words);
+                store.set(id, words, len);
+            }
+            writes += n;
+        });
+    }
+    for (unsigned r = 0; r < options.readers; r++) {
+        threads.emplace_back([&, r] {
+            std::mt19937 rng(200 + r);
+            uint64_t n = 0, bad = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (!store.read_check((uint32_t)(rng() % options.values))) bad++;
+                n++;
+            }
+            reads += n;
+            torn += bad;
+        });
+    }
+
+    auto start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    stop = true;
+    for (std::thread &t : threads) t.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    store.destroy(options.values);
+    return Result{reads / seconds, writes / seconds, torn.load()};
+}
+
+// =============================================================================
+// Write semantics
+// =============================================================================
+
+static bool check_semantics() {
+    ble::ValueStore store(2);
+    ble::ValueStore::Id id;
+    bool ok = store.add("Hello BLE!", 10, &id);
+    ble::ValueStore::Id other;
+    ok = ok && store.add(NULL, 0, &other) && !store.add(NULL, 0, &other);
+
+    // Long write fragments rebuild the value; offsets past the end fail
+    uint8_t big[BLE_GATT_MAX_VALUE_LEN + 1];
+    for (size_t i = 0; i < sizeof(big); i++) big[i] = (uint8_t)i;
+    ok = ok && store.write(id, 0, big, 200) == ble::WriteStatus::Ok;
+    ok = ok && store.write(id, 200, big + 200, 312) == ble::WriteStatus::Ok;
+    ok = ok && store.write(id, 600, big, 1) == ble::WriteStatus::InvalidOffset;
+    ok = ok && store.write(id, 500, big, 20) == ble::WriteStatus::InvalidLength;
+    ok = ok && store.write(id, 0, big, sizeof(big)) == ble::WriteStatus::InvalidLength;
+    ble::ValueSnapshot snapshot;
+    uint64_t version = store.read(id, &snapshot);
+    ok = ok && snapshot.len == 512 && memcmp(snapshot.data, big, 512) == 0 && version == 3;
+
+    GBytes *tail = store.read_bytes(id, 500);
+    ok = ok && g_bytes_get_size(tail) == 12 && memcmp(g_bytes_get_data(tail, NULL), big + 500, 12) == 0;
+    g_bytes_unref(tail);
+
+    // Prepared writes publish one version, or nothing when a fragment fails
+    ble::PreparedWrite prepared;
+    ok = ok && prepared.stage(0, "abc", 3, 512) == ble::WriteStatus::Ok;
+    ok = ok && prepared.stage(3, "def", 3, 512) == ble::WriteStatus::Ok;
+    ok = ok && prepared.stage(7, "xyz", 3, 512) == ble::WriteStatus::InvalidOffset;
+    ok = ok && prepared.stage(6, big, 510, 512) == ble::WriteStatus::InvalidLength;
+    ok = ok && store.commit(id, prepared, &version) == ble::WriteStatus::Ok && version == 4;
+    store.read(id, &snapshot);
+    ok = ok && snapshot.len == 6 && memcmp(snapshot.data, "abcdef", 6) == 0;
+
+    // Staged against a longer value than the one it is committed to
+    prepared.clear();
+    prepared.stage(8, "12", 2, 10);
+    prepared.stage(10, "34", 2, 10);
+    ok = ok && store.check(id, prepared) == ble::WriteStatus::InvalidOffset;
+    ok = ok && store.commit(id, prepared) == ble::WriteStatus::InvalidOffset;
+    store.read(id, &snapshot);
+    ok = ok && snapshot.version == 4 && memcmp(snapshot.data, "abcdef", 6) == 0;
+
+    // Unknown ids read as empty, version 0
+    ok = ok && store.read(2, &snapshot) == 0 && snapshot.len == 0 && store.version(7) == 0;
+    return ok;
+}
+
+static bool parse_args(int argc, char *argv[], Options *options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char *flag = argv[i], *value = argv[i + 1];
+        if (strcmp(flag, "--values") == 0) options->values = (size_t)atol(value);
+        else if (strcmp(flag, "--readers") == 0) options->readers = (unsigned)atoi(value);
+        else if (strcmp(flag, "--writers") == 0) options->writers = (unsigned)atoi(value);
+        else if (strcmp(flag, "--seconds") == 0) options->seconds = atof(value);
+        else return false;
+    }
+    return argc % 2 == 1 && options->values > 0 && options->seconds > 0;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parse_args(argc, argv, &options)) {
+        fprintf(stderr, "Usage: %s [--values N] [--readers N] [--writers N] [--seconds S]\n",
+                argv[0]);
+        return 2;
+    }
+
+    bool ok = check_semantics();
+    if (!ok) printf("Write, offset or prepared-write semantics are off\n");
+
+    printf("%zu values of 64-512 bytes, %u readers, %u writers, %.1f s each\n\n", options.values,
+           options.readers, options.writers, options.seconds);
+    printf("%-16s %14s %14s %8s\n", "store", "reads/s", "writes/s", "torn");
+    Result mutex = run<MutexStore>(options);
+    printf("%-16s %14.0f %14.0f %8llu\n", "mutex + GBytes", mutex.reads_per_s, mutex.writes_per_s,
+           (unsigned long long)mutex.torn);
+    Result seqlock = run<SeqlockStore>(options);
+    printf("%-16s %14.0f %14.0f %8llu\n", "ValueStore", seqlock.reads_per_s, seqlock.writes_per_s,
+           (unsigned long long)seqlock.torn);
+
+    ok = ok && mutex.torn == 0 && seqlock.torn == 0;
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -1,47 +1,397 @@
 // BLE Scanner - Discover nearby Bluetooth devices
-// Usage: sudo ./ble_scan
+// Usage: sudo ./ble_scan [--metrics LISTEN] [--record DIR]
+//        sudo ./ble_scan --adapters all|hci0,hci1,... [--metrics LISTEN]
+//        ./ble_scan --replay CAPTURE [--speed X] [--threads N] [--record DIR]
+//        ./ble_scan --dump LOG [--presence DBM]
+//
+// The gattlib callback only copies each sighting into a lock-free ring;
+// a consumer thread deduplicates into a device table and prints one diff
+// per second instead of one line per advertisement. --metrics
+// 127.0.0.1:9464 (or unix:PATH) serves the advert and drop counters in
+// Prometheus format while scanning.
+//
+// --replay feeds the LE Advertising Reports of a btsnoop capture (btmon -w,
+// Android snoop log) through the same pipeline, as fast as possible or at
+// X times capture speed. With --threads N the capture is split into N time
+// ranges, each replayed into its own pipeline.
+//
+// --adapters scans on several controllers at once, each adapter in its own
+// thread feeding its own pipeline, and prints a summary per adapter and the
+// union of the devices they saw.
+//
+// --record DIR appends every sighting to a binary scan log in DIR (16
+// bytes per advert, 4 MiB segments); --dump prints a segment, or every
+// segment in a directory, as CSV. While recording, only the per-second
+// summary is printed. With --presence, --dump instead feeds the log through
+// an RssiTracker and lists the devices seen in the last minute whose
+// Kalman-filtered RSSI is above DBM when the log ends.
 
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 #include <gattlib.h>
+#include "ble_adapter_pool.hpp"
+#include "ble_btsnoop.hpp"
+#include "ble_dbus.h"
+#include "ble_metrics.hpp"
+#include "ble_rssi_tracker.hpp"
+#include "ble_scan_ingest.hpp"
+#include "ble_scan_log.hpp"
 
 #define SCAN_DURATION 10
 
-void on_device_found(gattlib_adapter_t* adapter, const char* addr, 
+static ble::ScanIngest g_ingest;
+static ble::ScanLogWriter g_log;
+static bool g_recording = false;
+
+// user_data: the adapter's ScanIngest
+void on_device_found(gattlib_adapter_t* adapter, const char* addr,
                      const char* name, void* user_data) {
-    (void)adapter; (void)user_data;
-    
-    static int count = 0;
-    std::cout << "[" << ++count << "] " << addr;
-    if (name) std::cout << " - " << name;
-    std::cout << std::endl;
+    (void)adapter;
+
+    ble::ScanRecord record;
+    if (ble::scan_record_make(addr, name, BLE_RSSI_UNKNOWN, &record)) {
+        static_cast<ble::ScanIngest*>(user_data)->submit(record);
+    }
+}
+
+static void print_device(const ble::DeviceEntry& e) {
+    std::cout << "  " << ble::to_string(e.device.address).data();
+    if (e.device.name) std::cout << " - " << e.device.name;
+    if (e.device.rssi != BLE_RSSI_UNKNOWN) std::cout << " (" << e.device.rssi << " dBm)";
+    std::cout << "  x" << e.seen_count << "\n";
+}
+
+static void on_report(const ble::ScanIngest& ingest, uint32_t epoch) {
+    const ble::DeviceTable& table = ingest.devices();
+    size_t added = 0, changed = 0;
+
+    table.for_each([&](const ble::DeviceEntry& e) {
+        if (e.changed_epoch != epoch) return;
+        if (e.created_epoch == epoch) added++; else changed++;
+        if (g_recording) return;    // The log has every sighting; keep stdout to the summary
+        std::cout << (e.created_epoch == epoch ? "+" : "~");
+        print_device(e);
+    });
+
+    ble::ScanStats stats = ingest.stats();
+    std::cout << "[" << table.size() << " devices, +" << added << " new, "
+              << changed << " changed, " << stats.received << " adverts, "
+              << stats.dropped << " dropped]" << std::endl;
+}
+
+static bool start_log(const char* dir, int64_t clock_offset_ns, ble::ScanIngest& ingest) {
+    ble::ScanLogOptions options;
+    options.directory = dir;
+    options.clock_offset_ns = clock_offset_ns;
+    std::string error;
+    if (!g_log.open(options, &error)) {
+        std::cerr << "Scan log " << dir << ": " << error << std::endl;
+        return false;
+    }
+    ingest.on_batch([](const ble::ScanRecord* records, size_t count) {
+        for (size_t i = 0; i < count; i++) g_log.append(records[i]);
+    });
+    g_recording = true;
+    return true;
+}
+
+static void stop_log() {
+    ble::ScanLogStats stats = g_log.stats();
+    g_log.close();
+    if (!stats.segments) return;
+    std::cout << "Recorded " << stats.records << " adverts in " << stats.bytes << " bytes ("
+              << stats.segments << " segments, " << stats.names << " names, "
+              << stats.payloads << " payloads)" << std::endl;
 }
 
 void* scan_task(void* arg) {
     gattlib_adapter_t* adapter = (gattlib_adapter_t*)arg;
-    
+
     std::cout << "Scanning for " << SCAN_DURATION << " seconds...\n" << std::endl;
-    
-    int ret = gattlib_adapter_scan_enable(adapter, on_device_found, 
-                                          SCAN_DURATION, nullptr);
+
+    g_ingest.start(std::chrono::seconds(1), on_report);
+
+    int ret = gattlib_adapter_scan_enable(adapter, on_device_found,
+                                          SCAN_DURATION, &g_ingest);
     if (ret != GATTLIB_SUCCESS) {
         std::cerr << "Scan failed: " << ret << std::endl;
     }
-    
-    std::cout << "\nScan complete!" << std::endl;
+
+    g_ingest.stop();
+    stop_log();
+
+    std::cout << "\nScan complete! " << g_ingest.devices().size()
+              << " unique devices" << (g_recording ? "" : ":") << std::endl;
+    if (!g_recording) g_ingest.devices().for_each(print_device);
+
     gattlib_adapter_close(adapter);
     return nullptr;
 }
 
-int main() {
+// One adapter per thread, each feeding its own pipeline: the ring is
+// single-producer and every controller has its own callback thread
+struct AdapterScan {
+    std::string name;
     gattlib_adapter_t* adapter = nullptr;
-    
+    ble::ScanIngest ingest;
+    int result = GATTLIB_SUCCESS;
+};
+
+static void* scan_adapters_task(void* arg) {
+    auto& scans = *static_cast<std::vector<std::unique_ptr<AdapterScan>>*>(arg);
+
+    std::cout << "Scanning on " << scans.size() << " adapters for " << SCAN_DURATION
+              << " seconds...\n" << std::endl;
+
+    std::vector<std::thread> threads;
+    for (auto& scan : scans) {
+        AdapterScan* s = scan.get();
+        s->ingest.start(std::chrono::seconds(1), [s](const ble::ScanIngest& ingest, uint32_t) {
+            ble::ScanStats stats = ingest.stats();
+            std::cout << "[" << s->name << ": " << ingest.devices().size() << " devices, "
+                      << stats.received << " adverts, " << stats.dropped << " dropped]"
+                      << std::endl;
+        });
+        threads.emplace_back([s] {
+            s->result = gattlib_adapter_scan_enable(s->adapter, on_device_found, SCAN_DURATION,
+                                                    &s->ingest);
+        });
+    }
+    for (std::thread& t : threads) t.join();
+
+    std::unordered_set<ble_addr_t> devices;
+    for (auto& scan : scans) {
+        scan->ingest.stop();
+        if (scan->result != GATTLIB_SUCCESS) {
+            std::cerr << scan->name << ": scan failed: " << scan->result << std::endl;
+        }
+        scan->ingest.devices().for_each([&](const ble::DeviceEntry& e) {
+            devices.insert(e.device.address);
+        });
+        std::cout << scan->name << ": " << scan->ingest.devices().size() << " devices, "
+                  << scan->ingest.stats().received << " adverts" << std::endl;
+        gattlib_adapter_close(scan->adapter);
+    }
+    std::cout << "\nScan complete! " << devices.size() << " unique devices on "
+              << scans.size() << " adapters" << std::endl;
+    return nullptr;
+}
+
+static int scan_adapters(const char* spec) {
+    // Adapter names come from bluetoothd's object tree, as for the peripherals
+    GError* gerror = nullptr;
+    GDBusConnection* conn = ble_dbus_connect(nullptr, &gerror);
+    std::vector<ble::AdapterInfo> available, selected;
+    if (!conn || !ble::list_adapters(conn, &available, &gerror)) {
+        std::cerr << "Failed to list adapters: " << gerror->message << std::endl;
+        g_error_free(gerror);
+        if (conn) g_object_unref(conn);
+        return 1;
+    }
+    g_object_unref(conn);
+
+    std::string error;
+    if (!ble::select_adapters(available, spec, &selected, &error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<AdapterScan>> scans;
+    for (const ble::AdapterInfo& info : selected) {
+        std::unique_ptr<AdapterScan> scan(new AdapterScan);
+        scan->name = info.name;
+        if (gattlib_adapter_open(info.name.c_str(), &scan->adapter) != GATTLIB_SUCCESS) {
+            std::cerr << "Failed to open adapter " << info.name << std::endl;
+            for (auto& s : scans) gattlib_adapter_close(s->adapter);
+            return 1;
+        }
+        scans.push_back(std::move(scan));
+    }
+    if (scans.empty()) {
+        std::cerr << "No Bluetooth adapters" << std::endl;
+        return 1;
+    }
+
+    gattlib_mainloop(scan_adapters_task, &scans);
+    return 0;
+}
+
+// Calls fn for every entry of a segment or of every segment in a directory
+template <typename Fn>
+static bool read_log(const char* path, Fn fn) {
+    std::vector<std::string> segments = ble::scan_log_segments(path);
+    if (segments.empty()) segments.push_back(path);
+
+    for (const std::string& segment : segments) {
+        ble::ScanLogReader reader;
+        std::string error;
+        if (!reader.open(segment.c_str(), &error)) {
+            std::cerr << segment << ": " << error << std::endl;
+            return false;
+        }
+        ble::ScanLogEntry e;
+        while (reader.next(&e)) fn(e);
+    }
+    return true;
+}
+
+static int dump(const char* path) {
+    printf("timestamp_us,address,rssi,name,ad\n");
+    bool ok = read_log(path, [](const ble::ScanLogEntry& e) {
+        // Replayed adverts carry the name only inside the payload
+        ble::ByteView name = e.name;
+        if (!name.len && e.ad.len) name = ble::AdData(e.ad.data, e.ad.len).local_name();
+        printf("%llu,%s,", (unsigned long long)e.timestamp_us, ble::to_string(e.address).data());
+        if (e.rssi != BLE_RSSI_UNKNOWN) printf("%d", e.rssi);
+        printf(",%.*s,", (int)name.len, (const char*)name.data);
+        for (size_t i = 0; i < e.ad.len; i++) printf("%02x", e.ad.data[i]);
+        putchar('\n');
+    });
+    return ok ? 0 : 1;
+}
+
+// Devices whose filtered RSSI is above the threshold when the log ends
+static int presence(const char* path, float threshold_dbm) {
+    ble::RssiTracker tracker;
+    uint64_t end_ns = 0;
+    bool ok = read_log(path, [&](const ble::ScanLogEntry& e) {
+        end_ns = e.timestamp_us * 1000;
+        tracker.add(e.address, e.rssi, end_ns);
+    });
+    if (!ok) return 1;
+    tracker.expire(end_ns);
+
+    std::vector<ble_addr_t> present;
+    tracker.above(ble::RssiFilter::Kalman, threshold_dbm, &present);
+    printf("address,last_seen_us,samples,last,ewma,kalman,median\n");
+    for (ble_addr_t address : present) {
+        ble::RssiSummary s;
+        tracker.find(address, &s);
+        printf("%s,%llu,%u,%.0f,%.1f,%.1f,%.1f\n", ble::to_string(address).data(),
+               (unsigned long long)(s.last_seen_ns / 1000), s.samples, s.last, s.ewma, s.kalman,
+               s.median);
+    }
+    ble::RssiTrackerStats stats = tracker.stats();
+    std::cerr << present.size() << " of " << tracker.size() << " devices above " << threshold_dbm
+              << " dBm (" << stats.samples << " samples, " << stats.evicted << " evicted, "
+              << stats.expired << " unseen for "
+              << ble::RssiTrackerOptions().max_age_ns / 1000000000 << " s)" << std::endl;
+    return 0;
+}
+
+static int replay(const char* path, double speed, size_t threads, const char* record_dir) {
+    ble::BtsnoopFile file;
+    std::string error;
+    if (!file.open(path, &error)) {
+        std::cerr << path << ": " << error << std::endl;
+        return 1;
+    }
+    std::cout << "Replaying " << file.records() << " records from " << path
+              << (file.truncated() ? " (truncated)" : "") << "\n" << std::endl;
+
+    // One pipeline per time range; only a single one prints diffs
+    std::vector<std::unique_ptr<ble::ScanIngest>> shards;
+    for (size_t i = 0; i < threads; i++) {
+        shards.emplace_back(new ble::ScanIngest);
+        if (threads == 1) {
+            // Keep the capture's own timestamps, which are already wall time
+            if (record_dir && !start_log(record_dir, 0, *shards[i])) return 1;
+            shards[i]->start(std::chrono::seconds(1), on_report);
+        } else {
+            shards[i]->start(std::chrono::seconds(1), nullptr);
+        }
+    }
+
+    ble::ReplayOptions options;
+    options.speed = speed;
+    options.threads = threads;
+    ble::ReplayStats stats = ble::replay_adv_reports(file, options,
+        [&](size_t shard, const ble::AdvReport& r) {
+            ble::ScanRecord record;
+            ble::scan_record_make(r.address, r.rssi == 127 ? BLE_RSSI_UNKNOWN : r.rssi, r.data,
+                                  r.data_len, r.scan_response, r.timestamp_us * 1000, &record);
+            shards[shard]->submit_wait(record);
+        });
+
+    std::unordered_set<ble_addr_t> devices;
+    uint64_t parsed = 0;
+    for (auto& shard : shards) {
+        shard->stop();
+        shard->devices().for_each([&](const ble::DeviceEntry& e) { devices.insert(e.device.address); });
+        parsed += shard->stats().ad_parsed;
+    }
+    if (threads == 1 && !g_recording) {
+        std::cout << "\nReplay complete! " << devices.size() << " unique devices:" << std::endl;
+        shards[0]->devices().for_each(print_device);
+    }
+    std::cout << "\n" << stats.reports << " reports in " << std::fixed << std::setprecision(2)
+              << stats.seconds << " s (" << std::setprecision(0) << stats.reports / stats.seconds
+              << "/s), " << devices.size() << " unique devices, " << parsed
+              << " new or changed payloads" << std::endl;
+    stop_log();
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    gattlib_adapter_t* adapter = nullptr;
+    const char* metrics_listen = nullptr;
+    const char* replay_path = nullptr;
+    const char* record_dir = nullptr;
+    const char* dump_path = nullptr;
+    const char* presence_dbm = nullptr;
+    const char* adapters = nullptr;
+    double speed = 0;
+    size_t threads = 1;
+
+    bool usage = argc % 2 == 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag(argv[i]);
+        if (flag == "--metrics") metrics_listen = argv[i + 1];
+        else if (flag == "--replay") replay_path = argv[i + 1];
+        else if (flag == "--speed") speed = atof(argv[i + 1]);
+        else if (flag == "--threads") threads = (size_t)atol(argv[i + 1]);
+        else if (flag == "--record") record_dir = argv[i + 1];
+        else if (flag == "--dump") dump_path = argv[i + 1];
+        else if (flag == "--presence") presence_dbm = argv[i + 1];
+        else if (flag == "--adapters") adapters = argv[i + 1];
+        else usage = true;
+    }
+    // The log writer is single-threaded, so recording needs one pipeline
+    if (usage || threads == 0 || speed < 0 || (record_dir && (threads > 1 || adapters)) ||
+        (presence_dbm && !dump_path)) {
+        std::cerr << "Usage: " << argv[0] << " [--metrics LISTEN] [--record DIR]\n"
+                  << "       " << argv[0] << " --adapters all|hci0,... [--metrics LISTEN]\n"
+                  << "       " << argv[0] << " --replay CAPTURE [--speed X] [--threads N]"
+                  << " [--record DIR]\n"
+                  << "       " << argv[0] << " --dump LOG [--presence DBM]" << std::endl;
+        return 1;
+    }
+    if (presence_dbm) return presence(dump_path, (float)atof(presence_dbm));
+    if (dump_path) return dump(dump_path);
+
+    ble::MetricsServer metrics;
+    std::string error;
+    if (metrics_listen && !metrics.start(metrics_listen, &error)) {
+        std::cerr << "Metrics endpoint " << metrics_listen << ": " << error << std::endl;
+        return 1;
+    }
+    if (replay_path) return replay(replay_path, speed, threads, record_dir);
+    if (adapters) return scan_adapters(adapters);
+
     if (gattlib_adapter_open(nullptr, &adapter) != GATTLIB_SUCCESS) {
-        std::cerr << "Failed to open adapter. Try: sudo systemctl start bluetooth" 
+        std::cerr << "Failed to open adapter. Try: sudo systemctl start bluetooth"
                   << std::endl;
         return 1;
     }
-    
+
+    if (record_dir && !start_log(record_dir, ble::realtime_offset_ns(), g_ingest)) return 1;
+
     gattlib_mainloop(scan_task, adapter);
     return 0;
 }
@@ -1,111 +1,161 @@
-// BLE Connect - Connect to device and discover services
-// Usage: sudo ./ble_connect AA:BB:CC:DD:EE:FF
+// BLE Connect - Connect to devices and discover services
+// Usage: sudo ./ble_connect [--cache DIR] [--metrics LISTEN] AA:BB:CC:DD:EE:FF [...]
+//
+// All devices are connected concurrently by ble::ConnectionManager; each
+// one's services and characteristics are printed once it is ready. With
+// --cache, tables are stored in DIR and reused while the device's Database
+// Hash is unchanged. Connect and discovery times are summarised at the
+// end; --metrics 127.0.0.1:9464 (or unix:PATH) also serves every metric in
+// Prometheus format while the program runs.
 
 #include <iostream>
 #include <iomanip>
-#include <pthread.h>
-#include <unistd.h>
+#include <memory>
+#include <string>
+#include <vector>
 #include <gattlib.h>
+#include "ble_connection_manager.hpp"
+#include "ble_gattlib.hpp"
+#include "ble_metrics.hpp"
 
-static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
-static gattlib_connection_t* g_connection = nullptr;
-
-void on_connect(gattlib_adapter_t* adapter, const char* dst, 
-                gattlib_connection_t* connection, int error, void* user_data) {
-    (void)adapter; (void)dst; (void)user_data;
-    
-    pthread_mutex_lock(&g_mutex);
-    if (error == GATTLIB_SUCCESS) {
-        g_connection = connection;
-        std::cout << "Connected!" << std::endl;
-    } else {
-        std::cerr << "Connection failed: " << error << std::endl;
-    }
-    pthread_cond_signal(&g_cond);
-    pthread_mutex_unlock(&g_mutex);
-}
+#define MAX_ATTEMPTS 3
 
-void discover_services(gattlib_connection_t* conn) {
-    gattlib_primary_service_t* services;
+struct ConnectArgs {
     int count;
-    
-    if (gattlib_discover_primary(conn, &services, &count) != GATTLIB_SUCCESS) {
-        std::cerr << "Service discovery failed" << std::endl;
-        return;
-    }
-    
-    std::cout << "\nServices (" << count << "):" << std::endl;
-    for (int i = 0; i < count; i++) {
+    char** macs;
+    const char* cache_dir;
+    const char* metrics_listen;
+    // Outlives the gattlib main loop, which may still report disconnects
+    std::unique_ptr<ble::ConnectionManager> manager;
+};
+
+void print_services(const ble::GattTable& table) {
+    std::cout << "\nServices (" << table.services.size() << "):" << std::endl;
+    for (const gattlib_primary_service_t& service : table.services) {
         char uuid[37];
-        gattlib_uuid_to_string(&services[i].uuid, uuid, sizeof(uuid));
-        std::cout << "  " << uuid << std::endl;
+        gattlib_uuid_to_string(&service.uuid, uuid, sizeof(uuid));
+        const char* name = ble::gattlib_uuid_name(service.uuid);
+        std::cout << "  " << uuid;
+        if (name) std::cout << " (" << name << ")";
+        std::cout << std::endl;
     }
-    free(services);
 }
 
-void discover_characteristics(gattlib_connection_t* conn) {
-    gattlib_characteristic_t* chars;
-    int count;
-    
-    if (gattlib_discover_char(conn, &chars, &count) != GATTLIB_SUCCESS) {
-        std::cerr << "Characteristic discovery failed" << std::endl;
-        return;
-    }
-    
-    std::cout << "\nCharacteristics (" << count << "):" << std::endl;
-    for (int i = 0; i < count; i++) {
+void print_characteristics(const ble::GattTable& table) {
+    std::cout << "\nCharacteristics (" << table.characteristics.size() << "):" << std::endl;
+    for (const gattlib_characteristic_t& chr : table.characteristics) {
         char uuid[37];
-        gattlib_uuid_to_string(&chars[i].uuid, uuid, sizeof(uuid));
-        std::cout << "  " << uuid << " [";
-        if (chars[i].properties & GATTLIB_CHARACTERISTIC_READ) std::cout << "R";
-        if (chars[i].properties & GATTLIB_CHARACTERISTIC_WRITE) std::cout << "W";
-        if (chars[i].properties & GATTLIB_CHARACTERISTIC_NOTIFY) std::cout << "N";
+        gattlib_uuid_to_string(&chr.uuid, uuid, sizeof(uuid));
+        const char* name = ble::gattlib_uuid_name(chr.uuid);
+        std::cout << "  " << uuid;
+        if (name) std::cout << " (" << name << ")";
+        std::cout << " [";
+        if (chr.properties & GATTLIB_CHARACTERISTIC_READ) std::cout << "R";
+        if (chr.properties & GATTLIB_CHARACTERISTIC_WRITE) std::cout << "W";
+        if (chr.properties & GATTLIB_CHARACTERISTIC_NOTIFY) std::cout << "N";
         std::cout << "]" << std::endl;
     }
-    free(chars);
+}
+
+static void print_timing() {
+    std::cout << std::endl;
+    for (const ble::HistogramValue& h : ble::Metrics::global().snapshot().histograms) {
+        if (h.name != "ble_connect_seconds" && h.name != "ble_discovery_seconds") continue;
+        std::cout << std::left << std::setw(22) << h.name << std::right << " n=" << h.count
+                  << std::fixed << std::setprecision(1)
+                  << "  p50 " << h.percentile(0.50) / 1e6 << " ms"
+                  << "  p99 " << h.percentile(0.99) / 1e6 << " ms"
+                  << "  max " << h.max / 1e6 << " ms" << std::endl;
+    }
+}
+
+static void on_state(const ble::LinkStatus& status) {
+    std::cout << ble::to_string(status.address).data() << ": " << ble::to_string(status.state);
+    if (status.state == ble::LinkState::Backoff || status.state == ble::LinkState::Failed) {
+        std::cout << " (error " << status.last_error << ", attempt " << status.failures << ")";
+    }
+    std::cout << std::endl;
 }
 
 void* connect_task(void* arg) {
-    const char* mac = (const char*)arg;
+    ConnectArgs* args = (ConnectArgs*)arg;
     gattlib_adapter_t* adapter = nullptr;
-    
+
+    ble::MetricsServer metrics;
+    std::string error;
+    if (args->metrics_listen && !metrics.start(args->metrics_listen, &error)) {
+        std::cerr << "Metrics endpoint " << args->metrics_listen << ": " << error << std::endl;
+    }
+
     if (gattlib_adapter_open(nullptr, &adapter) != GATTLIB_SUCCESS) {
         std::cerr << "Failed to open adapter" << std::endl;
         return nullptr;
     }
-    
-    std::cout << "Connecting to " << mac << "..." << std::endl;
-    
-    if (gattlib_connect(adapter, mac, GATTLIB_CONNECTION_OPTIONS_NONE, 
-                        on_connect, nullptr) != GATTLIB_SUCCESS) {
-        std::cerr << "Connection initiation failed" << std::endl;
-        gattlib_adapter_close(adapter);
-        return nullptr;
+
+    ble::ConnectionOptions options;
+    options.max_attempts = MAX_ATTEMPTS;
+    options.reconnect = false;
+
+    std::unique_ptr<ble::DiscoveryCache> cache;
+    if (args->cache_dir) {
+        cache.reset(new ble::DiscoveryCache(args->cache_dir));
+        options.cache = cache.get();
     }
-    
-    pthread_mutex_lock(&g_mutex);
-    pthread_cond_wait(&g_cond, &g_mutex);
-    pthread_mutex_unlock(&g_mutex);
-    
-    if (g_connection) {
-        discover_services(g_connection);
-        discover_characteristics(g_connection);
-        
-        sleep(2);
-        gattlib_disconnect(g_connection, false);
+
+    args->manager.reset(new ble::ConnectionManager(adapter, options));
+    ble::ConnectionManager& manager = *args->manager;
+    manager.on_state(on_state);
+    manager.start();
+
+    std::vector<std::shared_future<ble::LinkStatus>> pending;
+    for (int i = 0; i < args->count; i++) {
+        std::cout << "Connecting to " << args->macs[i] << "..." << std::endl;
+        std::shared_future<ble::LinkStatus> f = manager.add(args->macs[i]);
+        if (f.valid()) pending.push_back(f);
+        else std::cerr << "Invalid address: " << args->macs[i] << std::endl;
+    }
+
+    for (std::shared_future<ble::LinkStatus>& f : pending) {
+        const ble::LinkStatus& status = f.get();
+        ble::GattTable table;
+        if (status.state != ble::LinkState::Ready || !manager.table(status.address, &table)) {
+            continue;
+        }
+        std::cout << "\n=== " << ble::to_string(status.address).data() << " ===" << std::endl;
+        print_services(table);
+        print_characteristics(table);
+    }
+
+    manager.stop();
+    print_timing();
+    if (cache) {
+        ble::DiscoveryCacheStats stats = cache->stats();
+        std::cout << "\nDiscovery cache: " << stats.hits << " hits, " << stats.misses
+                  << " misses, " << stats.stores << " stored" << std::endl;
     }
-    
     gattlib_adapter_close(adapter);
     return nullptr;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <MAC_ADDRESS>" << std::endl;
+    int first = 1;
+    const char* cache_dir = nullptr;
+    const char* metrics_listen = nullptr;
+    while (argc > first + 1 && argv[first][0] == '-') {
+        std::string flag(argv[first]);
+        if (flag == "--cache") cache_dir = argv[first + 1];
+        else if (flag == "--metrics") metrics_listen = argv[first + 1];
+        else break;
+        first += 2;
+    }
+    if (argc <= first || argv[first][0] == '-') {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--cache DIR] [--metrics LISTEN] <MAC_ADDRESS> [MAC_ADDRESS...]" << std::endl;
         return 1;
     }
-    
-    gattlib_mainloop(connect_task, argv[1]);
+
+    ConnectArgs args = {argc - first, argv + first, cache_dir, metrics_listen, nullptr};
+    gattlib_mainloop(connect_task, &args);
+    args.manager.reset();
     return 0;
 }
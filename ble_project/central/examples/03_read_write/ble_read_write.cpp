@@ -0,0 +1,150 @@
+// BLE Read/Write - Batched characteristic reads and writes
+// Usage: sudo ./ble_read_write AA:BB:CC:DD:EE:FF [UUID | UUID=HEX ...]
+//
+// Each UUID argument is read, each UUID=HEX argument written (e.g.
+// 2a06=01). Without arguments every readable characteristic is read. All
+// operations go out as one pipelined ble::BatchIo batch; each result is
+// printed with its latency.
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gattlib.h>
+#include "ble_batch_io.hpp"
+#include "ble_connection_manager.hpp"
+#include "ble_gattlib.hpp"
+
+#define PIPELINE_DEPTH 4
+
+struct ReadWriteArgs {
+    const char* mac;
+    int count;
+    char** ops;
+    std::unique_ptr<ble::ConnectionManager> manager;
+};
+
+static bool parse_hex(const std::string& hex, std::vector<uint8_t>* out) {
+    if (hex.empty() || hex.size() % 2) return false;
+    out->clear();
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        char* end = nullptr;
+        std::string byte = hex.substr(i, 2);
+        unsigned long value = strtoul(byte.c_str(), &end, 16);
+        if (*end) return false;
+        out->push_back((uint8_t)value);
+    }
+    return true;
+}
+
+static bool parse_op(gattlib_connection_t* connection, const char* arg, ble::GattOp* op) {
+    std::string text(arg);
+    size_t eq = text.find('=');
+    ble_uuid_t uuid;
+    if (!ble_uuid_parse(text.substr(0, eq).c_str(), &uuid)) return false;
+
+    if (eq == std::string::npos) {
+        *op = ble::GattOp::read(connection, ble::to_gattlib(uuid));
+        return true;
+    }
+    std::vector<uint8_t> data;
+    if (!parse_hex(text.substr(eq + 1), &data)) return false;
+    *op = ble::GattOp::write(connection, ble::to_gattlib(uuid), data.data(), data.size());
+    return true;
+}
+
+static void print_result(const ble::GattOp& op, const ble::GattResult& result) {
+    char uuid[37];
+    gattlib_uuid_to_string(&op.uuid, uuid, sizeof(uuid));
+    const char* name = ble::gattlib_uuid_name(op.uuid);
+
+    std::cout << "  " << (op.type == ble::GattOpType::Read ? "R " : "W ") << uuid;
+    if (name) std::cout << " (" << name << ")";
+    std::cout << std::dec << "  " << std::fixed << std::setprecision(1)
+              << result.latency.count() / 1e6 << " ms  ";
+
+    if (result.error != GATTLIB_SUCCESS) {
+        std::cout << "error " << result.error << std::endl;
+        return;
+    }
+    for (uint8_t byte : result.value) {
+        std::cout << std::hex << std::setw(2) << std::setfill('0') << (int)byte << " ";
+    }
+    std::cout << std::dec << std::setfill(' ') << std::endl;
+}
+
+void* read_write_task(void* arg) {
+    ReadWriteArgs* args = (ReadWriteArgs*)arg;
+    gattlib_adapter_t* adapter = nullptr;
+
+    if (gattlib_adapter_open(nullptr, &adapter) != GATTLIB_SUCCESS) {
+        std::cerr << "Failed to open adapter" << std::endl;
+        return nullptr;
+    }
+
+    ble::ConnectionOptions options;
+    options.max_attempts = 3;
+    options.reconnect = false;
+    args->manager.reset(new ble::ConnectionManager(adapter, options));
+    ble::ConnectionManager& manager = *args->manager;
+    manager.start();
+
+    std::cout << "Connecting to " << args->mac << "..." << std::endl;
+    std::shared_future<ble::LinkStatus> ready = manager.add(args->mac);
+    ble::GattTable table;
+    if (!ready.valid() || ready.get().state != ble::LinkState::Ready ||
+        !manager.table(ready.get().address, &table)) {
+        std::cerr << "Failed to connect" << std::endl;
+        manager.stop();
+        gattlib_adapter_close(adapter);
+        return nullptr;
+    }
+    gattlib_connection_t* connection = ready.get().connection;
+
+    std::vector<ble::GattOp> ops;
+    for (int i = 0; i < args->count; i++) {
+        ble::GattOp op;
+        if (!parse_op(connection, args->ops[i], &op)) {
+            std::cerr << "Ignoring invalid operation: " << args->ops[i] << std::endl;
+            continue;
+        }
+        ops.push_back(std::move(op));
+    }
+    if (args->count == 0) {
+        for (const gattlib_characteristic_t& chr : table.characteristics) {
+            if (chr.properties & GATTLIB_CHARACTERISTIC_READ) {
+                ops.push_back(ble::GattOp::read(connection, chr.uuid));
+            }
+        }
+    }
+
+    ble::BatchIo io(PIPELINE_DEPTH, PIPELINE_DEPTH);
+    ble::BatchResult batch = io.run(ops);
+
+    std::cout << "\n" << ops.size() << " operations:" << std::endl;
+    std::chrono::nanoseconds serial(0);
+    for (size_t i = 0; i < ops.size(); i++) {
+        print_result(ops[i], batch.results[i]);
+        serial += batch.results[i].latency;
+    }
+    std::cout << "\nBatch: " << batch.elapsed.count() / 1e6 << " ms ("
+              << serial.count() / 1e6 << " ms of request latency), "
+              << batch.failed << " failed" << std::endl;
+
+    manager.stop();
+    gattlib_adapter_close(adapter);
+    return nullptr;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <MAC_ADDRESS> [UUID | UUID=HEX ...]" << std::endl;
+        return 1;
+    }
+
+    ReadWriteArgs args = {argv[1], argc - 2, argv + 2, nullptr};
+    gattlib_mainloop(read_write_task, &args);
+    args.manager.reset();
+    return 0;
+}
@@ -0,0 +1,170 @@
+// BLE Notifications - High-rate notification ingestion from many devices
+// Usage: sudo ./ble_notifications [--block] [--seq OFFSET] <CHAR_UUID> MAC [MAC...]
+//
+// Subscribes to one characteristic on every device. The gattlib callback
+// only copies each notification into its device's ring; worker threads
+// decode batches and a stats line (rate, latency, drops, sequence gaps) is
+// printed every second. --seq OFFSET enables gap detection on a 16-bit
+// little-endian counter at that payload offset.
+
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gattlib.h>
+#include "ble_connection_manager.hpp"
+#include "ble_gattlib.hpp"
+#include "ble_notification_ingest.hpp"
+
+#define RUN_DURATION 30
+
+struct NotifyArgs {
+    ble::NotificationIngestOptions options;
+    uuid_t uuid;
+    int count;
+    char** macs;
+    std::unique_ptr<ble::ConnectionManager> manager;
+    std::unique_ptr<ble::NotificationIngest> ingest;
+};
+
+// Per-source decode state, only touched by the worker that owns the source
+struct SourceState {
+    uint64_t count = 0;
+    uint8_t last[4] = {0};
+    uint16_t last_len = 0;
+};
+
+static SourceState g_sources[ble::NotificationIngest::kMaxSources];
+
+static void on_batch(const ble::NotificationRecord* records, size_t count) {
+    SourceState& state = g_sources[records[0].source];
+    state.count += count;
+    const ble::NotificationRecord& newest = records[count - 1];
+    state.last_len = newest.len < sizeof(state.last) ? newest.len : sizeof(state.last);
+    memcpy(state.last, newest.data, state.last_len);
+}
+
+static void print_stats(const ble::NotificationIngestStats& now,
+                        const ble::NotificationIngestStats& prev) {
+    std::cout << std::setw(7) << (now.delivered - prev.delivered) << " notif/s  "
+              << "latency avg " << std::fixed << std::setprecision(2)
+              << now.latency_avg_ns / 1e6 << " ms max " << now.latency_max_ns / 1e6 << " ms  "
+              << "batches " << (now.batches - prev.batches) << "  "
+              << "dropped " << now.dropped << "  blocked " << now.blocked << "  "
+              << "gaps " << now.gaps << std::endl;
+}
+
+void* notify_task(void* arg) {
+    NotifyArgs* args = (NotifyArgs*)arg;
+    gattlib_adapter_t* adapter = nullptr;
+
+    if (gattlib_adapter_open(nullptr, &adapter) != GATTLIB_SUCCESS) {
+        std::cerr << "Failed to open adapter" << std::endl;
+        return nullptr;
+    }
+
+    args->ingest.reset(new ble::NotificationIngest(args->options, on_batch));
+    ble::NotificationIngest& ingest = *args->ingest;
+    ingest.start();
+
+    ble::ConnectionOptions options;
+    options.max_parallel = 8;
+    args->manager.reset(new ble::ConnectionManager(adapter, options));
+    ble::ConnectionManager& manager = *args->manager;
+
+    // Subscribe on every (re)connection, on a manager worker that still holds
+    // the connection; the device keeps its ring across them
+    uuid_t uuid = args->uuid;
+    manager.on_setup([&ingest, uuid](ble_addr_t address, gattlib_connection_t* connection) {
+        if (ingest.attach(connection, address) < 0 ||
+            gattlib_notification_start(connection, &uuid) != GATTLIB_SUCCESS) {
+            std::cerr << ble::to_string(address).data() << ": failed to subscribe" << std::endl;
+        }
+        return GATTLIB_SUCCESS;
+    });
+    manager.on_state([&ingest](const ble::LinkStatus& status) {
+        if (status.state == ble::LinkState::Backoff || status.state == ble::LinkState::Failed) {
+            ingest.detach(status.address, false);
+        }
+    });
+    manager.start();
+    for (int i = 0; i < args->count; i++) {
+        if (!manager.add(args->macs[i]).valid()) {
+            std::cerr << "Invalid address: " << args->macs[i] << std::endl;
+        }
+    }
+
+    std::cout << "Receiving for " << RUN_DURATION << " seconds...\n" << std::endl;
+    ble::NotificationIngestStats prev = ingest.stats();
+    for (int s = 0; s < RUN_DURATION; s++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        ble::NotificationIngestStats now = ingest.stats();
+        print_stats(now, prev);
+        prev = now;
+    }
+
+    // While the links are still open; stop() disconnects them
+    for (const ble::LinkStatus& status : manager.snapshot()) {
+        ingest.detach(status.address, status.state == ble::LinkState::Ready);
+    }
+    manager.stop();
+    ingest.stop();
+
+    std::cout << "\nPer device:" << std::endl;
+    for (const ble::LinkStatus& status : manager.snapshot()) {
+        std::cout << "  " << ble::to_string(status.address).data();
+        int source = ingest.find(status.address);
+        if (source < 0) {
+            std::cout << "  never subscribed (" << ble::to_string(status.state) << ")" << std::endl;
+            continue;
+        }
+        const SourceState& state = g_sources[source];
+        std::cout << "  " << state.count << " notifications, last";
+        for (uint16_t b = 0; b < state.last_len; b++) {
+            std::cout << " " << std::hex << std::setw(2) << std::setfill('0') << (int)state.last[b];
+        }
+        std::cout << std::dec << std::setfill(' ') << std::endl;
+    }
+    ble::NotificationIngestStats total = ingest.stats();
+    std::cout << "Total: " << total.received << " received, " << total.delivered
+              << " delivered, " << total.dropped << " dropped, " << total.gaps
+              << " gaps" << std::endl;
+
+    gattlib_adapter_close(adapter);
+    return nullptr;
+}
+
+int main(int argc, char* argv[]) {
+    NotifyArgs args;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        std::string flag(argv[i]);
+        if (flag == "--block") {
+            args.options.policy = ble::Backpressure::Block;
+        } else if (flag == "--seq" && i + 1 < argc) {
+            args.options.sequence.offset = atoi(argv[++i]);
+            args.options.sequence.width = 2;
+        } else {
+            break;
+        }
+    }
+
+    ble_uuid_t uuid;
+    if (argc - i < 2 || !ble_uuid_parse(argv[i], &uuid)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--block] [--seq OFFSET] <CHAR_UUID> <MAC_ADDRESS> [MAC_ADDRESS...]"
+                  << std::endl;
+        return 1;
+    }
+    args.uuid = ble::to_gattlib(uuid);
+    args.count = argc - i - 1;
+    args.macs = argv + i + 1;
+
+    gattlib_mainloop(notify_task, &args);
+    args.manager.reset();
+    args.ingest.reset();
+    return 0;
+}
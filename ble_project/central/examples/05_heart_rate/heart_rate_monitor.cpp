@@ -0,0 +1,139 @@
+// Heart Rate Monitor - Live BPM and HRV from one or more heart rate sensors
+// Usage: sudo ./heart_rate_monitor MAC [MAC...]
+//
+// Subscribes to Heart Rate Measurement (0x2A37) on every device. Buffered
+// notifications are decoded a batch at a time and fed to a per-device
+// aggregator; rolling BPM and RMSSD are printed every second.
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gattlib.h>
+#include "ble_connection_manager.hpp"
+#include "ble_gattlib.hpp"
+#include "ble_heart_rate.hpp"
+#include "ble_notification_ingest.hpp"
+
+#define RUN_DURATION 60
+#define HEART_RATE_MEASUREMENT 0x2A37
+
+struct MonitorArgs {
+    int count;
+    char** macs;
+    std::unique_ptr<ble::ConnectionManager> manager;
+    std::unique_ptr<ble::NotificationIngest> ingest;
+};
+
+// Per-source decode state, only touched by the worker that owns the source
+struct SourceState {
+    ble::HeartRateAggregator aggregator;
+    std::atomic<uint32_t> bpm_x10{0};
+    std::atomic<uint32_t> rmssd_x10{0};
+    std::atomic<uint64_t> samples{0};
+};
+
+static SourceState g_sources[ble::NotificationIngest::kMaxSources];
+
+static void on_batch(const ble::NotificationRecord* records, size_t count) {
+    // One decoder per worker; batches never exceed the ingest batch size
+    thread_local ble::HrmBatch batch(ble::NotificationIngestOptions().batch);
+    thread_local std::vector<const uint8_t*> payloads(batch.capacity());
+    thread_local std::vector<uint16_t> lens(batch.capacity());
+
+    SourceState& state = g_sources[records[0].source];
+    for (size_t done = 0; done < count;) {
+        size_t n = std::min(count - done, batch.capacity());
+        for (size_t i = 0; i < n; i++) {
+            payloads[i] = records[done + i].data;
+            lens[i] = records[done + i].len;
+        }
+        ble::hrm_decode_batch(payloads.data(), lens.data(), n, &batch);
+        state.aggregator.add(batch);
+        done += n;
+    }
+
+    state.bpm_x10.store((uint32_t)(state.aggregator.bpm() * 10), std::memory_order_relaxed);
+    state.rmssd_x10.store((uint32_t)(state.aggregator.rmssd_ms() * 10), std::memory_order_relaxed);
+    state.samples.store(state.aggregator.samples(), std::memory_order_relaxed);
+}
+
+void* monitor_task(void* arg) {
+    MonitorArgs* args = (MonitorArgs*)arg;
+    gattlib_adapter_t* adapter = nullptr;
+
+    if (gattlib_adapter_open(nullptr, &adapter) != GATTLIB_SUCCESS) {
+        std::cerr << "Failed to open adapter" << std::endl;
+        return nullptr;
+    }
+
+    args->ingest.reset(new ble::NotificationIngest(ble::NotificationIngestOptions(), on_batch));
+    ble::NotificationIngest& ingest = *args->ingest;
+    ingest.start();
+
+    ble::ConnectionOptions options;
+    options.max_parallel = 8;
+    args->manager.reset(new ble::ConnectionManager(adapter, options));
+    ble::ConnectionManager& manager = *args->manager;
+
+    // Subscribe on a manager worker that still holds the connection
+    uuid_t uuid = ble::to_gattlib(ble::uuid16(HEART_RATE_MEASUREMENT));
+    manager.on_setup([&ingest, uuid](ble_addr_t address, gattlib_connection_t* connection) {
+        if (ingest.attach(connection, address) < 0 ||
+            gattlib_notification_start(connection, &uuid) != GATTLIB_SUCCESS) {
+            std::cerr << ble::to_string(address).data()
+                      << ": no Heart Rate Measurement characteristic" << std::endl;
+        }
+        return GATTLIB_SUCCESS;
+    });
+    manager.on_state([&ingest](const ble::LinkStatus& status) {
+        if (status.state == ble::LinkState::Backoff || status.state == ble::LinkState::Failed) {
+            ingest.detach(status.address, false);
+        }
+    });
+    manager.start();
+    for (int i = 0; i < args->count; i++) {
+        if (!manager.add(args->macs[i]).valid()) {
+            std::cerr << "Invalid address: " << args->macs[i] << std::endl;
+        }
+    }
+
+    std::cout << "Monitoring for " << RUN_DURATION << " seconds...\n" << std::endl;
+    for (int s = 0; s < RUN_DURATION; s++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        for (const ble::LinkStatus& status : manager.snapshot()) {
+            int source = ingest.find(status.address);
+            if (source < 0) continue;
+            const SourceState& state = g_sources[source];
+            std::cout << ble::to_string(status.address).data() << std::fixed << std::setprecision(1)
+                      << "  " << std::setw(5) << state.bpm_x10.load() / 10.0 << " bpm"
+                      << "  RMSSD " << std::setw(6) << state.rmssd_x10.load() / 10.0 << " ms"
+                      << "  (" << state.samples.load() << " samples)" << std::endl;
+        }
+    }
+
+    // While the links are still open; stop() disconnects them
+    for (const ble::LinkStatus& status : manager.snapshot()) {
+        ingest.detach(status.address, status.state == ble::LinkState::Ready);
+    }
+    manager.stop();
+    ingest.stop();
+    gattlib_adapter_close(adapter);
+    return nullptr;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <MAC_ADDRESS> [MAC_ADDRESS...]" << std::endl;
+        return 1;
+    }
+
+    MonitorArgs args = {argc - 1, argv + 1, nullptr, nullptr};
+    gattlib_mainloop(monitor_task, &args);
+    args.manager.reset();
+    args.ingest.reset();
+    return 0;
+}
@@ -0,0 +1,255 @@
+// Nordic UART - Bidirectional byte stream over the Nordic UART Service
+// Usage: sudo ./nordic_uart AA:BB:CC:DD:EE:FF
+//        ./nordic_uart --bench [KB]
+//
+// Connected mode sends each stdin line to the device and prints whatever
+// it sends back. --bench needs no device: it streams KB kilobytes through
+// a simulated link that echoes everything back, once with 20-byte write
+// requests and once with MTU-sized chunks and write-command credits, and
+// reports throughput and per-chunk latency for both.
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gattlib.h>
+#include "ble_connection_manager.hpp"
+#include "ble_gattlib.hpp"
+#include "ble_nus_stream.hpp"
+
+#define BENCH_DEFAULT_KB 256
+#define BENCH_MTU 247
+
+// =============================================================================
+// Loopback stand-in for a NUS peripheral
+// =============================================================================
+
+// Models a link where each packet occupies the air for a time proportional
+// to its size and a write request additionally waits for a response one
+// round trip later. Received chunks are echoed back as notifications.
+class LoopbackLink {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit LoopbackLink(ble::NusStream* echo_to)
+        : echo_to_(echo_to), link_free_(Clock::now()), echo_(&LoopbackLink::run_echo, this) {}
+
+    ~LoopbackLink() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        queued_.notify_one();
+        echo_.join();
+    }
+
+    int write(const uint8_t* data, size_t len, bool with_response) {
+        // ~2 Mbit/s PHY with 14 bytes of link-layer and L2CAP/ATT overhead
+        Clock::time_point now = Clock::now();
+        link_free_ = std::max(link_free_, now) + std::chrono::microseconds((len + 14) * 4);
+        std::this_thread::sleep_until(with_response ? link_free_ + kRoundTrip : link_free_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.emplace_back(data, data + len);
+        }
+        queued_.notify_one();
+        return GATTLIB_SUCCESS;
+    }
+
+private:
+    static constexpr std::chrono::milliseconds kRoundTrip{15};  // two 7.5 ms connection events
+
+    void run_echo() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_ || !pending_.empty()) {
+            queued_.wait(lock, [this] { return !running_ || !pending_.empty(); });
+            while (!pending_.empty()) {
+                std::vector<uint8_t> chunk = std::move(pending_.front());
+                pending_.pop_front();
+                lock.unlock();
+                echo_to_->receive(chunk.data(), chunk.size());
+                lock.lock();
+            }
+        }
+    }
+
+    ble::NusStream* echo_to_;
+    Clock::time_point link_free_;
+    std::mutex mutex_;
+    std::condition_variable queued_;
+    std::deque<std::vector<uint8_t>> pending_;
+    bool running_ = true;
+    std::thread echo_;
+};
+
+static bool bench_run(const char* label, uint16_t mtu, unsigned credits, size_t bytes) {
+    ble::NusStreamOptions options;
+    options.mtu = mtu;
+    options.credits = credits;
+    options.rx_buffer = bytes;
+
+    std::unique_ptr<LoopbackLink> link;
+    ble::NusStream stream([&link](const uint8_t* data, size_t len, bool with_response) {
+        return link->write(data, len, with_response);
+    }, options);
+    link.reset(new LoopbackLink(&stream));
+
+    std::vector<uint8_t> data(bytes);
+    for (size_t i = 0; i < bytes; i++) data[i] = (uint8_t)(i * 31 + 7);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t sent = stream.write(data.data(), data.size());
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bool echoed = stream.wait_readable(bytes, std::chrono::seconds(5));
+
+    // Verify the echo in place, one contiguous span at a time
+    size_t checked = 0;
+    bool match = echoed;
+    while (match && checked < bytes) {
+        size_t len;
+        const uint8_t* span = stream.peek(&len);
+        match = len > 0 && memcmp(span, &data[checked], len) == 0;
+        stream.consume(len);
+        checked += len;
+    }
+
+    ble::NusStats stats = stream.stats();
+    std::cout << std::left << std::setw(28) << label << std::right << std::fixed
+              << std::setprecision(1) << std::setw(9) << sent / 1024.0 / seconds << " KB/s  "
+              << std::setw(6) << stats.tx_chunks << " chunks  "
+              << std::setw(5) << stats.tx_checkpoints << " requests  "
+              << "latency avg " << std::setprecision(2) << stats.chunk_latency_avg_ns / 1e6
+              << " ms max " << stats.chunk_latency_max_ns / 1e6 << " ms  "
+              << (match ? "echo ok" : "ECHO MISMATCH") << std::endl;
+    return match && sent == bytes;
+}
+
+static int bench(size_t kb) {
+    size_t bytes = kb * 1024;
+    std::cout << "Streaming " << kb << " KB through the loopback link\n" << std::endl;
+    bool ok = bench_run("20-byte write requests", 23, 0, std::min<size_t>(bytes, 16 * 1024));
+    ok = bench_run("MTU chunks, 16 credits", BENCH_MTU, 16, bytes) && ok;
+    ok = bench_run("MTU chunks, 64 credits", BENCH_MTU, 64, bytes) && ok;
+    return ok ? 0 : 1;
+}
+
+// =============================================================================
+// Connected mode
+// =============================================================================
+
+struct UartArgs {
+    const char* mac;
+    std::unique_ptr<ble::ConnectionManager> manager;
+    std::unique_ptr<ble::NusStream> stream;
+};
+
+static void on_notification(const uuid_t* uuid, const uint8_t* data, size_t len, void* user_data) {
+    static const uuid_t tx = ble::to_gattlib(ble::kNusTx);
+    if (gattlib_uuid_cmp(uuid, &tx) != 0) return;
+    static_cast<ble::NusStream*>(user_data)->receive(data, len);
+}
+
+void* uart_task(void* arg) {
+    UartArgs* args = (UartArgs*)arg;
+    gattlib_adapter_t* adapter = nullptr;
+
+    if (gattlib_adapter_open(nullptr, &adapter) != GATTLIB_SUCCESS) {
+        std::cerr << "Failed to open adapter" << std::endl;
+        return nullptr;
+    }
+
+    ble::ConnectionOptions options;
+    options.max_attempts = 3;
+    options.reconnect = false;
+    args->manager.reset(new ble::ConnectionManager(adapter, options));
+    ble::ConnectionManager& manager = *args->manager;
+    manager.start();
+
+    std::cout << "Connecting to " << args->mac << "..." << std::endl;
+    std::shared_future<ble::LinkStatus> ready = manager.add(args->mac);
+    if (!ready.valid() || ready.get().state != ble::LinkState::Ready) {
+        std::cerr << "Failed to connect" << std::endl;
+        manager.stop();
+        gattlib_adapter_close(adapter);
+        return nullptr;
+    }
+    gattlib_connection_t* connection = ready.get().connection;
+
+    uuid_t rx = ble::to_gattlib(ble::kNusRx);
+    uuid_t tx = ble::to_gattlib(ble::kNusTx);
+    args->stream.reset(new ble::NusStream([connection, rx](const uint8_t* data, size_t len,
+                                                           bool with_response) mutable {
+        return with_response
+            ? gattlib_write_char_by_uuid(connection, &rx, data, len)
+            : gattlib_write_without_response_char_by_uuid(connection, &rx, data, len);
+    }));
+    ble::NusStream& stream = *args->stream;
+
+    uint16_t mtu = 0;
+    if (gattlib_get_mtu(connection, &mtu) == GATTLIB_SUCCESS) stream.set_mtu(mtu);
+    gattlib_register_notification(connection, on_notification, &stream);
+    if (gattlib_notification_start(connection, &tx) != GATTLIB_SUCCESS) {
+        std::cerr << "Device has no Nordic UART TX characteristic" << std::endl;
+        manager.stop();
+        gattlib_adapter_close(adapter);
+        return nullptr;
+    }
+    std::cout << "Connected (" << stream.chunk_size() << "-byte chunks). "
+              << "Type lines to send, Ctrl-D to quit." << std::endl;
+
+    std::atomic<bool> done{false};
+    std::thread printer([&stream, &done] {
+        while (!done.load()) {
+            if (!stream.wait_readable(1, std::chrono::milliseconds(100))) continue;
+            size_t len;
+            const uint8_t* span = stream.peek(&len);
+            std::cout.write((const char*)span, len).flush();
+            stream.consume(len);
+        }
+    });
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        line += '\n';
+        if (stream.write(line.data(), line.size()) != line.size()) {
+            std::cerr << "Write failed" << std::endl;
+            break;
+        }
+    }
+
+    done = true;
+    printer.join();
+    gattlib_notification_stop(connection, &tx);
+
+    ble::NusStats stats = stream.stats();
+    std::cout << "\nSent " << stats.tx_bytes << " bytes in " << stats.tx_chunks << " chunks, received "
+              << stats.rx_bytes << " bytes (" << stats.rx_overflow << " overflowed)" << std::endl;
+
+    manager.stop();
+    gattlib_adapter_close(adapter);
+    return nullptr;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::string(argv[1]) == "--bench") {
+        return bench(argc >= 3 ? (size_t)atoi(argv[2]) : BENCH_DEFAULT_KB);
+    }
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <MAC_ADDRESS> | --bench [KB]" << std::endl;
+        return 1;
+    }
+
+    UartArgs args = {argv[1], nullptr, nullptr};
+    gattlib_mainloop(uart_task, &args);
+    args.manager.reset();
+    args.stream.reset();
+    return 0;
+}
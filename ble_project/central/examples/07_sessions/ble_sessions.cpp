@@ -0,0 +1,109 @@
+// BLE Sessions - One coroutine per device on a single thread
+// Usage: sudo ./ble_sessions [--seconds S] <MAC> [MAC...]
+//
+// Every device gets a ble::CoroRuntime session: connect, read the Device
+// Name and Battery Level, subscribe to Battery Level and print each
+// notification until --seconds (default 30) have passed, then disconnect.
+// All sessions run on this program's task thread, however many devices
+// are given; a connect or read that takes too long times out on its own
+// without holding up the others.
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gattlib.h>
+#include "ble_coro.hpp"
+#include "ble_gattlib.hpp"
+
+#define RUN_DURATION 30
+
+struct SessionArgs {
+    int count;
+    char** macs;
+    unsigned seconds;
+    GMainContext* context;
+    // Outlives the gattlib main loop, which may still report disconnects
+    std::unique_ptr<ble::CoroRuntime> runtime;
+};
+
+static const uuid_t kDeviceName = ble::to_gattlib(ble::uuid16(0x2A00));
+static const uuid_t kBatteryLevel = ble::to_gattlib(ble::uuid16(0x2A19));
+
+static ble::Task<> session(ble::CoroRuntime& rt, std::string address, const ble::CancelToken& stop) {
+    // Default timeouts; stop also ends a wait in progress
+    ble::AwaitOptions until_stop{std::chrono::milliseconds(0), &stop};
+    ble::Result<gattlib_connection_t*> link = co_await rt.connect(address.c_str(), until_stop);
+    if (!link.ok()) {
+        std::cout << address << ": connect failed (error " << link.error << ")" << std::endl;
+        co_return;
+    }
+    gattlib_connection_t* connection = link.value;
+
+    ble::Result<std::vector<uint8_t>> name = co_await rt.read(connection, kDeviceName);
+    if (name.ok()) {
+        std::cout << address << ": " << std::string(name.value.begin(), name.value.end()) << std::endl;
+    }
+    ble::Result<std::vector<uint8_t>> level = co_await rt.read(connection, kBatteryLevel);
+    if (level.ok() && !level.value.empty()) {
+        std::cout << address << ": battery " << (int)level.value[0] << "%" << std::endl;
+    }
+
+    if ((co_await rt.subscribe(connection, kBatteryLevel)).ok()) {
+        for (;;) {
+            ble::Result<ble::Notification> n = co_await rt.notification(connection, until_stop);
+            if (!n.ok()) break;
+            std::cout << address << ": notification, " << n.value.data.size() << " bytes" << std::endl;
+        }
+    }
+    co_await rt.disconnect(connection);
+    std::cout << address << ": disconnected" << std::endl;
+}
+
+static ble::Task<> stop_after(ble::CoroRuntime& rt, unsigned seconds, ble::CancelToken& stop) {
+    co_await rt.sleep(std::chrono::seconds(seconds));
+    stop.cancel();
+}
+
+void* sessions_task(void* arg) {
+    SessionArgs* args = (SessionArgs*)arg;
+    gattlib_adapter_t* adapter = nullptr;
+    if (gattlib_adapter_open(nullptr, &adapter) != GATTLIB_SUCCESS) {
+        std::cerr << "Failed to open adapter" << std::endl;
+        return nullptr;
+    }
+
+    // gattlib's loop owns the default context; the sessions get their own
+    args->context = g_main_context_new();
+    g_main_context_push_thread_default(args->context);
+    args->runtime.reset(new ble::CoroRuntime(adapter, ble::CoroOptions(), args->context));
+    ble::CoroRuntime& rt = *args->runtime;
+
+    ble::CancelToken stop = ble::CancelToken::make();
+    for (int i = 0; i < args->count; i++) rt.spawn(session(rt, args->macs[i], stop));
+    rt.spawn(stop_after(rt, args->seconds, stop));
+    rt.run();
+
+    g_main_context_pop_thread_default(args->context);
+    gattlib_adapter_close(adapter);
+    return nullptr;
+}
+
+int main(int argc, char* argv[]) {
+    int first = 1;
+    unsigned seconds = RUN_DURATION;
+    if (argc > 2 && std::string(argv[1]) == "--seconds") {
+        seconds = (unsigned)std::stoul(argv[2]);
+        first = 3;
+    }
+    if (argc <= first || argv[first][0] == '-') {
+        std::cerr << "Usage: " << argv[0] << " [--seconds S] <MAC_ADDRESS> [MAC_ADDRESS...]" << std::endl;
+        return 1;
+    }
+
+    SessionArgs args = {argc - first, argv + first, seconds, nullptr, nullptr};
+    gattlib_mainloop(sessions_task, &args);
+    args.runtime.reset();
+    if (args.context) g_main_context_unref(args.context);
+    return 0;
+}
@@ -0,0 +1,195 @@
+#ifndef BLE_ADAPTER_POOL_HPP
+#define BLE_ADAPTER_POOL_HPP
+
+#include <gio/gio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace ble {
+
+struct AdapterInfo {
+    std::string path;           ///< "/org/bluez/hci0"
+    std::string name;           ///< "hci0"
+    std::string address;        ///< Controller address, empty when BlueZ does not report one
+    bool powered;
+    unsigned links;             ///< Connected devices when listed
+};
+
+/**
+ * @brief Adapters exported by org.bluez on @p conn, from
+ * ObjectManager.GetManagedObjects on "/", sorted by path.
+ */
+bool list_adapters(GDBusConnection* conn, std::vector<AdapterInfo>* out, GError** error);
+
+/**
+ * @brief Picks adapters from @p available by @p spec: "all", or a comma
+ * separated list of names ("hci0,hci1") or object paths. Fails on a name
+ * that is not available or listed twice.
+ */
+bool select_adapters(const std::vector<AdapterInfo>& available, const std::string& spec,
+                     std::vector<AdapterInfo>* out, std::string* error);
+
+class AdapterPool;
+
+/**
+ * @brief One adapter of an AdapterPool: a thread running its own
+ * GMainContext with its own bus connection.
+ *
+ * Objects exported and calls made from the shard's thread are dispatched
+ * there, so handlers for different adapters run in parallel. Because each
+ * shard has its own unique bus name, every shard can export the same
+ * object paths. Everything except links() must be called on the shard's
+ * thread.
+ */
+class AdapterShard {
+public:
+    using ReplyFn = std::function<void(AdapterShard& shard, const GError* error)>;
+
+    const AdapterInfo& adapter() const { return adapter_; }
+    size_t index() const { return index_; }
+    GMainContext* context() const { return context_; }
+    GDBusConnection* connection() const { return connection_; }
+
+    /// Connected devices on this adapter; thread-safe.
+    unsigned links() const { return links_.load(std::memory_order_relaxed); }
+
+    /// GattManager1.RegisterApplication on this adapter; unregistered at stop().
+    void register_application(const std::string& app_path, ReplyFn done = nullptr);
+
+    /**
+     * LEAdvertisingManager1.RegisterAdvertisement on this adapter, while the
+     * pool wants this adapter to take new connections (see
+     * AdapterPoolOptions). @p done runs after every registration attempt.
+     */
+    void advertise(const std::string& advert_path, ReplyFn done = nullptr);
+    bool advertising() const { return advertising_; }
+
+    /// Per-shard state for setup and teardown.
+    void set_user_data(gpointer data) { user_data_ = data; }
+    gpointer user_data() const { return user_data_; }
+
+private:
+    friend class AdapterPool;
+
+    AdapterShard(AdapterPool* pool, size_t index, const AdapterInfo& adapter)
+        : pool_(pool), index_(index), adapter_(adapter) {}
+
+    void run();
+    bool watch_links(std::string* error);
+    void set_link(const char* device_path, bool connected);
+    void update_advertising();
+    void shutdown();
+
+    static void on_device_changed(GDBusConnection*, const gchar*, const gchar*, const gchar*,
+                                  const gchar*, GVariant*, gpointer);
+    static void on_interfaces_removed(GDBusConnection*, const gchar*, const gchar*, const gchar*,
+                                      const gchar*, GVariant*, gpointer);
+    static void on_advertisement_reply(GObject*, GAsyncResult*, gpointer);
+
+    AdapterPool* pool_;
+    size_t index_;
+    AdapterInfo adapter_;
+    GMainContext* context_ = nullptr;
+    GMainLoop* loop_ = nullptr;
+    GDBusConnection* connection_ = nullptr;
+    std::thread thread_;
+    gpointer user_data_ = nullptr;
+
+    std::unordered_set<std::string> linked_;    ///< Connected device paths
+    std::atomic<unsigned> links_{0};
+    guint device_watch_ = 0;
+    guint removed_watch_ = 0;
+
+    std::string app_path_;
+    std::string advert_path_;
+    ReplyFn advert_done_;
+    bool advertising_ = false;      ///< Registered with BlueZ
+    bool advert_pending_ = false;   ///< Register/Unregister call in flight
+    bool stopping_ = false;
+
+    // Setup result, handed back to AdapterPool::start()
+    bool ready_ = false;
+    bool failed_ = false;
+    std::string error_;
+};
+
+struct AdapterPoolOptions {
+    std::string bus_address;        ///< Empty: $BLE_DBUS_ADDRESS, then the system bus
+    std::string adapters = "all";   ///< See select_adapters()
+    unsigned max_links = 0;         ///< An adapter stops advertising at this many links; 0: no cap
+    /**
+     * An adapter also stops advertising while it has more than this many
+     * links above the least loaded adapter, so new centrals find the idle
+     * controllers.
+     */
+    unsigned link_spread = 1;
+};
+
+/**
+ * @brief Shards a GATT server or scanner across every Bluetooth adapter.
+ *
+ * start() lists the adapters through the ObjectManager, then starts one
+ * AdapterShard per selected adapter and runs @p setup on each shard's
+ * thread, with its context as the thread-default, before its loop. setup
+ * exports the shard's objects on shard.connection() and calls
+ * register_application() / advertise(). A controller caps concurrent
+ * links and airtime, so spreading services and advertisements over
+ * several of them scales both.
+ *
+ * The pool follows Device1.Connected on each adapter and withdraws an
+ * adapter's advertisement when it reaches max_links or runs ahead of the
+ * others by more than link_spread, and re-registers it once links drop,
+ * so incoming connections land on the least loaded controllers.
+ *
+ * stop() unregisters from BlueZ, runs @p teardown on each shard's thread
+ * and joins the threads.
+ */
+class AdapterPool {
+public:
+    using ShardFn = std::function<bool(AdapterShard& shard, std::string* error)>;
+    using TeardownFn = std::function<void(AdapterShard& shard)>;
+
+    AdapterPool() = default;
+    ~AdapterPool();
+
+    AdapterPool(const AdapterPool&) = delete;
+    AdapterPool& operator=(const AdapterPool&) = delete;
+
+    /// Fails, with every shard stopped again, if any setup fails.
+    bool start(const AdapterPoolOptions& options, ShardFn setup, TeardownFn teardown,
+               std::string* error);
+    void stop();
+
+    size_t size() const { return shards_.size(); }
+    AdapterShard& shard(size_t i) { return *shards_[i]; }
+
+    /// Links over all adapters; thread-safe.
+    unsigned links() const;
+
+private:
+    friend class AdapterShard;
+
+    bool should_advertise(const AdapterShard& shard) const;
+    void links_changed();
+    void shard_ready(AdapterShard& shard, bool ok, std::string error);
+
+    AdapterPoolOptions options_;
+    ShardFn setup_;
+    TeardownFn teardown_;
+    std::vector<std::unique_ptr<AdapterShard>> shards_;
+
+    std::mutex mutex_;
+    std::condition_variable ready_cond_;
+};
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef BLE_ADDR_H
+#define BLE_ADDR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Bluetooth device address packed into one integer: bits 0-47 hold the
+ * address with the first octet of "AA:BB:CC:DD:EE:FF" in bits 40-47, and
+ * bit 48 is set for random addresses. Equality, ordering and hashing are
+ * plain integer operations.
+ */
+typedef struct {
+    uint64_t value;
+} ble_addr_t;
+
+/* Size of the string form including the terminating NUL */
+#define BLE_ADDR_SIZE 18
+
+#define BLE_ADDR_BITS_MASK   0x0000FFFFFFFFFFFFULL
+#define BLE_ADDR_RANDOM_BIT  (1ULL << 48)
+
+typedef enum {
+    BLE_ADDR_PUBLIC = 0,
+    BLE_ADDR_RANDOM = 1,
+} ble_addr_type_t;
+
+static inline ble_addr_t ble_addr_make(uint64_t bits, ble_addr_type_t type) {
+    ble_addr_t addr;
+    addr.value = (bits & BLE_ADDR_BITS_MASK) | ((uint64_t)type << 48);
+    return addr;
+}
+
+static inline uint64_t ble_addr_bits(ble_addr_t addr) {
+    return addr.value & BLE_ADDR_BITS_MASK;
+}
+
+static inline ble_addr_type_t ble_addr_type(ble_addr_t addr) {
+    return (ble_addr_type_t)((addr.value >> 48) & 1);
+}
+
+static inline bool ble_addr_equal(ble_addr_t a, ble_addr_t b) {
+    return a.value == b.value;
+}
+
+static inline int ble_addr_cmp(ble_addr_t a, ble_addr_t b) {
+    return (a.value > b.value) - (a.value < b.value);
+}
+
+/* Well-mixed 64-bit hash (murmur3 finalizer); low bits are safe to mask */
+static inline uint64_t ble_addr_hash(ble_addr_t addr) {
+    uint64_t h = addr.value;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/*
+ * Parses "AA:BB:CC:DD:EE:FF" (either case) as a public address. The 17
+ * characters are decoded without data-dependent branches.
+ */
+bool ble_addr_parse(const char *str, ble_addr_t *out);
+
+/* Same as ble_addr_parse for a buffer of exactly 17 characters (no NUL needed) */
+bool ble_addr_parse17(const char *chars, ble_addr_t *out);
+
+/* Writes the uppercase colon-separated form; out must hold BLE_ADDR_SIZE bytes */
+void ble_addr_format(ble_addr_t addr, char *out);
+
+/*
+ * Batch forms. valid[i] (may be NULL) is set to 1/0 per input; out[i] is
+ * zero for invalid inputs. Return the number of valid inputs.
+ */
+size_t ble_addr_parse_batch(const char *const *strs, size_t n,
+                            ble_addr_t *out, uint8_t *valid);
+size_t ble_addr_validate_batch(const char *const *strs, size_t n, uint8_t *valid);
+/* Parses n fixed-width records: record i starts at base + i * stride */
+size_t ble_addr_parse_strided(const char *base, size_t stride, size_t n,
+                              ble_addr_t *out, uint8_t *valid);
+/* out points at n consecutive BLE_ADDR_SIZE-byte buffers */
+void ble_addr_format_batch(const ble_addr_t *addrs, size_t n, char *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
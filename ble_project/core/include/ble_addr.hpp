@@ -0,0 +1,34 @@
+#ifndef BLE_ADDR_HPP
+#define BLE_ADDR_HPP
+
+#include "ble_addr.h"
+
+#include <array>
+#include <functional>
+
+constexpr bool operator==(ble_addr_t a, ble_addr_t b) { return a.value == b.value; }
+constexpr bool operator!=(ble_addr_t a, ble_addr_t b) { return a.value != b.value; }
+constexpr bool operator<(ble_addr_t a, ble_addr_t b) { return a.value < b.value; }
+
+namespace std {
+
+template <>
+struct hash<ble_addr_t> {
+    size_t operator()(ble_addr_t addr) const noexcept {
+        return (size_t)ble_addr_hash(addr);
+    }
+};
+
+}  // namespace std
+
+namespace ble {
+
+inline std::array<char, BLE_ADDR_SIZE> to_string(ble_addr_t addr) {
+    std::array<char, BLE_ADDR_SIZE> out;
+    ble_addr_format(addr, out.data());
+    return out;
+}
+
+}  // namespace ble
+
+#endif
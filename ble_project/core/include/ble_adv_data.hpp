@@ -0,0 +1,175 @@
+#ifndef BLE_ADV_DATA_HPP
+#define BLE_ADV_DATA_HPP
+
+#include "ble_addr.hpp"
+#include "ble_uuid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ble {
+
+/// AD types (Assigned Numbers, Common Data Types) with dedicated extractors.
+enum AdType : uint8_t {
+    kAdFlags = 0x01,
+    kAdUuid16Incomplete = 0x02,
+    kAdUuid16Complete = 0x03,
+    kAdUuid32Incomplete = 0x04,
+    kAdUuid32Complete = 0x05,
+    kAdUuid128Incomplete = 0x06,
+    kAdUuid128Complete = 0x07,
+    kAdNameShort = 0x08,
+    kAdNameComplete = 0x09,
+    kAdTxPower = 0x0A,
+    kAdServiceData16 = 0x16,
+    kAdAppearance = 0x19,
+    kAdServiceData32 = 0x20,
+    kAdServiceData128 = 0x21,
+    kAdManufacturerData = 0xFF,
+};
+
+/// Longest legacy advertising or scan response payload
+constexpr size_t kAdLegacyMax = 31;
+/// Longest advertising payload (extended advertising data)
+constexpr size_t kAdMaxPayload = 1650;
+/// AD structures indexed per payload; a legacy 31-byte payload holds at most 15
+constexpr size_t kAdMaxFields = 64;
+
+/// Non-owning byte range.
+struct ByteView {
+    const uint8_t* data;
+    size_t len;
+};
+
+/// One AD structure, located inside the parsed payload.
+struct AdField {
+    uint8_t type;
+    uint16_t offset;            ///< First data byte (after the type), from the payload start
+    uint16_t len;               ///< Data bytes, excluding length and type
+};
+
+/**
+ * @brief Zero-copy view of an advertising or scan response payload.
+ *
+ * parse() walks the length-type-value structures once and records where
+ * each one starts; nothing is copied, so the payload must outlive the
+ * view. The extractors read the caller's bytes in place. A bitmap of the
+ * types present makes lookups of absent types a single test.
+ *
+ * Parsing stops at a zero length octet (the rest is padding), at a
+ * structure that runs past the end, or after kAdMaxFields structures. The
+ * last two make valid() false but keep the structures before them.
+ */
+class AdData {
+public:
+    AdData() = default;
+    AdData(const uint8_t* payload, size_t len) { parse(payload, len); }
+
+    bool parse(const uint8_t* payload, size_t len);
+
+    bool valid() const { return valid_; }
+    size_t size() const { return count_; }
+    const AdField& field(size_t i) const { return fields_[i]; }
+    ByteView view(const AdField& field) const { return ByteView{payload_ + field.offset, field.len}; }
+
+    bool has(uint8_t type) const {
+        return type_bit(type) ? may_have(type) : find(type) != nullptr;
+    }
+    /// First structure of @p type, or nullptr.
+    const AdField* find(uint8_t type) const;
+
+    bool flags(uint8_t* out) const;
+    bool tx_power(int8_t* dbm) const;
+    bool appearance(uint16_t* out) const;
+    /// Complete name if present, else the shortened one; {nullptr, 0} if neither.
+    ByteView local_name(bool* complete = nullptr) const;
+    /// First Manufacturer Specific Data structure; @p data excludes the company ID.
+    bool manufacturer_data(uint16_t* company_id, ByteView* data) const;
+
+    /// Writes up to @p max service UUIDs from all 16/32/128-bit lists; returns the total.
+    size_t service_uuids(ble_uuid_t* out, size_t max) const;
+    /// Searches the UUID lists in place, without converting them.
+    bool has_service(const ble_uuid_t& uuid) const;
+    /// Service Data for @p uuid; @p data excludes the UUID.
+    bool service_data(const ble_uuid_t& uuid, ByteView* data) const;
+
+    /// Calls fn(const ble_uuid_t&, ByteView) for every Service Data structure.
+    template <typename Fn>
+    void for_each_service_data(Fn&& fn) const {
+        for (size_t i = 0; i < count_; i++) {
+            ble_uuid_t uuid;
+            ByteView data;
+            if (split_service_data(fields_[i], &uuid, &data)) fn(uuid, data);
+        }
+    }
+
+private:
+    // Types 64 and up (0xFF, manufacturer data, among them) share bit 0 with
+    // the reserved type 0x00, so a set bit 0 has to be confirmed by a scan
+    static unsigned type_bit(uint8_t type) { return type < 64 ? type : 0; }
+    /// False only if no structure of @p type is present.
+    bool may_have(uint8_t type) const { return (present_ >> type_bit(type)) & 1; }
+
+    bool split_service_data(const AdField& field, ble_uuid_t* uuid, ByteView* data) const;
+
+    const uint8_t* payload_ = nullptr;
+    uint64_t present_ = 0;
+    uint8_t count_ = 0;
+    bool valid_ = false;
+    AdField fields_[kAdMaxFields];
+};
+
+/// 64-bit hash of an advertising payload, for change detection.
+uint64_t ad_hash(const uint8_t* payload, size_t len) noexcept;
+
+struct AdvertCacheStats {
+    uint64_t seen;              ///< Payloads checked
+    uint64_t changed;           ///< New devices plus payloads that differed
+};
+
+/**
+ * @brief Remembers the hash of each device's last advertising and scan
+ * response payload, so unchanged adverts can skip parsing.
+ *
+ * Beacons repeat the same payload many times a second; update() costs a
+ * hash of the payload and one probe of an open-addressing table, and
+ * returns true only when the device is new or the payload differs from
+ * the previous one of the same kind. Advertising and scan response
+ * payloads are tracked separately, since active scanning alternates
+ * between them. Not thread-safe; use one per consumer thread.
+ *
+ *     if (cache.update(addr, false, data, len)) {
+ *         AdData ad(data, len);
+ *         ...
+ *     }
+ */
+class AdvertCache {
+public:
+    explicit AdvertCache(size_t initial_capacity = 1024);
+
+    bool update(ble_addr_t addr, bool scan_response, const uint8_t* payload, size_t len);
+    void forget(ble_addr_t addr);
+
+    size_t size() const { return size_; }
+    AdvertCacheStats stats() const { return stats_; }
+
+private:
+    struct Entry {
+        ble_addr_t addr;
+        uint64_t hash[2];       ///< 0 until a payload of that kind is seen
+    };
+
+    size_t probe(ble_addr_t addr) const;
+    void rehash(size_t new_capacity);
+
+    std::vector<Entry> entries_;
+    std::vector<uint8_t> used_;
+    size_t mask_;
+    size_t size_ = 0;
+    AdvertCacheStats stats_ = {};
+};
+
+}  // namespace ble
+
+#endif
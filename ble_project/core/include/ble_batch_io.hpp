@@ -0,0 +1,117 @@
+#ifndef BLE_BATCH_IO_HPP
+#define BLE_BATCH_IO_HPP
+
+#include <gattlib.h>
+
+#include "ble_connection_manager.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ble {
+
+enum class GattOpType {
+    Read,
+    Write,                  ///< Write Request, waits for the response
+    WriteWithoutResponse,   ///< Write Command
+};
+
+/**
+ * @brief One read or write in a batch.
+ *
+ * Characteristics are addressed by UUID, or by value handle when @c handle
+ * is non-zero. gattlib has no read-by-handle call, so handle-addressed
+ * reads need their UUID filled in by resolve() first.
+ */
+struct GattOp {
+    gattlib_connection_t* connection;
+    GattOpType type;
+    uuid_t uuid;
+    uint16_t handle;
+    std::vector<uint8_t> data;  ///< Write payload
+
+    static GattOp read(gattlib_connection_t* connection, const uuid_t& uuid);
+    static GattOp read(gattlib_connection_t* connection, uint16_t handle);
+    static GattOp write(gattlib_connection_t* connection, const uuid_t& uuid,
+                        const void* data, size_t len, bool with_response = true);
+    static GattOp write(gattlib_connection_t* connection, uint16_t handle,
+                        const void* data, size_t len, bool with_response = true);
+};
+
+/// Fills in the UUID of a handle-addressed op (and vice versa) from a discovered table.
+bool resolve(const GattTable& table, GattOp* op);
+
+struct GattResult {
+    int error;                          ///< GATTLIB_* code
+    std::vector<uint8_t> value;         ///< Read value
+    std::chrono::nanoseconds latency;   ///< Request issued -> response received
+};
+
+struct BatchResult {
+    std::vector<GattResult> results;    ///< Same order as the ops
+    std::chrono::nanoseconds elapsed;   ///< Wall time of the whole batch
+    size_t failed;
+};
+
+/**
+ * @brief Runs lists of GATT reads and writes as pipelined operations.
+ *
+ * A blocking gattlib call costs a full round trip through BlueZ and the
+ * link before the next one can start. BatchIo keeps up to @p depth
+ * requests outstanding per connection (and any number of connections in
+ * parallel), so BlueZ always has the next request queued when a response
+ * arrives. Results come back in op order with per-op latency.
+ *
+ * ATT Read Multiple would fold several reads into one PDU, but neither
+ * gattlib nor the BlueZ D-Bus API exposes it; pipelining is the closest
+ * equivalent available here. Ops on one connection may complete out of
+ * order, so a batch should not rely on a write landing before a later read
+ * of the same characteristic.
+ */
+class BatchIo {
+public:
+    /// @p threads bounds requests in flight overall, @p depth per connection.
+    explicit BatchIo(size_t threads = 8, size_t depth = 4);
+    ~BatchIo();
+
+    BatchIo(const BatchIo&) = delete;
+    BatchIo& operator=(const BatchIo&) = delete;
+
+    /// Runs @p ops and waits for all of them. Thread-safe.
+    BatchResult run(const std::vector<GattOp>& ops);
+
+private:
+    struct Batch {
+        const std::vector<GattOp>* ops;
+        std::vector<GattResult>* results;
+        size_t remaining;
+        std::condition_variable done;
+    };
+
+    struct Job {
+        Batch* batch;
+        size_t index;
+    };
+
+    void worker();
+    bool next_job(Job* out);
+    static GattResult execute(const GattOp& op);
+
+    size_t depth_;
+    std::mutex mutex_;
+    std::condition_variable jobs_ready_;
+    std::deque<Job> jobs_;
+    std::map<gattlib_connection_t*, size_t> in_flight_;
+    bool running_ = true;
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef BLE_BTSNOOP_HPP
+#define BLE_BTSNOOP_HPP
+
+#include "ble_addr.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ble {
+
+/// btsnoop datalink types (RFC 1761 plus the Bluetooth additions)
+enum BtsnoopDatalink : uint32_t {
+    kBtsnoopHciH1 = 1001,       ///< Unencapsulated HCI; the flags give the packet type
+    kBtsnoopHciH4 = 1002,       ///< HCI UART; the first byte gives the packet type
+    kBtsnoopMonitor = 2001,     ///< Linux btmon; the flags carry the monitor opcode
+};
+
+/// One capture record, pointing into the mapped file.
+struct BtsnoopRecord {
+    uint64_t timestamp_us;      ///< Microseconds since 1970-01-01 UTC
+    uint32_t flags;
+    uint32_t len;               ///< Included length
+    const uint8_t* data;
+};
+
+/// Records from begin (inclusive) to end (exclusive) file offsets.
+struct BtsnoopRange {
+    size_t begin;
+    size_t end;
+    uint64_t first_us;
+    uint64_t last_us;
+    size_t records;
+};
+
+/**
+ * @brief Memory-mapped btsnoop capture (btmon -w, Android HCI snoop log).
+ *
+ * open() maps the file read-only and walks the record headers once to
+ * count records and keep a sparse index (one offset and timestamp every
+ * kIndexStride records), which split() uses to cut the capture into time
+ * ranges of similar size. A record cut short at the end of the file, as
+ * in a capture that was still being written, ends the capture there.
+ * Records are read in place; nothing is copied.
+ */
+class BtsnoopFile {
+public:
+    static constexpr size_t kIndexStride = 4096;
+
+    BtsnoopFile() = default;
+    ~BtsnoopFile();
+
+    BtsnoopFile(const BtsnoopFile&) = delete;
+    BtsnoopFile& operator=(const BtsnoopFile&) = delete;
+
+    bool open(const char* path, std::string* error);
+    void close();
+
+    uint32_t datalink() const { return datalink_; }
+    size_t records() const { return records_; }
+    bool truncated() const { return truncated_; }
+
+    /// Reads the record at @p offset; returns the next offset, or 0 past the end.
+    size_t read(size_t offset, BtsnoopRecord* out) const;
+
+    /// The HCI event in @p record (starting at the event code), or nullptr.
+    const uint8_t* hci_event(const BtsnoopRecord& record, size_t* len) const;
+
+    BtsnoopRange all() const;
+    /// Up to @p parts consecutive ranges with similar record counts.
+    std::vector<BtsnoopRange> split(size_t parts) const;
+
+private:
+    struct IndexEntry {
+        size_t offset;
+        uint64_t timestamp_us;
+    };
+
+    const uint8_t* map_ = nullptr;
+    size_t size_ = 0;
+    size_t end_ = 0;            ///< Offset after the last complete record
+    uint32_t datalink_ = 0;
+    size_t records_ = 0;
+    uint64_t last_us_ = 0;
+    bool truncated_ = false;
+    std::vector<IndexEntry> index_;
+};
+
+/// One device entry of an LE (Extended) Advertising Report event.
+struct AdvReport {
+    uint64_t timestamp_us;
+    ble_addr_t address;
+    int8_t rssi;                ///< 127 when not available
+    bool scan_response;
+    bool extended;
+    uint16_t event_type;
+    uint8_t data_len;
+    const uint8_t* data;        ///< AD payload inside the event
+};
+
+/// Most reports one LE Advertising Report event can carry
+constexpr size_t kHciMaxAdvReports = 25;
+
+/**
+ * @brief Decodes the reports of an LE Advertising Report (0x3E/0x02) or
+ * LE Extended Advertising Report (0x3E/0x0D) event.
+ *
+ * @p event starts at the event code. Returns the number of reports
+ * written to @p out (at most @p max); 0 for other events and for events
+ * too short for what they announce.
+ */
+size_t hci_adv_reports(const uint8_t* event, size_t len, uint64_t timestamp_us,
+                       AdvReport* out, size_t max);
+
+struct ReplayOptions {
+    double speed = 0;           ///< 0: as fast as possible; otherwise capture time / speed
+    size_t threads = 1;         ///< Time ranges replayed in parallel, each paced from its own start
+};
+
+struct ReplayStats {
+    uint64_t records;
+    uint64_t events;            ///< Advertising report events
+    uint64_t reports;
+    double seconds;             ///< Wall time
+};
+
+/// Called with the range index (0 .. threads-1) and each report, in capture order per range.
+using AdvReportFn = std::function<void(size_t shard, const AdvReport& report)>;
+
+/**
+ * @brief Streams the capture's advertising reports to @p fn.
+ *
+ * With threads > 1 the capture is split by time into that many ranges,
+ * each replayed on its own thread and passed its index, so every shard
+ * can feed its own pipeline. Blocks until all ranges are done.
+ */
+ReplayStats replay_adv_reports(const BtsnoopFile& file, const ReplayOptions& options,
+                               const AdvReportFn& fn);
+
+}  // namespace ble
+
+#endif
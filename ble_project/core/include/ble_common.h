@@ -3,13 +3,20 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "ble_addr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 #define BLE_UUID_SIZE 37
-#define BLE_ADDR_SIZE 18
+
+/* RSSI value reported when the controller did not provide one (HCI: 127) */
+#define BLE_RSSI_UNKNOWN 127
 
 typedef struct {
-    char address[BLE_ADDR_SIZE];
-    char name[256];
+    ble_addr_t address;
+    const char *name;   /* interned, never freed while the owning table lives; NULL if unknown */
     int16_t rssi;
 } ble_device_t;
 
@@ -17,4 +24,8 @@ const char* ble_uuid_to_name(const char* uuid);
 bool ble_is_valid_address(const char* address);
 void ble_print_device(const ble_device_t* device);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
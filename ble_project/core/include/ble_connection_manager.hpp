@@ -0,0 +1,199 @@
+#ifndef BLE_CONNECTION_MANAGER_HPP
+#define BLE_CONNECTION_MANAGER_HPP
+
+#include <gattlib.h>
+
+#include "ble_addr.hpp"
+#include "ble_discovery_cache.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ble {
+
+/// Per-device connection state.
+enum class LinkState {
+    Idle,           ///< Waiting for a connection slot
+    Connecting,
+    Discovering,    ///< Discovery and the on_setup hook
+    Ready,
+    Backoff,        ///< Waiting before the next attempt
+    Failed,         ///< Gave up: max_attempts reached, or dropped with reconnect off
+};
+
+const char* to_string(LinkState state);
+
+struct ConnectionOptions {
+    size_t max_parallel = 4;                                ///< Links connecting or discovering at once
+    std::chrono::milliseconds connect_timeout{10000};
+    std::chrono::milliseconds discovery_timeout{15000};
+    std::chrono::milliseconds backoff_initial{500};
+    std::chrono::milliseconds backoff_max{30000};
+    unsigned max_attempts = 0;                              ///< Consecutive failures before Failed; 0 = never
+    bool reconnect = true;                                  ///< Reconnect after a Ready link drops
+    bool discover = true;                                   ///< Run service/characteristic discovery
+    DiscoveryCache* cache = nullptr;                        ///< Reuse tables whose Database Hash matches
+};
+
+/// Attribute table found during discovery.
+struct GattTable {
+    std::vector<gattlib_primary_service_t> services;
+    std::vector<gattlib_characteristic_t> characteristics;
+};
+
+struct LinkStatus {
+    ble_addr_t address;
+    LinkState state;
+    gattlib_connection_t* connection;   ///< Valid while Discovering or Ready
+    unsigned failures;                  ///< Consecutive failed attempts
+    int last_error;                     ///< GATTLIB_* code of the last failure
+};
+
+/**
+ * @brief Keeps many peripherals connected through per-device state machines.
+ *
+ *   Idle -> Connecting -> Discovering -> Ready
+ *             |              |            |
+ *             +-> Backoff <--+------------+  (failure, timeout, disconnect)
+ *                    |
+ *                    +-> Idle, or Failed after max_attempts
+ *
+ * A scheduler thread owns all state. gattlib callbacks and discovery
+ * workers only post events to it, so transitions are serialized without
+ * holding a lock across gattlib calls. At most max_parallel links are
+ * Connecting or Discovering at once; retry delays double from
+ * backoff_initial up to backoff_max with random jitter, so a fleet that
+ * drops together does not reconnect in lockstep.
+ *
+ * Work that needs the connection before the link counts as Ready, such
+ * as subscribing to notifications, belongs in on_setup(): it runs on a
+ * discovery worker while the manager still holds the connection, so a
+ * timeout, remove() or stop() closes it only after the hook returns.
+ * on_state() runs on the scheduler thread and must not block.
+ *
+ * With a DiscoveryCache, Discovering first reads the peer's Database Hash
+ * and skips full discovery when a table with that hash is cached.
+ *
+ * gattlib cannot cancel a connect or discovery in progress. A result that
+ * arrives after its timeout is discarded and the connection closed.
+ * Because gattlib may still invoke callbacks for closed connections, the
+ * manager must outlive the gattlib main loop.
+ */
+class ConnectionManager {
+public:
+    using StateFn = std::function<void(const LinkStatus&)>;
+    /// Returns GATTLIB_SUCCESS, or an error that fails the attempt like a discovery error.
+    using SetupFn = std::function<int(ble_addr_t address, gattlib_connection_t* connection)>;
+
+    explicit ConnectionManager(gattlib_adapter_t* adapter, ConnectionOptions options = {});
+    ~ConnectionManager();
+
+    ConnectionManager(const ConnectionManager&) = delete;
+    ConnectionManager& operator=(const ConnectionManager&) = delete;
+
+    /// Called on the scheduler thread after every state change. Set before start().
+    void on_state(StateFn fn) { on_state_ = std::move(fn); }
+    /**
+     * Called on a discovery worker after discovery (or right after the
+     * connect with discover off) on every connection, before the link
+     * becomes Ready. Counts against discovery_timeout. Set before start().
+     */
+    void on_setup(SetupFn fn) { on_setup_ = std::move(fn); }
+
+    /**
+     * Adds a device; returns a future resolved the first time it becomes
+     * Ready or Failed (or is removed), or an invalid future if @p mac is
+     * malformed. Adding a known device returns its existing future.
+     */
+    std::shared_future<LinkStatus> add(const char* mac);
+    /// Disconnects and forgets a device.
+    bool remove(ble_addr_t address);
+
+    void start();
+    /// Stops scheduling and disconnects every link.
+    void stop();
+
+    std::vector<LinkStatus> snapshot() const;
+    /// Copies the attribute table of a Ready device.
+    bool table(ble_addr_t address, GattTable* out) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Link {
+        std::string mac;
+        LinkStatus status;
+        Clock::time_point deadline;
+        Clock::time_point connect_started;
+        GattTable table;
+        std::promise<LinkStatus> promise;
+        std::shared_future<LinkStatus> future;
+        bool settled = false;
+        bool removed = false;
+    };
+
+    enum class EventType { Connected, Disconnected, Discovered };
+
+    struct Event {
+        EventType type;
+        ble_addr_t address;
+        gattlib_connection_t* connection;
+        int error;
+        GattTable table;
+    };
+
+    struct Actions {
+        std::vector<std::pair<ble_addr_t, std::string>> connect;
+        std::vector<gattlib_connection_t*> disconnect;
+        std::vector<LinkStatus> notify;
+    };
+
+    static void on_connect(gattlib_adapter_t* adapter, const char* dst,
+                           gattlib_connection_t* connection, int error, void* user_data);
+    static void on_disconnect(gattlib_connection_t* connection, void* user_data);
+
+    void run();
+    void discovery_worker();
+    bool has_workers() const { return options_.discover || on_setup_; }
+    int discover(ble_addr_t address, gattlib_connection_t* connection, GattTable* table);
+
+    void handle(Event& event, Actions* actions);
+    void check_deadlines(Clock::time_point now, Actions* actions);
+    void schedule_connects(Clock::time_point now, Actions* actions);
+    void transition(Link& link, LinkState state, Actions* actions);
+    void fail(Link& link, int error, bool close_connection, Actions* actions);
+    Clock::duration backoff_delay(unsigned failures);
+    Link* find_by_connection(gattlib_connection_t* connection);
+
+    gattlib_adapter_t* adapter_;
+    ConnectionOptions options_;
+    StateFn on_state_;
+    SetupFn on_setup_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable jobs_ready_;
+    std::map<uint64_t, Link> links_;
+    std::deque<Event> events_;
+    std::deque<std::pair<ble_addr_t, gattlib_connection_t*>> jobs_;
+    std::vector<gattlib_connection_t*> abandoned_;   ///< Timed out while a worker still uses them
+    size_t connects_outstanding_ = 0;               ///< gattlib_connect calls without a callback yet
+    bool running_ = false;
+    bool wake_pending_ = false;
+    uint64_t rng_state_;
+
+    std::thread scheduler_;
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,417 @@
+#ifndef BLE_CORO_HPP
+#define BLE_CORO_HPP
+
+#if __cplusplus < 202002L
+#error "ble_coro.hpp needs C++20; link the ble_coro target"
+#endif
+
+#include <gattlib.h>
+#include <glib.h>
+
+#include "ble_connection_manager.hpp"
+#include "ble_handler_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace ble {
+
+class CoroRuntime;
+
+/// Not a gattlib code: the operation's CancelToken fired first.
+constexpr int kGattCancelled = -1;
+
+// =============================================================================
+// Task
+// =============================================================================
+
+namespace detail {
+
+void task_finished(CoroRuntime* runtime);
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;   ///< Awaiting coroutine, if any
+    CoroRuntime* detached = nullptr;        ///< Set by CoroRuntime::spawn()
+    std::exception_ptr exception;
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> self) noexcept {
+            PromiseBase& promise = self.promise();
+            if (promise.continuation) return promise.continuation;
+            // Spawned: nobody will read the result, so the frame frees itself
+            CoroRuntime* runtime = promise.detached;
+            bool failed = promise.exception != nullptr;
+            self.destroy();
+            if (failed) std::terminate();
+            if (runtime) task_finished(runtime);
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+}  // namespace detail
+
+/**
+ * @brief Lazily started coroutine returning @p T.
+ *
+ * Runs when awaited (the awaiting coroutine resumes when it returns) or
+ * when handed to CoroRuntime::spawn(). Exceptions propagate to the
+ * awaiter; one escaping a spawned task terminates the program.
+ */
+template <typename T = void>
+class Task {
+public:
+    struct promise_type : detail::PromiseBase {
+        std::optional<T> value;
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        template <typename U>
+        void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~Task() { if (handle_) handle_.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        handle_.promise().continuation = caller;
+        return handle_;
+    }
+    T await_resume() {
+        promise_type& promise = handle_.promise();
+        if (promise.exception) std::rethrow_exception(promise.exception);
+        return std::move(*promise.value);
+    }
+
+private:
+    friend class CoroRuntime;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    std::coroutine_handle<promise_type> release() { return std::exchange(handle_, nullptr); }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <>
+class Task<void> {
+public:
+    struct promise_type : detail::PromiseBase {
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        void return_void() {}
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~Task() { if (handle_) handle_.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        handle_.promise().continuation = caller;
+        return handle_;
+    }
+    void await_resume() {
+        if (handle_.promise().exception) std::rethrow_exception(handle_.promise().exception);
+    }
+
+private:
+    friend class CoroRuntime;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    std::coroutine_handle<promise_type> release() { return std::exchange(handle_, nullptr); }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// =============================================================================
+// Cancellation
+// =============================================================================
+
+/**
+ * @brief Cancels the operations it was passed to.
+ *
+ * Copies share one state. Cancelling completes every operation waiting
+ * with the token with kGattCancelled, and any later one at once. Used on
+ * the runtime's context only.
+ */
+class CancelToken {
+public:
+    CancelToken() = default;
+
+    /// A token that can be cancelled (a default-constructed one never is).
+    static CancelToken make();
+
+    void cancel();
+    bool cancelled() const { return state_ && state_->cancelled; }
+
+private:
+    friend class CoroRuntime;
+
+    struct State {
+        bool cancelled = false;
+        uint64_t next_id = 1;
+        std::map<uint64_t, std::function<void()>> callbacks;
+    };
+
+    uint64_t subscribe(std::function<void()> callback) const;
+    void unsubscribe(uint64_t id) const;
+
+    std::shared_ptr<State> state_;
+};
+
+// =============================================================================
+// Runtime
+// =============================================================================
+
+struct CoroOptions {
+    unsigned blocking_threads = 4;                      ///< Threads for blocking gattlib calls
+    size_t queue_depth = 4096;                          ///< Blocking calls queued or running
+    std::chrono::milliseconds connect_timeout{10000};
+    std::chrono::milliseconds gatt_timeout{5000};       ///< Read, write, discovery, subscribe
+    size_t notification_queue = 64;                     ///< Per connection; the oldest is dropped
+};
+
+/**
+ * Per-call timeout (0: the CoroOptions default) and cancellation. Plain
+ * data on purpose: GCC 12 destroys a braced temporary inside a co_await
+ * expression twice, so `co_await rt.read(c, uuid, {timeout, &token})`
+ * must not own anything.
+ */
+struct AwaitOptions {
+    std::chrono::milliseconds timeout{0};
+    const CancelToken* cancel = nullptr;    ///< Read when the call is made
+};
+
+template <typename T>
+struct Result {
+    int error = GATTLIB_SUCCESS;    ///< GATTLIB_* code, or kGattCancelled
+    T value{};
+
+    bool ok() const { return error == GATTLIB_SUCCESS; }
+};
+
+struct Notification {
+    uuid_t uuid;
+    std::vector<uint8_t> data;
+    uint64_t received_ns;       ///< monotonic_ns() when gattlib delivered it
+};
+
+/**
+ * @brief Runs coroutines that talk to many peripherals from one GLib
+ * main context.
+ *
+ *     ble::Task<> session(ble::CoroRuntime& rt, const char* address) {
+ *         auto link = co_await rt.connect(address);
+ *         if (!link.ok()) co_return;
+ *         auto level = co_await rt.read(link.value, battery_level);
+ *         co_await rt.subscribe(link.value, battery_level);
+ *         for (;;) {
+ *             auto n = co_await rt.notification(link.value, {std::chrono::seconds(5)});
+ *             if (!n.ok()) break;
+ *         }
+ *         co_await rt.disconnect(link.value);
+ *     }
+ *
+ * Every coroutine resumes on the context, so session code needs no
+ * locks, and a waiting session costs its coroutine frame rather than a
+ * thread. gattlib callbacks (connect, notification, link loss) arrive on
+ * gattlib's own thread and are posted to the context. Reads, writes,
+ * discovery, subscribing and disconnecting are blocking calls in gattlib;
+ * they run on a small HandlerPool, in order per connection, and hold a
+ * pool thread only for the round trip, so blocking_threads bounds ATT
+ * requests in flight, not sessions.
+ *
+ * Every operation completes exactly once: with its result, with
+ * GATTLIB_TIMEOUT when its timeout passes, or with kGattCancelled. gattlib
+ * cannot abort a call already made, so an abandoned read still finishes
+ * on its pool thread and its result is dropped; a connection that
+ * completes after its connect gave up is closed.
+ *
+ * Member functions are for the context's thread, except post() and
+ * spawn(). Disconnect every connection before destroying the runtime:
+ * gattlib keeps the runtime as callback data.
+ */
+class CoroRuntime {
+public:
+    /// @p context defaults to the calling thread's default context.
+    CoroRuntime(gattlib_adapter_t* adapter, const CoroOptions& options = CoroOptions(),
+                GMainContext* context = nullptr);
+    ~CoroRuntime();
+
+    CoroRuntime(const CoroRuntime&) = delete;
+    CoroRuntime& operator=(const CoroRuntime&) = delete;
+
+    /// Thread-safe. Starts @p task on the context; it frees itself when done.
+    void spawn(Task<void> task);
+    /// Spawned tasks not yet finished.
+    size_t active() const { return active_.load(std::memory_order_acquire); }
+    /// Iterates the context until every spawned task has finished.
+    void run();
+
+    /// Thread-safe. Runs @p fn on the context.
+    void post(std::function<void()> fn);
+
+    GMainContext* context() const { return context_; }
+    gattlib_adapter_t* adapter() const { return adapter_; }
+
+private:
+    struct OpBase;
+    template <typename T> struct OpState;
+    struct Link;
+    struct ConnectRequest;
+
+public:
+    /// Completes an operation; what co_await on one of the calls below returns.
+    template <typename T>
+    class Op {
+    public:
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> waiter) noexcept;
+        Result<T> await_resume();
+
+    private:
+        friend class CoroRuntime;
+        explicit Op(std::shared_ptr<OpState<T>> state) : state_(std::move(state)) {}
+        std::shared_ptr<OpState<T>> state_;
+    };
+
+    struct Empty {};
+
+    Op<gattlib_connection_t*> connect(const char* address, const AwaitOptions& options = {});
+    Op<Empty> disconnect(gattlib_connection_t* connection);
+    Op<GattTable> discover(gattlib_connection_t* connection, const AwaitOptions& options = {});
+    Op<std::vector<uint8_t>> read(gattlib_connection_t* connection, const uuid_t& uuid,
+                                  const AwaitOptions& options = {});
+    /// @p data is copied before this returns.
+    Op<Empty> write(gattlib_connection_t* connection, const uuid_t& uuid, const void* data,
+                    size_t len, bool with_response = true, const AwaitOptions& options = {});
+    /// Enables notifications for @p uuid; they queue for notification().
+    Op<Empty> subscribe(gattlib_connection_t* connection, const uuid_t& uuid,
+                        const AwaitOptions& options = {});
+    /**
+     * The next notification from @p connection, in arrival order.
+     * Completes with GATTLIB_DEVICE_DISCONNECTED once the link is gone and
+     * the queue is empty; waits without a timeout unless one is given.
+     */
+    Op<Notification> notification(gattlib_connection_t* connection, const AwaitOptions& options = {});
+    /// Completes after @p delay (never with GATTLIB_TIMEOUT).
+    Op<Empty> sleep(std::chrono::milliseconds delay, const CancelToken* cancel = nullptr);
+
+    /// Notifications dropped for @p connection because its queue was full.
+    uint64_t dropped(gattlib_connection_t* connection);
+
+private:
+    friend void detail::task_finished(CoroRuntime* runtime);
+
+    template <typename T>
+    std::shared_ptr<OpState<T>> make_op(std::chrono::milliseconds timeout,
+                                        const CancelToken* cancel);
+    template <typename T, typename Call>
+    Op<T> offload(gattlib_connection_t* connection, const AwaitOptions& options, Call call);
+
+    void arm(const std::shared_ptr<OpBase>& op, std::chrono::milliseconds timeout,
+             const CancelToken* cancel);
+    Link* find_link(gattlib_connection_t* connection);
+    Link* attach_link(gattlib_connection_t* connection);
+    void mark_down(Link* link);
+    void pump(Link* link);
+
+    static gboolean on_posted(gpointer user_data);
+    static gboolean on_timeout(gpointer user_data);
+    static void on_connected(gattlib_adapter_t* adapter, const char* dst,
+                             gattlib_connection_t* connection, int error, void* user_data);
+    static void on_notification(const uuid_t* uuid, const uint8_t* data, size_t len,
+                                void* user_data);
+    static void on_link_lost(gattlib_connection_t* connection, void* user_data);
+
+    gattlib_adapter_t* adapter_;
+    CoroOptions options_;
+    GMainContext* context_;
+    HandlerPool pool_;
+    std::atomic<size_t> active_{0};
+
+    std::mutex post_mutex_;
+    std::vector<std::function<void()>> posted_;
+    GSource* post_source_ = nullptr;    ///< Attached while posted_ is non-empty
+
+    std::mutex links_mutex_;
+    std::map<gattlib_connection_t*, std::unique_ptr<Link>> links_;  ///< Kept for the runtime's life
+};
+
+// =============================================================================
+// Implementation details
+// =============================================================================
+
+/// Shared by the awaiting coroutine, its timer and any blocking call in flight.
+struct CoroRuntime::OpBase {
+    CoroRuntime* runtime;
+    std::coroutine_handle<> waiter;
+    bool done = false;
+    int error = GATTLIB_SUCCESS;
+    int timeout_error = GATTLIB_TIMEOUT;    ///< What the timer completes with
+    GSource* timer = nullptr;
+    CancelToken cancel;
+    uint64_t cancel_id = 0;
+
+    virtual ~OpBase() = default;
+    /// Context thread. False if already done; otherwise resumes the waiter via post().
+    bool finish(int result);
+};
+
+template <typename T>
+struct CoroRuntime::OpState : CoroRuntime::OpBase {
+    T value{};
+};
+
+template <typename T>
+bool CoroRuntime::Op<T>::await_ready() const noexcept {
+    return state_->done;
+}
+
+template <typename T>
+void CoroRuntime::Op<T>::await_suspend(std::coroutine_handle<> waiter) noexcept {
+    state_->waiter = waiter;
+}
+
+template <typename T>
+Result<T> CoroRuntime::Op<T>::await_resume() {
+    return Result<T>{state_->error, std::move(state_->value)};
+}
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef BLE_DBUS_H
+#define BLE_DBUS_H
+
+#include <gio/gio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Bus and adapter selection for the D-Bus side of the project. Everything
+ * defaults to the system bus and /org/bluez/hci0; both can be redirected
+ * so the peripherals run against mock_bluez on a private bus.
+ */
+
+/* Bus address used when none is passed explicitly */
+#define BLE_DBUS_ADDRESS_ENV "BLE_DBUS_ADDRESS"
+
+/* Adapter name ("hci1") or object path ("/org/bluez/hci1") */
+#define BLE_DBUS_ADAPTER_ENV "BLE_ADAPTER"
+
+/*
+ * Opens a new message bus connection to address, or to $BLE_DBUS_ADDRESS
+ * when address is NULL, or to the system bus when neither is set. Each
+ * call returns a separate connection; release it with g_object_unref().
+ */
+GDBusConnection *ble_dbus_connect(const char *address, GError **error);
+
+/* Adapter object path from $BLE_ADAPTER, "/org/bluez/hci0" by default */
+const char *ble_dbus_adapter_path(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,335 @@
+#ifndef BLE_DBUS_SCHEMA_HPP
+#define BLE_DBUS_SCHEMA_HPP
+
+#include <gio/gio.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ble {
+
+/// Most arguments a schema method or signal can declare in each direction
+constexpr size_t kSchemaMaxArgs = 4;
+
+/// Argument signatures, one complete type each; unused slots are nullptr.
+using SchemaArgs = std::array<const char*, kSchemaMaxArgs>;
+
+struct MethodSchema {
+    const char* name;
+    SchemaArgs in = {};
+    SchemaArgs out = {};
+};
+
+struct PropertySchema {
+    const char* name;
+    const char* signature;
+    GDBusPropertyInfoFlags flags = G_DBUS_PROPERTY_INFO_FLAGS_READABLE;
+};
+
+struct SignalSchema {
+    const char* name;
+    SchemaArgs args = {};
+};
+
+/**
+ * @brief A D-Bus interface declared as a constexpr value.
+ *
+ *     static constexpr ble::InterfaceSchema<1, 2> kAdvertSchema = {
+ *         "org.bluez.LEAdvertisement1",
+ *         {{{"Release"}}},
+ *         {{{"Type", "s"}, {"LocalName", "s"}}},
+ *     };
+ *     using Advert = ble::DBusInterface<kAdvertSchema>;
+ */
+template <size_t Methods, size_t Properties, size_t Signals = 0>
+struct InterfaceSchema {
+    const char* name;
+    std::array<MethodSchema, Methods> methods = {};
+    std::array<PropertySchema, Properties> properties = {};
+    std::array<SignalSchema, Signals> signals = {};
+};
+
+namespace schema_detail {
+
+// gperf-style key: the length and the first, middle and last characters
+constexpr uint32_t name_key(const char* s, size_t len) {
+    if (!len) return 0;
+    return (uint32_t)len ^ (uint32_t)(uint8_t)s[0] << 8 ^ (uint32_t)(uint8_t)s[len / 2] << 16 ^
+           (uint32_t)(uint8_t)s[len - 1] << 24;
+}
+
+constexpr size_t slot_bits(size_t n) {
+    size_t bits = 1;
+    while (((size_t)1 << bits) < 2 * n) bits++;
+    return bits;
+}
+
+constexpr size_t arg_count(const SchemaArgs& args) {
+    size_t n = 0;
+    while (n < args.size() && args[n]) n++;
+    return n;
+}
+
+constexpr const char* kArgNames[2 * kSchemaMaxArgs] = {
+    "arg_0", "arg_1", "arg_2", "arg_3", "arg_4", "arg_5", "arg_6", "arg_7",
+};
+
+}  // namespace schema_detail
+
+/**
+ * @brief Perfect hash over a fixed set of names, built at compile time.
+ *
+ * Names are keyed by their length and first, middle and last characters,
+ * and the constructor searches for a multiplier under which every key
+ * lands in its own slot of a table twice the size of the set. Names with
+ * the same key fail to compile. find() is then a strlen(), one table load
+ * and one memcmp(), however many names there are.
+ */
+template <size_t N>
+class NameIndex {
+public:
+    static constexpr size_t kBits = schema_detail::slot_bits(N);
+    static constexpr size_t kSlots = (size_t)1 << kBits;
+
+    constexpr explicit NameIndex(const std::array<const char*, N>& names)
+        : names_(names), lengths_{}, slots_{}, multiplier_(0) {
+        for (size_t i = 0; i < N; i++) lengths_[i] = __builtin_strlen(names_[i]);
+        for (uint32_t m = 0x9E3779B1u; m != 0x9E3779B1u + 2 * 65536; m += 2) {
+            if (try_multiplier(m)) {
+                multiplier_ = m;
+                return;
+            }
+        }
+        throw "NameIndex: names with the same key";
+    }
+
+    /// Index of @p name in the constructor's array, or -1.
+    constexpr int find(const char* name) const {
+        if (N == 0 || !name) return -1;
+        size_t len = __builtin_strlen(name);
+        int i = slots_[slot(schema_detail::name_key(name, len), multiplier_)];
+        return i >= 0 && lengths_[i] == len && __builtin_memcmp(names_[i], name, len) == 0 ? i : -1;
+    }
+
+    /// Like find(), but a name that is not in the set fails to compile.
+    constexpr int id(const char* name) const {
+        return find(name) >= 0 ? find(name) : throw "NameIndex: unknown name";
+    }
+
+    constexpr size_t size() const { return N; }
+    constexpr const char* name(size_t i) const { return names_[i]; }
+
+private:
+    static constexpr size_t slot(uint32_t hash, uint32_t multiplier) {
+        return (uint32_t)(hash * multiplier) >> (32 - kBits);
+    }
+
+    constexpr bool try_multiplier(uint32_t m) {
+        for (size_t s = 0; s < kSlots; s++) slots_[s] = -1;
+        for (size_t i = 0; i < N; i++) {
+            int16_t& s = slots_[slot(schema_detail::name_key(names_[i], lengths_[i]), m)];
+            if (s >= 0) return false;
+            s = (int16_t)i;
+        }
+        return true;
+    }
+
+    std::array<const char*, N> names_;
+    std::array<size_t, N> lengths_;
+    std::array<int16_t, kSlots> slots_;
+    uint32_t multiplier_;
+};
+
+template <size_t N>
+constexpr NameIndex<N> make_name_index(const std::array<const char*, N>& names) {
+    return NameIndex<N>(names);
+}
+
+namespace schema_detail {
+
+template <typename Schema>
+constexpr size_t total_args(const Schema& s) {
+    size_t n = 0;
+    for (const MethodSchema& m : s.methods) n += arg_count(m.in) + arg_count(m.out);
+    for (const SignalSchema& g : s.signals) n += arg_count(g.args);
+    return n;
+}
+
+// Args in declaration order: each method's in then out args, then each signal's
+template <const auto& S>
+struct Args {
+    static constexpr size_t kCount = total_args(S);
+
+    static constexpr std::array<GDBusArgInfo, kCount> build() {
+        std::array<GDBusArgInfo, kCount> out{};
+        size_t k = 0;
+        auto add = [&](const SchemaArgs& args, size_t first) {
+            for (size_t i = 0; i < arg_count(args); i++) {
+                out[k++] = GDBusArgInfo{-1, const_cast<gchar*>(kArgNames[first + i]),
+                                        const_cast<gchar*>(args[i]), nullptr};
+            }
+        };
+        for (const MethodSchema& m : S.methods) {
+            add(m.in, 0);
+            add(m.out, arg_count(m.in));
+        }
+        for (const SignalSchema& g : S.signals) add(g.args, 0);
+        return out;
+    }
+
+    static constexpr std::array<GDBusArgInfo, kCount> info = build();
+};
+
+// NULL-terminated pointer lists into Args: per method in then out, then per signal
+template <const auto& S>
+struct ArgLists {
+    static constexpr size_t kCount = Args<S>::kCount + 2 * S.methods.size() + S.signals.size();
+
+    static constexpr std::array<GDBusArgInfo*, kCount> build() {
+        std::array<GDBusArgInfo*, kCount> out{};
+        size_t k = 0, arg = 0;
+        auto add = [&](const SchemaArgs& args) {
+            for (size_t i = 0; i < arg_count(args); i++) {
+                out[k++] = const_cast<GDBusArgInfo*>(&Args<S>::info[arg++]);
+            }
+            out[k++] = nullptr;
+        };
+        for (const MethodSchema& m : S.methods) {
+            add(m.in);
+            add(m.out);
+        }
+        for (const SignalSchema& g : S.signals) add(g.args);
+        return out;
+    }
+
+    static constexpr std::array<GDBusArgInfo*, kCount> lists = build();
+
+    static constexpr GDBusArgInfo** at(size_t offset) {
+        return const_cast<GDBusArgInfo**>(lists.data() + offset);
+    }
+};
+
+template <const auto& S>
+struct Members {
+    static constexpr size_t kMethods = S.methods.size();
+    static constexpr size_t kProperties = S.properties.size();
+    static constexpr size_t kSignals = S.signals.size();
+
+    static constexpr std::array<GDBusMethodInfo, kMethods> build_methods() {
+        std::array<GDBusMethodInfo, kMethods> out{};
+        size_t offset = 0;
+        for (size_t i = 0; i < kMethods; i++) {
+            const MethodSchema& m = S.methods[i];
+            GDBusArgInfo** in = ArgLists<S>::at(offset);
+            offset += arg_count(m.in) + 1;
+            GDBusArgInfo** out_args = ArgLists<S>::at(offset);
+            offset += arg_count(m.out) + 1;
+            out[i] = GDBusMethodInfo{-1, const_cast<gchar*>(m.name), in, out_args, nullptr};
+        }
+        return out;
+    }
+
+    static constexpr std::array<GDBusSignalInfo, kSignals> build_signals() {
+        std::array<GDBusSignalInfo, kSignals> out{};
+        size_t offset = 0;
+        for (const MethodSchema& m : S.methods) offset += arg_count(m.in) + arg_count(m.out) + 2;
+        for (size_t i = 0; i < kSignals; i++) {
+            const SignalSchema& g = S.signals[i];
+            out[i] = GDBusSignalInfo{-1, const_cast<gchar*>(g.name), ArgLists<S>::at(offset),
+                                     nullptr};
+            offset += arg_count(g.args) + 1;
+        }
+        return out;
+    }
+
+    static constexpr std::array<GDBusPropertyInfo, kProperties> build_properties() {
+        std::array<GDBusPropertyInfo, kProperties> out{};
+        for (size_t i = 0; i < kProperties; i++) {
+            const PropertySchema& p = S.properties[i];
+            out[i] = GDBusPropertyInfo{-1, const_cast<gchar*>(p.name),
+                                       const_cast<gchar*>(p.signature), p.flags, nullptr};
+        }
+        return out;
+    }
+
+    static constexpr std::array<GDBusMethodInfo, kMethods> methods = build_methods();
+    static constexpr std::array<GDBusSignalInfo, kSignals> signals = build_signals();
+    static constexpr std::array<GDBusPropertyInfo, kProperties> properties = build_properties();
+};
+
+template <typename T, size_t N>
+constexpr std::array<T*, N + 1> pointers_to(const std::array<T, N>& items) {
+    std::array<T*, N + 1> out{};
+    for (size_t i = 0; i < N; i++) out[i] = const_cast<T*>(&items[i]);
+    return out;
+}
+
+template <typename T, size_t N>
+constexpr std::array<const char*, N> names_of(const std::array<T, N>& items) {
+    std::array<const char*, N> out{};
+    for (size_t i = 0; i < N; i++) out[i] = items[i].name;
+    return out;
+}
+
+template <const auto& S>
+struct Lists {
+    static constexpr auto methods = pointers_to(Members<S>::methods);
+    static constexpr auto signals = pointers_to(Members<S>::signals);
+    static constexpr auto properties = pointers_to(Members<S>::properties);
+};
+
+}  // namespace schema_detail
+
+/**
+ * @brief Introspection data and member dispatch generated from a schema.
+ *
+ * info() is a static GDBusInterfaceInfo (reference count -1, as
+ * gdbus-codegen emits) laid out at compile time, so registering an
+ * object parses no XML and allocates nothing. GDBus rejects calls to
+ * members the interface does not declare, so handlers only need to tell
+ * declared members apart: find_method() and find_property() map a name
+ * to its declaration index through a NameIndex, and method() and
+ * property() give the same index as a constant for case labels,
+ * rejecting misspelled names at compile time.
+ *
+ *     switch (Advert::find_property(property_name)) {
+ *     case Advert::property("Type"): return g_variant_new_string("peripheral");
+ *     case Advert::property("LocalName"): ...
+ *     }
+ */
+template <const auto& S>
+class DBusInterface {
+public:
+    static constexpr size_t kMethods = S.methods.size();
+    static constexpr size_t kProperties = S.properties.size();
+
+    static GDBusInterfaceInfo* info() { return const_cast<GDBusInterfaceInfo*>(&kInfo); }
+    static constexpr const char* name() { return S.name; }
+
+    static constexpr int find_method(const char* name) { return kMethodIndex.find(name); }
+    static constexpr int find_property(const char* name) { return kPropertyIndex.find(name); }
+    static constexpr int method(const char* name) { return kMethodIndex.id(name); }
+    static constexpr int property(const char* name) { return kPropertyIndex.id(name); }
+
+    static constexpr const char* method_name(size_t i) { return S.methods[i].name; }
+    static constexpr const char* property_name(size_t i) { return S.properties[i].name; }
+
+private:
+    using Lists = schema_detail::Lists<S>;
+
+    static constexpr GDBusInterfaceInfo kInfo = {
+        -1,
+        const_cast<gchar*>(S.name),
+        const_cast<GDBusMethodInfo**>(Lists::methods.data()),
+        const_cast<GDBusSignalInfo**>(Lists::signals.data()),
+        const_cast<GDBusPropertyInfo**>(Lists::properties.data()),
+        nullptr,
+    };
+    static constexpr auto kMethodIndex = make_name_index(schema_detail::names_of(S.methods));
+    static constexpr auto kPropertyIndex = make_name_index(schema_detail::names_of(S.properties));
+};
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef BLE_DEVICE_TABLE_HPP
+#define BLE_DEVICE_TABLE_HPP
+
+#include "ble_addr.hpp"
+#include "ble_adv_data.hpp"
+#include "ble_common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ble {
+
+/**
+ * @brief Append-only string interner.
+ *
+ * Returned pointers stay valid for the lifetime of the pool, so they can be
+ * stored directly in ble_device_t::name. Not thread-safe.
+ */
+class NamePool {
+public:
+    NamePool();
+
+    /// Returns the canonical copy of @p name (first @p len bytes).
+    const char* intern(const char* name, size_t len);
+
+    size_t size() const { return count_; }
+    size_t bytes_used() const { return bytes_used_; }
+
+private:
+    struct Slot {
+        uint64_t hash;
+        const char* str;
+        uint32_t len;
+    };
+
+    char* allocate(size_t n);
+    void grow();
+
+    std::vector<Slot> slots_;
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    size_t chunk_used_;
+    size_t count_ = 0;
+    size_t bytes_used_ = 0;
+};
+
+/// One row of the device table.
+struct DeviceEntry {
+    ble_device_t device;        ///< device.address is the table key
+    uint64_t first_seen_ns;
+    uint64_t last_seen_ns;
+    uint32_t seen_count;
+    uint32_t changed_epoch;     ///< Epoch of the last insert or field change
+    uint32_t created_epoch;
+    uint8_t ad_len;             ///< Last advertising payload (not scan response); 0 if none
+    uint8_t ad[kAdLegacyMax];   ///< Longer extended payloads are truncated
+};
+
+/**
+ * @brief Open-addressing (linear probing) table of devices keyed by address.
+ *
+ * Designed for a single consumer thread folding a high-rate stream of
+ * repeated sightings: the hot path is one hash, a short probe and an
+ * in-place update. Every mutation is stamped with the current epoch so
+ * callers can emit diffs by bumping the epoch between reports.
+ */
+class DeviceTable {
+public:
+    explicit DeviceTable(size_t initial_capacity = 1024);
+
+    /// Updates or inserts the device; returns the entry and whether it is new.
+    DeviceEntry* upsert(ble_addr_t addr, uint64_t now_ns, bool* inserted);
+    const DeviceEntry* find(ble_addr_t addr) const;
+
+    size_t size() const { return size_; }
+    uint32_t epoch() const { return epoch_; }
+    /// Starts a new epoch; entries touched afterwards report changed_epoch == epoch().
+    uint32_t advance_epoch() { return ++epoch_; }
+
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (size_t i = 0; i < entries_.size(); i++) {
+            if (used_[i]) fn(entries_[i]);
+        }
+    }
+
+    /**
+     * Removes every device last seen before @p before_ns, calling
+     * fn(const DeviceEntry&) on each just before it goes. Returns how many
+     * were removed. Capacity is kept for the next wave of addresses.
+     */
+    template <typename Fn>
+    size_t expire(uint64_t before_ns, Fn&& fn) {
+        size_t n = 0;
+        for (size_t i = 0; i < entries_.size();) {
+            if (used_[i] && entries_[i].last_seen_ns < before_ns) {
+                fn(entries_[i]);
+                remove_at(i);   // may shift a later entry into i; look again
+                n++;
+            } else {
+                i++;
+            }
+        }
+        return n;
+    }
+
+private:
+    size_t probe(ble_addr_t addr) const;
+    void remove_at(size_t i);
+    void rehash(size_t new_capacity);
+
+    std::vector<DeviceEntry> entries_;
+    std::vector<uint8_t> used_;
+    size_t mask_;
+    size_t size_ = 0;
+    uint32_t epoch_ = 1;
+};
+
+}  // namespace ble
+
+#endif
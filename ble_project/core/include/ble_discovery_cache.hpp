@@ -0,0 +1,133 @@
+#ifndef BLE_DISCOVERY_CACHE_HPP
+#define BLE_DISCOVERY_CACHE_HPP
+
+#include "ble_addr.hpp"
+#include "ble_uuid.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ble {
+
+/// Database Hash characteristic (GATT 5.1, Vol 3 Part G 7.3).
+constexpr uint16_t kDatabaseHashUuid = 0x2B2A;
+
+using DatabaseHash = std::array<uint8_t, 16>;
+
+/// On-disk service record; the file stores these verbatim.
+struct CachedService {
+    ble_uuid_t uuid;
+    uint16_t start_handle;
+    uint16_t end_handle;
+};
+
+/// On-disk characteristic record.
+struct CachedCharacteristic {
+    ble_uuid_t uuid;
+    uint16_t handle;
+    uint16_t value_handle;
+    uint8_t properties;
+};
+
+static_assert(sizeof(CachedService) == 24, "CachedService layout is part of the file format");
+static_assert(sizeof(CachedCharacteristic) == 24, "CachedCharacteristic layout is part of the file format");
+
+/**
+ * @brief Read-only view of one device's cached attribute table.
+ *
+ * Points straight into the mapped file; valid for as long as the
+ * shared_ptr returned by DiscoveryCache::lookup() is held, even if the
+ * entry is replaced in the meantime.
+ */
+class CachedTable {
+public:
+    ~CachedTable();
+
+    CachedTable(const CachedTable&) = delete;
+    CachedTable& operator=(const CachedTable&) = delete;
+
+    ble_addr_t address() const;
+    const DatabaseHash& hash() const;
+
+    const CachedService* services() const { return services_; }
+    size_t service_count() const { return service_count_; }
+    const CachedCharacteristic* characteristics() const { return chars_; }
+    size_t characteristic_count() const { return char_count_; }
+
+private:
+    friend class DiscoveryCache;
+    CachedTable() = default;
+
+    void* map_ = nullptr;
+    size_t map_len_ = 0;
+    const CachedService* services_ = nullptr;
+    size_t service_count_ = 0;
+    const CachedCharacteristic* chars_ = nullptr;
+    size_t char_count_ = 0;
+};
+
+struct DiscoveryCacheStats {
+    uint64_t hits;              ///< lookup() found a table with a matching hash
+    uint64_t misses;            ///< No file, or the device's database changed
+    uint64_t stores;
+};
+
+/**
+ * @brief Persistent GATT discovery results, keyed by address and Database Hash.
+ *
+ * Each device's table lives in its own file, `<dir>/<address>.gdc`: a
+ * fixed header followed by arrays of CachedService and
+ * CachedCharacteristic. Files are mmap()ed and used in place, so a hit costs
+ * one hash compare and no parsing. Mappings stay open across lookups; a
+ * device that reconnects repeatedly is served from memory.
+ *
+ * The Database Hash changes whenever the server's attribute table does, so
+ * a matching hash means the cached handles are still valid. Devices without
+ * the characteristic cannot be validated and should not be cached.
+ *
+ * store() writes a temporary file and renames it over the old one, so
+ * readers in this or another process never see a partial table. All
+ * methods are thread-safe.
+ */
+class DiscoveryCache {
+public:
+    /// @p directory must exist; it is not created.
+    explicit DiscoveryCache(std::string directory);
+
+    DiscoveryCache(const DiscoveryCache&) = delete;
+    DiscoveryCache& operator=(const DiscoveryCache&) = delete;
+
+    /// Cached table for @p address if its hash equals @p hash, else nullptr.
+    std::shared_ptr<const CachedTable> lookup(ble_addr_t address, const DatabaseHash& hash);
+
+    bool store(ble_addr_t address, const DatabaseHash& hash,
+               const CachedService* services, size_t service_count,
+               const CachedCharacteristic* chars, size_t char_count);
+
+    /// Drops the in-memory mapping and deletes the file.
+    void invalidate(ble_addr_t address);
+
+    DiscoveryCacheStats stats() const;
+
+private:
+    std::string path_for(ble_addr_t address) const;
+    std::shared_ptr<const CachedTable> map_file(const std::string& path);
+
+    std::string directory_;
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, std::shared_ptr<const CachedTable>> tables_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> stores_{0};
+};
+
+}  // namespace ble
+
+#endif
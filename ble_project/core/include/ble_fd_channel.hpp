@@ -0,0 +1,122 @@
+#ifndef BLE_FD_CHANNEL_HPP
+#define BLE_FD_CHANNEL_HPP
+
+#include <gio/gio.h>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ble {
+
+/// ATT opcode + handle preceding a notification or write payload.
+constexpr size_t kAttHeaderLen = 3;
+/// Default ATT MTU when BlueZ does not pass one.
+constexpr uint16_t kAttDefaultMtu = 23;
+
+struct FdChannelStats {
+    uint64_t rx_packets;
+    uint64_t rx_batches;        ///< recvmmsg calls that returned data
+    uint64_t tx_packets;
+    uint64_t tx_batches;        ///< sendmmsg calls that sent data
+    uint64_t tx_rejected;       ///< Payloads over the MTU or with a full queue
+    uint64_t tx_dropped;        ///< Queued payloads discarded when a send failed
+};
+
+/**
+ * @brief SOCK_SEQPACKET data path handed out by AcquireWrite/AcquireNotify.
+ *
+ * Each datagram on the socket is one ATT payload. Incoming packets are read
+ * in batches of up to kBatch with recvmmsg(); outgoing payloads are queued
+ * and written in one sendmmsg() per flush. Payloads larger than
+ * mtu - kAttHeaderLen are rejected rather than truncated.
+ *
+ * The channel is driven either by attach() (a GSource on a GMainContext)
+ * or by calling receive()/flush() directly, e.g. against a socketpair.
+ * Handlers must not destroy the channel from on_rx; on_close may.
+ */
+class FdChannel {
+public:
+    static constexpr size_t kBatch = 32;
+
+    using RxHandler = std::function<void(const uint8_t* data, size_t len)>;
+    using CloseHandler = std::function<void()>;
+
+    /// Takes ownership of @p fd (made non-blocking).
+    FdChannel(int fd, uint16_t mtu);
+    ~FdChannel();
+
+    FdChannel(const FdChannel&) = delete;
+    FdChannel& operator=(const FdChannel&) = delete;
+
+    /// Creates a connected SOCK_SEQPACKET pair; @p remote_fd is the peer end.
+    static std::unique_ptr<FdChannel> socketpair(uint16_t mtu, int* remote_fd);
+
+    /**
+     * Answers an AcquireWrite/AcquireNotify(a{sv}) call with "(hq)": the
+     * peer end of a new socketpair and the MTU from the "mtu" option.
+     * Returns nullptr after replying with an error.
+     */
+    static std::unique_ptr<FdChannel> acquire(GDBusMethodInvocation* invocation,
+                                              GVariant* parameters);
+
+    /// @p on_rx sees each received packet; @p on_close runs on HUP/error.
+    void set_handlers(RxHandler on_rx, CloseHandler on_close = nullptr);
+
+    /// Services the fd from a GSource on @p context (nullptr: default context).
+    void attach(GMainContext* context);
+    void detach();
+
+    /// Reads one batch and dispatches it; returns the number of packets.
+    size_t receive();
+
+    /// Queues a payload; a full queue is flushed first.
+    bool queue(const void* data, size_t len);
+    /// Writes queued payloads; returns the number sent. A send error other
+    /// than EAGAIN drops the queue and closes the channel.
+    size_t flush();
+    bool send(const void* data, size_t len) { return queue(data, len) && flush() > 0; }
+
+    int fd() const { return fd_; }
+    uint16_t mtu() const { return mtu_; }
+    size_t max_payload() const { return mtu_ - kAttHeaderLen; }
+    size_t pending() const { return tx_count_; }
+    bool is_open() const { return fd_ >= 0; }
+    FdChannelStats stats() const { return stats_; }
+
+private:
+    static gboolean on_fd_ready(gint fd, GIOCondition condition, gpointer user_data);
+    static gboolean on_fd_writable(gint fd, GIOCondition condition, gpointer user_data);
+    void close_fd();
+    void arm_out_watch();
+    uint8_t* tx_slot(size_t i) { return tx_buf_.data() + i * mtu_; }
+
+    int fd_;
+    uint16_t mtu_;
+
+    std::vector<uint8_t> rx_buf_;
+    struct iovec rx_iov_[kBatch];
+    struct mmsghdr rx_msgs_[kBatch];
+
+    std::vector<uint8_t> tx_buf_;
+    struct iovec tx_iov_[kBatch];
+    struct mmsghdr tx_msgs_[kBatch];
+    size_t tx_count_ = 0;
+
+    GMainContext* context_ = nullptr;
+    GSource* watch_ = nullptr;
+    GSource* out_watch_ = nullptr;
+    RxHandler on_rx_;
+    CloseHandler on_close_;
+
+    FdChannelStats stats_ = {};
+};
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef BLE_GATT_DATABASE_HPP
+#define BLE_GATT_DATABASE_HPP
+
+#include <gio/gio.h>
+
+#include "ble_dbus_schema.hpp"
+#include "ble_handler_pool.hpp"
+#include "ble_uuid.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ble {
+
+inline constexpr InterfaceSchema<1, 0, 2> kObjectManagerSchema = {
+    "org.freedesktop.DBus.ObjectManager",
+    {{{"GetManagedObjects", {}, {"a{oa{sa{sv}}}"}}}},
+    {},
+    {{{"InterfacesAdded", {"o", "a{sa{sv}}"}}, {"InterfacesRemoved", {"o", "as"}}}},
+};
+
+inline constexpr InterfaceSchema<0, 3> kGattServiceSchema = {
+    "org.bluez.GattService1",
+    {},
+    {{{"UUID", "s"}, {"Primary", "b"}, {"Characteristics", "ao"}}},
+};
+
+inline constexpr InterfaceSchema<6, 8> kGattCharacteristicSchema = {
+    "org.bluez.GattCharacteristic1",
+    {{
+        {"ReadValue", {"a{sv}"}, {"ay"}},
+        {"WriteValue", {"ay", "a{sv}"}},
+        {"AcquireWrite", {"a{sv}"}, {"h", "q"}},
+        {"AcquireNotify", {"a{sv}"}, {"h", "q"}},
+        {"StartNotify"},
+        {"StopNotify"},
+    }},
+    {{
+        {"UUID", "s"}, {"Service", "o"}, {"Flags", "as"}, {"Descriptors", "ao"},
+        {"Value", "ay"}, {"Notifying", "b"}, {"WriteAcquired", "b"}, {"NotifyAcquired", "b"},
+    }},
+};
+
+inline constexpr InterfaceSchema<2, 3> kGattDescriptorSchema = {
+    "org.bluez.GattDescriptor1",
+    {{{"ReadValue", {"a{sv}"}, {"ay"}}, {"WriteValue", {"ay", "a{sv}"}}}},
+    {{{"UUID", "s"}, {"Characteristic", "o"}, {"Flags", "as"}}},
+};
+
+using ObjectManagerInterface = DBusInterface<kObjectManagerSchema>;
+using GattServiceInterface = DBusInterface<kGattServiceSchema>;
+/// For dispatch in characteristic handlers: `case GattCharacteristicInterface::method("ReadValue"):`
+using GattCharacteristicInterface = DBusInterface<kGattCharacteristicSchema>;
+using GattDescriptorInterface = DBusInterface<kGattDescriptorSchema>;
+
+/**
+ * @brief Declarative GATT database exported to BlueZ over D-Bus.
+ *
+ * Services, characteristics and descriptors are declared once; the database
+ * derives object paths, org.bluez.Gatt*1 properties and the
+ * ObjectManager.GetManagedObjects reply from those declarations.
+ *
+ * Each object caches its own `{oa{sa{sv}}}` entry and the full reply is
+ * assembled from those entries. A mutation drops only the touched objects'
+ * entries (plus the parent whose child list changed) and the assembled
+ * reply, so re-querying an unchanged database costs a reference bump.
+ *
+ * The interfaces come from the constexpr schemas above: registration
+ * parses no XML, and properties are stored in schema order, so a
+ * property get is a NameIndex lookup rather than a search by name. Only
+ * properties the schema declares can be set.
+ *
+ * With a HandlerPool set, ReadValue and WriteValue handlers run on its
+ * workers, one call at a time per characteristic or descriptor, and reply
+ * from there; the connection's thread only queues them. Those handlers
+ * must then be thread-safe and must not touch the database. The other
+ * methods (AcquireWrite, StartNotify, ...) set properties and attach
+ * sources, so they stay on the connection's thread.
+ */
+class GattDatabase {
+public:
+    /// Method handler for characteristics and descriptors (GDBus vtable signature).
+    using MethodHandler = GDBusInterfaceMethodCallFunc;
+
+    explicit GattDatabase(const char* app_path);
+    ~GattDatabase();
+
+    GattDatabase(const GattDatabase&) = delete;
+    GattDatabase& operator=(const GattDatabase&) = delete;
+
+    /// Declares a service; returns its object path.
+    std::string add_service(const ble_uuid_t& uuid, bool primary = true);
+
+    /// Declares a characteristic under @p service_path; returns its object path.
+    std::string add_characteristic(const std::string& service_path, const ble_uuid_t& uuid,
+                                   std::vector<std::string> flags,
+                                   MethodHandler handler = nullptr, gpointer user_data = nullptr);
+
+    /// Declares a descriptor under @p char_path; returns its object path.
+    std::string add_descriptor(const std::string& char_path, const ble_uuid_t& uuid,
+                               std::vector<std::string> flags,
+                               MethodHandler handler = nullptr, gpointer user_data = nullptr);
+
+    /// Removes an object and everything below it.
+    bool remove(const std::string& path);
+
+    /// Sets or replaces a declared property; takes ownership of a floating @p value.
+    bool set_property(const std::string& path, const char* name, GVariant* value);
+
+    /**
+     * Emits PropertiesChanged for @p name without storing @p value (takes
+     * ownership of a floating value). Used for transient properties such as
+     * a notified characteristic Value; does not invalidate the cache.
+     */
+    bool emit_changed(const std::string& path, const char* name, GVariant* value);
+
+    /// Property value (borrowed), or nullptr when the object or property is unknown.
+    GVariant* property(const std::string& path, const char* name) const;
+
+    /// The "(a{oa{sa{sv}}})" reply (borrowed; valid until the next mutation).
+    GVariant* managed_objects();
+
+    /**
+     * Dispatches ReadValue/WriteValue to @p pool (nullptr: inline). When the
+     * pool is saturated the call fails at once with org.bluez.Error.InProgress.
+     * Stop the pool before freeing the handlers' user data.
+     */
+    void set_handler_pool(HandlerPool* pool) { pool_ = pool; }
+
+    /// Exports the ObjectManager and all declared objects on @p conn.
+    bool register_objects(GDBusConnection* conn, GError** error);
+    void unregister_objects();
+
+    const std::string& app_path() const { return app_path_; }
+    size_t object_count() const { return objects_.size(); }
+    /// Number of per-object entries serialized so far (cache misses).
+    size_t entry_builds() const { return entry_builds_; }
+
+private:
+    enum class Kind { Service, Characteristic, Descriptor };
+
+    struct Object {
+        GattDatabase* db;
+        Kind kind;
+        std::string path;
+        Object* parent;
+        std::vector<Object*> children;
+        std::vector<GVariant*> props;   ///< By schema index; nullptr when unset
+        MethodHandler handler;
+        gpointer user_data;
+        GVariant* entry;            ///< Cached {oa{sa{sv}}}, nullptr when stale
+        guint registration_id;
+        unsigned next_child_index;
+    };
+
+    Object* find(const std::string& path) const;
+    Object* add_object(Kind kind, Object* parent, std::string path, const ble_uuid_t& uuid,
+                       std::vector<std::string> flags, MethodHandler handler, gpointer user_data);
+    bool set_prop(Object* obj, const char* name, GVariant* value);
+    void refresh_child_list(Object* obj);
+    void emit_child_list(Object* obj);
+    static const char* child_list_name(const Object* obj);
+    void invalidate(Object* obj);
+    GVariant* entry_for(Object* obj);
+    GVariant* interfaces_for(Object* obj) const;
+    void remove_subtree(Object* obj, std::vector<std::string>* removed);
+
+    void publish(Object* obj);
+    bool export_object(Object* obj, GError** error);
+    void emit_added(Object* obj);
+    void emit_removed(const std::string& path, Kind kind);
+
+    static const char* interface_name(Kind kind);
+    static GDBusInterfaceInfo* interface_info(Kind kind);
+    static size_t property_count(Kind kind);
+    static int find_property(Kind kind, const char* name);
+    static const char* property_name(Kind kind, size_t index);
+
+    static void handle_object_manager_call(GDBusConnection*, const gchar*, const gchar*,
+                                           const gchar*, const gchar*, GVariant*,
+                                           GDBusMethodInvocation*, gpointer);
+    static void handle_object_call(GDBusConnection*, const gchar*, const gchar*,
+                                   const gchar*, const gchar*, GVariant*,
+                                   GDBusMethodInvocation*, gpointer);
+    static GVariant* handle_get_property(GDBusConnection*, const gchar*, const gchar*,
+                                         const gchar*, const gchar*, GError**, gpointer);
+
+    std::string app_path_;
+    std::map<std::string, std::unique_ptr<Object>> objects_;
+    std::vector<Object*> services_;
+    unsigned next_service_index_ = 0;
+
+    GVariant* reply_ = nullptr;
+    size_t entry_builds_ = 0;
+
+    GDBusConnection* connection_ = nullptr;
+    guint manager_registration_id_ = 0;
+    HandlerPool* pool_ = nullptr;
+};
+
+}  // namespace ble
+
+#endif
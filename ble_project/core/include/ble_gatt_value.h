@@ -0,0 +1,36 @@
+#ifndef BLE_GATT_VALUE_H
+#define BLE_GATT_VALUE_H
+
+#include <gio/gio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest attribute value allowed by the Core spec (Vol 3, Part F, 3.2.9) */
+#define BLE_GATT_MAX_VALUE_LEN 512
+
+/*
+ * Characteristic values are kept as immutable, refcounted GBytes. These
+ * helpers move them in and out of the GattCharacteristic1 method
+ * signatures without touching individual bytes.
+ */
+
+/* ReadValue reply "(ay)" that references value instead of copying it */
+GVariant *ble_gatt_value_reply(GBytes *value);
+
+/* Same for value[offset:]; offsets past the end yield an empty array */
+GVariant *ble_gatt_value_reply_at(GBytes *value, gsize offset);
+
+/*
+ * Returns the "ay" argument of WriteValue(ay, a{sv}) as a GBytes sharing
+ * the message buffer. If options is non-NULL it receives a new reference
+ * to the options dict.
+ */
+GBytes *ble_gatt_value_from_write(GVariant *parameters, GVariant **options);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
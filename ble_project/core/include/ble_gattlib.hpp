@@ -0,0 +1,48 @@
+#ifndef BLE_GATTLIB_HPP
+#define BLE_GATTLIB_HPP
+
+// Conversions between gattlib types and ble_core types. Header-only so that
+// ble_core itself does not depend on gattlib.
+
+#include <gattlib.h>
+#include "ble_uuid.hpp"
+
+namespace ble {
+
+inline ble_uuid_t from_gattlib(const uuid_t& uuid) {
+    switch (uuid.type) {
+    case SDP_UUID16:
+        return uuid16(uuid.value.uuid16);
+    case SDP_UUID32:
+        return uuid32(uuid.value.uuid32);
+    default: {
+        ble_uuid_t out;
+        ble_uuid_from_bytes_be(uuid.value.uuid128.data, &out);
+        return out;
+    }
+    }
+}
+
+/// SIG 16-bit UUIDs become SDP_UUID16, as gattlib's own discovery reports them.
+inline uuid_t to_gattlib(const ble_uuid_t& uuid) {
+    uuid_t out{};
+    if (ble_uuid_is_sig(&uuid) && ble_uuid_sig_value(&uuid) <= 0xFFFF) {
+        out.type = SDP_UUID16;
+        out.value.uuid16 = (uint16_t)ble_uuid_sig_value(&uuid);
+        return out;
+    }
+    out.type = SDP_UUID128;
+    ble_uuid_to_bytes_be(&uuid, out.value.uuid128.data);
+    return out;
+}
+
+/// Registry name for a gattlib UUID, or nullptr when unknown.
+inline const char* gattlib_uuid_name(const uuid_t& uuid) {
+    ble_uuid_t u = from_gattlib(uuid);
+    const ble_uuid_info_t* info = ble_uuid_lookup(&u);
+    return info ? info->name : nullptr;
+}
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef BLE_HANDLER_POOL_HPP
+#define BLE_HANDLER_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ble {
+
+struct HandlerPoolOptions {
+    unsigned threads = 0;           ///< Worker threads; 0: one per CPU, at least 2
+    /**
+     * Tasks queued or running over all keys. submit() refuses more, so a
+     * caller can reject a request at once instead of letting a backlog of
+     * slow handlers grow without bound.
+     */
+    size_t queue_depth = 256;
+};
+
+struct HandlerPoolStats {
+    uint64_t submitted;             ///< Tasks accepted
+    uint64_t completed;             ///< Tasks run
+    uint64_t rejected;              ///< submit() calls refused (saturated or stopped)
+    size_t pending;                 ///< Tasks queued or running now
+};
+
+/**
+ * @brief Worker threads that run tasks in submission order per key.
+ *
+ * Tasks with the same key (a characteristic) form a serial queue: the next
+ * one starts only after the previous one has returned, on whichever worker
+ * is free. Different keys run in parallel, and a key that still has work
+ * goes to the back of the ready list after each task, so one busy key
+ * cannot starve the others.
+ *
+ * submit() is thread-safe and never blocks on a task.
+ */
+class HandlerPool {
+public:
+    using Task = std::function<void()>;
+
+    HandlerPool() = default;
+    ~HandlerPool();
+
+    HandlerPool(const HandlerPool&) = delete;
+    HandlerPool& operator=(const HandlerPool&) = delete;
+
+    bool start(const HandlerPoolOptions& options, std::string* error);
+
+    /// Runs every task already accepted, then joins the workers.
+    void stop();
+
+    /**
+     * Queues @p task behind earlier tasks for @p key. Returns false, without
+     * queueing, when queue_depth tasks are pending or the pool is not running.
+     */
+    bool submit(const void* key, Task task);
+
+    size_t threads() const { return workers_.size(); }
+    HandlerPoolStats stats() const;
+
+private:
+    /// Exists while its key has tasks; then it is on ready_ or held by a worker.
+    struct Strand {
+        std::deque<Task> tasks;     ///< Front is running or next
+    };
+
+    void run();
+
+    HandlerPoolOptions options_;
+    std::vector<std::thread> workers_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_cond_;
+    std::unordered_map<const void*, Strand> strands_;
+    std::deque<const void*> ready_;     ///< Keys with a task to start, FIFO
+    bool running_ = false;
+    size_t pending_ = 0;
+    uint64_t submitted_ = 0;
+    uint64_t completed_ = 0;
+    uint64_t rejected_ = 0;
+};
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef BLE_HEART_RATE_HPP
+#define BLE_HEART_RATE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ble {
+
+/// Heart Rate Measurement (0x2A37) flag bits.
+enum HrmFlags : uint8_t {
+    kHrmBpm16 = 0x01,               ///< Heart rate is uint16 (else uint8)
+    kHrmContactDetected = 0x02,
+    kHrmContactSupported = 0x04,
+    kHrmEnergyPresent = 0x08,       ///< uint16 Energy Expended in kJ follows
+    kHrmRrPresent = 0x10,           ///< uint16 RR intervals (1/1024 s) fill the rest
+};
+
+/// One decoded measurement; RR intervals are returned separately.
+struct HrmSample {
+    uint8_t flags;
+    uint16_t bpm;
+    uint16_t energy_kj;             ///< 0 unless kHrmEnergyPresent
+    uint16_t rr_count;
+};
+
+/// Decodes one payload (reference path). Writes up to @p rr_max RR intervals.
+bool hrm_decode(const uint8_t* data, size_t len, HrmSample* out,
+                uint16_t* rr, size_t rr_max);
+
+/**
+ * @brief Structure-of-arrays result of decoding many payloads at once.
+ *
+ * Buffers are sized once and reused across batches. RR intervals of
+ * payload i are rr[rr_begin[i] .. rr_begin[i] + rr_count[i]). By default
+ * rr_capacity allows 9 intervals per payload, the most a 20-byte payload
+ * can carry.
+ */
+struct HrmBatch {
+    explicit HrmBatch(size_t capacity, size_t rr_capacity = 0);
+
+    size_t capacity() const { return flags.size(); }
+
+    size_t size = 0;
+    size_t rr_size = 0;
+    std::vector<uint8_t> flags;
+    std::vector<uint8_t> valid;     ///< 0 for payloads too short for their flags
+    std::vector<uint16_t> bpm;
+    std::vector<uint16_t> energy_kj;
+    std::vector<uint16_t> rr_count;
+    std::vector<uint32_t> rr_begin;
+    std::vector<uint16_t> rr;
+
+    // Scratch for the decoder
+    std::vector<uint64_t> head;
+    std::vector<uint16_t> len;
+};
+
+/**
+ * @brief Decodes up to batch->capacity() payloads in three passes.
+ *
+ * The first pass copies the first eight bytes of each payload into a dense
+ * array. The second derives every fixed field (format, BPM, energy, RR
+ * offset and count) from those words with shifts and masks only, a
+ * branch-free loop over contiguous arrays that the compiler vectorizes.
+ * The third prefix-sums the RR counts and copies the intervals. Flag
+ * combinations cost the same, so mixed recordings do not mispredict.
+ *
+ * Returns the number of payloads decoded. RR intervals beyond the
+ * batch's rr capacity are dropped and rr_count reduced accordingly.
+ */
+size_t hrm_decode_batch(const uint8_t* const* payloads, const uint16_t* lens, size_t n,
+                        HrmBatch* batch);
+
+/**
+ * @brief Streaming heart rate statistics with fixed memory.
+ *
+ * Keeps a rolling mean over the last @p bpm_window samples and RMSSD (root
+ * mean square of successive RR differences, the standard short-term HRV
+ * measure) over the last @p rr_window intervals. Both windows are ring
+ * buffers allocated in the constructor, so add() never allocates.
+ */
+class HeartRateAggregator {
+public:
+    explicit HeartRateAggregator(size_t bpm_window = 10, size_t rr_window = 30);
+
+    void add_bpm(uint16_t bpm);
+    /// @p rr in 1/1024 s units, as in the measurement.
+    void add_rr(uint16_t rr);
+    /// Feeds every valid sample in @p batch. Samples older than the windows
+    /// are only counted, so the cost is bounded by the window sizes.
+    void add(const HrmBatch& batch);
+
+    double bpm() const;             ///< Rolling mean; 0 before the first sample
+    double rmssd_ms() const;        ///< 0 until two RR intervals have been seen
+    uint64_t samples() const { return samples_; }
+    uint64_t intervals() const { return intervals_; }
+
+private:
+    std::vector<uint16_t> bpm_ring_;
+    size_t bpm_pos_ = 0;
+    size_t bpm_fill_ = 0;
+    uint64_t bpm_sum_ = 0;
+
+    std::vector<uint64_t> diff_ring_;   ///< Squared successive differences
+    size_t diff_pos_ = 0;
+    size_t diff_fill_ = 0;
+    uint64_t diff_sum_ = 0;
+    uint16_t last_rr_ = 0;
+
+    uint64_t samples_ = 0;
+    uint64_t intervals_ = 0;
+};
+
+}  // namespace ble
+
+#endif
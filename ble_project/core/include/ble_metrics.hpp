@@ -0,0 +1,259 @@
+#ifndef BLE_METRICS_HPP
+#define BLE_METRICS_HPP
+
+#include <time.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Keeps this header free of GLib for the gattlib-side code
+typedef struct _GDBusConnection GDBusConnection;
+typedef struct _GError GError;
+
+namespace ble {
+
+/*
+ * Histograms bucket values HDR-style: exact below 16, then 16 linear
+ * sub-buckets per power of two, so any recorded value is within 6.25% of
+ * its bucket. Values at or above 2^kHistogramMaxBits land in the last bucket.
+ */
+constexpr unsigned kHistogramSubBits = 4;
+constexpr unsigned kHistogramMaxBits = 40;     ///< 2^40 ns is about 18 minutes
+constexpr unsigned kHistogramBuckets = (kHistogramMaxBits - kHistogramSubBits + 1) << kHistogramSubBits;
+constexpr size_t kMaxCounters = 256;
+constexpr size_t kMaxHistograms = 64;
+constexpr size_t kSpareShards = 32;            ///< Preallocated thread shards, about 2.5 KB each
+
+namespace detail {
+
+struct HistogramShard {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+    std::atomic<uint64_t> buckets[kHistogramBuckets] = {};
+};
+
+/// One per thread that records; only that thread writes to it.
+struct ThreadShard {
+    std::atomic<uint64_t> counters[kMaxCounters] = {};
+    std::atomic<HistogramShard*> histograms[kMaxHistograms] = {};
+};
+
+extern thread_local ThreadShard* tls_shard;
+ThreadShard& attach_thread();
+void detach_thread(ThreadShard* shard);
+HistogramShard& attach_histogram(ThreadShard& shard, uint32_t id);
+
+inline ThreadShard& local_shard() {
+    ThreadShard* shard = tls_shard;
+    return shard ? *shard : attach_thread();
+}
+
+// Single writer: a plain load + store, no locked instruction
+inline void add(std::atomic<uint64_t>& cell, uint64_t n) {
+    cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline unsigned bucket_index(uint64_t value) {
+    if (value < (1u << kHistogramSubBits)) return (unsigned)value;
+    unsigned exp = 63 - (unsigned)__builtin_clzll(value);
+    if (exp >= kHistogramMaxBits) return kHistogramBuckets - 1;
+    unsigned sub = (unsigned)(value >> (exp - kHistogramSubBits)) & ((1u << kHistogramSubBits) - 1);
+    return ((exp - kHistogramSubBits + 1) << kHistogramSubBits) + sub;
+}
+
+}  // namespace detail
+
+/// Largest value that falls into histogram bucket @p index.
+uint64_t histogram_bucket_upper(unsigned index);
+
+/**
+ * @brief Monotonic counter. Handles are cheap to copy; inc() touches only
+ * the calling thread's shard.
+ *
+ * A thread's first inc() takes one of kSpareShards preallocated shards
+ * with a single atomic increment, so it neither allocates nor locks. That
+ * makes counters safe in scan and notification callbacks, which record
+ * before the workers they feed do. Only once the spares are gone does a
+ * thread's first inc() allocate its shard and take the registry lock.
+ */
+class Counter {
+public:
+    Counter() = default;
+    void inc(uint64_t n = 1) const {
+        detail::add(detail::local_shard().counters[id_], n);
+    }
+
+private:
+    friend class Metrics;
+    explicit Counter(uint32_t id) : id_(id) {}
+    uint32_t id_ = 0;
+};
+
+/**
+ * @brief Latency histogram in nanoseconds, exported in seconds.
+ *
+ * record() updates the calling thread's shard; the first record on a
+ * thread allocates that thread's buckets (about 4.7 KB), so keep
+ * histograms out of callbacks that must not allocate.
+ */
+class Histogram {
+public:
+    Histogram() = default;
+    void record(uint64_t ns) const {
+        detail::ThreadShard& shard = detail::local_shard();
+        detail::HistogramShard* h = shard.histograms[id_].load(std::memory_order_relaxed);
+        if (!h) h = &detail::attach_histogram(shard, id_);
+        detail::add(h->buckets[detail::bucket_index(ns)], 1);
+        detail::add(h->count, 1);
+        detail::add(h->sum, ns);
+        if (ns > h->max.load(std::memory_order_relaxed)) h->max.store(ns, std::memory_order_relaxed);
+    }
+
+private:
+    friend class Metrics;
+    explicit Histogram(uint32_t id) : id_(id) {}
+    uint32_t id_ = 0;
+};
+
+struct CounterValue {
+    std::string name;
+    std::string labels;         ///< Prometheus label set without braces, e.g. method="ReadValue"
+    std::string help;
+    uint64_t value;
+};
+
+struct HistogramValue {
+    std::string name;
+    std::string labels;
+    std::string help;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    std::vector<uint64_t> buckets;  ///< kHistogramBuckets counts
+
+    /// Upper bound of the bucket holding quantile @p q (0..1); 0 when empty.
+    uint64_t percentile(double q) const;
+};
+
+struct MetricsSnapshot {
+    std::vector<CounterValue> counters;
+    std::vector<HistogramValue> histograms;
+};
+
+/**
+ * @brief Process-wide metric registry.
+ *
+ * Every recording thread owns a shard, so the hot path has no shared
+ * writes. Scrapes sum the shards of live threads plus the totals left by
+ * exited ones. Preallocated shards are never retired or reused; their
+ * totals stay where they are when the thread exits. Reads are relaxed, so a scrape racing a record can see a
+ * histogram's count one ahead of its buckets; totals are never lost.
+ *
+ * Registering an existing name and label set returns the same metric, so
+ * components can register in constructors. Registration takes a lock;
+ * keep the handle rather than registering per call.
+ */
+class Metrics {
+public:
+    static Metrics& global();
+
+    /// Returns a no-op metric (id 0 is reserved) once the limits are reached.
+    Counter counter(const char* name, const char* labels, const char* help);
+    Histogram histogram(const char* name, const char* labels, const char* help);
+
+    MetricsSnapshot snapshot() const;
+
+    /// Prometheus text exposition format 0.0.4.
+    std::string prometheus() const;
+
+private:
+    Metrics();
+    friend detail::ThreadShard& detail::attach_thread();
+    friend detail::HistogramShard& detail::attach_histogram(detail::ThreadShard&, uint32_t);
+    friend void detail::detach_thread(detail::ThreadShard*);
+
+    struct Info {
+        std::string name;
+        std::string labels;
+        std::string help;
+    };
+
+    void retire(detail::ThreadShard* shard);
+
+    mutable std::mutex mutex_;
+    std::vector<Info> counters_;
+    std::vector<Info> histograms_;
+    std::vector<detail::ThreadShard*> shards_;
+    detail::ThreadShard retired_;
+    std::unique_ptr<detail::ThreadShard[]> spare_;     ///< Also in shards_
+    std::atomic<size_t> spare_used_{0};
+};
+
+/// Records the time from construction to destruction.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const Histogram& histogram)
+        : histogram_(histogram), start_(now()) {}
+    ~ScopedTimer() { histogram_.record(now() - start_); }
+
+    static uint64_t now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    }
+
+private:
+    Histogram histogram_;
+    uint64_t start_;
+};
+
+/**
+ * @brief Serves Metrics::global() as Prometheus text over HTTP.
+ *
+ * Listens on "HOST:PORT" (TCP; use 127.0.0.1 to stay local) or
+ * "unix:PATH". One thread answers scrapes one at a time; the response is
+ * built outside the hot path, so recording threads never wait for it.
+ */
+class MetricsServer {
+public:
+    MetricsServer() = default;
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    bool start(const std::string& listen, std::string* error);
+    void stop();
+
+private:
+    void run();
+    void serve(int client);
+
+    int fd_ = -1;
+    std::string unix_path_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+/**
+ * @brief Exports Metrics::global() on @p conn as org.example.Stats at
+ * @p object_path:
+ *
+ *   GetCounters() -> a{st}             name{labels} -> value
+ *   GetHistograms() -> a{s(tttttt)}    count, sum, p50, p99, p999, max (ns)
+ *   GetPrometheus() -> s
+ *
+ * Returns the registration id (0 on error) for
+ * g_dbus_connection_unregister_object().
+ */
+unsigned metrics_register_dbus(GDBusConnection* conn, const char* object_path, GError** error);
+
+}  // namespace ble
+
+#endif
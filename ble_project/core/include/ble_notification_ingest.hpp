@@ -0,0 +1,168 @@
+#ifndef BLE_NOTIFICATION_INGEST_HPP
+#define BLE_NOTIFICATION_INGEST_HPP
+
+#include <gattlib.h>
+
+#include "ble_addr.hpp"
+#include "ble_uuid.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ble {
+
+/// Largest notification payload: ATT_MTU 247 (LE Data Length 251) minus the header.
+constexpr size_t kNotifyPayloadMax = 244;
+
+/// Fixed-size notification handed from the gattlib callback to a worker.
+struct NotificationRecord {
+    uint64_t timestamp_ns;      ///< CLOCK_MONOTONIC, taken in the callback
+    ble_uuid_t uuid;
+    uint16_t source;            ///< Index returned by NotificationIngest::attach()
+    uint16_t len;               ///< Payload bytes; longer payloads are truncated
+    uint8_t data[kNotifyPayloadMax];
+};
+
+enum class Backpressure {
+    DropOldest,     ///< A full ring discards its oldest record; the callback never waits
+    Block,          ///< The callback waits for room, stalling gattlib's event loop
+};
+
+/// Location of an application sequence number inside each payload.
+struct SequenceField {
+    int offset = -1;            ///< Byte offset; -1 disables gap detection
+    uint8_t width = 2;          ///< 1, 2 or 4 bytes, little-endian; wraps modulo 2^(8*width)
+};
+
+struct NotificationIngestOptions {
+    size_t workers = 2;
+    size_t ring_size = 512;                 ///< Records per source; rounded up to a power of two
+    size_t batch = 64;                      ///< Records per dispatch call
+    Backpressure policy = Backpressure::DropOldest;
+    SequenceField sequence;
+};
+
+struct NotificationIngestStats {
+    uint64_t received;          ///< Callbacks accepted into a ring
+    uint64_t dropped;           ///< Records discarded by DropOldest, or after stop()
+    uint64_t blocked;           ///< Callbacks that had to wait for room (Block)
+    uint64_t delivered;         ///< Records passed to the dispatch function
+    uint64_t batches;
+    uint64_t gaps;              ///< Sequence numbers missing between consecutive records
+    uint64_t latency_avg_ns;    ///< Callback timestamp -> dispatch
+    uint64_t latency_max_ns;
+};
+
+/**
+ * @brief Notification pipeline: gattlib callback -> per-source ring -> worker pool.
+ *
+ * The notification callback only timestamps the payload and copies it into
+ * its source's ring, so one busy peripheral cannot stall gattlib's event
+ * loop for the others. Each source is consumed by exactly one worker
+ * (source % workers), which keeps the rings single-producer/single-consumer
+ * and per-source dispatch in arrival order. Workers check sequence numbers
+ * and call the dispatch function with batches from one source at a time.
+ *
+ * The producer side is lock-free except under DropOldest with a full ring,
+ * where it briefly takes the ring's spinlock to discard the oldest record.
+ * An idle worker sleeps for at most 1 ms, which bounds added latency if a
+ * wakeup is missed.
+ *
+ * gattlib keeps a pointer into the pipeline as each connection's handler
+ * data. detach() devices before disconnecting them; the destructor
+ * unregisters those still attached, whose connections must still be open.
+ */
+class NotificationIngest {
+public:
+    /// Called on a worker thread with @p count records from one source.
+    using BatchFn = std::function<void(const NotificationRecord* records, size_t count)>;
+
+    static constexpr size_t kMaxSources = 256;
+
+    NotificationIngest(NotificationIngestOptions options, BatchFn on_batch);
+    ~NotificationIngest();
+
+    NotificationIngest(const NotificationIngest&) = delete;
+    NotificationIngest& operator=(const NotificationIngest&) = delete;
+
+    /**
+     * Registers the notification handler on @p connection and returns the
+     * device's source index, or -1 when kMaxSources is reached. A device
+     * that reconnects keeps its index, ring and sequence state.
+     */
+    int attach(gattlib_connection_t* connection, ble_addr_t address);
+    /**
+     * Unregisters the handler from the device's connection, which must
+     * still be open; the device keeps its index for a later attach(). With
+     * @p connected false (the link already dropped) the connection is only
+     * forgotten.
+     */
+    void detach(ble_addr_t address, bool connected = true);
+    /// Source index of a device, or -1 if it was never attached.
+    int find(ble_addr_t address) const;
+
+    void start();
+    /// Dispatches what is still queued and joins the workers.
+    void stop();
+
+    NotificationIngestStats stats() const;
+
+private:
+    struct Source {
+        NotificationIngest* owner;
+        ble_addr_t address;
+        uint16_t index;
+        gattlib_connection_t* connection = nullptr;     ///< While attached; attach_mutex_
+        size_t mask;
+        std::unique_ptr<NotificationRecord[]> slots;
+        alignas(64) std::atomic<size_t> head{0};
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;   ///< Consumer pop vs DropOldest discard
+        alignas(64) std::atomic<size_t> tail{0};
+        // Worker-owned
+        bool have_seq = false;
+        uint32_t last_seq = 0;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::atomic<bool> sleeping{false};
+    };
+
+    static void on_notification(const uuid_t* uuid, const uint8_t* data, size_t len,
+                                void* user_data);
+    void push(Source& source, const uuid_t* uuid, const uint8_t* data, size_t len);
+    size_t pop_batch(Source& source, NotificationRecord* out, size_t max);
+    size_t drain(Source& source, std::vector<NotificationRecord>& batch);
+    void run(size_t index);
+
+    NotificationIngestOptions options_;
+    BatchFn on_batch_;
+
+    mutable std::mutex attach_mutex_;
+    std::atomic<Source*> sources_[kMaxSources] = {};
+    std::atomic<size_t> source_count_{0};
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> running_{false};
+
+    std::atomic<uint64_t> received_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> blocked_{0};
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> gaps_{0};
+    std::atomic<uint64_t> latency_sum_ns_{0};
+    std::atomic<uint64_t> latency_max_ns_{0};
+};
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef BLE_NOTIFY_ENGINE_HPP
+#define BLE_NOTIFY_ENGINE_HPP
+
+#include <gio/gio.h>
+
+#include "ble_fd_channel.hpp"
+#include "ble_gatt_database.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ble {
+
+struct NotifyStats {
+    uint64_t published;         ///< publish() calls
+    uint64_t coalesced;         ///< Values replaced by a newer one before emission
+    uint64_t emitted;           ///< Notifications sent
+    uint64_t dropped;           ///< Values taken for emission but not delivered
+};
+
+/**
+ * @brief Rate-limited, coalescing notification sender for GATT characteristics.
+ *
+ * Each registered characteristic has a single-slot mailbox holding its
+ * latest value. Producers on any thread publish() by swapping a GBytes into
+ * the slot; a value that was still waiting is released and counted as
+ * coalesced, so memory per characteristic is bounded no matter how fast
+ * samples arrive. A timer on the engine's GMainContext drains each
+ * subscribed mailbox at most max_rate_hz times per second and emits the
+ * value, either as a Value PropertiesChanged signal or over an
+ * AcquireNotify FdChannel. When that channel still has unsent packets the
+ * value stays in the mailbox for the next tick. Each slot has its own
+ * deadline, advanced by its interval, so its rate holds when the timer
+ * fires a little early or the interval is not a multiple of the tick.
+ *
+ * Everything except publish() and stats() must run on the engine's context.
+ */
+class NotificationEngine {
+public:
+    using Id = size_t;
+
+    explicit NotificationEngine(GattDatabase& db, GMainContext* context = nullptr);
+    ~NotificationEngine();
+
+    NotificationEngine(const NotificationEngine&) = delete;
+    NotificationEngine& operator=(const NotificationEngine&) = delete;
+
+    /// Registers a characteristic; emissions are spaced at least 1/max_rate_hz apart.
+    Id add(const std::string& char_path, double max_rate_hz);
+
+    /// StartNotify/StopNotify: toggles the Notifying property and emission.
+    void start(Id id);
+    void stop(Id id);
+    bool subscribed(Id id) const;
+
+    /// Routes emissions through an AcquireNotify channel (nullptr: D-Bus signals).
+    void set_channel(Id id, FdChannel* channel);
+
+    /// Thread-safe. Replaces any value still waiting for emission.
+    void publish(Id id, const void* data, size_t len);
+    /// Thread-safe; takes a new reference to @p value.
+    void publish(Id id, GBytes* value);
+
+    /// Latest published value (borrowed), or nullptr before the first publish.
+    GBytes* value(Id id);
+
+    NotifyStats stats(Id id) const;
+
+private:
+    struct Slot {
+        std::string path;
+        uint64_t min_interval_ns;
+        std::atomic<GBytes*> mailbox{nullptr};
+        GBytes* current = nullptr;  ///< Last value taken from the mailbox
+        bool unsent = false;        ///< current has not been emitted yet
+        std::atomic<bool> subscribed{false};
+        FdChannel* channel = nullptr;
+        uint64_t next_due_ns = 0;   ///< Deadline of the next emission
+
+        std::atomic<uint64_t> published{0};
+        std::atomic<uint64_t> coalesced{0};
+        std::atomic<uint64_t> emitted{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    static gboolean on_tick(gpointer user_data);
+    void post(Slot& slot, GBytes* value);
+    void drain(Slot& slot, uint64_t now_ns);
+    bool take(Slot& slot);
+    void reschedule();
+
+    GattDatabase& db_;
+    GMainContext* context_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    GSource* timer_ = nullptr;
+    uint64_t tick_ns_ = 0;
+};
+
+}  // namespace ble
+
+#endif
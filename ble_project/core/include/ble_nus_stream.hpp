@@ -0,0 +1,113 @@
+#ifndef BLE_NUS_STREAM_HPP
+#define BLE_NUS_STREAM_HPP
+
+#include "ble_uuid.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace ble {
+
+constexpr ble_uuid_t kNusService = "6e400001-b5a3-f393-e0a9-e50e24dcca9e"_uuid;
+constexpr ble_uuid_t kNusRx = "6e400002-b5a3-f393-e0a9-e50e24dcca9e"_uuid;  ///< Central writes
+constexpr ble_uuid_t kNusTx = "6e400003-b5a3-f393-e0a9-e50e24dcca9e"_uuid;  ///< Peripheral notifies
+
+struct NusStreamOptions {
+    uint16_t mtu = 23;              ///< Negotiated ATT_MTU; payloads are mtu - 3 bytes, at most 512
+    unsigned credits = 16;          ///< Write commands allowed between write-request checkpoints
+    size_t rx_buffer = 64 * 1024;   ///< Receive ring bytes; rounded up to a power of two
+};
+
+struct NusStats {
+    uint64_t tx_bytes;
+    uint64_t tx_chunks;
+    uint64_t tx_checkpoints;        ///< Chunks sent as write requests to refill credits
+    uint64_t tx_errors;
+    uint64_t rx_bytes;
+    uint64_t rx_overflow;           ///< Bytes discarded because the receive ring was full
+    uint64_t chunk_latency_avg_ns;  ///< Time spent in the write call, per chunk
+    uint64_t chunk_latency_max_ns;
+};
+
+/**
+ * @brief Bidirectional byte stream over the Nordic UART Service.
+ *
+ * Transmit: write() cuts the data into ATT_MTU - 3 byte chunks, at most
+ * 512 (the longest attribute value), and sends them as write commands
+ * (write without response), which the link can pack several per
+ * connection event. Commands are unacknowledged, so the
+ * stream spends one credit per command and, when credits run out, sends
+ * the next chunk as a write request. ATT handles requests in order, so its
+ * response confirms every earlier command and refills the credits. The
+ * last chunk of each write() is always a request, so a returning write()
+ * means the peer has the data.
+ *
+ * Receive: receive() (the TX notification handler) appends payloads to a
+ * single-producer/single-consumer byte ring. peek() returns the readable
+ * bytes in place and consume() releases them, so reads copy nothing.
+ *
+ * The transport is a WriteFn, which keeps the stream independent of
+ * gattlib. write() blocks on the transport and must not be called from
+ * two threads at once; the receive side may run concurrently with it.
+ */
+class NusStream {
+public:
+    /// Sends one chunk; returns 0 on success (GATTLIB_SUCCESS).
+    using WriteFn = std::function<int(const uint8_t* data, size_t len, bool with_response)>;
+
+    explicit NusStream(WriteFn write, NusStreamOptions options = {});
+
+    NusStream(const NusStream&) = delete;
+    NusStream& operator=(const NusStream&) = delete;
+
+    void set_mtu(uint16_t mtu);
+    size_t chunk_size() const { return chunk_; }
+
+    /// Sends @p len bytes; returns the number confirmed or sent before an error.
+    size_t write(const void* data, size_t len);
+
+    /// Producer side: called with each TX notification payload.
+    void receive(const uint8_t* data, size_t len);
+
+    /// Readable bytes in place; may be fewer than available when the ring wraps.
+    const uint8_t* peek(size_t* len) const;
+    void consume(size_t n);
+    size_t available() const;
+    /// Waits until at least @p min bytes are readable; false on timeout.
+    bool wait_readable(size_t min, std::chrono::milliseconds timeout);
+
+    NusStats stats() const;
+
+private:
+    WriteFn write_;
+    size_t chunk_;
+    unsigned max_credits_;
+    unsigned credits_;
+
+    size_t rx_mask_;
+    std::unique_ptr<uint8_t[]> rx_;
+    alignas(64) std::atomic<size_t> rx_head_{0};
+    alignas(64) std::atomic<size_t> rx_tail_{0};
+
+    std::mutex wait_mutex_;
+    std::condition_variable readable_;
+    std::atomic<bool> waiting_{false};
+
+    std::atomic<uint64_t> tx_bytes_{0};
+    std::atomic<uint64_t> tx_chunks_{0};
+    std::atomic<uint64_t> tx_checkpoints_{0};
+    std::atomic<uint64_t> tx_errors_{0};
+    std::atomic<uint64_t> latency_sum_ns_{0};
+    std::atomic<uint64_t> latency_max_ns_{0};
+    std::atomic<uint64_t> rx_bytes_{0};
+    std::atomic<uint64_t> rx_overflow_{0};
+};
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef BLE_RSSI_TRACKER_HPP
+#define BLE_RSSI_TRACKER_HPP
+
+#include "ble_addr.hpp"
+#include "ble_scan_ingest.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ble {
+
+/// Smoothed value that RssiTracker queries select on.
+enum class RssiFilter {
+    Last,           ///< Latest sample
+    Ewma,           ///< Exponentially weighted moving average
+    Kalman,         ///< 1-D Kalman filter with a random-walk model
+    Median,         ///< Median of the last median_window samples
+};
+
+struct RssiTrackerOptions {
+    size_t capacity = 65536;            ///< Devices; the least recently seen is evicted beyond this
+    unsigned window = 16;               ///< Samples kept per device; rounded up to a power of two, 4 to 128
+    unsigned median_window = 5;         ///< Odd, at most window and 15; clamped down to fit
+    float ewma_alpha = 0.25f;           ///< Weight of the newest sample
+    float kalman_q = 0.5f;              ///< Process noise per sample, dB^2
+    float kalman_r = 16.0f;             ///< Measurement noise, dB^2 (4 dB standard deviation)
+    uint64_t max_age_ns = 60000000000ULL;   ///< expire() drops devices unseen this long; 0 = never
+};
+
+struct RssiSummary {
+    ble_addr_t address;
+    uint64_t last_seen_ns;
+    uint32_t samples;           ///< Since the device was (re)inserted, not just those kept
+    float last;
+    float ewma;
+    float kalman;
+    float median;
+};
+
+struct RssiTrackerStats {
+    uint64_t samples;           ///< Accepted by add()
+    uint64_t evicted;           ///< Dropped to make room (least recently seen)
+    uint64_t expired;           ///< Dropped by expire()
+};
+
+/**
+ * @brief Per-device RSSI history and streaming filters for presence
+ * detection, in bounded memory.
+ *
+ * Devices live in a fixed number of slots, stored as a structure of
+ * arrays: each filter output is one contiguous float column, so
+ * above() is a compare over a flat array that the compiler vectorizes.
+ * Each slot keeps a ring of its last @c window samples (int8 dBm and a
+ * 32-bit millisecond stamp). EWMA, Kalman and windowed median are
+ * updated in constant time per sample.
+ *
+ * Slots are linked in least-recently-seen order: a full tracker evicts
+ * the device seen longest ago, and expire() drops devices older than
+ * max_age_ns from the same end. An address index (open addressing,
+ * backward-shift deletion) maps addresses to slots. Memory is allocated
+ * once, at construction; memory_bytes() reports it.
+ *
+ * Not thread-safe. Feed it from one thread, such as ScanIngest's
+ * on_batch callback.
+ */
+class RssiTracker {
+public:
+    explicit RssiTracker(const RssiTrackerOptions& options = RssiTrackerOptions());
+    ~RssiTracker();
+
+    RssiTracker(const RssiTracker&) = delete;
+    RssiTracker& operator=(const RssiTracker&) = delete;
+
+    /**
+     * Records one sample; false for BLE_RSSI_UNKNOWN, which is ignored.
+     * Timestamps must not go backwards; expire() relies on it.
+     */
+    bool add(ble_addr_t address, int16_t rssi, uint64_t timestamp_ns);
+    /// add() for every record with an RSSI.
+    void add(const ScanRecord* records, size_t count);
+
+    /// Drops devices last seen before @p now_ns - max_age_ns; returns how many.
+    size_t expire(uint64_t now_ns);
+
+    bool find(ble_addr_t address, RssiSummary* out) const;
+    /**
+     * Copies up to @p max of the device's kept samples, oldest first.
+     * @p timestamps_ns may be null; they are exact for the newest sample
+     * and to the millisecond for the others. Returns the number copied.
+     */
+    size_t history(ble_addr_t address, int8_t* rssi, uint64_t* timestamps_ns, size_t max) const;
+
+    /// Appends every device whose @p filter value is above @p threshold_dbm.
+    size_t above(RssiFilter filter, float threshold_dbm, std::vector<ble_addr_t>* out) const;
+    /// Like above(), without collecting addresses.
+    size_t count_above(RssiFilter filter, float threshold_dbm) const;
+
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (uint32_t s = lru_head_; s != kNone; s = next_[s]) fn(summary(s));
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    size_t memory_bytes() const;
+    RssiTrackerStats stats() const { return RssiTrackerStats{samples_, evicted_, expired_}; }
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    uint32_t lookup(ble_addr_t address) const;
+    uint32_t insert(ble_addr_t address);
+    void remove(uint32_t slot);
+    void unlink(uint32_t slot);
+    void push_front(uint32_t slot);
+    RssiSummary summary(uint32_t slot) const;
+    float window_median(uint32_t slot) const;
+
+    RssiTrackerOptions options_;
+    size_t capacity_;
+    uint32_t window_mask_;
+    size_t size_ = 0;
+    uint32_t used_ = 0;                 ///< Slots ever handed out; columns are scanned up to here
+    uint32_t free_ = kNone;             ///< Freed slots, chained through next_
+
+    // Per-slot columns
+    std::unique_ptr<ble_addr_t[]> address_;
+    std::unique_ptr<uint64_t[]> last_seen_;
+    std::unique_ptr<uint32_t[]> count_;         ///< Samples since insertion
+    std::unique_ptr<uint32_t[]> prev_;          ///< Toward the most recently seen
+    std::unique_ptr<uint32_t[]> next_;
+    std::unique_ptr<float[]> filtered_[4];      ///< By RssiFilter; -inf for free slots
+    std::unique_ptr<float[]> kalman_p_;         ///< Kalman error variance
+    std::unique_ptr<int8_t[]> ring_rssi_;       ///< window per slot
+    std::unique_ptr<uint32_t[]> ring_ms_;       ///< Low 32 bits of the sample time in ms
+
+    // Address index: slot + 1, 0 when empty
+    std::unique_ptr<uint32_t[]> index_;
+    size_t index_mask_;
+
+    uint32_t lru_head_ = kNone;         ///< Most recently seen
+    uint32_t lru_tail_ = kNone;
+
+    uint64_t samples_ = 0;
+    uint64_t evicted_ = 0;
+    uint64_t expired_ = 0;
+};
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef BLE_SCAN_INGEST_HPP
+#define BLE_SCAN_INGEST_HPP
+
+#include "ble_adv_data.hpp"
+#include "ble_device_table.hpp"
+#include "ble_spsc_ring.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace ble {
+
+/// Longest local name that fits a legacy advertising PDU
+constexpr size_t kScanNameMax = 29;
+
+/// Fixed-size sighting handed from the scan callback to the consumer thread.
+struct ScanRecord {
+    uint64_t timestamp_ns;      ///< CLOCK_MONOTONIC
+    ble_addr_t address;
+    int16_t rssi;               ///< BLE_RSSI_UNKNOWN when not reported
+    uint8_t name_len;           ///< 0 when the advert carried no name
+    uint8_t ad_len;             ///< 0 when the source gives no payload (gattlib)
+    bool scan_response;
+    char name[kScanNameMax];
+    uint8_t ad[kAdLegacyMax];   ///< Raw AD structures, truncated to a legacy payload
+};
+
+/**
+ * @brief Fills @p out from the arguments of a scan callback.
+ *
+ * Does no allocation and no I/O, so it is safe to call on the gattlib
+ * callback thread. Returns false for malformed addresses.
+ */
+bool scan_record_make(const char* address, const char* name, int16_t rssi,
+                      ScanRecord* out) noexcept;
+
+/**
+ * @brief Fills @p out from a raw advertising report (HCI or a capture).
+ *
+ * The name is left empty; the consumer takes it from the payload.
+ */
+void scan_record_make(ble_addr_t address, int16_t rssi, const uint8_t* ad, size_t ad_len,
+                      bool scan_response, uint64_t timestamp_ns, ScanRecord* out) noexcept;
+
+struct ScanStats {
+    uint64_t received;          ///< Records accepted into the ring
+    uint64_t dropped;           ///< Records rejected because the ring was full
+    uint64_t folded;            ///< Records merged into the device table
+    uint64_t ad_parsed;         ///< Payloads that were new or changed, and so parsed
+    uint64_t expired;           ///< Devices dropped after expire_after() without a sighting
+};
+
+/**
+ * @brief Scan ingest pipeline: callback -> SPSC ring -> device table.
+ *
+ * The producer (scan callback) only copies a ScanRecord into the ring.
+ * A consumer thread folds records into a DeviceTable, interns names, and
+ * every report interval invokes the report callback with the table and the
+ * epoch whose entries changed during that interval.
+ *
+ * Records with an AD payload are checked against an AdvertCache first;
+ * only new or changed payloads are parsed, for the local name, and
+ * copied into the device's entry.
+ *
+ * Devices not seen for expire_after() leave the table and the advert
+ * cache before each report, so the rotating random addresses of privacy
+ * devices do not grow either without bound. Age is measured against the
+ * newest record timestamp, so replayed captures age the same way.
+ */
+class ScanIngest {
+public:
+    using ReportFn = std::function<void(const ScanIngest&, uint32_t epoch)>;
+    using BatchFn = std::function<void(const ScanRecord* records, size_t count)>;
+
+    ScanIngest();
+    ~ScanIngest();
+
+    ScanIngest(const ScanIngest&) = delete;
+    ScanIngest& operator=(const ScanIngest&) = delete;
+
+    /// Producer side; lock-free and allocation-free.
+    bool submit(const ScanRecord& record) noexcept;
+    /// Like submit(), but waits for room instead of dropping; for replays.
+    void submit_wait(const ScanRecord& record) noexcept;
+
+    /// Called on the consumer thread with every drained batch, after folding; set before start().
+    void on_batch(BatchFn fn) { on_batch_ = std::move(fn); }
+    /// Set before start(); 0 keeps every device for the life of the pipeline.
+    void expire_after(std::chrono::milliseconds age) { expire_after_ = age; }
+
+    void start(std::chrono::milliseconds report_interval, ReportFn on_report);
+    /// Drains the ring, emits a final report and joins the consumer thread.
+    void stop();
+
+    const DeviceTable& devices() const { return table_; }
+    const NamePool& names() const { return names_; }
+    ScanStats stats() const;
+
+private:
+    static constexpr size_t kRingSize = 8192;
+    static constexpr size_t kBatch = 256;
+
+    void run();
+    size_t drain();
+    void fold(const ScanRecord& record);
+    bool set_name(DeviceEntry* e, const char* name, size_t len);
+    void expire();
+    void report();
+
+    SpscRing<ScanRecord, kRingSize> ring_;
+    std::atomic<uint64_t> received_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> folded_{0};
+    std::atomic<uint64_t> ad_parsed_{0};
+    std::atomic<uint64_t> expired_{0};
+
+    DeviceTable table_;
+    NamePool names_;
+    AdvertCache adverts_;
+
+    std::chrono::milliseconds interval_{1000};
+    std::chrono::milliseconds expire_after_{std::chrono::minutes(30)};
+    uint64_t newest_ns_ = 0;            ///< Latest record timestamp folded; the expiry clock
+    ReportFn on_report_;
+    BatchFn on_batch_;
+    std::atomic<bool> running_{false};
+    std::thread consumer_;
+};
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef BLE_SCAN_LOG_HPP
+#define BLE_SCAN_LOG_HPP
+
+#include "ble_adv_data.hpp"
+#include "ble_scan_ingest.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ble {
+
+/**
+ * Scan log segments are sequences of 16-byte units. An advert takes one
+ * unit; names and AD payloads are written once per segment as definition
+ * units followed by their bytes, and adverts refer to them by id. Every
+ * segment starts with a time base, so segments can be read, copied or
+ * deleted independently.
+ */
+struct ScanLogUnit {
+    uint32_t delta_us;          ///< Advert: microseconds since the previous advert; definition: byte length
+    uint8_t kind;               ///< ScanLogKind, plus the kScanLog*Bit flags for adverts
+    int8_t rssi;                ///< BLE_RSSI_UNKNOWN (127) when unknown
+    uint16_t name_id;           ///< 0: no name
+    uint16_t payload_id;        ///< 0: no AD payload
+    uint8_t address[6];         ///< Little-endian, as on air
+};
+
+static_assert(sizeof(ScanLogUnit) == 16, "ScanLogUnit layout is part of the file format");
+
+enum ScanLogKind : uint8_t {
+    kScanLogAdvert = 0,
+    kScanLogName = 1,           ///< Defines name_id; delta_us bytes follow, padded to a unit
+    kScanLogPayload = 2,        ///< Defines payload_id; likewise
+    kScanLogTime = 3,           ///< Sets the absolute time (µs since 1970) stored in bytes 8-15
+};
+
+constexpr uint8_t kScanLogKindMask = 0x0F;
+constexpr uint8_t kScanLogRandomBit = 0x10;
+constexpr uint8_t kScanLogScanResponseBit = 0x20;
+
+struct ScanLogOptions {
+    std::string directory;                  ///< Must exist
+    size_t segment_bytes = 4 << 20;         ///< A segment is closed once it would exceed this
+    size_t max_segments = 0;                ///< Oldest segments are deleted beyond this; 0 keeps all
+    int64_t clock_offset_ns = 0;            ///< Added to ScanRecord::timestamp_ns to get wall time
+};
+
+struct ScanLogStats {
+    uint64_t records;
+    uint64_t bytes;             ///< Including definitions and headers
+    uint64_t segments;          ///< Segments opened
+    uint64_t names;             ///< Name definitions written
+    uint64_t payloads;          ///< Payload definitions written
+};
+
+/// realtime - monotonic, for ScanLogOptions::clock_offset_ns with live scans.
+int64_t realtime_offset_ns();
+
+/**
+ * @brief Append-only binary scan log in mmap()ed, size-rotated segments.
+ *
+ * Segments are `<directory>/scan-<sequence>.bsl`. A new one is created at
+ * open() and whenever the current one is full, so writing never modifies
+ * an older file; with max_segments set, the oldest are deleted to bound
+ * disk use. The header's committed length is updated after every record,
+ * so a reader, or recovery after a crash, sees only complete records.
+ * close() truncates the last segment to its committed length.
+ *
+ * Names and payloads are interned per segment by hash and verified
+ * against the bytes already written. A beacon repeating the same advert
+ * costs 16 bytes a sighting. Not thread-safe; call from the scan consumer
+ * thread (ScanIngest::on_batch()).
+ */
+class ScanLogWriter {
+public:
+    ScanLogWriter() = default;
+    ~ScanLogWriter();
+
+    ScanLogWriter(const ScanLogWriter&) = delete;
+    ScanLogWriter& operator=(const ScanLogWriter&) = delete;
+
+    bool open(const ScanLogOptions& options, std::string* error);
+    bool append(const ScanRecord& record);
+    /// Schedules write-back of the mapped pages (MS_ASYNC).
+    void flush();
+    void close();
+
+    ScanLogStats stats() const { return stats_; }
+    const std::string& error() const { return error_; }
+
+private:
+    bool open_segment();
+    void close_segment();
+    void prune();
+    uint8_t* reserve(size_t units);
+    uint16_t intern(std::unordered_map<uint64_t, uint16_t>& ids, std::vector<size_t>& offsets,
+                    uint8_t kind, const uint8_t* data, size_t len);
+    void commit();
+
+    ScanLogOptions options_;
+    std::string error_;
+    uint64_t sequence_ = 0;
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t used_ = 0;
+    uint64_t last_us_ = 0;
+
+    // Per segment: hash -> id, and id -> offset of the bytes in the map
+    std::unordered_map<uint64_t, uint16_t> name_ids_;
+    std::vector<size_t> name_offsets_;
+    std::unordered_map<uint64_t, uint16_t> payload_ids_;
+    std::vector<size_t> payload_offsets_;
+
+    ScanLogStats stats_ = {};
+};
+
+/// One advert read back from a segment; views point into the mapped file.
+struct ScanLogEntry {
+    uint64_t timestamp_us;      ///< Since 1970
+    ble_addr_t address;
+    int16_t rssi;               ///< BLE_RSSI_UNKNOWN when not recorded
+    bool scan_response;
+    ByteView name;              ///< {nullptr, 0} when absent
+    ByteView ad;
+};
+
+/**
+ * @brief Sequential reader for one scan log segment.
+ *
+ * Reads up to the committed length, so a segment that is still being
+ * written can be read safely.
+ */
+class ScanLogReader {
+public:
+    ScanLogReader() = default;
+    ~ScanLogReader();
+
+    ScanLogReader(const ScanLogReader&) = delete;
+    ScanLogReader& operator=(const ScanLogReader&) = delete;
+
+    bool open(const char* path, std::string* error);
+    void close();
+
+    uint64_t sequence() const { return sequence_; }
+    /// False at the end of the segment or at a malformed unit.
+    bool next(ScanLogEntry* out);
+
+private:
+    const uint8_t* map_ = nullptr;
+    size_t size_ = 0;
+    size_t end_ = 0;
+    size_t pos_ = 0;
+    uint64_t sequence_ = 0;
+    uint64_t now_us_ = 0;
+    std::vector<ByteView> names_;
+    std::vector<ByteView> payloads_;
+};
+
+/// Paths of the segments in @p directory, oldest first.
+std::vector<std::string> scan_log_segments(const std::string& directory);
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef BLE_SPSC_RING_HPP
+#define BLE_SPSC_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace ble {
+
+/**
+ * @brief Bounded single-producer/single-consumer ring buffer.
+ *
+ * Storage lives inside the object, so pushing never allocates. The producer
+ * and consumer indices sit on separate cache lines and each side keeps a
+ * cached copy of the other's index to avoid touching the shared line on
+ * every operation.
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscRing elements must be trivially copyable");
+
+public:
+    static constexpr size_t capacity = Capacity;
+
+    /// Producer side. Returns false when the ring is full.
+    bool try_push(const T& item) noexcept {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == Capacity) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == Capacity) return false;
+        }
+        slots_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side. Returns false when the ring is empty.
+    bool try_pop(T& out) noexcept {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) return false;
+        }
+        out = slots_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side. Moves up to @p max items into @p out; returns the count.
+    size_t pop_batch(T* out, size_t max) noexcept {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        size_t n = cached_tail_ - head;
+        if (n > max) n = max;
+        for (size_t i = 0; i < n; i++) {
+            out[i] = slots_[(head + i) & (Capacity - 1)];
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    /// Approximate fill level; exact only when both sides are quiescent.
+    size_t size_approx() const noexcept {
+        return tail_.load(std::memory_order_acquire) -
+               head_.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;
+    alignas(64) T slots_[Capacity];
+};
+
+}  // namespace ble
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef BLE_TIME_HPP
+#define BLE_TIME_HPP
+
+#include <cstdint>
+#include <time.h>
+
+namespace ble {
+
+/// CLOCK_MONOTONIC in nanoseconds; the timestamp of scan records and notifications.
+inline uint64_t monotonic_ns() noexcept {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+}  // namespace ble
+
+#endif
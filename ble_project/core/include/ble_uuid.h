@@ -0,0 +1,86 @@
+#ifndef BLE_UUID_H
+#define BLE_UUID_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 128-bit UUID stored as two big-endian halves, so that
+ * "0000180d-0000-1000-8000-00805f9b34fb" is hi = 0x0000180d00001000,
+ * lo = 0x800000805f9b34fb. Equality and ordering are two integer compares,
+ * and SIG-base UUIDs are recognised by comparing against the base halves.
+ */
+typedef struct {
+    uint64_t hi;
+    uint64_t lo;
+} ble_uuid_t;
+
+/* Bluetooth Base UUID 00000000-0000-1000-8000-00805F9B34FB */
+#define BLE_UUID_BASE_HI 0x0000000000001000ULL
+#define BLE_UUID_BASE_LO 0x800000805F9B34FBULL
+
+typedef enum {
+    BLE_UUID_KIND_UNKNOWN = 0,
+    BLE_UUID_KIND_DECLARATION,
+    BLE_UUID_KIND_SERVICE,
+    BLE_UUID_KIND_CHARACTERISTIC,
+    BLE_UUID_KIND_DESCRIPTOR,
+} ble_uuid_kind_t;
+
+typedef struct {
+    const char *name;
+    ble_uuid_kind_t kind;
+} ble_uuid_info_t;
+
+static inline ble_uuid_t ble_uuid_from32(uint32_t value) {
+    ble_uuid_t uuid;
+    uuid.hi = ((uint64_t)value << 32) | BLE_UUID_BASE_HI;
+    uuid.lo = BLE_UUID_BASE_LO;
+    return uuid;
+}
+
+static inline ble_uuid_t ble_uuid_from16(uint16_t value) {
+    return ble_uuid_from32(value);
+}
+
+/* True when the UUID is derived from the Bluetooth Base UUID */
+static inline bool ble_uuid_is_sig(const ble_uuid_t *uuid) {
+    return uuid->lo == BLE_UUID_BASE_LO &&
+           (uint32_t)uuid->hi == (uint32_t)BLE_UUID_BASE_HI;
+}
+
+/* 16/32-bit value of a SIG-base UUID; only meaningful if ble_uuid_is_sig() */
+static inline uint32_t ble_uuid_sig_value(const ble_uuid_t *uuid) {
+    return (uint32_t)(uuid->hi >> 32);
+}
+
+static inline bool ble_uuid_equal(const ble_uuid_t *a, const ble_uuid_t *b) {
+    return a->hi == b->hi && a->lo == b->lo;
+}
+
+static inline int ble_uuid_cmp(const ble_uuid_t *a, const ble_uuid_t *b) {
+    if (a->hi != b->hi) return a->hi < b->hi ? -1 : 1;
+    if (a->lo != b->lo) return a->lo < b->lo ? -1 : 1;
+    return 0;
+}
+
+/* Parses the 36-character form, or a 4/8 hex digit SIG short form */
+bool ble_uuid_parse(const char *str, ble_uuid_t *out);
+/* Writes the lowercase 36-character form; out must hold BLE_UUID_SIZE bytes */
+void ble_uuid_format(const ble_uuid_t *uuid, char *out);
+/* Big-endian 16-byte wire order <-> ble_uuid_t */
+void ble_uuid_from_bytes_be(const uint8_t bytes[16], ble_uuid_t *out);
+void ble_uuid_to_bytes_be(const ble_uuid_t *uuid, uint8_t bytes[16]);
+
+/* Assigned-numbers lookup; NULL when the UUID is not in the registry */
+const ble_uuid_info_t *ble_uuid_lookup(const ble_uuid_t *uuid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
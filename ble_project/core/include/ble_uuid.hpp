@@ -0,0 +1,100 @@
+#ifndef BLE_UUID_HPP
+#define BLE_UUID_HPP
+
+#include "ble_common.h"
+#include "ble_uuid.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace ble {
+
+namespace detail {
+
+constexpr int hex_digit(char c) {
+    return (c >= '0' && c <= '9') ? c - '0'
+         : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+         : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+         : -1;
+}
+
+// Reached only for malformed input. In a constant expression the throw makes
+// the program ill-formed, so a bad literal is a compile error.
+constexpr uint64_t accumulate_hex(const char* s, size_t n, uint64_t acc) {
+    for (size_t i = 0; i < n; i++) {
+        int d = hex_digit(s[i]);
+        if (d < 0) throw std::invalid_argument("UUID contains a non-hex digit");
+        acc = (acc << 4) | (uint64_t)d;
+    }
+    return acc;
+}
+
+}  // namespace detail
+
+constexpr ble_uuid_t uuid16(uint16_t value) {
+    return ble_uuid_t{((uint64_t)value << 32) | BLE_UUID_BASE_HI, BLE_UUID_BASE_LO};
+}
+
+constexpr ble_uuid_t uuid32(uint32_t value) {
+    return ble_uuid_t{((uint64_t)value << 32) | BLE_UUID_BASE_HI, BLE_UUID_BASE_LO};
+}
+
+/// Constexpr counterpart of ble_uuid_parse(); throws on malformed input.
+constexpr ble_uuid_t make_uuid(const char* s, size_t len) {
+    if (len == 4 || len == 8) {
+        return uuid32((uint32_t)detail::accumulate_hex(s, len, 0));
+    }
+    if (len != BLE_UUID_SIZE - 1) {
+        throw std::invalid_argument("UUID must have 4, 8 or 36 characters");
+    }
+    if (s[8] != '-' || s[13] != '-' || s[18] != '-' || s[23] != '-') {
+        throw std::invalid_argument("UUID dashes must be at 8, 13, 18 and 23");
+    }
+    uint64_t hi = detail::accumulate_hex(s, 8, 0);
+    hi = detail::accumulate_hex(s + 9, 4, hi);
+    hi = detail::accumulate_hex(s + 14, 4, hi);
+    uint64_t lo = detail::accumulate_hex(s + 19, 4, 0);
+    lo = detail::accumulate_hex(s + 24, 12, lo);
+    return ble_uuid_t{hi, lo};
+}
+
+/// Lowercase 36-character form, usable in constant expressions.
+constexpr std::array<char, BLE_UUID_SIZE> to_string(const ble_uuid_t& uuid) {
+    std::array<char, BLE_UUID_SIZE> out{};
+    const char hex[] = "0123456789abcdef";
+    size_t pos = 0;
+    for (int i = 0; i < 32; i++) {
+        if (i == 8 || i == 12 || i == 16 || i == 20) out[pos++] = '-';
+        uint64_t half = i < 16 ? uuid.hi : uuid.lo;
+        out[pos++] = hex[(half >> (60 - 4 * (i % 16))) & 0xF];
+    }
+    out[pos] = '\0';
+    return out;
+}
+
+inline namespace literals {
+
+/// "6e400001-b5a3-f393-e0a9-e50e24dcca9e"_uuid or "180d"_uuid
+constexpr ble_uuid_t operator""_uuid(const char* s, size_t len) {
+    return make_uuid(s, len);
+}
+
+}  // namespace literals
+
+}  // namespace ble
+
+constexpr bool operator==(const ble_uuid_t& a, const ble_uuid_t& b) {
+    return a.hi == b.hi && a.lo == b.lo;
+}
+
+constexpr bool operator!=(const ble_uuid_t& a, const ble_uuid_t& b) {
+    return !(a == b);
+}
+
+constexpr bool operator<(const ble_uuid_t& a, const ble_uuid_t& b) {
+    return a.hi != b.hi ? a.hi < b.hi : a.lo < b.lo;
+}
+
+#endif
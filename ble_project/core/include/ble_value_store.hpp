@@ -0,0 +1,197 @@
+#ifndef BLE_VALUE_STORE_HPP
+#define BLE_VALUE_STORE_HPP
+
+#include <gio/gio.h>
+
+#include "ble_gatt_value.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ble {
+
+/// A consistent copy of one value.
+struct ValueSnapshot {
+    uint64_t version;           ///< 1 when added, then one more per write
+    size_t len;
+    uint8_t data[BLE_GATT_MAX_VALUE_LEN];
+};
+
+enum class WriteStatus {
+    Ok,
+    InvalidOffset,              ///< Offset past the end of the value
+    InvalidLength,              ///< Value would exceed BLE_GATT_MAX_VALUE_LEN
+};
+
+/// BlueZ error name for a failed write ("org.bluez.Error.InvalidOffset", ...).
+const char* write_status_error(WriteStatus status);
+
+/**
+ * @brief Writes queued against one value (ATT Prepare Write), applied in
+ * order and published as one version by ValueStore::commit().
+ */
+class PreparedWrite {
+public:
+    /**
+     * Queues a fragment. Like ValueStore::write(), its offset may not pass
+     * the end of the value it lands on: @p value_len, the current length,
+     * for the first fragment and the end of the previous one after that.
+     */
+    WriteStatus stage(size_t offset, const void* data, size_t len, size_t value_len);
+    bool empty() const { return fragments_.empty(); }
+    void clear();
+
+private:
+    friend class ValueStore;
+
+    struct Fragment {
+        size_t offset;
+        size_t pos;             ///< Into bytes_
+        size_t len;
+    };
+    std::vector<Fragment> fragments_;
+    std::vector<uint8_t> bytes_;
+};
+
+/**
+ * @brief Fixed set of attribute values of up to 512 bytes, each behind a
+ * seqlock.
+ *
+ * Writers on any thread take the value's writer lock, bump its sequence
+ * to odd, store the bytes and bump it to even again; the even sequence
+ * is the version. Readers on any thread never take a lock: they copy the
+ * bytes and retry if the sequence changed meanwhile, so a sensor thread
+ * publishing at a high rate never waits for BlueZ, and BlueZ never sees
+ * half of an update. The bytes are stored as relaxed atomic words, which
+ * makes the racing copy well defined.
+ *
+ * Capacity is fixed at construction so that slots never move.
+ */
+class ValueStore {
+public:
+    using Id = uint32_t;
+
+    explicit ValueStore(size_t capacity);
+    ~ValueStore();
+
+    ValueStore(const ValueStore&) = delete;
+    ValueStore& operator=(const ValueStore&) = delete;
+
+    /// Thread-safe. Adds a value with @p len initial bytes; false when full or too long.
+    bool add(const void* data, size_t len, Id* id);
+    size_t size() const { return size_.load(std::memory_order_acquire); }
+    size_t capacity() const { return capacity_; }
+
+    /// Replaces the whole value; returns its new version, or 0 if @p len is too long.
+    uint64_t set(Id id, const void* data, size_t len);
+
+    /**
+     * Writes @p data at @p offset: the value becomes its first @p offset
+     * bytes followed by @p data, so the fragments of a long write rebuild
+     * it in order.
+     */
+    WriteStatus write(Id id, size_t offset, const void* data, size_t len,
+                      uint64_t* version = nullptr);
+
+    /// Applies @p prepared as one update; nothing is published if a fragment fails.
+    WriteStatus commit(Id id, const PreparedWrite& prepared, uint64_t* version = nullptr);
+    /// What commit() would return for @p prepared against the current value.
+    WriteStatus check(Id id, const PreparedWrite& prepared) const;
+
+    /// Lock-free consistent copy; returns the version, or 0 (and no bytes) for an unknown @p id.
+    uint64_t read(Id id, ValueSnapshot* out) const;
+    /// Lock-free; the bytes from @p offset to the end, in a new GBytes.
+    GBytes* read_bytes(Id id, size_t offset = 0, uint64_t* version = nullptr) const;
+    /// 0 for an unknown @p id.
+    uint64_t version(Id id) const;
+    /// Lock-free; 0 for an unknown @p id.
+    size_t length(Id id) const;
+
+private:
+    struct Slot;
+
+    void publish(Slot& slot, const uint8_t* data, size_t len);
+    void load_locked(const Slot& slot, uint8_t* data, size_t* len) const;
+
+    size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<size_t> size_{0};
+    std::mutex add_mutex_;
+};
+
+/**
+ * @brief ReadValue and WriteValue for characteristics backed by a
+ * ValueStore, with BlueZ's offset, mtu, device and type options.
+ *
+ * Long reads: a read at offset 0 of a value longer than one ATT response
+ * pins that snapshot for the device, and the following Read Blob offsets
+ * are served from it until the last slice, so a client never stitches
+ * two versions together. A pin not read for @p pin_timeout_ms is dropped,
+ * so a central that disconnects mid-read does not keep its session.
+ *
+ * Reliable writes: BlueZ replays an Execute Write as WriteValue calls of
+ * type "reliable", one per prepared fragment, without marking the last
+ * one. They are staged per device and committed, one version per value,
+ * when that device makes any other request or after @p commit_delay_ms
+ * without a fragment. Readers see the old value or the whole new one.
+ * Fragment offsets are checked as they are staged and every staged value
+ * again before any is committed: if one fails, nothing staged for the
+ * device commits and its remaining fragments get the same error.
+ *
+ * Thread-safe, so handlers may run on a HandlerPool. The commit timer
+ * runs on @p context; destroy the object there.
+ */
+class ValueRequests {
+public:
+    ValueRequests(ValueStore& store, GMainContext* context = nullptr,
+                  unsigned commit_delay_ms = 50, unsigned pin_timeout_ms = 5000);
+    ~ValueRequests();
+
+    ValueRequests(const ValueRequests&) = delete;
+    ValueRequests& operator=(const ValueRequests&) = delete;
+
+    /// Replies to ReadValue(a{sv}) for value @p id.
+    void read(ValueStore::Id id, GVariant* parameters, GDBusMethodInvocation* invocation);
+    /// Replies to WriteValue(ay, a{sv}) for value @p id.
+    void write(ValueStore::Id id, GVariant* parameters, GDBusMethodInvocation* invocation);
+
+    /// Commits @p device's staged reliable writes now; false if one failed.
+    bool commit(const std::string& device);
+
+private:
+    struct Session {
+        std::map<ValueStore::Id, GBytes*> pinned;       ///< Long reads in progress
+        std::vector<std::pair<ValueStore::Id, PreparedWrite>> staged;
+        WriteStatus failed = WriteStatus::Ok;           ///< A fragment failed; reject the rest
+        GSource* commit_timer = nullptr;
+        GSource* pin_timer = nullptr;                   ///< Drops pins a vanished device left
+    };
+
+    struct Timer;
+
+    bool commit_locked(Session& session);
+    void drop_pins_locked(Session& session);
+    void arm_timer(const std::string& device, GSource** timer, unsigned delay_ms);
+    void release_if_idle(std::map<std::string, Session>::iterator it);
+    static gboolean on_timer(gpointer user_data);
+
+    ValueStore& store_;
+    GMainContext* context_;
+    unsigned commit_delay_ms_;
+    unsigned pin_timeout_ms_;
+
+    std::mutex mutex_;
+    std::map<std::string, Session> sessions_;   ///< By device path
+    std::atomic<size_t> sessions_active_{0};    ///< sessions_.size(), read without the lock
+};
+
+}  // namespace ble
+
+#endif
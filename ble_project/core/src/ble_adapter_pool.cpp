@@ -0,0 +1,437 @@
+#include "ble_adapter_pool.hpp"
+#include "ble_dbus.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <utility>
+
+namespace ble {
+
+namespace {
+
+constexpr const char* kBluezName = "org.bluez";
+constexpr const char* kAdapterInterface = "org.bluez.Adapter1";
+constexpr const char* kDeviceInterface = "org.bluez.Device1";
+constexpr const char* kObjectManagerInterface = "org.freedesktop.DBus.ObjectManager";
+
+// BlueZ answers registrations only after calling back into the application
+constexpr int kCallTimeoutMs = 10000;
+
+GVariant* get_managed_objects(GDBusConnection* conn, GError** error) {
+    return g_dbus_connection_call_sync(conn, kBluezName, "/", kObjectManagerInterface,
+        "GetManagedObjects", NULL, G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE,
+        kCallTimeoutMs, NULL, error);
+}
+
+/**
+ * Walks a GetManagedObjects reply: adapters go to @p adapters, and the
+ * path of every connected device to @p devices, keyed by its adapter.
+ */
+void collect(GVariant* reply, std::vector<AdapterInfo>* adapters,
+             std::multimap<std::string, std::string>* devices) {
+    GVariantIter* iter;
+    const gchar* path;
+    GVariant* interfaces;
+    g_variant_get(reply, "(a{oa{sa{sv}}})", &iter);
+    while (g_variant_iter_next(iter, "{&o@a{sa{sv}}}", &path, &interfaces)) {
+        GVariant* props;
+        if (adapters && (props = g_variant_lookup_value(interfaces, kAdapterInterface,
+                                                        G_VARIANT_TYPE("a{sv}")))) {
+            AdapterInfo info;
+            info.path = path;
+            const char* slash = strrchr(path, '/');
+            info.name = slash ? slash + 1 : path;
+            const gchar* address = NULL;
+            if (g_variant_lookup(props, "Address", "&s", &address)) info.address = address;
+            gboolean powered = FALSE;
+            g_variant_lookup(props, "Powered", "b", &powered);
+            info.powered = powered;
+            info.links = 0;
+            adapters->push_back(std::move(info));
+            g_variant_unref(props);
+        }
+        if ((props = g_variant_lookup_value(interfaces, kDeviceInterface,
+                                            G_VARIANT_TYPE("a{sv}")))) {
+            const gchar* adapter = NULL;
+            gboolean connected = FALSE;
+            g_variant_lookup(props, "Adapter", "&o", &adapter);
+            g_variant_lookup(props, "Connected", "b", &connected);
+            if (adapter && connected) devices->emplace(adapter, path);
+            g_variant_unref(props);
+        }
+        g_variant_unref(interfaces);
+    }
+    g_variant_iter_free(iter);
+}
+
+void set_error(std::string* error, std::string message) {
+    if (error) *error = std::move(message);
+}
+
+// Runs @p fn on @p context's next iteration, never on the calling thread
+void post(GMainContext* context, GSourceFunc fn, gpointer data) {
+    GSource* source = g_idle_source_new();
+    g_source_set_callback(source, fn, data, NULL);
+    g_source_attach(source, context);
+    g_source_unref(source);
+}
+
+}  // namespace
+
+// =============================================================================
+// Adapter discovery
+// =============================================================================
+
+bool list_adapters(GDBusConnection* conn, std::vector<AdapterInfo>* out, GError** error) {
+    GVariant* reply = get_managed_objects(conn, error);
+    if (!reply) return false;
+
+    std::multimap<std::string, std::string> devices;
+    out->clear();
+    collect(reply, out, &devices);
+    g_variant_unref(reply);
+
+    for (AdapterInfo& info : *out) info.links = (unsigned)devices.count(info.path);
+    std::sort(out->begin(), out->end(),
+              [](const AdapterInfo& a, const AdapterInfo& b) { return a.path < b.path; });
+    return true;
+}
+
+bool select_adapters(const std::vector<AdapterInfo>& available, const std::string& spec,
+                     std::vector<AdapterInfo>* out, std::string* error) {
+    out->clear();
+    if (spec == "all") {
+        *out = available;
+        return true;
+    }
+
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string name = spec.substr(start, end - start);
+        start = end + 1;
+        if (name.empty()) continue;
+
+        std::string path = name[0] == '/' ? name : "/org/bluez/" + name;
+        auto same = [&path](const AdapterInfo& a) { return a.path == path; };
+        auto it = std::find_if(available.begin(), available.end(), same);
+        if (it == available.end()) {
+            set_error(error, "No adapter " + name);
+            return false;
+        }
+        if (std::any_of(out->begin(), out->end(), same)) {
+            set_error(error, "Adapter " + name + " listed twice");
+            return false;
+        }
+        out->push_back(*it);
+    }
+    if (out->empty()) {
+        set_error(error, "No adapter selected");
+        return false;
+    }
+    return true;
+}
+
+// =============================================================================
+// AdapterShard
+// =============================================================================
+
+namespace {
+
+struct ApplicationCall {
+    AdapterShard* shard;
+    AdapterShard::ReplyFn done;
+};
+
+}  // namespace
+
+void AdapterShard::run() {
+    g_main_context_push_thread_default(context_);
+
+    GError* gerror = NULL;
+    std::string error;
+    const char* address = pool_->options_.bus_address.empty() ? NULL
+                                                               : pool_->options_.bus_address.c_str();
+    connection_ = ble_dbus_connect(address, &gerror);
+    bool ok = connection_ != NULL;
+    if (!ok) {
+        error = gerror->message;
+        g_error_free(gerror);
+    }
+    ok = ok && watch_links(&error);
+    ok = ok && (!pool_->setup_ || pool_->setup_(*this, &error));
+    pool_->shard_ready(*this, ok, error);
+
+    if (ok) {
+        g_main_loop_run(loop_);
+    } else {
+        shutdown();
+    }
+    g_main_context_pop_thread_default(context_);
+}
+
+bool AdapterShard::watch_links(std::string* error) {
+    device_watch_ = g_dbus_connection_signal_subscribe(connection_, kBluezName,
+        "org.freedesktop.DBus.Properties", "PropertiesChanged", NULL, kDeviceInterface,
+        G_DBUS_SIGNAL_FLAGS_NONE, on_device_changed, this, NULL);
+    removed_watch_ = g_dbus_connection_signal_subscribe(connection_, kBluezName,
+        kObjectManagerInterface, "InterfacesRemoved", "/", NULL,
+        G_DBUS_SIGNAL_FLAGS_NONE, on_interfaces_removed, this, NULL);
+
+    // Links that were up before the watches
+    GError* gerror = NULL;
+    GVariant* reply = get_managed_objects(connection_, &gerror);
+    if (!reply) {
+        set_error(error, gerror->message);
+        g_error_free(gerror);
+        return false;
+    }
+    std::multimap<std::string, std::string> devices;
+    collect(reply, NULL, &devices);
+    g_variant_unref(reply);
+
+    auto range = devices.equal_range(adapter_.path);
+    for (auto it = range.first; it != range.second; ++it) linked_.insert(it->second);
+    links_.store((unsigned)linked_.size(), std::memory_order_relaxed);
+    return true;
+}
+
+void AdapterShard::set_link(const char* device_path, bool connected) {
+    size_t before = linked_.size();
+    if (connected) linked_.insert(device_path);
+    else linked_.erase(device_path);
+    if (linked_.size() == before) return;
+
+    links_.store((unsigned)linked_.size(), std::memory_order_relaxed);
+    pool_->links_changed();
+}
+
+void AdapterShard::on_device_changed(GDBusConnection*, const gchar*, const gchar* object_path,
+                                     const gchar*, const gchar*, GVariant* parameters,
+                                     gpointer user_data) {
+    AdapterShard* shard = (AdapterShard*)user_data;
+    const std::string& prefix = shard->adapter_.path;
+    if (strncmp(object_path, prefix.c_str(), prefix.size()) != 0 ||
+        object_path[prefix.size()] != '/') return;
+
+    GVariant* changed;
+    g_variant_get(parameters, "(&s@a{sv}@as)", NULL, &changed, NULL);
+    gboolean connected;
+    if (g_variant_lookup(changed, "Connected", "b", &connected)) {
+        shard->set_link(object_path, connected);
+    }
+    g_variant_unref(changed);
+}
+
+void AdapterShard::on_interfaces_removed(GDBusConnection*, const gchar*, const gchar*,
+                                         const gchar*, const gchar*, GVariant* parameters,
+                                         gpointer user_data) {
+    // A device object going away takes its link with it
+    AdapterShard* shard = (AdapterShard*)user_data;
+    const gchar* path;
+    g_variant_get(parameters, "(&o@as)", &path, NULL);
+    if (shard->linked_.count(path)) shard->set_link(path, false);
+}
+
+void AdapterShard::register_application(const std::string& app_path, ReplyFn done) {
+    app_path_ = app_path;
+    g_dbus_connection_call(connection_, kBluezName, adapter_.path.c_str(),
+        "org.bluez.GattManager1", "RegisterApplication",
+        g_variant_new("(oa{sv})", app_path.c_str(), NULL), NULL, G_DBUS_CALL_FLAGS_NONE,
+        kCallTimeoutMs, NULL,
+        [](GObject*, GAsyncResult* res, gpointer user_data) {
+            ApplicationCall* call = (ApplicationCall*)user_data;
+            GError* error = NULL;
+            GVariant* result = g_dbus_connection_call_finish(call->shard->connection_, res, &error);
+            if (result) g_variant_unref(result);
+            else call->shard->app_path_.clear();    // Nothing to unregister at stop()
+            if (call->done) call->done(*call->shard, error);
+            if (error) g_error_free(error);
+            delete call;
+        },
+        new ApplicationCall{this, std::move(done)});
+}
+
+void AdapterShard::advertise(const std::string& advert_path, ReplyFn done) {
+    advert_path_ = advert_path;
+    advert_done_ = std::move(done);
+    update_advertising();
+}
+
+void AdapterShard::update_advertising() {
+    if (advert_path_.empty() || advert_pending_) return;
+    bool want = !stopping_ && pool_->should_advertise(*this);
+    if (want == advertising_) return;
+
+    advert_pending_ = true;
+    GVariant* params = want ? g_variant_new("(oa{sv})", advert_path_.c_str(), NULL)
+                            : g_variant_new("(o)", advert_path_.c_str());
+    g_dbus_connection_call(connection_, kBluezName, adapter_.path.c_str(),
+        "org.bluez.LEAdvertisingManager1",
+        want ? "RegisterAdvertisement" : "UnregisterAdvertisement", params, NULL,
+        G_DBUS_CALL_FLAGS_NONE, kCallTimeoutMs, NULL, on_advertisement_reply, this);
+}
+
+void AdapterShard::on_advertisement_reply(GObject*, GAsyncResult* res, gpointer user_data) {
+    AdapterShard* shard = (AdapterShard*)user_data;
+    GError* error = NULL;
+    GVariant* result = g_dbus_connection_call_finish(shard->connection_, res, &error);
+    bool registering = !shard->advertising_;
+
+    shard->advert_pending_ = false;
+    // A failed unregistration means BlueZ no longer has it either
+    shard->advertising_ = registering && result;
+    if (result) g_variant_unref(result);
+    if (registering && shard->advert_done_) shard->advert_done_(*shard, error);
+
+    if (error) {
+        g_error_free(error);
+        return;     // Retried at the next link change
+    }
+    shard->update_advertising();
+}
+
+void AdapterShard::shutdown() {
+    if (stopping_) return;
+    stopping_ = true;
+
+    if (connection_) {
+        if (advertising_ || advert_pending_) {
+            GVariant* result = g_dbus_connection_call_sync(connection_, kBluezName,
+                adapter_.path.c_str(), "org.bluez.LEAdvertisingManager1",
+                "UnregisterAdvertisement", g_variant_new("(o)", advert_path_.c_str()), NULL,
+                G_DBUS_CALL_FLAGS_NONE, kCallTimeoutMs, NULL, NULL);
+            if (result) g_variant_unref(result);
+            advertising_ = false;
+        }
+        if (!app_path_.empty()) {
+            GVariant* result = g_dbus_connection_call_sync(connection_, kBluezName,
+                adapter_.path.c_str(), "org.bluez.GattManager1", "UnregisterApplication",
+                g_variant_new("(o)", app_path_.c_str()), NULL, G_DBUS_CALL_FLAGS_NONE,
+                kCallTimeoutMs, NULL, NULL);
+            if (result) g_variant_unref(result);
+        }
+        if (device_watch_) g_dbus_connection_signal_unsubscribe(connection_, device_watch_);
+        if (removed_watch_) g_dbus_connection_signal_unsubscribe(connection_, removed_watch_);
+        device_watch_ = removed_watch_ = 0;
+    }
+    if (pool_->teardown_) pool_->teardown_(*this);
+    g_main_loop_quit(loop_);
+}
+
+// =============================================================================
+// AdapterPool
+// =============================================================================
+
+AdapterPool::~AdapterPool() {
+    stop();
+}
+
+bool AdapterPool::start(const AdapterPoolOptions& options, ShardFn setup, TeardownFn teardown,
+                        std::string* error) {
+    GError* gerror = NULL;
+    GDBusConnection* conn = ble_dbus_connect(
+        options.bus_address.empty() ? NULL : options.bus_address.c_str(), &gerror);
+    std::vector<AdapterInfo> available;
+    if (!conn || !list_adapters(conn, &available, &gerror)) {
+        set_error(error, gerror->message);
+        g_error_free(gerror);
+        if (conn) g_object_unref(conn);
+        return false;
+    }
+    g_object_unref(conn);
+
+    std::vector<AdapterInfo> selected;
+    if (!select_adapters(available, options.adapters, &selected, error)) return false;
+    if (selected.empty()) {
+        set_error(error, "No Bluetooth adapters");
+        return false;
+    }
+
+    options_ = options;
+    setup_ = std::move(setup);
+    teardown_ = std::move(teardown);
+    for (size_t i = 0; i < selected.size(); i++) {
+        AdapterShard* shard = new AdapterShard(this, i, selected[i]);
+        shard->context_ = g_main_context_new();
+        shard->loop_ = g_main_loop_new(shard->context_, FALSE);
+        shards_.emplace_back(shard);
+    }
+    // Started only once shards_ is complete; shards read each other's links
+    for (auto& shard : shards_) shard->thread_ = std::thread(&AdapterShard::run, shard.get());
+
+    std::string failure;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_cond_.wait(lock, [this] {
+            return std::all_of(shards_.begin(), shards_.end(),
+                               [](const std::unique_ptr<AdapterShard>& s) { return s->ready_; });
+        });
+        for (auto& shard : shards_) {
+            if (shard->failed_ && failure.empty()) {
+                failure = shard->adapter_.name + ": " + shard->error_;
+            }
+        }
+    }
+    if (!failure.empty()) {
+        stop();
+        set_error(error, failure);
+        return false;
+    }
+    return true;
+}
+
+void AdapterPool::shard_ready(AdapterShard& shard, bool ok, std::string error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shard.ready_ = true;
+    shard.failed_ = !ok;
+    shard.error_ = std::move(error);
+    ready_cond_.notify_all();
+}
+
+void AdapterPool::stop() {
+    for (auto& shard : shards_) {
+        post(shard->context_, [](gpointer data) {
+            ((AdapterShard*)data)->shutdown();
+            return (gboolean)G_SOURCE_REMOVE;
+        }, shard.get());
+    }
+    for (auto& shard : shards_) {
+        if (shard->thread_.joinable()) shard->thread_.join();
+    }
+    for (auto& shard : shards_) {
+        if (shard->connection_) g_object_unref(shard->connection_);
+        g_main_loop_unref(shard->loop_);
+        g_main_context_unref(shard->context_);
+    }
+    shards_.clear();
+}
+
+unsigned AdapterPool::links() const {
+    unsigned total = 0;
+    for (const auto& shard : shards_) total += shard->links();
+    return total;
+}
+
+bool AdapterPool::should_advertise(const AdapterShard& shard) const {
+    unsigned links = shard.links();
+    if (options_.max_links && links >= options_.max_links) return false;
+
+    unsigned least = links;
+    for (const auto& other : shards_) least = std::min(least, other->links());
+    return links <= least + options_.link_spread;
+}
+
+void AdapterPool::links_changed() {
+    // Every adapter's share may have changed, not only the one that moved
+    for (auto& shard : shards_) {
+        post(shard->context_, [](gpointer data) {
+            ((AdapterShard*)data)->update_advertising();
+            return (gboolean)G_SOURCE_REMOVE;
+        }, shard.get());
+    }
+}
+
+}  // namespace ble
@@ -0,0 +1,102 @@
+#define _POSIX_C_SOURCE 200809L  /* strnlen */
+
+#include "ble_addr.h"
+
+#include <string.h>
+
+/*
+ * Branch-free hex digit decode. For valid digits (c & 0xF) + 9 * (c >> 6)
+ * yields 0-9 for '0'-'9' and 10-15 for 'A'-'F'/'a'-'f'; *bad collects a
+ * non-zero value for anything that is not a hex digit.
+ */
+static inline uint64_t hex_nibble(uint8_t c, uint32_t *bad) {
+    uint32_t lower = c | 0x20u;
+    uint32_t is_digit = (uint32_t)(c - '0') < 10u;
+    uint32_t is_alpha = (uint32_t)(lower - 'a') < 6u;
+    *bad |= (is_digit | is_alpha) ^ 1u;
+    return (uint64_t)((c & 0xFu) + 9u * (c >> 6));
+}
+
+bool ble_addr_parse17(const char *chars, ble_addr_t *out) {
+    const uint8_t *s = (const uint8_t *)chars;
+    uint32_t bad = 0;
+    uint64_t v = 0;
+
+    bad |= (uint32_t)(s[2] ^ ':') | (uint32_t)(s[5] ^ ':') | (uint32_t)(s[8] ^ ':') |
+           (uint32_t)(s[11] ^ ':') | (uint32_t)(s[14] ^ ':');
+
+    for (int byte = 0; byte < 6; byte++) {
+        v = (v << 4) | hex_nibble(s[byte * 3], &bad);
+        v = (v << 4) | hex_nibble(s[byte * 3 + 1], &bad);
+    }
+
+    out->value = bad ? 0 : v;
+    return bad == 0;
+}
+
+bool ble_addr_parse(const char *str, ble_addr_t *out) {
+    if (!str || strnlen(str, BLE_ADDR_SIZE) != BLE_ADDR_SIZE - 1) {
+        out->value = 0;
+        return false;
+    }
+    return ble_addr_parse17(str, out);
+}
+
+/* Two uppercase hex characters per byte value */
+static const char hex_pairs[513] =
+    "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+void ble_addr_format(ble_addr_t addr, char *out) {
+    for (int byte = 0; byte < 6; byte++) {
+        uint8_t b = (uint8_t)(addr.value >> (40 - 8 * byte));
+        memcpy(out + byte * 3, hex_pairs + 2 * b, 2);
+        out[byte * 3 + 2] = ':';
+    }
+    out[17] = '\0';
+}
+
+size_t ble_addr_parse_batch(const char *const *strs, size_t n,
+                            ble_addr_t *out, uint8_t *valid) {
+    size_t ok = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t v = ble_addr_parse(strs[i], &out[i]);
+        if (valid) valid[i] = v;
+        ok += v;
+    }
+    return ok;
+}
+
+size_t ble_addr_validate_batch(const char *const *strs, size_t n, uint8_t *valid) {
+    size_t ok = 0;
+    for (size_t i = 0; i < n; i++) {
+        ble_addr_t scratch;
+        uint8_t v = ble_addr_parse(strs[i], &scratch);
+        if (valid) valid[i] = v;
+        ok += v;
+    }
+    return ok;
+}
+
+size_t ble_addr_parse_strided(const char *base, size_t stride, size_t n,
+                              ble_addr_t *out, uint8_t *valid) {
+    size_t ok = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t v = ble_addr_parse17(base + i * stride, &out[i]);
+        if (valid) valid[i] = v;
+        ok += v;
+    }
+    return ok;
+}
+
+void ble_addr_format_batch(const ble_addr_t *addrs, size_t n, char *out) {
+    for (size_t i = 0; i < n; i++) {
+        ble_addr_format(addrs[i], out + i * BLE_ADDR_SIZE);
+    }
+}
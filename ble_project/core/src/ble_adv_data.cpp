@@ -0,0 +1,287 @@
+#include "ble_adv_data.hpp"
+
+#include <cstring>
+
+namespace ble {
+
+namespace {
+
+inline uint16_t le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t le32(const uint8_t* p) {
+    return (uint32_t)le16(p) | ((uint32_t)le16(p + 2) << 16);
+}
+
+inline uint64_t le64(const uint8_t* p) {
+    return (uint64_t)le32(p) | ((uint64_t)le32(p + 4) << 32);
+}
+
+// 128-bit UUIDs are sent least significant byte first
+inline ble_uuid_t uuid128_le(const uint8_t* p) {
+    return ble_uuid_t{le64(p + 8), le64(p)};
+}
+
+// Width of one UUID in a service UUID list, or 0 for other types
+inline size_t uuid_list_width(uint8_t type) {
+    switch (type) {
+    case kAdUuid16Incomplete:
+    case kAdUuid16Complete: return 2;
+    case kAdUuid32Incomplete:
+    case kAdUuid32Complete: return 4;
+    case kAdUuid128Incomplete:
+    case kAdUuid128Complete: return 16;
+    default: return 0;
+    }
+}
+
+inline ble_uuid_t uuid_at(const uint8_t* p, size_t width) {
+    if (width == 2) return ble_uuid_from16(le16(p));
+    if (width == 4) return ble_uuid_from32(le32(p));
+    return uuid128_le(p);
+}
+
+inline uint64_t rotl64(uint64_t x, unsigned r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t fmix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+size_t round_up_pow2(size_t n) {
+    size_t p = 16;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+}  // namespace
+
+// =============================================================================
+// AdData
+// =============================================================================
+
+bool AdData::parse(const uint8_t* payload, size_t len) {
+    payload_ = payload;
+    present_ = 0;
+    count_ = 0;
+    valid_ = true;
+    if (len > kAdMaxPayload) len = kAdMaxPayload;
+
+    size_t pos = 0;
+    while (pos < len) {
+        size_t field_len = payload[pos];
+        if (field_len == 0) break;
+        if (pos + 1 + field_len > len || count_ == kAdMaxFields) {
+            valid_ = false;
+            break;
+        }
+        uint8_t type = payload[pos + 1];
+        fields_[count_++] = AdField{type, (uint16_t)(pos + 2), (uint16_t)(field_len - 1)};
+        present_ |= 1ull << type_bit(type);
+        pos += 1 + field_len;
+    }
+    return valid_;
+}
+
+const AdField* AdData::find(uint8_t type) const {
+    if (!may_have(type)) return nullptr;
+    for (size_t i = 0; i < count_; i++) {
+        if (fields_[i].type == type) return &fields_[i];
+    }
+    return nullptr;
+}
+
+bool AdData::flags(uint8_t* out) const {
+    const AdField* f = find(kAdFlags);
+    if (!f || f->len < 1) return false;
+    *out = payload_[f->offset];
+    return true;
+}
+
+bool AdData::tx_power(int8_t* dbm) const {
+    const AdField* f = find(kAdTxPower);
+    if (!f || f->len < 1) return false;
+    *dbm = (int8_t)payload_[f->offset];
+    return true;
+}
+
+bool AdData::appearance(uint16_t* out) const {
+    const AdField* f = find(kAdAppearance);
+    if (!f || f->len < 2) return false;
+    *out = le16(payload_ + f->offset);
+    return true;
+}
+
+ByteView AdData::local_name(bool* complete) const {
+    const AdField* f = find(kAdNameComplete);
+    if (complete) *complete = f != nullptr;
+    if (!f) f = find(kAdNameShort);
+    if (!f) return ByteView{nullptr, 0};
+    return view(*f);
+}
+
+bool AdData::manufacturer_data(uint16_t* company_id, ByteView* data) const {
+    const AdField* f = find(kAdManufacturerData);
+    if (!f || f->len < 2) return false;
+    *company_id = le16(payload_ + f->offset);
+    *data = ByteView{payload_ + f->offset + 2, (size_t)f->len - 2};
+    return true;
+}
+
+size_t AdData::service_uuids(ble_uuid_t* out, size_t max) const {
+    size_t total = 0;
+    for (size_t i = 0; i < count_; i++) {
+        size_t width = uuid_list_width(fields_[i].type);
+        if (!width) continue;
+        const uint8_t* p = payload_ + fields_[i].offset;
+        for (size_t n = fields_[i].len / width; n > 0; n--, p += width) {
+            if (total < max) out[total] = uuid_at(p, width);
+            total++;
+        }
+    }
+    return total;
+}
+
+bool AdData::has_service(const ble_uuid_t& uuid) const {
+    const bool sig = ble_uuid_is_sig(&uuid);
+    const uint32_t value = ble_uuid_sig_value(&uuid);
+    for (size_t i = 0; i < count_; i++) {
+        size_t width = uuid_list_width(fields_[i].type);
+        if (!width || (width != 16 && !sig)) continue;
+        const uint8_t* p = payload_ + fields_[i].offset;
+        for (size_t n = fields_[i].len / width; n > 0; n--, p += width) {
+            bool match = width == 2 ? le16(p) == value
+                       : width == 4 ? le32(p) == value
+                       : le64(p + 8) == uuid.hi && le64(p) == uuid.lo;
+            if (match) return true;
+        }
+    }
+    return false;
+}
+
+bool AdData::split_service_data(const AdField& field, ble_uuid_t* uuid, ByteView* data) const {
+    size_t width = field.type == kAdServiceData16 ? 2
+                 : field.type == kAdServiceData32 ? 4
+                 : field.type == kAdServiceData128 ? 16 : 0;
+    if (!width || field.len < width) return false;
+    const uint8_t* p = payload_ + field.offset;
+    *uuid = uuid_at(p, width);
+    *data = ByteView{p + width, field.len - width};
+    return true;
+}
+
+bool AdData::service_data(const ble_uuid_t& uuid, ByteView* data) const {
+    if (!has(kAdServiceData16) && !has(kAdServiceData32) && !has(kAdServiceData128)) return false;
+    for (size_t i = 0; i < count_; i++) {
+        ble_uuid_t candidate;
+        if (split_service_data(fields_[i], &candidate, data) && ble_uuid_equal(&candidate, &uuid)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// =============================================================================
+// Change detection
+// =============================================================================
+
+// One multiply and rotate per 8 bytes, with a full avalanche only at the
+// end: a legacy payload is four words, so this stays a few nanoseconds.
+uint64_t ad_hash(const uint8_t* payload, size_t len) noexcept {
+    const uint64_t k = 0x9e3779b97f4a7c15ULL;
+    uint64_t h = k ^ len;
+    while (len >= 8) {
+        uint64_t word;
+        memcpy(&word, payload, 8);
+        h = rotl64((h ^ word) * k, 29);
+        payload += 8;
+        len -= 8;
+    }
+    if (len) {
+        uint64_t word = 0;
+        memcpy(&word, payload, len);
+        h = rotl64((h ^ word) * k, 29);
+    }
+    return fmix64(h) | 1;                   // 0 marks "not seen yet"
+}
+
+AdvertCache::AdvertCache(size_t initial_capacity)
+    : entries_(round_up_pow2(initial_capacity)),
+      used_(entries_.size(), 0),
+      mask_(entries_.size() - 1) {}
+
+size_t AdvertCache::probe(ble_addr_t addr) const {
+    size_t i = ble_addr_hash(addr) & mask_;
+    while (used_[i] && entries_[i].addr != addr) i = (i + 1) & mask_;
+    return i;
+}
+
+void AdvertCache::rehash(size_t new_capacity) {
+    std::vector<Entry> old_entries(new_capacity);
+    std::vector<uint8_t> old_used(new_capacity, 0);
+    old_entries.swap(entries_);
+    old_used.swap(used_);
+    mask_ = new_capacity - 1;
+
+    for (size_t i = 0; i < old_entries.size(); i++) {
+        if (!old_used[i]) continue;
+        size_t j = probe(old_entries[i].addr);
+        entries_[j] = old_entries[i];
+        used_[j] = 1;
+    }
+}
+
+bool AdvertCache::update(ble_addr_t addr, bool scan_response, const uint8_t* payload, size_t len) {
+    const uint64_t h = ad_hash(payload, len);
+    stats_.seen++;
+
+    size_t i = probe(addr);
+    if (used_[i]) {
+        uint64_t& last = entries_[i].hash[scan_response];
+        if (last == h) return false;
+        last = h;
+        stats_.changed++;
+        return true;
+    }
+
+    if ((size_ + 1) * 10 > entries_.size() * 7) {
+        rehash(entries_.size() * 2);
+        i = probe(addr);
+    }
+    Entry& e = entries_[i];
+    used_[i] = 1;
+    size_++;
+    e.addr = addr;
+    e.hash[0] = e.hash[1] = 0;
+    e.hash[scan_response] = h;
+    stats_.changed++;
+    return true;
+}
+
+void AdvertCache::forget(ble_addr_t addr) {
+    size_t i = probe(addr);
+    if (!used_[i]) return;
+    used_[i] = 0;
+    size_--;
+
+    // Backward-shift the rest of the cluster so probes do not stop early
+    for (size_t j = (i + 1) & mask_; used_[j]; j = (j + 1) & mask_) {
+        size_t home = ble_addr_hash(entries_[j].addr) & mask_;
+        // Move j into the hole unless its home lies cyclically in (i, j]
+        bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+        if (stays) continue;
+        entries_[i] = entries_[j];
+        used_[i] = 1;
+        used_[j] = 0;
+        i = j;
+    }
+}
+
+}  // namespace ble
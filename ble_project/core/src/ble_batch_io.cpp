@@ -0,0 +1,200 @@
+#include "ble_batch_io.hpp"
+#include "ble_metrics.hpp"
+
+namespace ble {
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// Indexed by GattOpType; covers BlueZ, D-Bus and the peer
+struct OpMetrics {
+    Histogram seconds[3];
+    Counter errors[3];
+
+    OpMetrics() {
+        static const char* const kLabels[] = {
+            "op=\"read\"", "op=\"write\"", "op=\"write_without_response\""};
+        Metrics& m = Metrics::global();
+        for (int i = 0; i < 3; i++) {
+            seconds[i] = m.histogram("ble_gatt_op_seconds", kLabels[i],
+                                     "gattlib read/write call duration on the central");
+            errors[i] = m.counter("ble_gatt_op_errors_total", kLabels[i],
+                                  "gattlib read/write calls that returned an error");
+        }
+    }
+};
+
+const OpMetrics& op_metrics() {
+    static const OpMetrics metrics;
+    return metrics;
+}
+
+}  // namespace
+
+// =============================================================================
+// Ops
+// =============================================================================
+
+GattOp GattOp::read(gattlib_connection_t* connection, const uuid_t& uuid) {
+    return GattOp{connection, GattOpType::Read, uuid, 0, {}};
+}
+
+GattOp GattOp::read(gattlib_connection_t* connection, uint16_t handle) {
+    return GattOp{connection, GattOpType::Read, uuid_t{}, handle, {}};
+}
+
+GattOp GattOp::write(gattlib_connection_t* connection, const uuid_t& uuid,
+                     const void* data, size_t len, bool with_response) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    return GattOp{connection,
+                  with_response ? GattOpType::Write : GattOpType::WriteWithoutResponse,
+                  uuid, 0, std::vector<uint8_t>(bytes, bytes + len)};
+}
+
+GattOp GattOp::write(gattlib_connection_t* connection, uint16_t handle,
+                     const void* data, size_t len, bool with_response) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    return GattOp{connection,
+                  with_response ? GattOpType::Write : GattOpType::WriteWithoutResponse,
+                  uuid_t{}, handle, std::vector<uint8_t>(bytes, bytes + len)};
+}
+
+bool resolve(const GattTable& table, GattOp* op) {
+    for (const gattlib_characteristic_t& chr : table.characteristics) {
+        if (op->handle) {
+            if (chr.value_handle != op->handle) continue;
+            op->uuid = chr.uuid;
+            return true;
+        }
+        if (gattlib_uuid_cmp(&chr.uuid, &op->uuid) == 0) {
+            op->handle = chr.value_handle;
+            return true;
+        }
+    }
+    return false;
+}
+
+// =============================================================================
+// BatchIo
+// =============================================================================
+
+BatchIo::BatchIo(size_t threads, size_t depth) : depth_(depth ? depth : 1) {
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; i++) workers_.emplace_back(&BatchIo::worker, this);
+}
+
+BatchIo::~BatchIo() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    jobs_ready_.notify_all();
+    for (std::thread& t : workers_) t.join();
+}
+
+BatchResult BatchIo::run(const std::vector<GattOp>& ops) {
+    BatchResult out;
+    out.results.resize(ops.size());
+    out.failed = 0;
+
+    Clock::time_point start = Clock::now();
+    if (!ops.empty()) {
+        Batch batch;
+        batch.ops = &ops;
+        batch.results = &out.results;
+        batch.remaining = ops.size();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < ops.size(); i++) jobs_.push_back(Job{&batch, i});
+        jobs_ready_.notify_all();
+        batch.done.wait(lock, [&batch] { return batch.remaining == 0; });
+    }
+    out.elapsed = Clock::now() - start;
+
+    for (const GattResult& result : out.results) {
+        if (result.error != GATTLIB_SUCCESS) out.failed++;
+    }
+    return out;
+}
+
+bool BatchIo::next_job(Job* out) {
+    // First queued op whose connection still has room in its pipeline
+    for (auto it = jobs_.begin(); it != jobs_.end(); ++it) {
+        gattlib_connection_t* connection = (*it->batch->ops)[it->index].connection;
+        auto slot = in_flight_.find(connection);
+        if (slot != in_flight_.end() && slot->second >= depth_) continue;
+        in_flight_[connection]++;
+        *out = *it;
+        jobs_.erase(it);
+        return true;
+    }
+    return false;
+}
+
+void BatchIo::worker() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        Job job;
+        jobs_ready_.wait(lock, [&] { return !running_ || next_job(&job); });
+        if (!running_) return;
+
+        const GattOp& op = (*job.batch->ops)[job.index];
+        lock.unlock();
+        GattResult result = execute(op);
+        lock.lock();
+
+        (*job.batch->results)[job.index] = std::move(result);
+        auto it = in_flight_.find(op.connection);
+        if (--it->second == 0) in_flight_.erase(it);
+        if (--job.batch->remaining == 0) job.batch->done.notify_all();
+        if (!jobs_.empty()) jobs_ready_.notify_one();
+    }
+}
+
+GattResult BatchIo::execute(const GattOp& op) {
+    GattResult result{GATTLIB_SUCCESS, {}, {}};
+    uuid_t uuid = op.uuid;
+    Clock::time_point start = Clock::now();
+
+    switch (op.type) {
+    case GattOpType::Read: {
+        if (op.handle && uuid.type == 0) {
+            result.error = GATTLIB_INVALID_PARAMETER;   // not resolved
+            break;
+        }
+        void* value = nullptr;
+        size_t len = 0;
+        result.error = gattlib_read_char_by_uuid(op.connection, &uuid, &value, &len);
+        if (result.error == GATTLIB_SUCCESS) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(value);
+            result.value.assign(bytes, bytes + len);
+            gattlib_characteristic_free_value(value);
+        }
+        break;
+    }
+    case GattOpType::Write:
+        result.error = op.handle
+            ? gattlib_write_char_by_handle(op.connection, op.handle, op.data.data(), op.data.size())
+            : gattlib_write_char_by_uuid(op.connection, &uuid, op.data.data(), op.data.size());
+        break;
+    case GattOpType::WriteWithoutResponse:
+        result.error = op.handle
+            ? gattlib_write_without_response_char_by_handle(op.connection, op.handle,
+                                                            op.data.data(), op.data.size())
+            : gattlib_write_without_response_char_by_uuid(op.connection, &uuid,
+                                                          op.data.data(), op.data.size());
+        break;
+    }
+
+    result.latency = Clock::now() - start;
+
+    const OpMetrics& metrics = op_metrics();
+    int type = (int)op.type;
+    metrics.seconds[type].record(
+        (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(result.latency).count());
+    if (result.error != GATTLIB_SUCCESS) metrics.errors[type].inc();
+    return result;
+}
+
+}  // namespace ble
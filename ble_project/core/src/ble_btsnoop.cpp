@@ -0,0 +1,307 @@
+#include "ble_btsnoop.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace ble {
+
+namespace {
+
+constexpr char kMagic[8] = {'b', 't', 's', 'n', 'o', 'o', 'p', 0};
+constexpr size_t kFileHeader = 16;
+constexpr size_t kRecordHeader = 24;
+
+// Timestamps count microseconds from 0000-01-01 (proleptic Gregorian)
+constexpr uint64_t kEpochDelta = 0x00dcddb30f2f8000ULL;
+
+constexpr uint8_t kH4Event = 0x04;
+constexpr uint32_t kH1CommandOrEvent = 0x02;
+constexpr uint32_t kH1Received = 0x01;
+constexpr uint16_t kMonitorEvent = 3;
+
+constexpr uint8_t kEventLeMeta = 0x3E;
+constexpr uint8_t kLeAdvertisingReport = 0x02;
+constexpr uint8_t kLeExtendedAdvertisingReport = 0x0D;
+constexpr uint8_t kAdvScanRsp = 0x04;
+constexpr uint16_t kExtAdvScanRsp = 0x0008;
+
+inline uint32_t be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+inline uint64_t be64(const uint8_t* p) {
+    return ((uint64_t)be32(p) << 32) | be32(p + 4);
+}
+
+inline uint64_t le48(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 5; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+// Address types 0/2 are public, 1/3 random (the latter two resolved from an RPA)
+inline ble_addr_t report_address(uint8_t type, const uint8_t* p) {
+    return ble_addr_make(le48(p), (type & 1) ? BLE_ADDR_RANDOM : BLE_ADDR_PUBLIC);
+}
+
+}  // namespace
+
+// =============================================================================
+// BtsnoopFile
+// =============================================================================
+
+BtsnoopFile::~BtsnoopFile() {
+    close();
+}
+
+void BtsnoopFile::close() {
+    if (map_) munmap(const_cast<uint8_t*>(map_), size_);
+    map_ = nullptr;
+    size_ = end_ = records_ = 0;
+    last_us_ = 0;
+    truncated_ = false;
+    index_.clear();
+}
+
+bool BtsnoopFile::open(const char* path, std::string* error) {
+    close();
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *error = strerror(errno);
+        return false;
+    }
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= kFileHeader) {
+        map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        *error = "not a btsnoop file";
+        return false;
+    }
+    map_ = static_cast<const uint8_t*>(map);
+    size_ = (size_t)st.st_size;
+
+    if (memcmp(map_, kMagic, sizeof(kMagic)) != 0 || be32(map_ + 8) != 1) {
+        close();
+        *error = "not a btsnoop version 1 file";
+        return false;
+    }
+    datalink_ = be32(map_ + 12);
+    if (datalink_ != kBtsnoopHciH1 && datalink_ != kBtsnoopHciH4 && datalink_ != kBtsnoopMonitor) {
+        close();
+        *error = "unsupported datalink " + std::to_string(datalink_);
+        return false;
+    }
+
+    // One pass over the record headers; the kernel reads ahead for us
+    madvise(map, size_, MADV_SEQUENTIAL);
+    size_t offset = kFileHeader;
+    BtsnoopRecord record;
+    while (size_t next = read(offset, &record)) {
+        if (records_ % kIndexStride == 0) index_.push_back(IndexEntry{offset, record.timestamp_us});
+        last_us_ = record.timestamp_us;
+        records_++;
+        offset = next;
+    }
+    end_ = offset;
+    truncated_ = end_ != size_;
+    madvise(map, size_, MADV_NORMAL);
+    return true;
+}
+
+size_t BtsnoopFile::read(size_t offset, BtsnoopRecord* out) const {
+    if (offset + kRecordHeader > size_) return 0;
+    const uint8_t* h = map_ + offset;
+    uint32_t len = be32(h + 4);
+    if (len > size_ - offset - kRecordHeader) return 0;
+    uint64_t ts = be64(h + 16);
+    out->timestamp_us = ts > kEpochDelta ? ts - kEpochDelta : 0;
+    out->flags = be32(h + 8);
+    out->len = len;
+    out->data = h + kRecordHeader;
+    return offset + kRecordHeader + len;
+}
+
+const uint8_t* BtsnoopFile::hci_event(const BtsnoopRecord& record, size_t* len) const {
+    switch (datalink_) {
+    case kBtsnoopHciH4:
+        if (record.len < 2 || record.data[0] != kH4Event) return nullptr;
+        *len = record.len - 1;
+        return record.data + 1;
+    case kBtsnoopHciH1:
+        if ((record.flags & (kH1CommandOrEvent | kH1Received)) != (kH1CommandOrEvent | kH1Received)) {
+            return nullptr;
+        }
+        break;
+    case kBtsnoopMonitor:
+        if ((record.flags & 0xFFFF) != kMonitorEvent) return nullptr;
+        break;
+    default:
+        return nullptr;
+    }
+    *len = record.len;
+    return record.len >= 2 ? record.data : nullptr;
+}
+
+BtsnoopRange BtsnoopFile::all() const {
+    return BtsnoopRange{kFileHeader, end_, index_.empty() ? 0 : index_.front().timestamp_us,
+                        last_us_, records_};
+}
+
+std::vector<BtsnoopRange> BtsnoopFile::split(size_t parts) const {
+    std::vector<BtsnoopRange> ranges;
+    parts = std::max<size_t>(1, std::min(parts, index_.size()));
+    if (index_.empty()) {
+        ranges.push_back(all());
+        return ranges;
+    }
+    // Cut at index entries, so each range starts on a known record
+    for (size_t p = 0; p < parts; p++) {
+        size_t first = index_.size() * p / parts;
+        size_t last = index_.size() * (p + 1) / parts;
+        BtsnoopRange r;
+        r.begin = index_[first].offset;
+        r.first_us = index_[first].timestamp_us;
+        r.end = last < index_.size() ? index_[last].offset : end_;
+        r.last_us = last < index_.size() ? index_[last].timestamp_us : last_us_;
+        r.records = (last < index_.size() ? last * kIndexStride : records_) - first * kIndexStride;
+        ranges.push_back(r);
+    }
+    return ranges;
+}
+
+// =============================================================================
+// Advertising reports
+// =============================================================================
+
+size_t hci_adv_reports(const uint8_t* event, size_t len, uint64_t timestamp_us,
+                       AdvReport* out, size_t max) {
+    // Event code, parameter length, subevent code, number of reports
+    if (len < 4 || event[0] != kEventLeMeta) return 0;
+    const uint8_t subevent = event[2];
+    if (subevent != kLeAdvertisingReport && subevent != kLeExtendedAdvertisingReport) return 0;
+
+    const uint8_t* p = event + 4;
+    const uint8_t* end = event + std::min<size_t>(len, 2 + (size_t)event[1]);
+    size_t n = std::min<size_t>(event[3], max);
+    size_t count = 0;
+    for (; count < n; count++) {
+        AdvReport& r = out[count];
+        r.timestamp_us = timestamp_us;
+        if (subevent == kLeAdvertisingReport) {
+            // Event type, address type, address, data length, data, RSSI
+            if (end - p < 10 || end - p < 10 + p[8]) break;
+            r.event_type = p[0];
+            r.scan_response = p[0] == kAdvScanRsp;
+            r.extended = false;
+            r.address = report_address(p[1], p + 2);
+            r.data_len = p[8];
+            r.data = p + 9;
+            r.rssi = (int8_t)p[9 + r.data_len];
+            p += 10 + r.data_len;
+        } else {
+            // Event type (2), address type, address, PHYs (2), SID, TX power,
+            // RSSI, periodic interval (2), direct address type and address,
+            // data length, data
+            if (end - p < 24 || end - p < 24 + p[23]) break;
+            r.event_type = (uint16_t)(p[0] | (p[1] << 8));
+            r.scan_response = (r.event_type & kExtAdvScanRsp) != 0;
+            r.extended = true;
+            r.address = report_address(p[2], p + 3);
+            r.rssi = (int8_t)p[13];
+            r.data_len = p[23];
+            r.data = p + 24;
+            p += 24 + r.data_len;
+        }
+    }
+    return count;
+}
+
+// =============================================================================
+// Replay
+// =============================================================================
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+ReplayStats replay_range(const BtsnoopFile& file, const BtsnoopRange& range, double speed,
+                         size_t shard, const AdvReportFn& fn) {
+    ReplayStats stats = {};
+    AdvReport reports[kHciMaxAdvReports];
+    const Clock::time_point start = Clock::now();
+    Clock::time_point now = start;
+
+    BtsnoopRecord record;
+    size_t offset = range.begin;
+    while (offset < range.end) {
+        offset = file.read(offset, &record);
+        if (!offset) break;
+        stats.records++;
+
+        size_t len;
+        const uint8_t* event = file.hci_event(record, &len);
+        if (!event) continue;
+        size_t n = hci_adv_reports(event, len, record.timestamp_us, reports, kHciMaxAdvReports);
+        if (!n) continue;
+
+        if (speed > 0) {
+            // Read the clock only when the capture gets ahead of it. A record
+            // older than the first (host clock step, merged captures) is due now.
+            uint64_t offset_us = record.timestamp_us > range.first_us
+                                     ? record.timestamp_us - range.first_us : 0;
+            auto due = start + std::chrono::microseconds((int64_t)(offset_us / speed));
+            if (due > now) {
+                now = Clock::now();
+                if (due > now) {
+                    std::this_thread::sleep_until(due);
+                    now = due;
+                }
+            }
+        }
+        for (size_t i = 0; i < n; i++) fn(shard, reports[i]);
+        stats.events++;
+        stats.reports += n;
+    }
+    stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
+
+}  // namespace
+
+ReplayStats replay_adv_reports(const BtsnoopFile& file, const ReplayOptions& options,
+                               const AdvReportFn& fn) {
+    if (options.threads <= 1) return replay_range(file, file.all(), options.speed, 0, fn);
+
+    std::vector<BtsnoopRange> ranges = file.split(options.threads);
+    std::vector<ReplayStats> results(ranges.size());
+    std::vector<std::thread> threads;
+    const Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < ranges.size(); i++) {
+        threads.emplace_back([&, i] {
+            results[i] = replay_range(file, ranges[i], options.speed, i, fn);
+        });
+    }
+    for (std::thread& t : threads) t.join();
+
+    ReplayStats total = {};
+    for (const ReplayStats& r : results) {
+        total.records += r.records;
+        total.events += r.events;
+        total.reports += r.reports;
+    }
+    total.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return total;
+}
+
+}  // namespace ble
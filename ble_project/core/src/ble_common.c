@@ -1,30 +1,23 @@
 #include "ble_common.h"
+#include "ble_uuid.h"
 #include <stdio.h>
-#include <string.h>
-#include <ctype.h>
 
 const char* ble_uuid_to_name(const char* uuid) {
-    if (strcmp(uuid, "0000180d-0000-1000-8000-00805f9b34fb") == 0) return "Heart Rate";
-    if (strcmp(uuid, "0000180f-0000-1000-8000-00805f9b34fb") == 0) return "Battery";
-    if (strcmp(uuid, "0000180a-0000-1000-8000-00805f9b34fb") == 0) return "Device Info";
-    if (strcmp(uuid, "6e400001-b5a3-f393-e0a9-e50e24dcca9e") == 0) return "Nordic UART";
-    return "Unknown";
+    ble_uuid_t parsed;
+    if (!ble_uuid_parse(uuid, &parsed)) return "Unknown";
+    const ble_uuid_info_t* info = ble_uuid_lookup(&parsed);
+    return info ? info->name : "Unknown";
 }
 
 bool ble_is_valid_address(const char* address) {
-    if (!address || strlen(address) != 17) return false;
-    for (int i = 0; i < 17; i++) {
-        if (i % 3 == 2) {
-            if (address[i] != ':') return false;
-        } else {
-            if (!isxdigit(address[i])) return false;
-        }
-    }
-    return true;
+    ble_addr_t parsed;
+    return ble_addr_parse(address, &parsed);
 }
 
 void ble_print_device(const ble_device_t* device) {
-    printf("Device: %s\n", device->name[0] ? device->name : "Unknown");
-    printf("  Address: %s\n", device->address);
+    char address[BLE_ADDR_SIZE];
+    ble_addr_format(device->address, address);
+    printf("Device: %s\n", device->name && device->name[0] ? device->name : "Unknown");
+    printf("  Address: %s\n", address);
     printf("  RSSI: %d dBm\n", device->rssi);
 }
@@ -0,0 +1,557 @@
+#include "ble_connection_manager.hpp"
+#include "ble_gattlib.hpp"
+#include "ble_metrics.hpp"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+namespace ble {
+
+namespace {
+
+struct LinkMetrics {
+    Metrics& m = Metrics::global();
+    Histogram connect = m.histogram("ble_connect_seconds", "",
+                                    "gattlib_connect() to a successful connect callback");
+    Histogram discovery = m.histogram("ble_discovery_seconds", "",
+                                      "Service and characteristic discovery, cache lookups included");
+    Counter attempts = m.counter("ble_connect_attempts_total", "", "gattlib_connect() calls");
+    Counter connect_failures = m.counter("ble_link_failures_total", "stage=\"connect\"",
+                                         "Failed connection attempts by stage");
+    Counter discovery_failures = m.counter("ble_link_failures_total", "stage=\"discovery\"",
+                                           "Failed connection attempts by stage");
+    Counter drops = m.counter("ble_link_drops_total", "", "Ready links that disconnected");
+};
+
+const LinkMetrics& link_metrics() {
+    static const LinkMetrics metrics;
+    return metrics;
+}
+
+uint64_t elapsed_ns(std::chrono::steady_clock::time_point since) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - since).count();
+}
+
+bool read_database_hash(gattlib_connection_t* connection, DatabaseHash* out) {
+    uuid_t uuid = to_gattlib(uuid16(kDatabaseHashUuid));
+    void* value = nullptr;
+    size_t len = 0;
+    if (gattlib_read_char_by_uuid(connection, &uuid, &value, &len) != GATTLIB_SUCCESS) {
+        return false;
+    }
+    bool ok = len == out->size();
+    if (ok) memcpy(out->data(), value, len);
+    gattlib_characteristic_free_value(value);
+    return ok;
+}
+
+void table_from_cache(const CachedTable& cached, GattTable* table) {
+    table->services.resize(cached.service_count());
+    for (size_t i = 0; i < cached.service_count(); i++) {
+        const CachedService& in = cached.services()[i];
+        gattlib_primary_service_t& out = table->services[i];
+        out.attr_handle_start = in.start_handle;
+        out.attr_handle_end = in.end_handle;
+        out.uuid = to_gattlib(in.uuid);
+    }
+    table->characteristics.resize(cached.characteristic_count());
+    for (size_t i = 0; i < cached.characteristic_count(); i++) {
+        const CachedCharacteristic& in = cached.characteristics()[i];
+        gattlib_characteristic_t& out = table->characteristics[i];
+        out.handle = in.handle;
+        out.value_handle = in.value_handle;
+        out.properties = in.properties;
+        out.uuid = to_gattlib(in.uuid);
+    }
+}
+
+bool store_table(DiscoveryCache* cache, ble_addr_t address, const DatabaseHash& hash,
+                 const GattTable& table) {
+    std::vector<CachedService> services(table.services.size());
+    for (size_t i = 0; i < services.size(); i++) {
+        const gattlib_primary_service_t& in = table.services[i];
+        services[i].uuid = from_gattlib(in.uuid);
+        services[i].start_handle = in.attr_handle_start;
+        services[i].end_handle = in.attr_handle_end;
+    }
+    std::vector<CachedCharacteristic> chars(table.characteristics.size());
+    for (size_t i = 0; i < chars.size(); i++) {
+        const gattlib_characteristic_t& in = table.characteristics[i];
+        chars[i].uuid = from_gattlib(in.uuid);
+        chars[i].handle = in.handle;
+        chars[i].value_handle = in.value_handle;
+        chars[i].properties = in.properties;
+    }
+    return cache->store(address, hash, services.data(), services.size(),
+                        chars.data(), chars.size());
+}
+
+}  // namespace
+
+const char* to_string(LinkState state) {
+    switch (state) {
+    case LinkState::Idle: return "idle";
+    case LinkState::Connecting: return "connecting";
+    case LinkState::Discovering: return "discovering";
+    case LinkState::Ready: return "ready";
+    case LinkState::Backoff: return "backoff";
+    case LinkState::Failed: return "failed";
+    }
+    return "?";
+}
+
+ConnectionManager::ConnectionManager(gattlib_adapter_t* adapter, ConnectionOptions options)
+    : adapter_(adapter),
+      options_(options),
+      rng_state_((uint64_t)Clock::now().time_since_epoch().count() | 1) {
+    if (options_.max_parallel == 0) options_.max_parallel = 1;
+}
+
+ConnectionManager::~ConnectionManager() {
+    stop();
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+std::shared_future<LinkStatus> ConnectionManager::add(const char* mac) {
+    ble_addr_t address;
+    if (!ble_addr_parse(mac, &address)) return std::shared_future<LinkStatus>();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = links_.find(address.value);
+    if (it != links_.end()) {
+        it->second.removed = false;     // re-added before the scheduler reaped it
+        return it->second.future;
+    }
+
+    Link& link = links_[address.value];
+    link.mac = mac;
+    link.status = LinkStatus{address, LinkState::Idle, nullptr, 0, GATTLIB_SUCCESS};
+    link.future = link.promise.get_future().share();
+
+    wake_pending_ = true;
+    wake_.notify_one();
+    return link.future;
+}
+
+bool ConnectionManager::remove(ble_addr_t address) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = links_.find(address.value);
+    if (it == links_.end() || it->second.removed) return false;
+
+    it->second.removed = true;
+    wake_pending_ = true;
+    wake_.notify_one();
+    return true;
+}
+
+void ConnectionManager::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) return;
+    running_ = true;
+
+    scheduler_ = std::thread(&ConnectionManager::run, this);
+    size_t workers = has_workers() ? options_.max_parallel : 0;
+    for (size_t i = 0; i < workers; i++) {
+        workers_.emplace_back(&ConnectionManager::discovery_worker, this);
+    }
+}
+
+void ConnectionManager::stop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) return;
+    running_ = false;
+    wake_.notify_all();
+    jobs_ready_.notify_all();
+    lock.unlock();
+
+    scheduler_.join();
+    for (std::thread& t : workers_) t.join();
+    workers_.clear();
+
+    // Connects in flight cannot be cancelled; give their callbacks a chance
+    // to run so the connections they open are closed rather than leaked.
+    lock.lock();
+    wake_.wait_for(lock, options_.connect_timeout, [this] { return connects_outstanding_ == 0; });
+
+    for (const Event& event : events_) {
+        if (event.type != EventType::Disconnected) continue;
+        Link* link = find_by_connection(event.connection);
+        if (link) link->status.connection = nullptr;
+    }
+
+    std::vector<gattlib_connection_t*> connections;
+    connections.swap(abandoned_);
+    for (auto& kv : links_) {
+        Link& link = kv.second;
+        if (link.status.connection) connections.push_back(link.status.connection);
+        link.status.connection = nullptr;
+        if (!link.settled) {
+            link.promise.set_value(link.status);
+            link.settled = true;
+        }
+    }
+    jobs_.clear();
+    events_.clear();
+    lock.unlock();
+
+    for (gattlib_connection_t* connection : connections) gattlib_disconnect(connection, false);
+}
+
+std::vector<LinkStatus> ConnectionManager::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<LinkStatus> out;
+    out.reserve(links_.size());
+    for (const auto& kv : links_) {
+        if (!kv.second.removed) out.push_back(kv.second.status);
+    }
+    return out;
+}
+
+bool ConnectionManager::table(ble_addr_t address, GattTable* out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = links_.find(address.value);
+    if (it == links_.end() || it->second.status.state != LinkState::Ready) return false;
+    *out = it->second.table;
+    return true;
+}
+
+// =============================================================================
+// gattlib callbacks (gattlib thread) and discovery workers
+// =============================================================================
+
+void ConnectionManager::on_connect(gattlib_adapter_t*, const char* dst,
+                                   gattlib_connection_t* connection, int error,
+                                   void* user_data) {
+    ConnectionManager* self = static_cast<ConnectionManager*>(user_data);
+    if (error == GATTLIB_SUCCESS && connection) {
+        gattlib_register_on_disconnect(connection, on_disconnect, self);
+    }
+
+    Event event{EventType::Connected, {0}, connection, error, {}};
+    ble_addr_parse(dst, &event.address);
+
+    std::unique_lock<std::mutex> lock(self->mutex_);
+    self->connects_outstanding_--;
+    if (!self->running_) {
+        self->wake_.notify_all();
+        lock.unlock();
+        if (connection) gattlib_disconnect(connection, false);
+        return;
+    }
+    self->events_.push_back(std::move(event));
+    self->wake_.notify_one();
+}
+
+void ConnectionManager::on_disconnect(gattlib_connection_t* connection, void* user_data) {
+    ConnectionManager* self = static_cast<ConnectionManager*>(user_data);
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    if (!self->running_) {
+        // Stopping: make sure stop() does not disconnect it a second time
+        Link* link = self->find_by_connection(connection);
+        if (link) link->status.connection = nullptr;
+        return;
+    }
+    self->events_.push_back(Event{EventType::Disconnected, {0}, connection,
+                                  GATTLIB_DEVICE_DISCONNECTED, {}});
+    self->wake_.notify_one();
+}
+
+void ConnectionManager::discovery_worker() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        jobs_ready_.wait(lock, [this] { return !running_ || !jobs_.empty(); });
+        if (!running_) return;
+
+        auto job = jobs_.front();
+        jobs_.pop_front();
+        lock.unlock();
+
+        Event event{EventType::Discovered, job.first, job.second, GATTLIB_SUCCESS, {}};
+        if (options_.discover) event.error = discover(job.first, job.second, &event.table);
+        if (event.error == GATTLIB_SUCCESS && on_setup_) {
+            event.error = on_setup_(job.first, job.second);
+        }
+
+        lock.lock();
+        events_.push_back(std::move(event));
+        wake_.notify_one();
+    }
+}
+
+int ConnectionManager::discover(ble_addr_t address, gattlib_connection_t* connection,
+                                GattTable* table) {
+    ScopedTimer timer(link_metrics().discovery);
+    DatabaseHash hash;
+    bool have_hash = options_.cache && read_database_hash(connection, &hash);
+    if (have_hash) {
+        std::shared_ptr<const CachedTable> cached = options_.cache->lookup(address, hash);
+        if (cached) {
+            table_from_cache(*cached, table);
+            return GATTLIB_SUCCESS;
+        }
+    }
+
+    gattlib_primary_service_t* services = nullptr;
+    gattlib_characteristic_t* chars = nullptr;
+    int count = 0;
+
+    int ret = gattlib_discover_primary(connection, &services, &count);
+    if (ret != GATTLIB_SUCCESS) return ret;
+    table->services.assign(services, services + count);
+    free(services);
+
+    ret = gattlib_discover_char(connection, &chars, &count);
+    if (ret != GATTLIB_SUCCESS) return ret;
+    table->characteristics.assign(chars, chars + count);
+    free(chars);
+
+    // Without a hash there is no way to tell when the table goes stale
+    if (have_hash) store_table(options_.cache, address, hash, *table);
+    return GATTLIB_SUCCESS;
+}
+
+// =============================================================================
+// Scheduler
+// =============================================================================
+
+void ConnectionManager::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        Actions actions;
+        Clock::time_point now = Clock::now();
+
+        while (!events_.empty()) {
+            Event event = std::move(events_.front());
+            events_.pop_front();
+            handle(event, &actions);
+        }
+
+        for (auto it = links_.begin(); it != links_.end();) {
+            Link& link = it->second;
+            if (!link.removed) { ++it; continue; }
+            if (link.status.state == LinkState::Discovering) {
+                abandoned_.push_back(link.status.connection);
+            } else if (link.status.connection) {
+                actions.disconnect.push_back(link.status.connection);
+            }
+            if (!link.settled) link.promise.set_value(link.status);
+            it = links_.erase(it);
+        }
+
+        check_deadlines(now, &actions);
+        schedule_connects(now, &actions);
+
+        Clock::time_point next = now + std::chrono::seconds(1);
+        for (const auto& kv : links_) {
+            LinkState state = kv.second.status.state;
+            if (state == LinkState::Connecting || state == LinkState::Discovering ||
+                state == LinkState::Backoff) {
+                next = std::min(next, kv.second.deadline);
+            }
+        }
+        connects_outstanding_ += actions.connect.size();
+        lock.unlock();
+
+        for (const auto& target : actions.connect) {
+            int ret = gattlib_connect(adapter_, target.second.c_str(),
+                                      GATTLIB_CONNECTION_OPTIONS_NONE, on_connect, this);
+            if (ret != GATTLIB_SUCCESS) {
+                std::lock_guard<std::mutex> guard(mutex_);
+                connects_outstanding_--;
+                events_.push_back(Event{EventType::Connected, target.first, nullptr, ret, {}});
+            }
+        }
+        for (gattlib_connection_t* connection : actions.disconnect) {
+            gattlib_disconnect(connection, false);
+        }
+        if (on_state_) {
+            for (const LinkStatus& status : actions.notify) on_state_(status);
+        }
+
+        lock.lock();
+        wake_.wait_until(lock, next, [this] {
+            return !running_ || wake_pending_ || !events_.empty();
+        });
+        wake_pending_ = false;
+    }
+}
+
+ConnectionManager::Link* ConnectionManager::find_by_connection(gattlib_connection_t* connection) {
+    for (auto& kv : links_) {
+        if (kv.second.status.connection == connection) return &kv.second;
+    }
+    return nullptr;
+}
+
+void ConnectionManager::handle(Event& event, Actions* actions) {
+    switch (event.type) {
+    case EventType::Connected: {
+        auto it = links_.find(event.address.value);
+        Link* link = it == links_.end() ? nullptr : &it->second;
+        if (!link || link->removed || link->status.state != LinkState::Connecting) {
+            // Late result of a timed-out attempt, or the device was removed
+            if (event.connection) actions->disconnect.push_back(event.connection);
+            return;
+        }
+        if (event.error != GATTLIB_SUCCESS || !event.connection) {
+            fail(*link, event.error != GATTLIB_SUCCESS ? event.error : GATTLIB_UNEXPECTED,
+                 false, actions);
+            return;
+        }
+
+        link_metrics().connect.record(elapsed_ns(link->connect_started));
+        link->status.connection = event.connection;
+        if (has_workers()) {
+            link->deadline = Clock::now() + options_.discovery_timeout;
+            jobs_.emplace_back(link->status.address, event.connection);
+            jobs_ready_.notify_one();
+            transition(*link, LinkState::Discovering, actions);
+        } else {
+            link->status.failures = 0;
+            transition(*link, LinkState::Ready, actions);
+        }
+        return;
+    }
+
+    case EventType::Disconnected: {
+        Link* link = find_by_connection(event.connection);
+        if (!link) return;
+        link->status.connection = nullptr;
+        if (link->status.state == LinkState::Ready) link_metrics().drops.inc();
+
+        if (link->status.state == LinkState::Ready && options_.reconnect) {
+            link->status.last_error = GATTLIB_DEVICE_DISCONNECTED;
+            link->deadline = Clock::now() + backoff_delay(0);
+            transition(*link, LinkState::Backoff, actions);
+        } else if (link->status.state == LinkState::Ready) {
+            link->status.last_error = GATTLIB_DEVICE_DISCONNECTED;
+            transition(*link, LinkState::Failed, actions);
+        } else {
+            fail(*link, GATTLIB_DEVICE_DISCONNECTED, false, actions);
+        }
+        return;
+    }
+
+    case EventType::Discovered: {
+        auto abandoned = std::find(abandoned_.begin(), abandoned_.end(), event.connection);
+        if (abandoned != abandoned_.end()) {
+            abandoned_.erase(abandoned);
+            actions->disconnect.push_back(event.connection);
+            return;
+        }
+
+        auto it = links_.find(event.address.value);
+        if (it == links_.end()) return;
+        Link& link = it->second;
+        if (link.status.state != LinkState::Discovering ||
+            link.status.connection != event.connection) {
+            return;
+        }
+        if (event.error != GATTLIB_SUCCESS) {
+            fail(link, event.error, true, actions);
+            return;
+        }
+
+        link.table = std::move(event.table);
+        link.status.failures = 0;
+        transition(link, LinkState::Ready, actions);
+        return;
+    }
+    }
+}
+
+void ConnectionManager::check_deadlines(Clock::time_point now, Actions* actions) {
+    for (auto& kv : links_) {
+        Link& link = kv.second;
+        if (now < link.deadline) continue;
+
+        switch (link.status.state) {
+        case LinkState::Connecting:
+            fail(link, GATTLIB_TIMEOUT, false, actions);
+            break;
+        case LinkState::Discovering:
+            // The worker still holds the connection; close it when it returns
+            abandoned_.push_back(link.status.connection);
+            link.status.connection = nullptr;
+            fail(link, GATTLIB_TIMEOUT, false, actions);
+            break;
+        case LinkState::Backoff:
+            transition(link, LinkState::Idle, actions);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void ConnectionManager::schedule_connects(Clock::time_point now, Actions* actions) {
+    size_t in_flight = 0;
+    for (const auto& kv : links_) {
+        LinkState state = kv.second.status.state;
+        if (state == LinkState::Connecting || state == LinkState::Discovering) in_flight++;
+    }
+
+    for (auto& kv : links_) {
+        if (in_flight >= options_.max_parallel) break;
+        Link& link = kv.second;
+        if (link.status.state != LinkState::Idle) continue;
+
+        link.deadline = now + options_.connect_timeout;
+        link.connect_started = Clock::now();
+        link_metrics().attempts.inc();
+        transition(link, LinkState::Connecting, actions);
+        actions->connect.emplace_back(link.status.address, link.mac);
+        in_flight++;
+    }
+}
+
+void ConnectionManager::transition(Link& link, LinkState state, Actions* actions) {
+    link.status.state = state;
+    actions->notify.push_back(link.status);
+
+    if ((state == LinkState::Ready || state == LinkState::Failed) && !link.settled) {
+        link.promise.set_value(link.status);
+        link.settled = true;
+    }
+}
+
+void ConnectionManager::fail(Link& link, int error, bool close_connection, Actions* actions) {
+    if (link.status.state == LinkState::Discovering) {
+        link_metrics().discovery_failures.inc();
+    } else {
+        link_metrics().connect_failures.inc();
+    }
+    if (close_connection && link.status.connection) {
+        actions->disconnect.push_back(link.status.connection);
+    }
+    link.status.connection = nullptr;
+    link.status.last_error = error;
+    link.status.failures++;
+
+    if (options_.max_attempts && link.status.failures >= options_.max_attempts) {
+        transition(link, LinkState::Failed, actions);
+        return;
+    }
+    link.deadline = Clock::now() + backoff_delay(link.status.failures);
+    transition(link, LinkState::Backoff, actions);
+}
+
+ConnectionManager::Clock::duration ConnectionManager::backoff_delay(unsigned failures) {
+    unsigned shift = failures ? std::min(failures - 1, 16u) : 0;
+    Clock::duration delay = std::min<Clock::duration>(options_.backoff_initial * (1u << shift),
+                                                      options_.backoff_max);
+
+    // Jitter into [delay/2, delay] (xorshift64)
+    rng_state_ ^= rng_state_ << 13;
+    rng_state_ ^= rng_state_ >> 7;
+    rng_state_ ^= rng_state_ << 17;
+    Clock::duration half = delay / 2;
+    return half + Clock::duration(rng_state_ % (uint64_t)(half.count() + 1));
+}
+
+}  // namespace ble
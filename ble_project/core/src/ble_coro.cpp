@@ -0,0 +1,493 @@
+#include "ble_coro.hpp"
+
+#include "ble_time.hpp"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+
+namespace ble {
+
+namespace {
+
+std::chrono::milliseconds or_default(std::chrono::milliseconds timeout,
+                                     std::chrono::milliseconds fallback) {
+    return timeout.count() > 0 ? timeout : fallback;
+}
+
+}  // namespace
+
+void detail::task_finished(CoroRuntime* runtime) {
+    if (runtime->active_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        g_main_context_wakeup(runtime->context_);
+    }
+}
+
+// =============================================================================
+// CancelToken
+// =============================================================================
+
+CancelToken CancelToken::make() {
+    CancelToken token;
+    token.state_ = std::make_shared<State>();
+    return token;
+}
+
+void CancelToken::cancel() {
+    if (!state_ || state_->cancelled) return;
+    state_->cancelled = true;
+    // Callbacks unsubscribe as their operations finish
+    std::map<uint64_t, std::function<void()>> callbacks;
+    callbacks.swap(state_->callbacks);
+    for (auto& entry : callbacks) entry.second();
+}
+
+uint64_t CancelToken::subscribe(std::function<void()> callback) const {
+    uint64_t id = state_->next_id++;
+    state_->callbacks.emplace(id, std::move(callback));
+    return id;
+}
+
+void CancelToken::unsubscribe(uint64_t id) const {
+    state_->callbacks.erase(id);
+}
+
+// =============================================================================
+// Operations
+// =============================================================================
+
+struct CoroRuntime::Link {
+    CoroRuntime* runtime;
+    gattlib_connection_t* connection;
+
+    std::mutex mutex;
+    std::deque<Notification> queue;
+    uint64_t dropped = 0;
+    bool connected = false;
+    bool waiting = false;           ///< A notification() is pending; callbacks post pump()
+    bool pump_posted = false;
+
+    std::shared_ptr<OpState<Notification>> waiter;  ///< Context thread only
+};
+
+struct CoroRuntime::ConnectRequest {
+    CoroRuntime* runtime;
+    std::shared_ptr<OpState<gattlib_connection_t*>> op;
+};
+
+bool CoroRuntime::OpBase::finish(int result) {
+    if (done) return false;
+    done = true;
+    error = result;
+    if (timer) {
+        g_source_destroy(timer);
+        g_source_unref(timer);
+        timer = nullptr;
+    }
+    if (cancel_id) {
+        cancel.unsubscribe(cancel_id);
+        cancel_id = 0;
+    }
+    // Posted rather than resumed here: the caller may be a timer or cancel()
+    if (waiter) {
+        std::coroutine_handle<> handle = std::exchange(waiter, nullptr);
+        runtime->post([handle] { handle.resume(); });
+    }
+    return true;
+}
+
+template <typename T>
+std::shared_ptr<CoroRuntime::OpState<T>> CoroRuntime::make_op(std::chrono::milliseconds timeout,
+                                                              const CancelToken* cancel) {
+    auto op = std::make_shared<OpState<T>>();
+    op->runtime = this;
+    arm(op, timeout, cancel);
+    return op;
+}
+
+void CoroRuntime::arm(const std::shared_ptr<OpBase>& op, std::chrono::milliseconds timeout,
+                      const CancelToken* cancel) {
+    if (cancel && cancel->cancelled()) {
+        op->finish(kGattCancelled);
+        return;
+    }
+    if (cancel && cancel->state_) {
+        op->cancel = *cancel;
+        std::weak_ptr<OpBase> weak = op;
+        op->cancel_id = cancel->subscribe([weak] {
+            if (std::shared_ptr<OpBase> pending = weak.lock()) pending->finish(kGattCancelled);
+        });
+    }
+    if (timeout.count() > 0) {
+        op->timer = g_timeout_source_new((guint)timeout.count());
+        g_source_set_callback(op->timer, on_timeout, new std::shared_ptr<OpBase>(op),
+                              [](gpointer data) { delete static_cast<std::shared_ptr<OpBase>*>(data); });
+        g_source_attach(op->timer, context_);
+    }
+}
+
+gboolean CoroRuntime::on_timeout(gpointer user_data) {
+    OpBase& op = **static_cast<std::shared_ptr<OpBase>*>(user_data);
+    // sleep() arms its delay as a timeout that succeeds
+    op.finish(op.timeout_error);
+    return G_SOURCE_REMOVE;
+}
+
+template <typename T, typename Call>
+CoroRuntime::Op<T> CoroRuntime::offload(gattlib_connection_t* connection,
+                                        const AwaitOptions& options, Call call) {
+    auto op = make_op<T>(or_default(options.timeout, options_.gatt_timeout), options.cancel);
+    if (op->done) return Op<T>(op);
+
+    // One strand per connection: ATT allows one request at a time anyway
+    bool queued = pool_.submit(connection, [this, op, call]() mutable {
+        T value{};
+        int error = call(&value);
+        post([op, error, value = std::move(value)]() mutable {
+            // Timed out or cancelled meanwhile: the result is dropped
+            if (op->done) return;
+            op->value = std::move(value);
+            op->finish(error);
+        });
+    });
+    if (!queued) op->finish(GATTLIB_BUSY);
+    return Op<T>(op);
+}
+
+// =============================================================================
+// Runtime
+// =============================================================================
+
+CoroRuntime::CoroRuntime(gattlib_adapter_t* adapter, const CoroOptions& options,
+                         GMainContext* context)
+    : adapter_(adapter),
+      options_(options),
+      context_(context ? g_main_context_ref(context) : g_main_context_ref_thread_default()) {
+    HandlerPoolOptions pool_options;
+    pool_options.threads = options.blocking_threads;
+    pool_options.queue_depth = options.queue_depth;
+    std::string error;
+    // Only fails for queue_depth 0; every blocking call then reports GATTLIB_BUSY
+    pool_.start(pool_options, &error);
+}
+
+CoroRuntime::~CoroRuntime() {
+    pool_.stop();
+    {
+        std::lock_guard<std::mutex> lock(links_mutex_);
+        // gattlib may have freed the handles of closed links
+        for (auto& entry : links_) {
+            std::lock_guard<std::mutex> link_lock(entry.second->mutex);
+            if (!entry.second->connected) continue;
+            gattlib_register_notification(entry.first, nullptr, nullptr);
+            gattlib_register_on_disconnect(entry.first, nullptr, nullptr);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        if (post_source_) {
+            g_source_destroy(post_source_);
+            g_source_unref(post_source_);
+            post_source_ = nullptr;
+        }
+        posted_.clear();
+    }
+    g_main_context_unref(context_);
+}
+
+void CoroRuntime::spawn(Task<void> task) {
+    std::coroutine_handle<Task<void>::promise_type> handle = task.release();
+    handle.promise().detached = this;
+    active_.fetch_add(1, std::memory_order_acq_rel);
+    post([handle] { handle.resume(); });
+}
+
+void CoroRuntime::run() {
+    while (active() > 0) g_main_context_iteration(context_, TRUE);
+}
+
+void CoroRuntime::post(std::function<void()> fn) {
+    std::lock_guard<std::mutex> lock(post_mutex_);
+    posted_.push_back(std::move(fn));
+    if (post_source_) return;
+    // One idle source drains everything posted until it runs
+    post_source_ = g_idle_source_new();
+    g_source_set_priority(post_source_, G_PRIORITY_DEFAULT);
+    g_source_set_callback(post_source_, on_posted, this, nullptr);
+    g_source_attach(post_source_, context_);
+}
+
+gboolean CoroRuntime::on_posted(gpointer user_data) {
+    CoroRuntime* self = static_cast<CoroRuntime*>(user_data);
+    std::vector<std::function<void()>> batch;
+    {
+        std::lock_guard<std::mutex> lock(self->post_mutex_);
+        batch.swap(self->posted_);
+        g_source_unref(self->post_source_);
+        self->post_source_ = nullptr;
+    }
+    for (std::function<void()>& fn : batch) fn();
+    return G_SOURCE_REMOVE;
+}
+
+// =============================================================================
+// Connections
+// =============================================================================
+
+CoroRuntime::Op<gattlib_connection_t*> CoroRuntime::connect(const char* address,
+                                                            const AwaitOptions& options) {
+    auto op = make_op<gattlib_connection_t*>(
+        or_default(options.timeout, options_.connect_timeout), options.cancel);
+    if (op->done) return Op<gattlib_connection_t*>(op);
+
+    ConnectRequest* request = new ConnectRequest{this, op};
+    int error = gattlib_connect(adapter_, address, GATTLIB_CONNECTION_OPTIONS_NONE, on_connected,
+                                request);
+    if (error != GATTLIB_SUCCESS) {
+        delete request;
+        op->finish(error);
+    }
+    return Op<gattlib_connection_t*>(op);
+}
+
+void CoroRuntime::on_connected(gattlib_adapter_t*, const char*, gattlib_connection_t* connection,
+                               int error, void* user_data) {
+    std::unique_ptr<ConnectRequest> request(static_cast<ConnectRequest*>(user_data));
+    CoroRuntime* self = request->runtime;
+    // Handlers go on before anything can be delivered
+    Link* link = error == GATTLIB_SUCCESS ? self->attach_link(connection) : nullptr;
+
+    self->post([self, op = std::move(request->op), connection, error, link] {
+        if (!op->done) {
+            op->value = error == GATTLIB_SUCCESS ? connection : nullptr;
+            op->finish(error);
+            return;
+        }
+        if (!link) return;
+        // The connect timed out or was cancelled, so nobody owns this link
+        self->pool_.submit(connection, [link, connection] {
+            gattlib_disconnect(connection, true);
+            link->runtime->mark_down(link);
+        });
+    });
+}
+
+CoroRuntime::Link* CoroRuntime::attach_link(gattlib_connection_t* connection) {
+    Link* link;
+    {
+        std::lock_guard<std::mutex> lock(links_mutex_);
+        std::unique_ptr<Link>& slot = links_[connection];
+        if (!slot) {
+            slot.reset(new Link);
+            slot->runtime = this;
+            slot->connection = connection;
+        }
+        link = slot.get();
+    }
+    {
+        std::lock_guard<std::mutex> lock(link->mutex);
+        link->connected = true;
+        link->queue.clear();
+    }
+    gattlib_register_on_disconnect(connection, on_link_lost, link);
+    gattlib_register_notification(connection, on_notification, link);
+    return link;
+}
+
+CoroRuntime::Link* CoroRuntime::find_link(gattlib_connection_t* connection) {
+    std::lock_guard<std::mutex> lock(links_mutex_);
+    auto it = links_.find(connection);
+    return it == links_.end() ? nullptr : it->second.get();
+}
+
+void CoroRuntime::mark_down(Link* link) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(link->mutex);
+        link->connected = false;
+        wake = link->waiting && !link->pump_posted;
+        if (wake) link->pump_posted = true;
+    }
+    if (wake) post([link] { link->runtime->pump(link); });
+}
+
+void CoroRuntime::on_link_lost(gattlib_connection_t*, void* user_data) {
+    Link* link = static_cast<Link*>(user_data);
+    link->runtime->mark_down(link);
+}
+
+CoroRuntime::Op<CoroRuntime::Empty> CoroRuntime::disconnect(gattlib_connection_t* connection) {
+    Link* link = find_link(connection);
+    return offload<Empty>(connection, AwaitOptions(), [link, connection](Empty*) {
+        int error = gattlib_disconnect(connection, true);
+        // Local disconnects do not reach the disconnect handler
+        if (link) link->runtime->mark_down(link);
+        return error;
+    });
+}
+
+// =============================================================================
+// GATT
+// =============================================================================
+
+CoroRuntime::Op<GattTable> CoroRuntime::discover(gattlib_connection_t* connection,
+                                                 const AwaitOptions& options) {
+    return offload<GattTable>(connection, options, [connection](GattTable* table) {
+        gattlib_primary_service_t* services = nullptr;
+        gattlib_characteristic_t* chars = nullptr;
+        int count = 0;
+
+        int ret = gattlib_discover_primary(connection, &services, &count);
+        if (ret != GATTLIB_SUCCESS) return ret;
+        table->services.assign(services, services + count);
+        free(services);
+
+        ret = gattlib_discover_char(connection, &chars, &count);
+        if (ret != GATTLIB_SUCCESS) return ret;
+        table->characteristics.assign(chars, chars + count);
+        free(chars);
+        return GATTLIB_SUCCESS;
+    });
+}
+
+CoroRuntime::Op<std::vector<uint8_t>> CoroRuntime::read(gattlib_connection_t* connection,
+                                                        const uuid_t& uuid,
+                                                        const AwaitOptions& options) {
+    return offload<std::vector<uint8_t>>(connection, options,
+                                         [connection, target = uuid](std::vector<uint8_t>* value) mutable {
+        void* buffer = nullptr;
+        size_t len = 0;
+        int ret = gattlib_read_char_by_uuid(connection, &target, &buffer, &len);
+        if (ret != GATTLIB_SUCCESS) return ret;
+        const uint8_t* bytes = static_cast<const uint8_t*>(buffer);
+        value->assign(bytes, bytes + len);
+        gattlib_characteristic_free_value(buffer);
+        return GATTLIB_SUCCESS;
+    });
+}
+
+CoroRuntime::Op<CoroRuntime::Empty> CoroRuntime::write(gattlib_connection_t* connection,
+                                                       const uuid_t& uuid, const void* data,
+                                                       size_t len, bool with_response,
+                                                       const AwaitOptions& options) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    std::vector<uint8_t> payload(bytes, bytes + len);
+    return offload<Empty>(connection, options,
+                          [connection, target = uuid, data = std::move(payload), with_response](Empty*) mutable {
+        if (with_response) {
+            return gattlib_write_char_by_uuid(connection, &target, data.data(), data.size());
+        }
+        return gattlib_write_without_response_char_by_uuid(connection, &target, data.data(),
+                                                           data.size());
+    });
+}
+
+CoroRuntime::Op<CoroRuntime::Empty> CoroRuntime::subscribe(gattlib_connection_t* connection,
+                                                           const uuid_t& uuid,
+                                                           const AwaitOptions& options) {
+    return offload<Empty>(connection, options, [connection, uuid](Empty*) {
+        return gattlib_notification_start(connection, &uuid);
+    });
+}
+
+// =============================================================================
+// Notifications
+// =============================================================================
+
+void CoroRuntime::on_notification(const uuid_t* uuid, const uint8_t* data, size_t len,
+                                  void* user_data) {
+    Link* link = static_cast<Link*>(user_data);
+    CoroRuntime* self = link->runtime;
+    Notification notification{*uuid, std::vector<uint8_t>(data, data + len), monotonic_ns()};
+
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(link->mutex);
+        if (link->queue.size() >= self->options_.notification_queue) {
+            link->queue.pop_front();
+            link->dropped++;
+        }
+        link->queue.push_back(std::move(notification));
+        wake = link->waiting && !link->pump_posted;
+        if (wake) link->pump_posted = true;
+    }
+    if (wake) self->post([link] { link->runtime->pump(link); });
+}
+
+CoroRuntime::Op<Notification> CoroRuntime::notification(gattlib_connection_t* connection,
+                                                        const AwaitOptions& options) {
+    auto op = make_op<Notification>(options.timeout, options.cancel);
+    if (op->done) return Op<Notification>(op);
+
+    Link* link = find_link(connection);
+    if (!link) {
+        op->finish(GATTLIB_DEVICE_NOT_CONNECTED);
+        return Op<Notification>(op);
+    }
+    if (link->waiter && !link->waiter->done) {
+        op->finish(GATTLIB_BUSY);
+        return Op<Notification>(op);
+    }
+
+    int error = GATTLIB_SUCCESS;
+    {
+        std::lock_guard<std::mutex> lock(link->mutex);
+        if (!link->queue.empty()) {
+            op->value = std::move(link->queue.front());
+            link->queue.pop_front();
+        } else if (!link->connected) {
+            error = GATTLIB_DEVICE_DISCONNECTED;
+        } else {
+            link->waiter = op;
+            link->waiting = true;
+            return Op<Notification>(op);
+        }
+    }
+    op->finish(error);
+    return Op<Notification>(op);
+}
+
+void CoroRuntime::pump(Link* link) {
+    std::shared_ptr<OpState<Notification>> op = link->waiter;
+    int error = GATTLIB_SUCCESS;
+    {
+        std::lock_guard<std::mutex> lock(link->mutex);
+        link->pump_posted = false;
+        if (!op || op->done) {
+            // The waiter timed out or was cancelled
+            link->waiting = false;
+            link->waiter.reset();
+            return;
+        }
+        if (!link->queue.empty()) {
+            op->value = std::move(link->queue.front());
+            link->queue.pop_front();
+        } else if (!link->connected) {
+            error = GATTLIB_DEVICE_DISCONNECTED;
+        } else {
+            return;
+        }
+        link->waiting = false;
+    }
+    link->waiter.reset();
+    op->finish(error);
+}
+
+uint64_t CoroRuntime::dropped(gattlib_connection_t* connection) {
+    Link* link = find_link(connection);
+    if (!link) return 0;
+    std::lock_guard<std::mutex> lock(link->mutex);
+    return link->dropped;
+}
+
+CoroRuntime::Op<CoroRuntime::Empty> CoroRuntime::sleep(std::chrono::milliseconds delay,
+                                                       const CancelToken* cancel) {
+    auto op = std::make_shared<OpState<Empty>>();
+    op->runtime = this;
+    op->timeout_error = GATTLIB_SUCCESS;
+    arm(op, std::max(delay, std::chrono::milliseconds(1)), cancel);
+    return Op<Empty>(op);
+}
+
+}  // namespace ble
@@ -0,0 +1,38 @@
+#include "ble_dbus.h"
+
+#include <stdlib.h>
+
+GDBusConnection *ble_dbus_connect(const char *address, GError **error) {
+    gchar *system_address = NULL;
+    if (!address || !*address) address = getenv(BLE_DBUS_ADDRESS_ENV);
+    if (!address || !*address) {
+        system_address = g_dbus_address_get_for_bus_sync(G_BUS_TYPE_SYSTEM, NULL, error);
+        if (!system_address) return NULL;
+        address = system_address;
+    }
+
+    GDBusConnection *conn = g_dbus_connection_new_for_address_sync(
+        address,
+        (GDBusConnectionFlags)(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                               G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+        NULL, NULL, error);
+    g_free(system_address);
+    return conn;
+}
+
+const char *ble_dbus_adapter_path(void) {
+    static gchar *path = NULL;
+    if (g_once_init_enter(&path)) {
+        const char *adapter = getenv(BLE_DBUS_ADAPTER_ENV);
+        gchar *value;
+        if (!adapter || !*adapter) {
+            value = g_strdup("/org/bluez/hci0");
+        } else if (adapter[0] == '/') {
+            value = g_strdup(adapter);
+        } else {
+            value = g_strconcat("/org/bluez/", adapter, NULL);
+        }
+        g_once_init_leave(&path, value);
+    }
+    return path;
+}
@@ -0,0 +1,166 @@
+#include "ble_device_table.hpp"
+
+#include <cstring>
+
+namespace ble {
+
+namespace {
+
+constexpr size_t kChunkSize = 16 * 1024;
+
+uint64_t hash_bytes(const char* s, size_t len) {
+    uint64_t h = 1469598103934665603ull;    // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 1099511628211ull;
+    }
+    return h | 1;                           // 0 marks an empty slot
+}
+
+size_t round_up_pow2(size_t n) {
+    size_t p = 16;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+}  // namespace
+
+// =============================================================================
+// NamePool
+// =============================================================================
+
+NamePool::NamePool() : slots_(256), chunk_used_(kChunkSize) {}
+
+char* NamePool::allocate(size_t n) {
+    if (n > kChunkSize) {
+        chunks_.emplace_back(new char[n]);
+        return chunks_.back().get();
+    }
+    if (chunk_used_ + n > kChunkSize) {
+        chunks_.emplace_back(new char[kChunkSize]);
+        chunk_used_ = 0;
+    }
+    char* p = chunks_.back().get() + chunk_used_;
+    chunk_used_ += n;
+    return p;
+}
+
+void NamePool::grow() {
+    std::vector<Slot> old(slots_.size() * 2);
+    old.swap(slots_);
+    const size_t mask = slots_.size() - 1;
+    for (const Slot& s : old) {
+        if (!s.hash) continue;
+        size_t i = s.hash & mask;
+        while (slots_[i].hash) i = (i + 1) & mask;
+        slots_[i] = s;
+    }
+}
+
+const char* NamePool::intern(const char* name, size_t len) {
+    const uint64_t h = hash_bytes(name, len);
+    const size_t mask = slots_.size() - 1;
+    size_t i = h & mask;
+    while (slots_[i].hash) {
+        const Slot& s = slots_[i];
+        if (s.hash == h && s.len == len && memcmp(s.str, name, len) == 0) {
+            return s.str;
+        }
+        i = (i + 1) & mask;
+    }
+
+    char* copy = allocate(len + 1);
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+    slots_[i] = Slot{h, copy, (uint32_t)len};
+    count_++;
+    bytes_used_ += len + 1;
+
+    if (count_ * 4 > slots_.size() * 3) grow();
+    return copy;
+}
+
+// =============================================================================
+// DeviceTable
+// =============================================================================
+
+DeviceTable::DeviceTable(size_t initial_capacity)
+    : entries_(round_up_pow2(initial_capacity)),
+      used_(entries_.size(), 0),
+      mask_(entries_.size() - 1) {}
+
+size_t DeviceTable::probe(ble_addr_t addr) const {
+    size_t i = ble_addr_hash(addr) & mask_;
+    while (used_[i] && entries_[i].device.address != addr) i = (i + 1) & mask_;
+    return i;
+}
+
+void DeviceTable::rehash(size_t new_capacity) {
+    std::vector<DeviceEntry> old_entries(new_capacity);
+    std::vector<uint8_t> old_used(new_capacity, 0);
+    old_entries.swap(entries_);
+    old_used.swap(used_);
+    mask_ = new_capacity - 1;
+
+    for (size_t i = 0; i < old_entries.size(); i++) {
+        if (!old_used[i]) continue;
+        size_t j = probe(old_entries[i].device.address);
+        entries_[j] = old_entries[i];
+        used_[j] = 1;
+    }
+}
+
+void DeviceTable::remove_at(size_t i) {
+    used_[i] = 0;
+    size_--;
+
+    // Backward-shift the rest of the cluster so probes do not stop early
+    for (size_t j = (i + 1) & mask_; used_[j]; j = (j + 1) & mask_) {
+        size_t home = ble_addr_hash(entries_[j].device.address) & mask_;
+        // Move j into the hole unless its home lies cyclically in (i, j]
+        bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+        if (stays) continue;
+        entries_[i] = entries_[j];
+        used_[i] = 1;
+        used_[j] = 0;
+        i = j;
+    }
+}
+
+DeviceEntry* DeviceTable::upsert(ble_addr_t addr, uint64_t now_ns, bool* inserted) {
+    size_t i = probe(addr);
+    if (used_[i]) {
+        DeviceEntry& e = entries_[i];
+        e.last_seen_ns = now_ns;
+        e.seen_count++;
+        *inserted = false;
+        return &e;
+    }
+
+    if ((size_ + 1) * 10 > entries_.size() * 7) {
+        rehash(entries_.size() * 2);
+        i = probe(addr);
+    }
+
+    DeviceEntry& e = entries_[i];
+    used_[i] = 1;
+    size_++;
+    e.device.address = addr;
+    e.device.name = nullptr;
+    e.device.rssi = BLE_RSSI_UNKNOWN;
+    e.first_seen_ns = now_ns;
+    e.last_seen_ns = now_ns;
+    e.seen_count = 1;
+    e.changed_epoch = epoch_;
+    e.created_epoch = epoch_;
+    e.ad_len = 0;
+    *inserted = true;
+    return &e;
+}
+
+const DeviceEntry* DeviceTable::find(ble_addr_t addr) const {
+    size_t i = probe(addr);
+    return used_[i] ? &entries_[i] : nullptr;
+}
+
+}  // namespace ble
@@ -0,0 +1,202 @@
+#include "ble_discovery_cache.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace ble {
+
+namespace {
+
+constexpr char kMagic[8] = {'B', 'L', 'E', 'G', 'D', 'C', 0, 1};
+
+/// File layout: header, services[service_count], chars[char_count].
+/// Host byte order; the cache is local to the machine that wrote it.
+struct FileHeader {
+    char magic[8];
+    uint32_t service_count;
+    uint32_t char_count;
+    uint64_t address;
+    DatabaseHash hash;
+};
+
+static_assert(sizeof(FileHeader) % alignof(CachedService) == 0, "records must stay aligned");
+
+bool write_all(int fd, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+}  // namespace
+
+// =============================================================================
+// CachedTable
+// =============================================================================
+
+CachedTable::~CachedTable() {
+    if (map_) munmap(map_, map_len_);
+}
+
+ble_addr_t CachedTable::address() const {
+    return ble_addr_t{static_cast<const FileHeader*>(map_)->address};
+}
+
+const DatabaseHash& CachedTable::hash() const {
+    return static_cast<const FileHeader*>(map_)->hash;
+}
+
+// =============================================================================
+// DiscoveryCache
+// =============================================================================
+
+DiscoveryCache::DiscoveryCache(std::string directory) : directory_(std::move(directory)) {}
+
+std::string DiscoveryCache::path_for(ble_addr_t address) const {
+    char name[32];
+    snprintf(name, sizeof(name), "/%014" PRIx64 ".gdc", address.value);
+    return directory_ + name;
+}
+
+std::shared_ptr<const CachedTable> DiscoveryCache::map_file(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(FileHeader)) {
+        map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) return nullptr;
+
+    std::shared_ptr<CachedTable> table(new CachedTable);
+    table->map_ = map;
+    table->map_len_ = (size_t)st.st_size;
+
+    const FileHeader* header = static_cast<const FileHeader*>(map);
+    size_t expected = sizeof(FileHeader) +
+                      (size_t)header->service_count * sizeof(CachedService) +
+                      (size_t)header->char_count * sizeof(CachedCharacteristic);
+    if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || expected != table->map_len_) {
+        return nullptr;
+    }
+
+    const uint8_t* base = static_cast<const uint8_t*>(map) + sizeof(FileHeader);
+    table->services_ = reinterpret_cast<const CachedService*>(base);
+    table->service_count_ = header->service_count;
+    table->chars_ = reinterpret_cast<const CachedCharacteristic*>(
+        base + header->service_count * sizeof(CachedService));
+    table->char_count_ = header->char_count;
+    return table;
+}
+
+std::shared_ptr<const CachedTable> DiscoveryCache::lookup(ble_addr_t address,
+                                                          const DatabaseHash& hash) {
+    std::shared_ptr<const CachedTable> table;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tables_.find(address.value);
+        if (it != tables_.end()) table = it->second;
+
+        // Not mapped yet, or stale: another process may have refreshed the file
+        if (!table || table->hash() != hash) {
+            table = map_file(path_for(address));
+            if (table && table->address() == address) tables_[address.value] = table;
+            else table = nullptr;
+        }
+    }
+
+    if (!table || table->hash() != hash) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return table;
+}
+
+bool DiscoveryCache::store(ble_addr_t address, const DatabaseHash& hash,
+                           const CachedService* services, size_t service_count,
+                           const CachedCharacteristic* chars, size_t char_count) {
+    if (service_count > UINT32_MAX || char_count > UINT32_MAX) return false;
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.service_count = (uint32_t)service_count;
+    header.char_count = (uint32_t)char_count;
+    header.address = address.value;
+    header.hash = hash;
+
+    // Zero the records' padding so files are byte-for-byte reproducible
+    std::vector<CachedService> svc(service_count);
+    std::vector<CachedCharacteristic> chr(char_count);
+    memset(svc.data(), 0, svc.size() * sizeof(CachedService));
+    memset(chr.data(), 0, chr.size() * sizeof(CachedCharacteristic));
+    for (size_t i = 0; i < service_count; i++) {
+        svc[i].uuid = services[i].uuid;
+        svc[i].start_handle = services[i].start_handle;
+        svc[i].end_handle = services[i].end_handle;
+    }
+    for (size_t i = 0; i < char_count; i++) {
+        chr[i].uuid = chars[i].uuid;
+        chr[i].handle = chars[i].handle;
+        chr[i].value_handle = chars[i].value_handle;
+        chr[i].properties = chars[i].properties;
+    }
+
+    std::string path = path_for(address);
+    std::string tmp = path + ".XXXXXX";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int fd = mkostemp(&tmp[0], O_CLOEXEC);
+    if (fd < 0) return false;
+
+    bool ok = write_all(fd, &header, sizeof(header)) &&
+              write_all(fd, svc.data(), svc.size() * sizeof(CachedService)) &&
+              write_all(fd, chr.data(), chr.size() * sizeof(CachedCharacteristic));
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+
+    // Readers holding the previous table keep their mapping of the old inode
+    std::shared_ptr<const CachedTable> table = map_file(path);
+    if (table) tables_[address.value] = table;
+    else tables_.erase(address.value);
+    stores_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void DiscoveryCache::invalidate(ble_addr_t address) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tables_.erase(address.value);
+    unlink(path_for(address).c_str());
+}
+
+DiscoveryCacheStats DiscoveryCache::stats() const {
+    return DiscoveryCacheStats{
+        hits_.load(std::memory_order_relaxed),
+        misses_.load(std::memory_order_relaxed),
+        stores_.load(std::memory_order_relaxed),
+    };
+}
+
+}  // namespace ble
@@ -0,0 +1,236 @@
+#include "ble_fd_channel.hpp"
+
+#include <gio/gunixfdlist.h>
+#include <glib-unix.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace ble {
+
+namespace {
+
+/// Batches read per wakeup before yielding back to the main loop.
+constexpr int kMaxBatchesPerWakeup = 8;
+
+}  // namespace
+
+FdChannel::FdChannel(int fd, uint16_t mtu)
+    : fd_(fd),
+      mtu_(mtu > kAttHeaderLen ? mtu : kAttDefaultMtu),
+      rx_buf_(kBatch * mtu_),
+      tx_buf_(kBatch * mtu_) {
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+
+    memset(rx_msgs_, 0, sizeof(rx_msgs_));
+    memset(tx_msgs_, 0, sizeof(tx_msgs_));
+    for (size_t i = 0; i < kBatch; i++) {
+        rx_iov_[i].iov_base = rx_buf_.data() + i * mtu_;
+        rx_iov_[i].iov_len = mtu_;
+        rx_msgs_[i].msg_hdr.msg_iov = &rx_iov_[i];
+        rx_msgs_[i].msg_hdr.msg_iovlen = 1;
+
+        tx_iov_[i].iov_base = tx_slot(i);
+        tx_msgs_[i].msg_hdr.msg_iov = &tx_iov_[i];
+        tx_msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+FdChannel::~FdChannel() {
+    detach();
+    close_fd();
+}
+
+std::unique_ptr<FdChannel> FdChannel::socketpair(uint16_t mtu, int* remote_fd) {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0) return nullptr;
+    *remote_fd = fds[1];
+    return std::unique_ptr<FdChannel>(new FdChannel(fds[0], mtu));
+}
+
+std::unique_ptr<FdChannel> FdChannel::acquire(GDBusMethodInvocation* invocation,
+                                              GVariant* parameters) {
+    GVariant* options = NULL;
+    guint16 mtu = kAttDefaultMtu;
+    g_variant_get(parameters, "(@a{sv})", &options);
+    g_variant_lookup(options, "mtu", "q", &mtu);
+    g_variant_unref(options);
+
+    int remote_fd = -1;
+    std::unique_ptr<FdChannel> channel = socketpair(mtu, &remote_fd);
+    if (!channel) {
+        g_dbus_method_invocation_return_dbus_error(invocation, "org.bluez.Error.Failed",
+                                                   strerror(errno));
+        return nullptr;
+    }
+
+    GError* error = NULL;
+    GUnixFDList* fd_list = g_unix_fd_list_new();
+    gint index = g_unix_fd_list_append(fd_list, remote_fd, &error);
+    close(remote_fd);  // the list holds its own duplicate
+    if (index < 0) {
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_error_free(error);
+        g_object_unref(fd_list);
+        return nullptr;
+    }
+
+    g_dbus_method_invocation_return_value_with_unix_fd_list(
+        invocation, g_variant_new("(hq)", index, channel->mtu()), fd_list);
+    g_object_unref(fd_list);
+    return channel;
+}
+
+// =============================================================================
+// Main loop integration
+// =============================================================================
+
+void FdChannel::set_handlers(RxHandler on_rx, CloseHandler on_close) {
+    on_rx_ = std::move(on_rx);
+    on_close_ = std::move(on_close);
+}
+
+void FdChannel::attach(GMainContext* context) {
+    detach();
+    context_ = context;
+    if (fd_ < 0) return;
+
+    watch_ = g_unix_fd_source_new(fd_, (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR));
+    g_source_set_callback(watch_, (GSourceFunc)(void (*)(void))on_fd_ready, this, NULL);
+    g_source_attach(watch_, context_);
+    if (tx_count_) arm_out_watch();
+}
+
+void FdChannel::detach() {
+    if (watch_) {
+        g_source_destroy(watch_);
+        g_source_unref(watch_);
+        watch_ = nullptr;
+    }
+    if (out_watch_) {
+        g_source_destroy(out_watch_);
+        g_source_unref(out_watch_);
+        out_watch_ = nullptr;
+    }
+}
+
+void FdChannel::arm_out_watch() {
+    if (out_watch_ || !watch_ || fd_ < 0) return;
+    out_watch_ = g_unix_fd_source_new(fd_, G_IO_OUT);
+    g_source_set_callback(out_watch_, (GSourceFunc)(void (*)(void))on_fd_writable, this, NULL);
+    g_source_attach(out_watch_, context_);
+}
+
+gboolean FdChannel::on_fd_ready(gint, GIOCondition condition, gpointer user_data) {
+    FdChannel* self = static_cast<FdChannel*>(user_data);
+
+    if (condition & G_IO_IN) {
+        for (int i = 0; i < kMaxBatchesPerWakeup; i++) {
+            if (self->receive() < kBatch) break;
+        }
+    }
+    if (!(condition & (G_IO_HUP | G_IO_ERR)) && self->fd_ >= 0) return G_SOURCE_CONTINUE;
+
+    // Peer closed (BlueZ released the fd or the link dropped). The handler
+    // may destroy the channel, so nothing touches self after it runs.
+    self->detach();
+    self->close_fd();
+    CloseHandler on_close = std::move(self->on_close_);
+    if (on_close) on_close();
+    return G_SOURCE_REMOVE;
+}
+
+gboolean FdChannel::on_fd_writable(gint, GIOCondition, gpointer user_data) {
+    FdChannel* self = static_cast<FdChannel*>(user_data);
+    self->flush();
+    if (self->tx_count_ && self->fd_ >= 0) return G_SOURCE_CONTINUE;
+
+    g_source_unref(self->out_watch_);
+    self->out_watch_ = nullptr;
+    return G_SOURCE_REMOVE;
+}
+
+void FdChannel::close_fd() {
+    if (fd_ < 0) return;
+    close(fd_);
+    fd_ = -1;
+    tx_count_ = 0;
+}
+
+// =============================================================================
+// Batched I/O
+// =============================================================================
+
+size_t FdChannel::receive() {
+    if (fd_ < 0) return 0;
+
+    int n;
+    do {
+        n = recvmmsg(fd_, rx_msgs_, kBatch, MSG_DONTWAIT, NULL);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return 0;
+
+    stats_.rx_batches++;
+    stats_.rx_packets += n;
+    for (int i = 0; i < n; i++) {
+        const struct msghdr& hdr = rx_msgs_[i].msg_hdr;
+        if (hdr.msg_flags & MSG_TRUNC) continue;  // larger than the MTU
+        if (on_rx_) on_rx_(static_cast<const uint8_t*>(rx_iov_[i].iov_base), rx_msgs_[i].msg_len);
+    }
+    return (size_t)n;
+}
+
+bool FdChannel::queue(const void* data, size_t len) {
+    if (fd_ < 0 || len > max_payload()) {
+        stats_.tx_rejected++;
+        return false;
+    }
+    if (tx_count_ == kBatch && (flush(), tx_count_ == kBatch)) {
+        stats_.tx_rejected++;
+        return false;
+    }
+
+    memcpy(tx_slot(tx_count_), data, len);
+    tx_iov_[tx_count_].iov_len = len;
+    tx_count_++;
+    return true;
+}
+
+size_t FdChannel::flush() {
+    size_t sent = 0;
+    while (tx_count_ > 0 && fd_ >= 0) {
+        int n = sendmmsg(fd_, tx_msgs_, tx_count_, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                arm_out_watch();
+                break;
+            }
+            // Anything else (EPIPE, ECONNRESET, ...) will not clear by
+            // retrying: drop the batch and close. With a watch attached the
+            // shutdown shows up as HUP, so on_close runs from the main loop
+            // as for a peer close, not from inside the caller's queue().
+            stats_.tx_dropped += tx_count_;
+            tx_count_ = 0;
+            if (watch_) shutdown(fd_, SHUT_RDWR);
+            else close_fd();
+            break;
+        }
+
+        stats_.tx_batches++;
+        stats_.tx_packets += n;
+        sent += n;
+
+        // Short write: move the unsent payloads to the front of the queue
+        for (size_t i = n; i < tx_count_; i++) {
+            memcpy(tx_slot(i - n), tx_slot(i), tx_iov_[i].iov_len);
+            tx_iov_[i - n].iov_len = tx_iov_[i].iov_len;
+        }
+        tx_count_ -= n;
+    }
+    return sent;
+}
+
+}  // namespace ble
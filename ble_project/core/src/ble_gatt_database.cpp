@@ -0,0 +1,491 @@
+#include "ble_gatt_database.hpp"
+#include "ble_metrics.hpp"
+
+namespace ble {
+
+namespace {
+
+// Time spent in our handlers per BlueZ request; BlueZ and D-Bus transit
+// show up on the central side (ble_gatt_op_seconds) and in ble_bench
+struct HandlerMetrics {
+    static constexpr auto kMethods = make_name_index(std::array<const char*, 8>{
+        "ReadValue", "WriteValue", "AcquireWrite", "AcquireNotify",
+        "StartNotify", "StopNotify", "Confirm", "GetManagedObjects",
+    });
+    Histogram seconds[kMethods.size() + 1];     ///< The last one is "other"
+    Histogram queued;       ///< Wait for a HandlerPool worker
+    Counter rejected;       ///< Calls refused by a saturated HandlerPool
+
+    HandlerMetrics() {
+        for (size_t i = 0; i <= kMethods.size(); i++) {
+            const char* method = i < kMethods.size() ? kMethods.name(i) : "other";
+            std::string labels = std::string("method=\"") + method + "\"";
+            seconds[i] = Metrics::global().histogram("ble_gatt_handler_seconds", labels.c_str(),
+                                                     "GATT server method handling time");
+        }
+        queued = Metrics::global().histogram("ble_gatt_handler_queue_seconds", "",
+                                             "GATT server method wait for a handler worker");
+        rejected = Metrics::global().counter("ble_gatt_handler_rejected_total", "",
+                                             "GATT server methods refused by a full handler queue");
+    }
+
+    const Histogram& for_method(const char* method) const {
+        int i = kMethods.find(method);
+        return seconds[i >= 0 ? (size_t)i : kMethods.size()];
+    }
+};
+
+const HandlerMetrics& handler_metrics() {
+    static const HandlerMetrics metrics;
+    return metrics;
+}
+
+const char* const kObjectManagerInterface = ObjectManagerInterface::name();
+
+// Methods whose handlers only produce or consume a value; see set_handler_pool()
+bool offloadable(const char* method) {
+    int i = GattCharacteristicInterface::find_method(method);
+    return i == GattCharacteristicInterface::method("ReadValue") ||
+           i == GattCharacteristicInterface::method("WriteValue");
+}
+
+GVariant* new_strv(const std::vector<std::string>& strings) {
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("as"));
+    for (const std::string& s : strings) g_variant_builder_add(&builder, "s", s.c_str());
+    return g_variant_builder_end(&builder);
+}
+
+}  // namespace
+
+GattDatabase::GattDatabase(const char* app_path) : app_path_(app_path) {}
+
+GattDatabase::~GattDatabase() {
+    unregister_objects();
+    for (auto& kv : objects_) {
+        Object* obj = kv.second.get();
+        for (GVariant* p : obj->props) if (p) g_variant_unref(p);
+        if (obj->entry) g_variant_unref(obj->entry);
+    }
+    if (reply_) g_variant_unref(reply_);
+}
+
+const char* GattDatabase::interface_name(Kind kind) {
+    switch (kind) {
+    case Kind::Service: return GattServiceInterface::name();
+    case Kind::Characteristic: return GattCharacteristicInterface::name();
+    case Kind::Descriptor: return GattDescriptorInterface::name();
+    }
+    return NULL;
+}
+
+GDBusInterfaceInfo* GattDatabase::interface_info(Kind kind) {
+    switch (kind) {
+    case Kind::Service: return GattServiceInterface::info();
+    case Kind::Characteristic: return GattCharacteristicInterface::info();
+    case Kind::Descriptor: return GattDescriptorInterface::info();
+    }
+    return NULL;
+}
+
+size_t GattDatabase::property_count(Kind kind) {
+    switch (kind) {
+    case Kind::Service: return GattServiceInterface::kProperties;
+    case Kind::Characteristic: return GattCharacteristicInterface::kProperties;
+    case Kind::Descriptor: return GattDescriptorInterface::kProperties;
+    }
+    return 0;
+}
+
+int GattDatabase::find_property(Kind kind, const char* name) {
+    switch (kind) {
+    case Kind::Service: return GattServiceInterface::find_property(name);
+    case Kind::Characteristic: return GattCharacteristicInterface::find_property(name);
+    case Kind::Descriptor: return GattDescriptorInterface::find_property(name);
+    }
+    return -1;
+}
+
+const char* GattDatabase::property_name(Kind kind, size_t index) {
+    switch (kind) {
+    case Kind::Service: return GattServiceInterface::property_name(index);
+    case Kind::Characteristic: return GattCharacteristicInterface::property_name(index);
+    case Kind::Descriptor: return GattDescriptorInterface::property_name(index);
+    }
+    return NULL;
+}
+
+GattDatabase::Object* GattDatabase::find(const std::string& path) const {
+    auto it = objects_.find(path);
+    return it == objects_.end() ? nullptr : it->second.get();
+}
+
+// =============================================================================
+// Declarations
+// =============================================================================
+
+GattDatabase::Object* GattDatabase::add_object(Kind kind, Object* parent, std::string path,
+                                               const ble_uuid_t& uuid,
+                                               std::vector<std::string> flags,
+                                               MethodHandler handler, gpointer user_data) {
+    std::unique_ptr<Object> owned(new Object{
+        this, kind, std::move(path), parent, {}, std::vector<GVariant*>(property_count(kind)),
+        handler, user_data, nullptr, 0, 0});
+    Object* obj = owned.get();
+    objects_.emplace(obj->path, std::move(owned));
+
+    set_prop(obj, "UUID", g_variant_new_string(to_string(uuid).data()));
+    switch (kind) {
+    case Kind::Service:
+        break;
+    case Kind::Characteristic:
+        set_prop(obj, "Service", g_variant_new_object_path(parent->path.c_str()));
+        set_prop(obj, "Flags", new_strv(flags));
+        break;
+    case Kind::Descriptor:
+        set_prop(obj, "Characteristic", g_variant_new_object_path(parent->path.c_str()));
+        set_prop(obj, "Flags", new_strv(flags));
+        break;
+    }
+
+    if (parent) {
+        parent->children.push_back(obj);
+        refresh_child_list(parent);
+    }
+    invalidate(obj);
+    return obj;
+}
+
+void GattDatabase::publish(Object* obj) {
+    if (!connection_ || !export_object(obj, NULL)) return;
+    emit_added(obj);
+    if (obj->parent) emit_child_list(obj->parent);
+}
+
+std::string GattDatabase::add_service(const ble_uuid_t& uuid, bool primary) {
+    std::string path = app_path_ + "/service" + std::to_string(next_service_index_++);
+    Object* obj = add_object(Kind::Service, nullptr, path, uuid, {}, nullptr, nullptr);
+    set_prop(obj, "Primary", g_variant_new_boolean(primary));
+    refresh_child_list(obj);
+    services_.push_back(obj);
+    publish(obj);
+    return path;
+}
+
+std::string GattDatabase::add_characteristic(const std::string& service_path,
+                                             const ble_uuid_t& uuid,
+                                             std::vector<std::string> flags,
+                                             MethodHandler handler, gpointer user_data) {
+    Object* service = find(service_path);
+    if (!service || service->kind != Kind::Service) return std::string();
+
+    std::string path = service_path + "/char" + std::to_string(service->next_child_index++);
+    Object* obj = add_object(Kind::Characteristic, service, path, uuid, std::move(flags),
+                             handler, user_data);
+    refresh_child_list(obj);
+    publish(obj);
+    return path;
+}
+
+std::string GattDatabase::add_descriptor(const std::string& char_path, const ble_uuid_t& uuid,
+                                         std::vector<std::string> flags,
+                                         MethodHandler handler, gpointer user_data) {
+    Object* chr = find(char_path);
+    if (!chr || chr->kind != Kind::Characteristic) return std::string();
+
+    std::string path = char_path + "/desc" + std::to_string(chr->next_child_index++);
+    publish(add_object(Kind::Descriptor, chr, path, uuid, std::move(flags), handler, user_data));
+    return path;
+}
+
+void GattDatabase::remove_subtree(Object* obj, std::vector<std::string>* removed) {
+    for (Object* child : obj->children) remove_subtree(child, removed);
+
+    if (obj->registration_id) {
+        g_dbus_connection_unregister_object(connection_, obj->registration_id);
+        emit_removed(obj->path, obj->kind);
+    }
+    for (GVariant* p : obj->props) if (p) g_variant_unref(p);
+    if (obj->entry) g_variant_unref(obj->entry);
+    removed->push_back(obj->path);
+}
+
+bool GattDatabase::remove(const std::string& path) {
+    Object* obj = find(path);
+    if (!obj) return false;
+
+    Object* parent = obj->parent;
+    std::vector<std::string> removed;
+    remove_subtree(obj, &removed);
+
+    if (parent) {
+        auto& siblings = parent->children;
+        for (auto it = siblings.begin(); it != siblings.end(); ++it) {
+            if (*it == obj) { siblings.erase(it); break; }
+        }
+        refresh_child_list(parent);
+        emit_child_list(parent);
+    } else {
+        for (auto it = services_.begin(); it != services_.end(); ++it) {
+            if (*it == obj) { services_.erase(it); break; }
+        }
+    }
+
+    for (const std::string& p : removed) objects_.erase(p);
+    if (reply_) {
+        g_variant_unref(reply_);
+        reply_ = nullptr;
+    }
+    return true;
+}
+
+// =============================================================================
+// Properties and cache
+// =============================================================================
+
+bool GattDatabase::set_prop(Object* obj, const char* name, GVariant* value) {
+    g_variant_ref_sink(value);
+    int i = find_property(obj->kind, name);
+    if (i < 0) {
+        g_variant_unref(value);
+        return false;
+    }
+    if (obj->props[i]) g_variant_unref(obj->props[i]);
+    obj->props[i] = value;
+    invalidate(obj);
+    return true;
+}
+
+const char* GattDatabase::child_list_name(const Object* obj) {
+    return obj->kind == Kind::Service ? "Characteristics" : "Descriptors";
+}
+
+void GattDatabase::refresh_child_list(Object* obj) {
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("ao"));
+    for (Object* child : obj->children) g_variant_builder_add(&builder, "o", child->path.c_str());
+
+    set_prop(obj, child_list_name(obj), g_variant_builder_end(&builder));
+}
+
+// After InterfacesAdded/Removed for the child, so the path it lists or
+// drops is already known to BlueZ
+void GattDatabase::emit_child_list(Object* obj) {
+    const char* name = child_list_name(obj);
+    if (obj->registration_id) emit_changed(obj->path, name, property(obj->path, name));
+}
+
+bool GattDatabase::set_property(const std::string& path, const char* name, GVariant* value) {
+    Object* obj = find(path);
+    if (!obj) {
+        g_variant_unref(g_variant_ref_sink(value));
+        return false;
+    }
+    if (!set_prop(obj, name, value)) return false;
+    emit_changed(path, name, property(path, name));
+    return true;
+}
+
+bool GattDatabase::emit_changed(const std::string& path, const char* name, GVariant* value) {
+    Object* obj = find(path);
+    if (!obj || !obj->registration_id) {
+        g_variant_unref(g_variant_ref_sink(value));
+        return false;
+    }
+
+    GVariantBuilder changed;
+    g_variant_builder_init(&changed, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&changed, "{sv}", name, value);
+    return g_dbus_connection_emit_signal(connection_, NULL, path.c_str(),
+        "org.freedesktop.DBus.Properties", "PropertiesChanged",
+        g_variant_new("(sa{sv}as)", interface_name(obj->kind), &changed, NULL),
+        NULL);
+}
+
+GVariant* GattDatabase::property(const std::string& path, const char* name) const {
+    Object* obj = find(path);
+    if (!obj) return nullptr;
+    int i = find_property(obj->kind, name);
+    return i >= 0 ? obj->props[i] : nullptr;
+}
+
+void GattDatabase::invalidate(Object* obj) {
+    if (obj->entry) {
+        g_variant_unref(obj->entry);
+        obj->entry = nullptr;
+    }
+    if (reply_) {
+        g_variant_unref(reply_);
+        reply_ = nullptr;
+    }
+}
+
+GVariant* GattDatabase::interfaces_for(Object* obj) const {
+    GVariantBuilder props;
+    g_variant_builder_init(&props, G_VARIANT_TYPE("a{sv}"));
+    for (size_t i = 0; i < obj->props.size(); i++) {
+        if (obj->props[i]) {
+            g_variant_builder_add(&props, "{sv}", property_name(obj->kind, i), obj->props[i]);
+        }
+    }
+
+    GVariantBuilder ifaces;
+    g_variant_builder_init(&ifaces, G_VARIANT_TYPE("a{sa{sv}}"));
+    g_variant_builder_add(&ifaces, "{s@a{sv}}", interface_name(obj->kind),
+                          g_variant_builder_end(&props));
+    return g_variant_builder_end(&ifaces);
+}
+
+GVariant* GattDatabase::entry_for(Object* obj) {
+    if (!obj->entry) {
+        obj->entry = g_variant_ref_sink(g_variant_new("{o@a{sa{sv}}}", obj->path.c_str(),
+                                                      interfaces_for(obj)));
+        entry_builds_++;
+    }
+    return obj->entry;
+}
+
+GVariant* GattDatabase::managed_objects() {
+    if (!reply_) {
+        std::vector<GVariant*> entries;
+        entries.reserve(objects_.size());
+        for (auto& kv : objects_) entries.push_back(entry_for(kv.second.get()));
+
+        GVariant* array = g_variant_new_array(G_VARIANT_TYPE("{oa{sa{sv}}}"),
+                                              entries.data(), entries.size());
+        reply_ = g_variant_ref_sink(g_variant_new_tuple(&array, 1));
+    }
+    return reply_;
+}
+
+// =============================================================================
+// D-Bus export
+// =============================================================================
+
+bool GattDatabase::export_object(Object* obj, GError** error) {
+    static const GDBusInterfaceVTable object_vtable = {
+        handle_object_call, handle_get_property, NULL, {0}
+    };
+    obj->registration_id = g_dbus_connection_register_object(
+        connection_, obj->path.c_str(), interface_info(obj->kind),
+        &object_vtable, obj, NULL, error);
+    return obj->registration_id != 0;
+}
+
+void GattDatabase::emit_added(Object* obj) {
+    g_dbus_connection_emit_signal(connection_, NULL, app_path_.c_str(),
+        kObjectManagerInterface, "InterfacesAdded",
+        g_variant_new("(o@a{sa{sv}})", obj->path.c_str(), interfaces_for(obj)), NULL);
+}
+
+void GattDatabase::emit_removed(const std::string& path, Kind kind) {
+    const gchar* ifaces[] = {interface_name(kind), NULL};
+    g_dbus_connection_emit_signal(connection_, NULL, app_path_.c_str(),
+        kObjectManagerInterface, "InterfacesRemoved",
+        g_variant_new("(o^as)", path.c_str(), ifaces), NULL);
+}
+
+bool GattDatabase::register_objects(GDBusConnection* conn, GError** error) {
+    static const GDBusInterfaceVTable object_manager_vtable = {
+        handle_object_manager_call, NULL, NULL, {0}
+    };
+    connection_ = G_DBUS_CONNECTION(g_object_ref(conn));
+
+    manager_registration_id_ = g_dbus_connection_register_object(
+        connection_, app_path_.c_str(),
+        ObjectManagerInterface::info(),
+        &object_manager_vtable, this, NULL, error);
+    if (!manager_registration_id_) return false;
+
+    for (auto& kv : objects_) {
+        if (!export_object(kv.second.get(), error)) return false;
+    }
+    return true;
+}
+
+void GattDatabase::unregister_objects() {
+    if (!connection_) return;
+
+    for (auto& kv : objects_) {
+        Object* obj = kv.second.get();
+        if (obj->registration_id) {
+            g_dbus_connection_unregister_object(connection_, obj->registration_id);
+            obj->registration_id = 0;
+        }
+    }
+    if (manager_registration_id_) {
+        g_dbus_connection_unregister_object(connection_, manager_registration_id_);
+        manager_registration_id_ = 0;
+    }
+    g_object_unref(connection_);
+    connection_ = nullptr;
+}
+
+void GattDatabase::handle_object_manager_call(GDBusConnection* conn, const gchar* sender,
+                                              const gchar* object_path,
+                                              const gchar* interface_name,
+                                              const gchar* method_name, GVariant* parameters,
+                                              GDBusMethodInvocation* invocation,
+                                              gpointer user_data) {
+    GattDatabase* db = static_cast<GattDatabase*>(user_data);
+    ScopedTimer timer(handler_metrics().for_method(method_name));
+    // GetManagedObjects is the interface's only method; GDBus rejects the rest
+    g_dbus_method_invocation_return_value(invocation, db->managed_objects());
+}
+
+void GattDatabase::handle_object_call(GDBusConnection* conn, const gchar* sender,
+                                      const gchar* object_path, const gchar* interface_name,
+                                      const gchar* method_name, GVariant* parameters,
+                                      GDBusMethodInvocation* invocation, gpointer user_data) {
+    Object* obj = static_cast<Object*>(user_data);
+    HandlerPool* pool = obj->db->pool_;
+    if (pool && obj->handler && offloadable(method_name)) {
+        // The invocation owns the connection, names and parameters, and stays
+        // alive until the handler replies; the object itself may be removed
+        // meanwhile, so the task copies what it needs and keys on the address
+        MethodHandler handler = obj->handler;
+        gpointer data = obj->user_data;
+        const Histogram& seconds = handler_metrics().for_method(method_name);
+        uint64_t queued_at = ScopedTimer::now();
+        bool queued = pool->submit(obj, [=] {
+            handler_metrics().queued.record(ScopedTimer::now() - queued_at);
+            ScopedTimer timer(seconds);
+            handler(g_dbus_method_invocation_get_connection(invocation),
+                    g_dbus_method_invocation_get_sender(invocation),
+                    g_dbus_method_invocation_get_object_path(invocation),
+                    g_dbus_method_invocation_get_interface_name(invocation),
+                    g_dbus_method_invocation_get_method_name(invocation),
+                    g_dbus_method_invocation_get_parameters(invocation), invocation, data);
+        });
+        if (!queued) {
+            handler_metrics().rejected.inc();
+            g_dbus_method_invocation_return_dbus_error(invocation, "org.bluez.Error.InProgress",
+                                                       "Handler queue full");
+        }
+        return;
+    }
+
+    ScopedTimer timer(handler_metrics().for_method(method_name));
+    if (obj->handler) {
+        obj->handler(conn, sender, object_path, interface_name, method_name, parameters,
+                     invocation, obj->user_data);
+        return;
+    }
+    g_dbus_method_invocation_return_dbus_error(invocation, "org.bluez.Error.NotSupported",
+                                               "Operation not supported");
+}
+
+GVariant* GattDatabase::handle_get_property(GDBusConnection* conn, const gchar* sender,
+                                            const gchar* object_path,
+                                            const gchar* interface_name,
+                                            const gchar* property_name, GError** error,
+                                            gpointer user_data) {
+    Object* obj = static_cast<Object*>(user_data);
+    int i = find_property(obj->kind, property_name);
+    if (i >= 0 && obj->props[i]) return g_variant_ref(obj->props[i]);
+    g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                "No such property '%s'", property_name);
+    return NULL;
+}
+
+}  // namespace ble
@@ -0,0 +1,26 @@
+#include "ble_gatt_value.h"
+
+GVariant *ble_gatt_value_reply(GBytes *value) {
+    GVariant *array = g_variant_new_from_bytes(G_VARIANT_TYPE_BYTESTRING, value, TRUE);
+    return g_variant_new_tuple(&array, 1);
+}
+
+GVariant *ble_gatt_value_reply_at(GBytes *value, gsize offset) {
+    gsize size = g_bytes_get_size(value);
+    if (offset == 0) return ble_gatt_value_reply(value);
+    if (offset > size) offset = size;
+
+    GBytes *slice = g_bytes_new_from_bytes(value, offset, size - offset);
+    GVariant *reply = ble_gatt_value_reply(slice);
+    g_bytes_unref(slice);
+    return reply;
+}
+
+GBytes *ble_gatt_value_from_write(GVariant *parameters, GVariant **options) {
+    GVariant *array = g_variant_get_child_value(parameters, 0);
+    GBytes *value = g_variant_get_data_as_bytes(array);
+    g_variant_unref(array);
+
+    if (options) *options = g_variant_get_child_value(parameters, 1);
+    return value;
+}
@@ -0,0 +1,103 @@
+#include "ble_handler_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace ble {
+
+HandlerPool::~HandlerPool() {
+    stop();
+}
+
+bool HandlerPool::start(const HandlerPoolOptions& options, std::string* error) {
+    if (!workers_.empty()) {
+        *error = "handler pool already started";
+        return false;
+    }
+    if (options.queue_depth == 0) {
+        *error = "queue depth must be at least 1";
+        return false;
+    }
+    options_ = options;
+    unsigned threads = options.threads;
+    // Handlers block, so even one CPU gets a second worker
+    if (threads == 0) threads = std::max(2u, std::thread::hardware_concurrency());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = true;
+    }
+    for (unsigned i = 0; i < threads; i++) workers_.emplace_back(&HandlerPool::run, this);
+    return true;
+}
+
+void HandlerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    ready_cond_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+    workers_.clear();
+}
+
+bool HandlerPool::submit(const void* key, Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || pending_ >= options_.queue_depth) {
+            rejected_++;
+            return false;
+        }
+        Strand& strand = strands_[key];
+        strand.tasks.push_back(std::move(task));
+        pending_++;
+        submitted_++;
+        // A key with earlier tasks is already on ready_ or held by a worker
+        if (strand.tasks.size() > 1) return true;
+        ready_.push_back(key);
+    }
+    ready_cond_.notify_one();
+    return true;
+}
+
+HandlerPoolStats HandlerPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return HandlerPoolStats{submitted_, completed_, rejected_, pending_};
+}
+
+// =============================================================================
+// Workers
+// =============================================================================
+
+void HandlerPool::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        ready_cond_.wait(lock, [this] { return !ready_.empty() || !running_; });
+        // Accepted tasks still run after stop()
+        if (ready_.empty()) return;
+
+        const void* key = ready_.front();
+        ready_.pop_front();
+        // Only the worker holding a key erases its strand, so this stays valid
+        Strand& strand = strands_.find(key)->second;
+        Task task = std::move(strand.tasks.front());
+
+        lock.unlock();
+        task();
+        task = nullptr;     // Release captures before taking the lock
+        lock.lock();
+
+        strand.tasks.pop_front();
+        pending_--;
+        completed_++;
+        if (strand.tasks.empty()) {
+            strands_.erase(key);
+        } else {
+            // Back of the line, so other characteristics get a turn
+            ready_.push_back(key);
+            ready_cond_.notify_one();
+        }
+    }
+}
+
+}  // namespace ble
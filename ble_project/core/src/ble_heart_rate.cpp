@@ -0,0 +1,206 @@
+#include "ble_heart_rate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ble {
+
+namespace {
+
+constexpr size_t kDefaultRrPerPayload = 9;     // (20 - 2) / 2
+
+inline uint16_t load_le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// First eight payload bytes as a little-endian word, zero-padded past len
+inline uint64_t load_head(const uint8_t* p, size_t len) {
+    uint64_t h = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (len >= sizeof(h)) {
+        memcpy(&h, p, sizeof(h));
+        return h;
+    }
+#endif
+    for (size_t k = std::min(len, sizeof(h)); k-- > 0;) h = (h << 8) | p[k];
+    return h;
+}
+
+}  // namespace
+
+bool hrm_decode(const uint8_t* data, size_t len, HrmSample* out, uint16_t* rr, size_t rr_max) {
+    if (len < 2) return false;
+    size_t pos = 1;
+    out->flags = data[0];
+
+    if (out->flags & kHrmBpm16) {
+        if (len < 3) return false;
+        out->bpm = load_le16(&data[pos]);
+        pos += 2;
+    } else {
+        out->bpm = data[pos++];
+    }
+
+    out->energy_kj = 0;
+    if (out->flags & kHrmEnergyPresent) {
+        if (len < pos + 2) return false;
+        out->energy_kj = load_le16(&data[pos]);
+        pos += 2;
+    }
+
+    out->rr_count = 0;
+    if (out->flags & kHrmRrPresent) {
+        for (; pos + 2 <= len && out->rr_count < rr_max; pos += 2) {
+            rr[out->rr_count++] = load_le16(&data[pos]);
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// Batch decoder
+// =============================================================================
+
+HrmBatch::HrmBatch(size_t capacity, size_t rr_capacity)
+    : flags(capacity),
+      valid(capacity),
+      bpm(capacity),
+      energy_kj(capacity),
+      rr_count(capacity),
+      rr_begin(capacity),
+      rr(rr_capacity ? rr_capacity : capacity * kDefaultRrPerPayload),
+      head(capacity),
+      len(capacity) {}
+
+size_t hrm_decode_batch(const uint8_t* const* payloads, const uint16_t* lens, size_t n,
+                        HrmBatch* batch) {
+    n = std::min(n, batch->capacity());
+    uint64_t* head = batch->head.data();
+    uint16_t* len = batch->len.data();
+
+    // Pass 1: gather the fixed-position bytes (flags through energy) of each payload
+    for (size_t i = 0; i < n; i++) {
+        head[i] = load_head(payloads[i], lens[i]);
+        len[i] = lens[i];
+    }
+
+    // Pass 2: branch-free field extraction over dense arrays
+    uint8_t* flags = batch->flags.data();
+    uint8_t* valid = batch->valid.data();
+    uint16_t* bpm = batch->bpm.data();
+    uint16_t* energy = batch->energy_kj.data();
+    uint16_t* rr_count = batch->rr_count.data();
+    for (size_t i = 0; i < n; i++) {
+        uint64_t h = head[i];
+        uint32_t f = (uint32_t)(h & 0xFF);
+        uint32_t wide = f & 1u;
+        uint32_t has_energy = (f >> 3) & 1u;
+        uint32_t has_rr = (f >> 4) & 1u;
+
+        uint32_t energy_off = 2u + wide;
+        uint32_t rr_off = energy_off + 2u * has_energy;    // also the minimum length
+        uint32_t ok = (uint32_t)len[i] >= rr_off;
+
+        flags[i] = (uint8_t)f;
+        valid[i] = (uint8_t)ok;
+        bpm[i] = (uint16_t)((uint32_t)(h >> 8) & (0xFFu | (0xFF00u * wide)) & (0u - ok));
+        energy[i] = (uint16_t)((uint32_t)(h >> (8 * energy_off)) & (0u - (has_energy & ok)) & 0xFFFFu);
+        rr_count[i] = (uint16_t)((((uint32_t)len[i] - rr_off) >> 1) & (0u - (has_rr & ok)));
+    }
+
+    // Pass 3: lay out RR intervals back to back
+    uint32_t* rr_begin = batch->rr_begin.data();
+    uint16_t* rr = batch->rr.data();
+    const size_t rr_capacity = batch->rr.size();
+    size_t rr_size = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t count = std::min<size_t>(rr_count[i], rr_capacity - rr_size);
+        rr_count[i] = (uint16_t)count;
+        rr_begin[i] = (uint32_t)rr_size;
+
+        const uint8_t* p = payloads[i] + 2 + (flags[i] & 1u) + 2 * ((flags[i] >> 3) & 1u);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        memcpy(&rr[rr_size], p, count * sizeof(uint16_t));
+#else
+        for (size_t j = 0; j < count; j++) rr[rr_size + j] = load_le16(&p[2 * j]);
+#endif
+        rr_size += count;
+    }
+
+    batch->size = n;
+    batch->rr_size = rr_size;
+    return n;
+}
+
+// =============================================================================
+// Aggregator
+// =============================================================================
+
+HeartRateAggregator::HeartRateAggregator(size_t bpm_window, size_t rr_window)
+    : bpm_ring_(std::max<size_t>(bpm_window, 1)),
+      diff_ring_(std::max<size_t>(rr_window, 2) - 1) {}
+
+void HeartRateAggregator::add_bpm(uint16_t bpm) {
+    if (bpm_fill_ == bpm_ring_.size()) {
+        bpm_sum_ -= bpm_ring_[bpm_pos_];
+    } else {
+        bpm_fill_++;
+    }
+    bpm_ring_[bpm_pos_] = bpm;
+    bpm_sum_ += bpm;
+    bpm_pos_ = bpm_pos_ + 1 == bpm_ring_.size() ? 0 : bpm_pos_ + 1;
+    samples_++;
+}
+
+void HeartRateAggregator::add_rr(uint16_t rr) {
+    if (intervals_++ > 0) {
+        // 64-bit: a corrupt 0xFFFF interval squares past INT32_MAX
+        int64_t d = (int64_t)rr - (int64_t)last_rr_;
+        uint64_t sq = (uint64_t)(d * d);
+        if (diff_fill_ == diff_ring_.size()) {
+            diff_sum_ -= diff_ring_[diff_pos_];
+        } else {
+            diff_fill_++;
+        }
+        diff_ring_[diff_pos_] = sq;
+        diff_sum_ += sq;
+        diff_pos_ = diff_pos_ + 1 == diff_ring_.size() ? 0 : diff_pos_ + 1;
+    }
+    last_rr_ = rr;
+}
+
+void HeartRateAggregator::add(const HrmBatch& batch) {
+    // Only the newest window's worth of each series can affect the result,
+    // so older samples are counted but not pushed through the rings.
+    size_t valid = 0;
+    for (size_t i = 0; i < batch.size; i++) valid += batch.valid[i];
+    size_t skip = valid > bpm_ring_.size() ? valid - bpm_ring_.size() : 0;
+    samples_ += skip;
+    for (size_t i = 0; i < batch.size; i++) {
+        if (!batch.valid[i]) continue;
+        if (skip) { skip--; continue; }
+        add_bpm(batch.bpm[i]);
+    }
+
+    // Invalid payloads contribute no intervals, so rr[] is the continuous series
+    size_t keep = diff_ring_.size() + 1;
+    size_t start = batch.rr_size > keep ? batch.rr_size - keep : 0;
+    if (start) {
+        intervals_ += start;
+        last_rr_ = batch.rr[start - 1];
+    }
+    for (size_t k = start; k < batch.rr_size; k++) add_rr(batch.rr[k]);
+}
+
+double HeartRateAggregator::bpm() const {
+    return bpm_fill_ ? (double)bpm_sum_ / (double)bpm_fill_ : 0.0;
+}
+
+double HeartRateAggregator::rmssd_ms() const {
+    if (!diff_fill_) return 0.0;
+    // Differences are in 1/1024 s
+    return std::sqrt((double)diff_sum_ / (double)diff_fill_) * 1000.0 / 1024.0;
+}
+
+}  // namespace ble
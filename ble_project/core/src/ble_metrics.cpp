@@ -0,0 +1,458 @@
+#include "ble_metrics.hpp"
+#include "ble_dbus_schema.hpp"
+
+#include <gio/gio.h>
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+
+namespace ble {
+
+// =============================================================================
+// Per-thread shards
+// =============================================================================
+
+namespace detail {
+
+thread_local ThreadShard* tls_shard = nullptr;
+
+namespace {
+
+// Hands the shard back to the registry when its thread exits
+struct ShardOwner {
+    ThreadShard* shard = nullptr;
+    ~ShardOwner() {
+        if (shard) detach_thread(shard);
+    }
+};
+
+thread_local ShardOwner tls_owner;
+
+}  // namespace
+
+ThreadShard& attach_thread() {
+    Metrics& metrics = Metrics::global();
+    // No allocation, lock or thread-exit hook: callbacks may land here
+    size_t spare = metrics.spare_used_.fetch_add(1, std::memory_order_relaxed);
+    if (spare < kSpareShards) {
+        tls_shard = &metrics.spare_[spare];
+        return *tls_shard;
+    }
+
+    ThreadShard* shard = new ThreadShard;
+    {
+        std::lock_guard<std::mutex> lock(metrics.mutex_);
+        metrics.shards_.push_back(shard);
+    }
+    tls_owner.shard = shard;
+    tls_shard = shard;
+    return *shard;
+}
+
+void detach_thread(ThreadShard* shard) {
+    Metrics::global().retire(shard);
+    tls_shard = nullptr;
+}
+
+HistogramShard& attach_histogram(ThreadShard& shard, uint32_t id) {
+    // Published with release so a concurrent scrape sees zeroed buckets
+    HistogramShard* h = new HistogramShard;
+    shard.histograms[id].store(h, std::memory_order_release);
+    return *h;
+}
+
+}  // namespace detail
+
+uint64_t histogram_bucket_upper(unsigned index) {
+    if (index < (1u << kHistogramSubBits)) return index;
+    unsigned exp = (index >> kHistogramSubBits) + kHistogramSubBits - 1;
+    uint64_t sub = index & ((1u << kHistogramSubBits) - 1);
+    uint64_t width = 1ULL << (exp - kHistogramSubBits);
+    return (((1ULL << kHistogramSubBits) + sub) << (exp - kHistogramSubBits)) + width - 1;
+}
+
+uint64_t HistogramValue::percentile(double q) const {
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)(q * count + 0.5);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank) return std::min(histogram_bucket_upper(i), max);
+    }
+    return max;
+}
+
+// =============================================================================
+// Registry
+// =============================================================================
+
+Metrics& Metrics::global() {
+    // Never destroyed: threads may record while static destructors run
+    static Metrics* metrics = new Metrics;
+    return *metrics;
+}
+
+Metrics::Metrics() : spare_(new detail::ThreadShard[kSpareShards]) {
+    // Id 0 is the sink for metrics registered past the limits
+    counters_.push_back(Info{});
+    histograms_.push_back(Info{});
+    for (size_t i = 0; i < kSpareShards; i++) shards_.push_back(&spare_[i]);
+}
+
+Counter Metrics::counter(const char* name, const char* labels, const char* help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t id = 1; id < counters_.size(); id++) {
+        if (counters_[id].name == name && counters_[id].labels == labels) return Counter(id);
+    }
+    if (counters_.size() == kMaxCounters) return Counter(0);
+    counters_.push_back(Info{name, labels, help});
+    return Counter((uint32_t)counters_.size() - 1);
+}
+
+Histogram Metrics::histogram(const char* name, const char* labels, const char* help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t id = 1; id < histograms_.size(); id++) {
+        if (histograms_[id].name == name && histograms_[id].labels == labels) return Histogram(id);
+    }
+    if (histograms_.size() == kMaxHistograms) return Histogram(0);
+    histograms_.push_back(Info{name, labels, help});
+    return Histogram((uint32_t)histograms_.size() - 1);
+}
+
+void Metrics::retire(detail::ThreadShard* shard) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t id = 0; id < kMaxCounters; id++) {
+        detail::add(retired_.counters[id], shard->counters[id].load(std::memory_order_relaxed));
+    }
+    for (size_t id = 0; id < kMaxHistograms; id++) {
+        detail::HistogramShard* from = shard->histograms[id].load(std::memory_order_acquire);
+        if (!from) continue;
+        detail::HistogramShard* to = retired_.histograms[id].load(std::memory_order_relaxed);
+        if (!to) {
+            to = new detail::HistogramShard;
+            retired_.histograms[id].store(to, std::memory_order_release);
+        }
+        for (unsigned b = 0; b < kHistogramBuckets; b++) {
+            detail::add(to->buckets[b], from->buckets[b].load(std::memory_order_relaxed));
+        }
+        detail::add(to->count, from->count.load(std::memory_order_relaxed));
+        detail::add(to->sum, from->sum.load(std::memory_order_relaxed));
+        to->max.store(std::max(to->max.load(std::memory_order_relaxed),
+                               from->max.load(std::memory_order_relaxed)),
+                      std::memory_order_relaxed);
+        delete from;
+    }
+    shards_.erase(std::find(shards_.begin(), shards_.end(), shard));
+    delete shard;
+}
+
+MetricsSnapshot Metrics::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<const detail::ThreadShard*> shards(shards_.begin(), shards_.end());
+    shards.push_back(&retired_);
+
+    MetricsSnapshot out;
+    for (uint32_t id = 1; id < counters_.size(); id++) {
+        uint64_t value = 0;
+        for (const detail::ThreadShard* shard : shards) {
+            value += shard->counters[id].load(std::memory_order_relaxed);
+        }
+        out.counters.push_back(CounterValue{counters_[id].name, counters_[id].labels,
+                                            counters_[id].help, value});
+    }
+    for (uint32_t id = 1; id < histograms_.size(); id++) {
+        HistogramValue value{histograms_[id].name, histograms_[id].labels, histograms_[id].help,
+                             0, 0, 0, std::vector<uint64_t>(kHistogramBuckets)};
+        for (const detail::ThreadShard* shard : shards) {
+            const detail::HistogramShard* h = shard->histograms[id].load(std::memory_order_acquire);
+            if (!h) continue;
+            for (unsigned b = 0; b < kHistogramBuckets; b++) {
+                value.buckets[b] += h->buckets[b].load(std::memory_order_relaxed);
+            }
+            value.count += h->count.load(std::memory_order_relaxed);
+            value.sum += h->sum.load(std::memory_order_relaxed);
+            value.max = std::max(value.max, h->max.load(std::memory_order_relaxed));
+        }
+        out.histograms.push_back(std::move(value));
+    }
+    return out;
+}
+
+// =============================================================================
+// Prometheus exposition
+// =============================================================================
+
+namespace {
+
+// Bucket bounds in seconds: 10 us to 10 s in 1-2.5-5 steps
+const double kExportBounds[] = {1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3, 5e-3,
+                                0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+
+std::string label_set(const std::string& labels, const char* extra) {
+    std::string out = labels;
+    if (extra) {
+        if (!out.empty()) out += ',';
+        out += extra;
+    }
+    return out.empty() ? out : "{" + out + "}";
+}
+
+void append(std::string* out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+void append(std::string* out, const char* fmt, ...) {
+    char line[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n > 0) out->append(line, std::min((size_t)n, sizeof(line) - 1));
+}
+
+template <typename T>
+void append_header(std::string* out, std::map<std::string, bool>* seen, const T& metric,
+                   const char* type) {
+    if ((*seen)[metric.name]) return;
+    (*seen)[metric.name] = true;
+    append(out, "# HELP %s %s\n# TYPE %s %s\n", metric.name.c_str(), metric.help.c_str(),
+           metric.name.c_str(), type);
+}
+
+}  // namespace
+
+std::string Metrics::prometheus() const {
+    MetricsSnapshot snap = snapshot();
+    std::string out;
+    out.reserve(4096);
+    std::map<std::string, bool> seen;
+
+    for (const CounterValue& c : snap.counters) {
+        append_header(&out, &seen, c, "counter");
+        append(&out, "%s%s %llu\n", c.name.c_str(), label_set(c.labels, nullptr).c_str(),
+               (unsigned long long)c.value);
+    }
+
+    for (const HistogramValue& h : snap.histograms) {
+        append_header(&out, &seen, h, "histogram");
+        uint64_t cumulative = 0;
+        unsigned b = 0;
+        for (double bound : kExportBounds) {
+            uint64_t bound_ns = (uint64_t)(bound * 1e9);
+            for (; b < kHistogramBuckets && histogram_bucket_upper(b) <= bound_ns; b++) {
+                cumulative += h.buckets[b];
+            }
+            char le[32];
+            snprintf(le, sizeof(le), "le=\"%g\"", bound);
+            append(&out, "%s_bucket%s %llu\n", h.name.c_str(), label_set(h.labels, le).c_str(),
+                   (unsigned long long)cumulative);
+        }
+        append(&out, "%s_bucket%s %llu\n", h.name.c_str(),
+               label_set(h.labels, "le=\"+Inf\"").c_str(), (unsigned long long)h.count);
+        append(&out, "%s_sum%s %.9f\n", h.name.c_str(), label_set(h.labels, nullptr).c_str(),
+               h.sum / 1e9);
+        append(&out, "%s_count%s %llu\n", h.name.c_str(), label_set(h.labels, nullptr).c_str(),
+               (unsigned long long)h.count);
+    }
+    return out;
+}
+
+// =============================================================================
+// HTTP endpoint
+// =============================================================================
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(const std::string& listen_on, std::string* error) {
+    if (running_) return true;
+
+    if (listen_on.compare(0, 5, "unix:") == 0) {
+        struct sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        std::string path = listen_on.substr(5);
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            if (error) *error = "invalid socket path";
+            return false;
+        }
+        memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        unlink(path.c_str());
+        if (fd_ < 0 || bind(fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            if (error) *error = strerror(errno);
+            stop();
+            return false;
+        }
+        unix_path_ = path;
+    } else {
+        size_t colon = listen_on.rfind(':');
+        if (colon == std::string::npos) {
+            if (error) *error = "expected HOST:PORT or unix:PATH";
+            return false;
+        }
+        std::string host = listen_on.substr(0, colon), port = listen_on.substr(colon + 1);
+        struct addrinfo hints = {}, *res = nullptr;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        int ret = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &res);
+        if (ret != 0) {
+            if (error) *error = gai_strerror(ret);
+            return false;
+        }
+        fd_ = socket(res->ai_family, res->ai_socktype | SOCK_CLOEXEC, res->ai_protocol);
+        int one = 1;
+        if (fd_ >= 0) setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        bool bound = fd_ >= 0 && bind(fd_, res->ai_addr, res->ai_addrlen) == 0;
+        int saved = errno;
+        freeaddrinfo(res);
+        if (!bound) {
+            if (error) *error = strerror(saved);
+            stop();
+            return false;
+        }
+    }
+
+    if (listen(fd_, 16) < 0) {
+        if (error) *error = strerror(errno);
+        stop();
+        return false;
+    }
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::run, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+    if (!unix_path_.empty()) unlink(unix_path_.c_str());
+    unix_path_.clear();
+}
+
+void MetricsServer::run() {
+    while (running_) {
+        // Short poll so stop() does not have to interrupt accept()
+        struct pollfd pfd = {fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) continue;
+        int client = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) continue;
+        serve(client);
+        close(client);
+    }
+}
+
+void MetricsServer::serve(int client) {
+    struct timeval timeout = {1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[2048];
+    size_t len = 0;
+    while (len < sizeof(request) - 1) {
+        ssize_t n = recv(client, request + len, sizeof(request) - 1 - len, 0);
+        if (n <= 0) break;
+        len += (size_t)n;
+        request[len] = '\0';
+        if (strstr(request, "\r\n\r\n")) break;
+    }
+    request[len] = '\0';
+
+    std::string response;
+    if (strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET / ", 6) == 0) {
+        std::string body = Metrics::global().prometheus();
+        append(&response, "HTTP/1.0 200 OK\r\n"
+                          "Content-Type: text/plain; version=0.0.4\r\n"
+                          "Content-Length: %zu\r\n\r\n", body.size());
+        response += body;
+    } else {
+        response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+    }
+
+    for (size_t off = 0; off < response.size();) {
+        ssize_t n = send(client, response.data() + off, response.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        off += (size_t)n;
+    }
+}
+
+// =============================================================================
+// org.example.Stats
+// =============================================================================
+
+namespace {
+
+constexpr InterfaceSchema<3, 0> kStatsSchema = {
+    "org.example.Stats",
+    {{
+        {"GetCounters", {}, {"a{st}"}},
+        {"GetHistograms", {}, {"a{s(tttttt)}"}},
+        {"GetPrometheus", {}, {"s"}},
+    }},
+};
+
+using StatsInterface = DBusInterface<kStatsSchema>;
+
+std::string full_name(const std::string& name, const std::string& labels) {
+    return labels.empty() ? name : name + "{" + labels + "}";
+}
+
+void handle_stats_call(GDBusConnection* conn, const gchar* sender, const gchar* object_path,
+                       const gchar* interface_name, const gchar* method_name,
+                       GVariant* parameters, GDBusMethodInvocation* invocation,
+                       gpointer user_data) {
+    Metrics& metrics = Metrics::global();
+    switch (StatsInterface::find_method(method_name)) {
+    case StatsInterface::method("GetCounters"): {
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE("a{st}"));
+        for (const CounterValue& c : metrics.snapshot().counters) {
+            g_variant_builder_add(&builder, "{st}", full_name(c.name, c.labels).c_str(),
+                                  (guint64)c.value);
+        }
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(a{st})", &builder));
+        break;
+    }
+    case StatsInterface::method("GetHistograms"): {
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE("a{s(tttttt)}"));
+        for (const HistogramValue& h : metrics.snapshot().histograms) {
+            g_variant_builder_add(&builder, "{s(tttttt)}", full_name(h.name, h.labels).c_str(),
+                                  (guint64)h.count, (guint64)h.sum,
+                                  (guint64)h.percentile(0.50), (guint64)h.percentile(0.99),
+                                  (guint64)h.percentile(0.999), (guint64)h.max);
+        }
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(a{s(tttttt)})", &builder));
+        break;
+    }
+    case StatsInterface::method("GetPrometheus"):
+        g_dbus_method_invocation_return_value(
+            invocation, g_variant_new("(s)", metrics.prometheus().c_str()));
+        break;
+    default:
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR,
+                                              G_DBUS_ERROR_UNKNOWN_METHOD,
+                                              "Method %s not supported", method_name);
+    }
+}
+
+}  // namespace
+
+unsigned metrics_register_dbus(GDBusConnection* conn, const char* object_path, GError** error) {
+    static const GDBusInterfaceVTable vtable = {handle_stats_call, NULL, NULL};
+    return g_dbus_connection_register_object(conn, object_path, StatsInterface::info(), &vtable,
+                                             NULL, NULL, error);
+}
+
+}  // namespace ble
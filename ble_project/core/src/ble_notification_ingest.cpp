@@ -0,0 +1,304 @@
+#include "ble_notification_ingest.hpp"
+#include "ble_gattlib.hpp"
+#include "ble_metrics.hpp"
+#include "ble_time.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace ble {
+
+namespace {
+
+struct NotifyMetrics {
+    Histogram latency = Metrics::global().histogram(
+        "ble_notify_latency_seconds", "", "Notification callback to dispatch on a worker");
+    Counter received = Metrics::global().counter(
+        "ble_notify_received_total", "", "Notifications accepted into a source ring");
+    Counter dropped = Metrics::global().counter(
+        "ble_notify_dropped_total", "", "Notifications discarded by DropOldest or after stop()");
+};
+
+const NotifyMetrics& notify_metrics() {
+    static const NotifyMetrics metrics;
+    return metrics;
+}
+
+size_t round_up_pow2(size_t n) {
+    size_t p = 2;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+void spin_lock(std::atomic_flag& lock) {
+    while (lock.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+}
+
+void spin_unlock(std::atomic_flag& lock) {
+    lock.clear(std::memory_order_release);
+}
+
+uint32_t read_sequence(const NotificationRecord& record, const SequenceField& field, bool* ok) {
+    *ok = field.offset >= 0 && (size_t)field.offset + field.width <= record.len;
+    if (!*ok) return 0;
+    uint32_t seq = 0;
+    for (uint8_t i = 0; i < field.width; i++) {
+        seq |= (uint32_t)record.data[field.offset + i] << (8 * i);
+    }
+    return seq;
+}
+
+}  // namespace
+
+NotificationIngest::NotificationIngest(NotificationIngestOptions options, BatchFn on_batch)
+    : options_(options), on_batch_(std::move(on_batch)) {
+    if (options_.workers == 0) options_.workers = 1;
+    if (options_.batch == 0) options_.batch = 1;
+    options_.ring_size = round_up_pow2(options_.ring_size);
+    if (options_.sequence.width != 1 && options_.sequence.width != 2) {
+        options_.sequence.width = 4;
+    }
+    // Fixed for the lifetime of the pipeline; the producer indexes it unlocked
+    for (size_t i = 0; i < options_.workers; i++) workers_.emplace_back(new Worker);
+    notify_metrics();   // register here, not on the first callback
+}
+
+NotificationIngest::~NotificationIngest() {
+    stop();
+    // gattlib holds each source as user_data until its handler is replaced
+    for (size_t i = 0; i < source_count_.load(); i++) {
+        Source* source = sources_[i].load();
+        if (source->connection) gattlib_register_notification(source->connection, nullptr, nullptr);
+        delete source;
+    }
+}
+
+int NotificationIngest::attach(gattlib_connection_t* connection, ble_addr_t address) {
+    Source* source = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(attach_mutex_);
+        size_t count = source_count_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count && !source; i++) {
+            Source* s = sources_[i].load(std::memory_order_relaxed);
+            if (s->address == address) source = s;
+        }
+        if (!source) {
+            if (count == kMaxSources) return -1;
+            source = new Source;
+            source->owner = this;
+            source->address = address;
+            source->index = (uint16_t)count;
+            source->mask = options_.ring_size - 1;
+            source->slots.reset(new NotificationRecord[options_.ring_size]);
+            sources_[count].store(source, std::memory_order_release);
+            source_count_.store(count + 1, std::memory_order_release);
+        }
+    }
+
+    if (gattlib_register_notification(connection, on_notification, source) != GATTLIB_SUCCESS) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(attach_mutex_);
+    source->connection = connection;
+    return source->index;
+}
+
+void NotificationIngest::detach(ble_addr_t address, bool connected) {
+    gattlib_connection_t* connection = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(attach_mutex_);
+        size_t count = source_count_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; i++) {
+            Source* s = sources_[i].load(std::memory_order_relaxed);
+            if (s->address != address) continue;
+            connection = s->connection;
+            s->connection = nullptr;
+            break;
+        }
+    }
+    if (connection && connected) gattlib_register_notification(connection, nullptr, nullptr);
+}
+
+int NotificationIngest::find(ble_addr_t address) const {
+    std::lock_guard<std::mutex> lock(attach_mutex_);
+    size_t count = source_count_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) {
+        if (sources_[i].load(std::memory_order_relaxed)->address == address) return (int)i;
+    }
+    return -1;
+}
+
+void NotificationIngest::start() {
+    if (running_.exchange(true)) return;
+    for (size_t i = 0; i < workers_.size(); i++) {
+        workers_[i]->thread = std::thread(&NotificationIngest::run, this, i);
+    }
+}
+
+void NotificationIngest::stop() {
+    if (!running_.exchange(false)) return;
+    for (auto& worker : workers_) {
+        worker->wake.notify_one();
+        worker->thread.join();
+    }
+}
+
+// =============================================================================
+// Producer (gattlib callback thread)
+// =============================================================================
+
+void NotificationIngest::on_notification(const uuid_t* uuid, const uint8_t* data, size_t len,
+                                         void* user_data) {
+    Source* source = static_cast<Source*>(user_data);
+    source->owner->push(*source, uuid, data, len);
+}
+
+void NotificationIngest::push(Source& source, const uuid_t* uuid, const uint8_t* data,
+                              size_t len) {
+    uint64_t now = monotonic_ns();
+    const size_t capacity = source.mask + 1;
+    const size_t tail = source.tail.load(std::memory_order_relaxed);
+
+    if (tail - source.head.load(std::memory_order_acquire) == capacity) {
+        if (!running_.load(std::memory_order_relaxed)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            notify_metrics().dropped.inc();
+            return;
+        }
+        if (options_.policy == Backpressure::Block) {
+            blocked_.fetch_add(1, std::memory_order_relaxed);
+            while (tail - source.head.load(std::memory_order_acquire) == capacity) {
+                if (!running_.load(std::memory_order_relaxed)) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    notify_metrics().dropped.inc();
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        } else {
+            spin_lock(source.lock);
+            size_t head = source.head.load(std::memory_order_relaxed);
+            if (tail - head == capacity) {
+                source.head.store(head + 1, std::memory_order_release);
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                notify_metrics().dropped.inc();
+            }
+            spin_unlock(source.lock);
+        }
+    }
+
+    NotificationRecord& record = source.slots[tail & source.mask];
+    record.timestamp_ns = now;
+    record.uuid = from_gattlib(*uuid);
+    record.source = source.index;
+    record.len = (uint16_t)std::min(len, kNotifyPayloadMax);
+    memcpy(record.data, data, record.len);
+    source.tail.store(tail + 1, std::memory_order_release);
+    received_.fetch_add(1, std::memory_order_relaxed);
+    notify_metrics().received.inc();
+
+    Worker& worker = *workers_[source.index % workers_.size()];
+    if (worker.sleeping.load(std::memory_order_acquire)) worker.wake.notify_one();
+}
+
+// =============================================================================
+// Consumers (worker threads)
+// =============================================================================
+
+size_t NotificationIngest::pop_batch(Source& source, NotificationRecord* out, size_t max) {
+    spin_lock(source.lock);
+    size_t head = source.head.load(std::memory_order_relaxed);
+    size_t n = std::min(source.tail.load(std::memory_order_acquire) - head, max);
+    for (size_t i = 0; i < n; i++) {
+        const NotificationRecord& record = source.slots[(head + i) & source.mask];
+        memcpy(&out[i], &record, offsetof(NotificationRecord, data) + record.len);
+    }
+    source.head.store(head + n, std::memory_order_release);
+    spin_unlock(source.lock);
+    return n;
+}
+
+size_t NotificationIngest::drain(Source& source, std::vector<NotificationRecord>& batch) {
+    size_t total = 0;
+    size_t n;
+    const Histogram& latency_histogram = notify_metrics().latency;
+    while ((n = pop_batch(source, batch.data(), batch.size())) > 0) {
+        uint64_t now = monotonic_ns();
+        uint64_t latency_sum = 0;
+        uint64_t latency_max = 0;
+        uint64_t gaps = 0;
+
+        for (size_t i = 0; i < n; i++) {
+            uint64_t latency = now - batch[i].timestamp_ns;
+            latency_sum += latency;
+            latency_max = std::max(latency_max, latency);
+            latency_histogram.record(latency);
+
+            bool ok;
+            uint32_t seq = read_sequence(batch[i], options_.sequence, &ok);
+            if (!ok) continue;
+            if (source.have_seq) {
+                uint32_t mask = options_.sequence.width == 4
+                    ? 0xFFFFFFFFu : (1u << (8 * options_.sequence.width)) - 1;
+                gaps += (seq - source.last_seq - 1) & mask;
+            }
+            source.have_seq = true;
+            source.last_seq = seq;
+        }
+
+        if (on_batch_) on_batch_(batch.data(), n);
+
+        delivered_.fetch_add(n, std::memory_order_relaxed);
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        gaps_.fetch_add(gaps, std::memory_order_relaxed);
+        latency_sum_ns_.fetch_add(latency_sum, std::memory_order_relaxed);
+        uint64_t max = latency_max_ns_.load(std::memory_order_relaxed);
+        while (latency_max > max &&
+               !latency_max_ns_.compare_exchange_weak(max, latency_max, std::memory_order_relaxed)) {
+        }
+        total += n;
+    }
+    return total;
+}
+
+void NotificationIngest::run(size_t index) {
+    Worker& worker = *workers_[index];
+    std::vector<NotificationRecord> batch(options_.batch);
+
+    auto drain_all = [&] {
+        size_t total = 0;
+        size_t count = source_count_.load(std::memory_order_acquire);
+        for (size_t i = index; i < count; i += options_.workers) {
+            total += drain(*sources_[i].load(std::memory_order_acquire), batch);
+        }
+        return total;
+    };
+
+    while (running_.load(std::memory_order_acquire)) {
+        if (drain_all()) continue;
+
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.sleeping.store(true, std::memory_order_release);
+        worker.wake.wait_for(lock, std::chrono::milliseconds(1));
+        worker.sleeping.store(false, std::memory_order_relaxed);
+    }
+    drain_all();
+}
+
+NotificationIngestStats NotificationIngest::stats() const {
+    uint64_t delivered = delivered_.load(std::memory_order_relaxed);
+    uint64_t latency_sum = latency_sum_ns_.load(std::memory_order_relaxed);
+    return NotificationIngestStats{
+        received_.load(std::memory_order_relaxed),
+        dropped_.load(std::memory_order_relaxed),
+        blocked_.load(std::memory_order_relaxed),
+        delivered,
+        batches_.load(std::memory_order_relaxed),
+        gaps_.load(std::memory_order_relaxed),
+        delivered ? latency_sum / delivered : 0,
+        latency_max_ns_.load(std::memory_order_relaxed),
+    };
+}
+
+}  // namespace ble
@@ -0,0 +1,173 @@
+#include "ble_notify_engine.hpp"
+#include "ble_time.hpp"
+
+#include <algorithm>
+
+namespace ble {
+
+namespace {
+
+constexpr uint64_t kMinTickNs = 1000000;   // 1 ms
+
+}  // namespace
+
+NotificationEngine::NotificationEngine(GattDatabase& db, GMainContext* context)
+    : db_(db), context_(context) {}
+
+NotificationEngine::~NotificationEngine() {
+    if (timer_) {
+        g_source_destroy(timer_);
+        g_source_unref(timer_);
+    }
+    for (auto& slot : slots_) {
+        GBytes* pending = slot->mailbox.exchange(nullptr);
+        if (pending) g_bytes_unref(pending);
+        if (slot->current) g_bytes_unref(slot->current);
+    }
+}
+
+NotificationEngine::Id NotificationEngine::add(const std::string& char_path, double max_rate_hz) {
+    std::unique_ptr<Slot> slot(new Slot);
+    slot->path = char_path;
+    slot->min_interval_ns = max_rate_hz > 0 ? (uint64_t)(1e9 / max_rate_hz) : 0;
+    slots_.push_back(std::move(slot));
+    return slots_.size() - 1;
+}
+
+// =============================================================================
+// Subscription state
+// =============================================================================
+
+void NotificationEngine::start(Id id) {
+    Slot& slot = *slots_[id];
+    if (slot.subscribed.exchange(true)) return;
+    db_.set_property(slot.path, "Notifying", g_variant_new_boolean(TRUE));
+    reschedule();
+}
+
+void NotificationEngine::stop(Id id) {
+    Slot& slot = *slots_[id];
+    if (!slot.subscribed.exchange(false)) return;
+    db_.set_property(slot.path, "Notifying", g_variant_new_boolean(FALSE));
+    reschedule();
+}
+
+bool NotificationEngine::subscribed(Id id) const {
+    return slots_[id]->subscribed.load(std::memory_order_relaxed);
+}
+
+void NotificationEngine::set_channel(Id id, FdChannel* channel) {
+    slots_[id]->channel = channel;
+}
+
+void NotificationEngine::reschedule() {
+    uint64_t tick = 0;
+    for (const auto& slot : slots_) {
+        if (!slot->subscribed.load(std::memory_order_relaxed)) continue;
+        uint64_t interval = std::max(slot->min_interval_ns, kMinTickNs);
+        tick = tick ? std::min(tick, interval) : interval;
+    }
+    if (tick == tick_ns_) return;
+
+    if (timer_) {
+        g_source_destroy(timer_);
+        g_source_unref(timer_);
+        timer_ = nullptr;
+    }
+    tick_ns_ = tick;
+    if (!tick) return;
+
+    timer_ = g_timeout_source_new((guint)(tick / 1000000));
+    g_source_set_callback(timer_, on_tick, this, NULL);
+    g_source_attach(timer_, context_);
+}
+
+// =============================================================================
+// Producers
+// =============================================================================
+
+void NotificationEngine::post(Slot& slot, GBytes* value) {
+    slot.published.fetch_add(1, std::memory_order_relaxed);
+
+    GBytes* replaced = slot.mailbox.exchange(value, std::memory_order_acq_rel);
+    if (replaced) {
+        g_bytes_unref(replaced);
+        slot.coalesced.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void NotificationEngine::publish(Id id, const void* data, size_t len) {
+    post(*slots_[id], g_bytes_new(data, len));
+}
+
+void NotificationEngine::publish(Id id, GBytes* value) {
+    post(*slots_[id], g_bytes_ref(value));
+}
+
+// =============================================================================
+// Emission
+// =============================================================================
+
+bool NotificationEngine::take(Slot& slot) {
+    GBytes* value = slot.mailbox.exchange(nullptr, std::memory_order_acq_rel);
+    if (!value) return false;
+    if (slot.current) g_bytes_unref(slot.current);
+    slot.current = value;
+    slot.unsent = true;
+    return true;
+}
+
+GBytes* NotificationEngine::value(Id id) {
+    Slot& slot = *slots_[id];
+    take(slot);
+    return slot.current;
+}
+
+void NotificationEngine::drain(Slot& slot, uint64_t now_ns) {
+    if (!slot.subscribed.load(std::memory_order_relaxed)) return;
+    // Half a tick early still counts, so a timer that fires slightly early
+    // does not cost a whole tick
+    if (now_ns + tick_ns_ / 2 < slot.next_due_ns) return;
+
+    // Link behind: leave the value in the mailbox so newer samples coalesce
+    if (slot.channel && (slot.channel->flush(), slot.channel->pending())) return;
+
+    take(slot);
+    if (!slot.unsent) return;
+    slot.unsent = false;
+    // From the previous deadline, not from now, unless the slot was idle
+    // for longer than an interval; then it must not catch up in a burst
+    uint64_t base = now_ns > slot.next_due_ns + slot.min_interval_ns ? now_ns : slot.next_due_ns;
+    slot.next_due_ns = base + slot.min_interval_ns;
+
+    bool delivered;
+    if (slot.channel) {
+        gsize len;
+        const void* data = g_bytes_get_data(slot.current, &len);
+        delivered = slot.channel->queue(data, len);
+        slot.channel->flush();
+    } else {
+        delivered = db_.emit_changed(slot.path, "Value",
+            g_variant_new_from_bytes(G_VARIANT_TYPE("ay"), slot.current, TRUE));
+    }
+    (delivered ? slot.emitted : slot.dropped).fetch_add(1, std::memory_order_relaxed);
+}
+
+gboolean NotificationEngine::on_tick(gpointer user_data) {
+    NotificationEngine* self = static_cast<NotificationEngine*>(user_data);
+    uint64_t now = monotonic_ns();
+    for (auto& slot : self->slots_) self->drain(*slot, now);
+    return G_SOURCE_CONTINUE;
+}
+
+NotifyStats NotificationEngine::stats(Id id) const {
+    const Slot& slot = *slots_[id];
+    return NotifyStats{
+        slot.published.load(std::memory_order_relaxed),
+        slot.coalesced.load(std::memory_order_relaxed),
+        slot.emitted.load(std::memory_order_relaxed),
+        slot.dropped.load(std::memory_order_relaxed),
+    };
+}
+
+}  // namespace ble
@@ -0,0 +1,146 @@
+#include "ble_nus_stream.hpp"
+#include "ble_time.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ble {
+
+namespace {
+
+constexpr uint16_t kAttMinMtu = 23;
+constexpr size_t kAttWriteHeader = 3;   // opcode + handle
+constexpr size_t kAttMaxValue = 512;    // No attribute value is longer, whatever the MTU
+
+size_t round_up_pow2(size_t n) {
+    size_t p = 64;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+}  // namespace
+
+NusStream::NusStream(WriteFn write, NusStreamOptions options)
+    : write_(std::move(write)),
+      max_credits_(options.credits),
+      credits_(options.credits),
+      rx_mask_(round_up_pow2(options.rx_buffer) - 1),
+      rx_(new uint8_t[rx_mask_ + 1]) {
+    set_mtu(options.mtu);
+}
+
+void NusStream::set_mtu(uint16_t mtu) {
+    chunk_ = std::min(std::max(mtu, kAttMinMtu) - kAttWriteHeader, kAttMaxValue);
+}
+
+// =============================================================================
+// Transmit
+// =============================================================================
+
+size_t NusStream::write(const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    size_t sent = 0;
+
+    while (sent < len) {
+        size_t n = std::min(chunk_, len - sent);
+        bool last = sent + n == len;
+        bool checkpoint = last || credits_ == 0;
+
+        uint64_t start = monotonic_ns();
+        int ret = write_(p + sent, n, checkpoint);
+        uint64_t latency = monotonic_ns() - start;
+
+        if (ret != 0) {
+            tx_errors_.fetch_add(1, std::memory_order_relaxed);
+            credits_ = 0;   // delivery of earlier commands is unknown
+            return sent;
+        }
+        if (checkpoint) {
+            credits_ = max_credits_;
+            tx_checkpoints_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            credits_--;
+        }
+
+        sent += n;
+        tx_bytes_.fetch_add(n, std::memory_order_relaxed);
+        tx_chunks_.fetch_add(1, std::memory_order_relaxed);
+        latency_sum_ns_.fetch_add(latency, std::memory_order_relaxed);
+        if (latency > latency_max_ns_.load(std::memory_order_relaxed)) {
+            latency_max_ns_.store(latency, std::memory_order_relaxed);  // single writer
+        }
+    }
+    return sent;
+}
+
+// =============================================================================
+// Receive
+// =============================================================================
+
+void NusStream::receive(const uint8_t* data, size_t len) {
+    const size_t capacity = rx_mask_ + 1;
+    size_t tail = rx_tail_.load(std::memory_order_relaxed);
+    size_t room = capacity - (tail - rx_head_.load(std::memory_order_acquire));
+    if (len > room) {
+        rx_overflow_.fetch_add(len - room, std::memory_order_relaxed);
+        len = room;
+    }
+    if (len == 0) return;
+
+    size_t offset = tail & rx_mask_;
+    size_t first = std::min(len, capacity - offset);
+    memcpy(&rx_[offset], data, first);
+    memcpy(&rx_[0], data + first, len - first);
+    rx_tail_.store(tail + len, std::memory_order_seq_cst);
+    rx_bytes_.fetch_add(len, std::memory_order_relaxed);
+
+    if (waiting_.load(std::memory_order_seq_cst)) {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        readable_.notify_one();
+    }
+}
+
+const uint8_t* NusStream::peek(size_t* len) const {
+    size_t head = rx_head_.load(std::memory_order_relaxed);
+    size_t avail = rx_tail_.load(std::memory_order_acquire) - head;
+    size_t offset = head & rx_mask_;
+    *len = std::min(avail, rx_mask_ + 1 - offset);
+    return &rx_[offset];
+}
+
+void NusStream::consume(size_t n) {
+    size_t head = rx_head_.load(std::memory_order_relaxed);
+    n = std::min(n, rx_tail_.load(std::memory_order_acquire) - head);
+    rx_head_.store(head + n, std::memory_order_release);
+}
+
+size_t NusStream::available() const {
+    return rx_tail_.load(std::memory_order_acquire) - rx_head_.load(std::memory_order_relaxed);
+}
+
+bool NusStream::wait_readable(size_t min, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    waiting_.store(true, std::memory_order_seq_cst);
+    bool ok = readable_.wait_for(lock, timeout, [&] {
+        return rx_tail_.load(std::memory_order_seq_cst) -
+               rx_head_.load(std::memory_order_relaxed) >= min;
+    });
+    waiting_.store(false, std::memory_order_relaxed);
+    return ok;
+}
+
+NusStats NusStream::stats() const {
+    uint64_t chunks = tx_chunks_.load(std::memory_order_relaxed);
+    return NusStats{
+        tx_bytes_.load(std::memory_order_relaxed),
+        chunks,
+        tx_checkpoints_.load(std::memory_order_relaxed),
+        tx_errors_.load(std::memory_order_relaxed),
+        rx_bytes_.load(std::memory_order_relaxed),
+        rx_overflow_.load(std::memory_order_relaxed),
+        chunks ? latency_sum_ns_.load(std::memory_order_relaxed) / chunks : 0,
+        latency_max_ns_.load(std::memory_order_relaxed),
+    };
+}
+
+}  // namespace ble
@@ -0,0 +1,280 @@
+#include "ble_rssi_tracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ble {
+
+namespace {
+
+constexpr float kAbsent = -INFINITY;    ///< Filter value of a free slot; above() never matches it
+constexpr size_t kScanBlock = 256;
+
+unsigned round_window(unsigned window) {
+    unsigned w = 4;
+    while (w < window && w < 128) w *= 2;
+    return w;
+}
+
+uint32_t to_ms(uint64_t ns) {
+    return (uint32_t)(ns / 1000000);
+}
+
+}  // namespace
+
+RssiTracker::RssiTracker(const RssiTrackerOptions& options)
+    : options_(options), capacity_(std::max<size_t>(options.capacity, 1)) {
+    options_.window = round_window(options.window);
+    unsigned median = std::max(1u, std::min({options.median_window, options_.window, 15u}));
+    options_.median_window = median % 2 ? median : median - 1;
+    window_mask_ = options_.window - 1;
+
+    address_.reset(new ble_addr_t[capacity_]);
+    last_seen_.reset(new uint64_t[capacity_]);
+    count_.reset(new uint32_t[capacity_]);
+    prev_.reset(new uint32_t[capacity_]);
+    next_.reset(new uint32_t[capacity_]);
+    for (auto& column : filtered_) {
+        column.reset(new float[capacity_]);
+        std::fill(column.get(), column.get() + capacity_, kAbsent);
+    }
+    kalman_p_.reset(new float[capacity_]);
+    ring_rssi_.reset(new int8_t[capacity_ * options_.window]);
+    ring_ms_.reset(new uint32_t[capacity_ * options_.window]);
+
+    // At most half full, so probes stay short
+    size_t index_size = 1;
+    while (index_size < capacity_ * 2) index_size *= 2;
+    index_.reset(new uint32_t[index_size]());
+    index_mask_ = index_size - 1;
+}
+
+RssiTracker::~RssiTracker() = default;
+
+size_t RssiTracker::memory_bytes() const {
+    size_t per_slot = sizeof(ble_addr_t) + sizeof(uint64_t) + 3 * sizeof(uint32_t) +
+                      5 * sizeof(float) + options_.window * (sizeof(int8_t) + sizeof(uint32_t));
+    return capacity_ * per_slot + (index_mask_ + 1) * sizeof(uint32_t);
+}
+
+// =============================================================================
+// Samples
+// =============================================================================
+
+bool RssiTracker::add(ble_addr_t address, int16_t rssi, uint64_t timestamp_ns) {
+    if (rssi == BLE_RSSI_UNKNOWN) return false;
+    rssi = std::max<int16_t>(-128, std::min<int16_t>(127, rssi));
+    float z = rssi;
+
+    uint32_t slot = lookup(address);
+    if (slot == kNone) {
+        slot = insert(address);
+        filtered_[(int)RssiFilter::Ewma][slot] = z;
+        filtered_[(int)RssiFilter::Kalman][slot] = z;
+        kalman_p_[slot] = options_.kalman_r;
+    } else {
+        unlink(slot);
+        float& ewma = filtered_[(int)RssiFilter::Ewma][slot];
+        ewma += options_.ewma_alpha * (z - ewma);
+
+        float& x = filtered_[(int)RssiFilter::Kalman][slot];
+        float p = kalman_p_[slot] + options_.kalman_q;
+        float gain = p / (p + options_.kalman_r);
+        x += gain * (z - x);
+        kalman_p_[slot] = (1 - gain) * p;
+    }
+    push_front(slot);
+
+    size_t pos = (size_t)slot * options_.window + (count_[slot] & window_mask_);
+    ring_rssi_[pos] = (int8_t)rssi;
+    ring_ms_[pos] = to_ms(timestamp_ns);
+    count_[slot]++;
+    last_seen_[slot] = timestamp_ns;
+    filtered_[(int)RssiFilter::Last][slot] = z;
+    filtered_[(int)RssiFilter::Median][slot] = window_median(slot);
+    samples_++;
+    return true;
+}
+
+void RssiTracker::add(const ScanRecord* records, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        add(records[i].address, records[i].rssi, records[i].timestamp_ns);
+    }
+}
+
+float RssiTracker::window_median(uint32_t slot) const {
+    // At most 15 samples, so this is a constant amount of work per sample
+    int8_t v[15];
+    uint32_t n = std::min<uint32_t>(count_[slot], options_.median_window);
+    const int8_t* ring = &ring_rssi_[(size_t)slot * options_.window];
+    uint32_t newest = count_[slot] - 1;
+    for (uint32_t i = 0; i < n; i++) {
+        int8_t x = ring[(newest - i) & window_mask_];
+        uint32_t j = i;
+        for (; j > 0 && v[j - 1] > x; j--) v[j] = v[j - 1];
+        v[j] = x;
+    }
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0f;
+}
+
+size_t RssiTracker::expire(uint64_t now_ns) {
+    if (!options_.max_age_ns || now_ns < options_.max_age_ns) return 0;
+    uint64_t cutoff = now_ns - options_.max_age_ns;
+    size_t n = 0;
+    // The list is in order of last sighting, so the stale ones are at the tail
+    while (lru_tail_ != kNone && last_seen_[lru_tail_] < cutoff) {
+        remove(lru_tail_);
+        n++;
+    }
+    expired_ += n;
+    return n;
+}
+
+// =============================================================================
+// Queries
+// =============================================================================
+
+RssiSummary RssiTracker::summary(uint32_t slot) const {
+    return RssiSummary{
+        address_[slot],
+        last_seen_[slot],
+        count_[slot],
+        filtered_[(int)RssiFilter::Last][slot],
+        filtered_[(int)RssiFilter::Ewma][slot],
+        filtered_[(int)RssiFilter::Kalman][slot],
+        filtered_[(int)RssiFilter::Median][slot],
+    };
+}
+
+bool RssiTracker::find(ble_addr_t address, RssiSummary* out) const {
+    uint32_t slot = lookup(address);
+    if (slot == kNone) return false;
+    *out = summary(slot);
+    return true;
+}
+
+size_t RssiTracker::history(ble_addr_t address, int8_t* rssi, uint64_t* timestamps_ns,
+                            size_t max) const {
+    uint32_t slot = lookup(address);
+    if (slot == kNone) return 0;
+    uint32_t kept = std::min<uint32_t>(count_[slot], options_.window);
+    size_t n = std::min<size_t>(kept, max);
+    const int8_t* ring = &ring_rssi_[(size_t)slot * options_.window];
+    const uint32_t* ms = &ring_ms_[(size_t)slot * options_.window];
+    uint32_t newest = count_[slot] - 1;
+    uint32_t last_ms = ms[newest & window_mask_];
+    for (size_t i = 0; i < n; i++) {
+        uint32_t pos = (newest - (uint32_t)(n - 1 - i)) & window_mask_;
+        rssi[i] = ring[pos];
+        // Stamps wrap every 49 days; the age relative to the newest does not
+        if (timestamps_ns) timestamps_ns[i] = last_seen_[slot] - (uint64_t)(last_ms - ms[pos]) * 1000000;
+    }
+    return n;
+}
+
+size_t RssiTracker::above(RssiFilter filter, float threshold_dbm,
+                          std::vector<ble_addr_t>* out) const {
+    const float* values = filtered_[(int)filter].get();
+    size_t found = 0;
+    uint8_t hit[kScanBlock];
+    for (size_t base = 0; base < used_; base += kScanBlock) {
+        size_t n = std::min<size_t>(kScanBlock, used_ - base);
+        // Branch-free compare over the column; free slots hold -inf
+        unsigned hits = 0;
+        for (size_t i = 0; i < n; i++) {
+            hit[i] = values[base + i] > threshold_dbm;
+            hits += hit[i];
+        }
+        if (!hits) continue;
+        // Write every address and keep the hits; no branch to mispredict
+        size_t at = out->size();
+        out->resize(at + n);
+        ble_addr_t* dst = out->data() + at;
+        size_t kept = 0;
+        for (size_t i = 0; i < n; i++) {
+            dst[kept] = address_[base + i];
+            kept += hit[i];
+        }
+        out->resize(at + kept);
+        found += kept;
+    }
+    return found;
+}
+
+size_t RssiTracker::count_above(RssiFilter filter, float threshold_dbm) const {
+    const float* values = filtered_[(int)filter].get();
+    size_t found = 0;
+    for (size_t i = 0; i < used_; i++) found += values[i] > threshold_dbm;
+    return found;
+}
+
+// =============================================================================
+// Slots, LRU list and address index
+// =============================================================================
+
+uint32_t RssiTracker::lookup(ble_addr_t address) const {
+    for (size_t i = ble_addr_hash(address) & index_mask_; index_[i]; i = (i + 1) & index_mask_) {
+        uint32_t slot = index_[i] - 1;
+        if (address_[slot] == address) return slot;
+    }
+    return kNone;
+}
+
+uint32_t RssiTracker::insert(ble_addr_t address) {
+    if (size_ == capacity_) {
+        remove(lru_tail_);
+        evicted_++;
+    }
+    uint32_t slot;
+    if (free_ != kNone) {
+        slot = free_;
+        free_ = next_[slot];
+    } else {
+        slot = used_++;
+    }
+    address_[slot] = address;
+    count_[slot] = 0;
+    size_t i = ble_addr_hash(address) & index_mask_;
+    while (index_[i]) i = (i + 1) & index_mask_;
+    index_[i] = slot + 1;
+    size_++;
+    return slot;
+}
+
+void RssiTracker::remove(uint32_t slot) {
+    // Backward-shift deletion keeps every probe sequence unbroken
+    size_t i = ble_addr_hash(address_[slot]) & index_mask_;
+    while (index_[i] != slot + 1) i = (i + 1) & index_mask_;
+    for (size_t j = (i + 1) & index_mask_; index_[j]; j = (j + 1) & index_mask_) {
+        size_t home = ble_addr_hash(address_[index_[j] - 1]) & index_mask_;
+        // Move j into the hole unless its home lies cyclically in (i, j]
+        if (((j - home) & index_mask_) >= ((j - i) & index_mask_)) {
+            index_[i] = index_[j];
+            i = j;
+        }
+    }
+    index_[i] = 0;
+
+    unlink(slot);
+    for (auto& column : filtered_) column[slot] = kAbsent;
+    next_[slot] = free_;
+    free_ = slot;
+    size_--;
+}
+
+void RssiTracker::unlink(uint32_t slot) {
+    if (prev_[slot] != kNone) next_[prev_[slot]] = next_[slot];
+    else lru_head_ = next_[slot];
+    if (next_[slot] != kNone) prev_[next_[slot]] = prev_[slot];
+    else lru_tail_ = prev_[slot];
+}
+
+void RssiTracker::push_front(uint32_t slot) {
+    prev_[slot] = kNone;
+    next_[slot] = lru_head_;
+    if (lru_head_ != kNone) prev_[lru_head_] = slot;
+    else lru_tail_ = slot;
+    lru_head_ = slot;
+}
+
+}  // namespace ble
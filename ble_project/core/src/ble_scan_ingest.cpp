@@ -0,0 +1,182 @@
+#include "ble_scan_ingest.hpp"
+#include "ble_metrics.hpp"
+#include "ble_time.hpp"
+
+#include <cstring>
+
+namespace ble {
+
+namespace {
+
+struct ScanMetrics {
+    Counter received = Metrics::global().counter(
+        "ble_scan_adverts_total", "", "Scan callbacks accepted into the ingest ring");
+    Counter dropped = Metrics::global().counter(
+        "ble_scan_dropped_total", "", "Scan callbacks dropped because the ingest ring was full");
+};
+
+const ScanMetrics& scan_metrics() {
+    static const ScanMetrics metrics;
+    return metrics;
+}
+
+}  // namespace
+
+bool scan_record_make(const char* address, const char* name, int16_t rssi,
+                      ScanRecord* out) noexcept {
+    if (!ble_addr_parse(address, &out->address)) return false;
+
+    out->timestamp_ns = monotonic_ns();
+    out->rssi = rssi;
+    size_t len = 0;
+    if (name) {
+        while (len < kScanNameMax && name[len]) len++;
+        memcpy(out->name, name, len);
+    }
+    out->name_len = (uint8_t)len;
+    out->ad_len = 0;
+    out->scan_response = false;
+    return true;
+}
+
+void scan_record_make(ble_addr_t address, int16_t rssi, const uint8_t* ad, size_t ad_len,
+                      bool scan_response, uint64_t timestamp_ns, ScanRecord* out) noexcept {
+    out->timestamp_ns = timestamp_ns;
+    out->address = address;
+    out->rssi = rssi;
+    out->name_len = 0;
+    out->ad_len = (uint8_t)(ad_len < kAdLegacyMax ? ad_len : kAdLegacyMax);
+    out->scan_response = scan_response;
+    memcpy(out->ad, ad, out->ad_len);
+}
+
+ScanIngest::ScanIngest() : table_(4096), adverts_(4096) {
+    scan_metrics();     // register here, not on the first callback
+}
+
+ScanIngest::~ScanIngest() {
+    stop();
+}
+
+bool ScanIngest::submit(const ScanRecord& record) noexcept {
+    if (!ring_.try_push(record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        scan_metrics().dropped.inc();
+        return false;
+    }
+    received_.fetch_add(1, std::memory_order_relaxed);
+    scan_metrics().received.inc();
+    return true;
+}
+
+void ScanIngest::submit_wait(const ScanRecord& record) noexcept {
+    while (!ring_.try_push(record)) std::this_thread::yield();
+    received_.fetch_add(1, std::memory_order_relaxed);
+    scan_metrics().received.inc();
+}
+
+ScanStats ScanIngest::stats() const {
+    return ScanStats{
+        received_.load(std::memory_order_relaxed),
+        dropped_.load(std::memory_order_relaxed),
+        folded_.load(std::memory_order_relaxed),
+        ad_parsed_.load(std::memory_order_relaxed),
+        expired_.load(std::memory_order_relaxed),
+    };
+}
+
+void ScanIngest::start(std::chrono::milliseconds report_interval, ReportFn on_report) {
+    if (running_.exchange(true)) return;
+    interval_ = report_interval;
+    on_report_ = std::move(on_report);
+    consumer_ = std::thread(&ScanIngest::run, this);
+}
+
+void ScanIngest::stop() {
+    if (!running_.exchange(false)) return;
+    consumer_.join();
+}
+
+void ScanIngest::fold(const ScanRecord& record) {
+    bool inserted;
+    DeviceEntry* e = table_.upsert(record.address, record.timestamp_ns, &inserted);
+    if (record.timestamp_ns > newest_ns_) newest_ns_ = record.timestamp_ns;
+
+    bool changed = inserted;
+    if (record.name_len) changed |= set_name(e, record.name, record.name_len);
+    if (record.ad_len &&
+        adverts_.update(record.address, record.scan_response, record.ad, record.ad_len)) {
+        AdData ad(record.ad, record.ad_len);
+        ByteView name = ad.local_name();
+        if (name.len && !record.name_len) changed |= set_name(e, (const char*)name.data, name.len);
+        if (!record.scan_response) {
+            memcpy(e->ad, record.ad, record.ad_len);
+            e->ad_len = record.ad_len;
+        }
+        changed = true;
+        ad_parsed_.store(ad_parsed_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    if (record.rssi != BLE_RSSI_UNKNOWN && record.rssi != e->device.rssi) {
+        e->device.rssi = record.rssi;
+        changed = true;
+    }
+    if (changed) e->changed_epoch = table_.epoch();
+    folded_.store(folded_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+bool ScanIngest::set_name(DeviceEntry* e, const char* name, size_t len) {
+    // Interned pointers compare equal iff the strings do
+    const char* interned = names_.intern(name, len);
+    if (e->device.name == interned) return false;
+    e->device.name = interned;
+    return true;
+}
+
+size_t ScanIngest::drain() {
+    ScanRecord batch[kBatch];
+    size_t total = 0;
+    size_t n;
+    while ((n = ring_.pop_batch(batch, kBatch)) > 0) {
+        for (size_t i = 0; i < n; i++) fold(batch[i]);
+        if (on_batch_) on_batch_(batch, n);
+        total += n;
+    }
+    return total;
+}
+
+void ScanIngest::expire() {
+    uint64_t age_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        expire_after_).count();
+    if (!age_ns || newest_ns_ <= age_ns) return;
+    size_t n = table_.expire(newest_ns_ - age_ns, [this](const DeviceEntry& e) {
+        adverts_.forget(e.device.address);
+    });
+    expired_.store(expired_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void ScanIngest::report() {
+    if (on_report_) on_report_(*this, table_.epoch());
+    table_.advance_epoch();
+}
+
+void ScanIngest::run() {
+    auto next_report = std::chrono::steady_clock::now() + interval_;
+
+    while (running_.load(std::memory_order_acquire)) {
+        if (drain() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_report) {
+            expire();
+            report();
+            next_report = now + interval_;
+        }
+    }
+
+    drain();
+    expire();
+    report();
+}
+
+}  // namespace ble
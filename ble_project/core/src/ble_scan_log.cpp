@@ -0,0 +1,349 @@
+#include "ble_scan_log.hpp"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace ble {
+
+namespace {
+
+constexpr char kMagic[8] = {'B', 'L', 'E', 'S', 'L', 'O', 'G', 0};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kUnit = sizeof(ScanLogUnit);
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t unit;
+    uint64_t sequence;
+    uint64_t committed;         ///< Bytes of units after the header
+};
+
+static_assert(sizeof(SegmentHeader) == 2 * kUnit, "SegmentHeader is two units");
+
+constexpr size_t kMaxId = UINT16_MAX;
+
+inline size_t units_for(size_t bytes) {
+    return (bytes + kUnit - 1) / kUnit;
+}
+
+bool parse_segment_name(const char* name, uint64_t* sequence) {
+    unsigned long long seq;
+    int end = 0;
+    if (sscanf(name, "scan-%llu.bsl%n", &seq, &end) != 1 || name[end] != '\0') return false;
+    *sequence = seq;
+    return true;
+}
+
+}  // namespace
+
+int64_t realtime_offset_ns() {
+    struct timespec real, mono;
+    clock_gettime(CLOCK_REALTIME, &real);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    return ((int64_t)real.tv_sec - mono.tv_sec) * 1000000000LL + (real.tv_nsec - mono.tv_nsec);
+}
+
+std::vector<std::string> scan_log_segments(const std::string& directory) {
+    std::vector<std::pair<uint64_t, std::string>> found;
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (struct dirent* entry = readdir(dir)) {
+            uint64_t sequence;
+            if (parse_segment_name(entry->d_name, &sequence)) {
+                found.emplace_back(sequence, directory + "/" + entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(found.begin(), found.end());
+    std::vector<std::string> paths;
+    for (auto& f : found) paths.push_back(std::move(f.second));
+    return paths;
+}
+
+// =============================================================================
+// ScanLogWriter
+// =============================================================================
+
+ScanLogWriter::~ScanLogWriter() {
+    close();
+}
+
+bool ScanLogWriter::open(const ScanLogOptions& options, std::string* error) {
+    close();
+    options_ = options;
+    if (options_.segment_bytes < 64 * kUnit) options_.segment_bytes = 64 * kUnit;
+
+    // Continue after the newest segment; existing files are never reopened
+    sequence_ = 0;
+    std::vector<std::string> existing = scan_log_segments(options_.directory);
+    if (!existing.empty()) {
+        const char* name = strrchr(existing.back().c_str(), '/') + 1;
+        parse_segment_name(name, &sequence_);
+    }
+    if (!open_segment()) {
+        *error = error_;
+        return false;
+    }
+    return true;
+}
+
+bool ScanLogWriter::open_segment() {
+    char name[32];
+    snprintf(name, sizeof(name), "/scan-%010" PRIu64 ".bsl", ++sequence_);
+    std::string path = options_.directory + name;
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd_ < 0 || ftruncate(fd_, (off_t)options_.segment_bytes) != 0) {
+        error_ = path + ": " + strerror(errno);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    void* map = mmap(nullptr, options_.segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        error_ = path + ": " + strerror(errno);
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    map_ = static_cast<uint8_t*>(map);
+
+    SegmentHeader* header = reinterpret_cast<SegmentHeader*>(map_);
+    memcpy(header->magic, kMagic, sizeof(kMagic));
+    header->version = kVersion;
+    header->unit = kUnit;
+    header->sequence = sequence_;
+    header->committed = 0;
+    used_ = 0;
+    name_ids_.clear();
+    name_offsets_.assign(1, 0);
+    payload_ids_.clear();
+    payload_offsets_.assign(1, 0);
+
+    stats_.segments++;
+    stats_.bytes += sizeof(SegmentHeader);
+    prune();
+    return true;
+}
+
+void ScanLogWriter::close_segment() {
+    if (!map_) return;
+    munmap(map_, options_.segment_bytes);
+    // Give the unused tail back; flash on field units is small
+    if (ftruncate(fd_, (off_t)(sizeof(SegmentHeader) + used_)) != 0) {
+        error_ = strerror(errno);
+    }
+    ::close(fd_);
+    map_ = nullptr;
+    fd_ = -1;
+}
+
+void ScanLogWriter::close() {
+    close_segment();
+}
+
+void ScanLogWriter::prune() {
+    if (!options_.max_segments) return;
+    std::vector<std::string> segments = scan_log_segments(options_.directory);
+    for (size_t i = 0; i + options_.max_segments < segments.size(); i++) {
+        unlink(segments[i].c_str());
+    }
+}
+
+void ScanLogWriter::flush() {
+    if (map_) msync(map_, sizeof(SegmentHeader) + used_, MS_ASYNC);
+}
+
+uint8_t* ScanLogWriter::reserve(size_t units) {
+    uint8_t* p = map_ + sizeof(SegmentHeader) + used_;
+    used_ += units * kUnit;
+    stats_.bytes += units * kUnit;
+    return p;
+}
+
+void ScanLogWriter::commit() {
+    SegmentHeader* header = reinterpret_cast<SegmentHeader*>(map_);
+    __atomic_store_n(&header->committed, (uint64_t)used_, __ATOMIC_RELEASE);
+}
+
+uint16_t ScanLogWriter::intern(std::unordered_map<uint64_t, uint16_t>& ids,
+                               std::vector<size_t>& offsets, uint8_t kind,
+                               const uint8_t* data, size_t len) {
+    const uint64_t h = ad_hash(data, len);
+    auto it = ids.find(h);
+    if (it != ids.end()) {
+        const ScanLogUnit* def = reinterpret_cast<const ScanLogUnit*>(map_ + offsets[it->second] - kUnit);
+        if (def->delta_us == len && memcmp(map_ + offsets[it->second], data, len) == 0) {
+            return it->second;
+        }
+    }
+
+    // New, or a hash collision; either way define it again under a new id
+    uint16_t id = (uint16_t)offsets.size();
+    ScanLogUnit* def = reinterpret_cast<ScanLogUnit*>(reserve(1 + units_for(len)));
+    memset(def, 0, (1 + units_for(len)) * kUnit);
+    def->delta_us = (uint32_t)len;
+    def->kind = kind;
+    if (kind == kScanLogName) def->name_id = id;
+    else def->payload_id = id;
+    memcpy(def + 1, data, len);
+    offsets.push_back((size_t)((uint8_t*)(def + 1) - map_));
+    ids[h] = id;
+    if (kind == kScanLogName) stats_.names++;
+    else stats_.payloads++;
+    return id;
+}
+
+bool ScanLogWriter::append(const ScanRecord& record) {
+    if (!map_) return false;
+    const uint64_t now_us =
+        (uint64_t)((int64_t)record.timestamp_ns + options_.clock_offset_ns) / 1000;
+
+    // Rotate before writing anything, so a record and its definitions share a segment
+    size_t worst = 2 + (record.name_len ? 1 + units_for(record.name_len) : 0) +
+                   (record.ad_len ? 1 + units_for(record.ad_len) : 0);
+    if (sizeof(SegmentHeader) + used_ + worst * kUnit > options_.segment_bytes ||
+        name_offsets_.size() > kMaxId || payload_offsets_.size() > kMaxId) {
+        close_segment();
+        if (!open_segment()) return false;
+    }
+
+    if (used_ == 0 || now_us < last_us_ || now_us - last_us_ > UINT32_MAX) {
+        ScanLogUnit* t = reinterpret_cast<ScanLogUnit*>(reserve(1));
+        memset(t, 0, kUnit);
+        t->kind = kScanLogTime;
+        memcpy(reinterpret_cast<uint8_t*>(t) + 8, &now_us, sizeof(now_us));
+        last_us_ = now_us;
+    }
+
+    uint16_t name_id = record.name_len
+        ? intern(name_ids_, name_offsets_, kScanLogName, (const uint8_t*)record.name, record.name_len)
+        : 0;
+    uint16_t payload_id = record.ad_len
+        ? intern(payload_ids_, payload_offsets_, kScanLogPayload, record.ad, record.ad_len)
+        : 0;
+
+    ScanLogUnit* u = reinterpret_cast<ScanLogUnit*>(reserve(1));
+    u->delta_us = (uint32_t)(now_us - last_us_);
+    u->kind = kScanLogAdvert;
+    if (ble_addr_type(record.address) == BLE_ADDR_RANDOM) u->kind |= kScanLogRandomBit;
+    if (record.scan_response) u->kind |= kScanLogScanResponseBit;
+    u->rssi = (int8_t)std::max<int16_t>(-128, std::min<int16_t>(127, record.rssi));
+    u->name_id = name_id;
+    u->payload_id = payload_id;
+    uint64_t bits = ble_addr_bits(record.address);
+    for (int i = 0; i < 6; i++) u->address[i] = (uint8_t)(bits >> (8 * i));
+    last_us_ = now_us;
+
+    commit();
+    stats_.records++;
+    return true;
+}
+
+// =============================================================================
+// ScanLogReader
+// =============================================================================
+
+ScanLogReader::~ScanLogReader() {
+    close();
+}
+
+void ScanLogReader::close() {
+    if (map_) munmap(const_cast<uint8_t*>(map_), size_);
+    map_ = nullptr;
+    size_ = end_ = pos_ = 0;
+    names_.clear();
+    payloads_.clear();
+}
+
+bool ScanLogReader::open(const char* path, std::string* error) {
+    close();
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *error = strerror(errno);
+        return false;
+    }
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(SegmentHeader)) {
+        map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        *error = "not a scan log segment";
+        return false;
+    }
+    map_ = static_cast<const uint8_t*>(map);
+    size_ = (size_t)st.st_size;
+
+    const SegmentHeader* header = reinterpret_cast<const SegmentHeader*>(map_);
+    if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion ||
+        header->unit != kUnit) {
+        close();
+        *error = "not a scan log segment";
+        return false;
+    }
+    sequence_ = header->sequence;
+    uint64_t committed = __atomic_load_n(&header->committed, __ATOMIC_ACQUIRE);
+    end_ = sizeof(SegmentHeader) + std::min<uint64_t>(committed, size_ - sizeof(SegmentHeader));
+    pos_ = sizeof(SegmentHeader);
+    now_us_ = 0;
+    names_.assign(1, ByteView{nullptr, 0});
+    payloads_.assign(1, ByteView{nullptr, 0});
+    return true;
+}
+
+bool ScanLogReader::next(ScanLogEntry* out) {
+    while (pos_ + kUnit <= end_) {
+        ScanLogUnit u;
+        memcpy(&u, map_ + pos_, kUnit);
+        pos_ += kUnit;
+
+        switch (u.kind & kScanLogKindMask) {
+        case kScanLogTime:
+            memcpy(&now_us_, map_ + pos_ - kUnit + 8, sizeof(now_us_));
+            break;
+        case kScanLogName:
+        case kScanLogPayload: {
+            size_t len = u.delta_us;
+            if (pos_ + units_for(len) * kUnit > end_) return false;
+            bool is_name = (u.kind & kScanLogKindMask) == kScanLogName;
+            std::vector<ByteView>& table = is_name ? names_ : payloads_;
+            uint16_t id = is_name ? u.name_id : u.payload_id;
+            if (table.size() <= id) table.resize(id + 1, ByteView{nullptr, 0});
+            table[id] = ByteView{map_ + pos_, len};
+            pos_ += units_for(len) * kUnit;
+            break;
+        }
+        case kScanLogAdvert: {
+            now_us_ += u.delta_us;
+            uint64_t bits = 0;
+            for (int i = 5; i >= 0; i--) bits = (bits << 8) | u.address[i];
+            out->timestamp_us = now_us_;
+            out->address = ble_addr_make(bits, (u.kind & kScanLogRandomBit) ? BLE_ADDR_RANDOM
+                                                                             : BLE_ADDR_PUBLIC);
+            out->rssi = u.rssi;
+            out->scan_response = (u.kind & kScanLogScanResponseBit) != 0;
+            out->name = u.name_id < names_.size() ? names_[u.name_id] : ByteView{nullptr, 0};
+            out->ad = u.payload_id < payloads_.size() ? payloads_[u.payload_id] : ByteView{nullptr, 0};
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+    return false;
+}
+
+}  // namespace ble
@@ -0,0 +1,87 @@
+#include "ble_uuid.h"
+#include "ble_common.h"
+
+#include <string.h>
+
+/* -1 for non-hex characters */
+static const int8_t hex_table[256] = {
+    ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+    ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+/* Accumulates n hex digits into *acc; returns false on a non-hex char */
+static bool parse_hex(const char *s, int n, uint64_t *acc) {
+    uint64_t v = *acc;
+    for (int i = 0; i < n; i++) {
+        int d = hex_table[(uint8_t)s[i]] - 1;
+        if (d < 0) return false;
+        v = (v << 4) | (uint64_t)d;
+    }
+    *acc = v;
+    return true;
+}
+
+bool ble_uuid_parse(const char *str, ble_uuid_t *out) {
+    if (!str) return false;
+    size_t len = strlen(str);
+
+    if (len == 4 || len == 8) {
+        uint64_t v = 0;
+        if (!parse_hex(str, (int)len, &v)) return false;
+        *out = ble_uuid_from32((uint32_t)v);
+        return true;
+    }
+
+    if (len != BLE_UUID_SIZE - 1) return false;
+    if (str[8] != '-' || str[13] != '-' || str[18] != '-' || str[23] != '-') return false;
+
+    uint64_t hi = 0, lo = 0;
+    if (!parse_hex(str, 8, &hi) || !parse_hex(str + 9, 4, &hi) ||
+        !parse_hex(str + 14, 4, &hi) || !parse_hex(str + 19, 4, &lo) ||
+        !parse_hex(str + 24, 12, &lo)) {
+        return false;
+    }
+    out->hi = hi;
+    out->lo = lo;
+    return true;
+}
+
+static void format_hex(uint64_t v, int digits, char *out) {
+    static const char hex[] = "0123456789abcdef";
+    for (int i = digits - 1; i >= 0; i--) {
+        out[i] = hex[v & 0xF];
+        v >>= 4;
+    }
+}
+
+void ble_uuid_format(const ble_uuid_t *uuid, char *out) {
+    format_hex(uuid->hi >> 32, 8, out);
+    out[8] = '-';
+    format_hex(uuid->hi >> 16, 4, out + 9);
+    out[13] = '-';
+    format_hex(uuid->hi, 4, out + 14);
+    out[18] = '-';
+    format_hex(uuid->lo >> 48, 4, out + 19);
+    out[23] = '-';
+    format_hex(uuid->lo, 12, out + 24);
+    out[36] = '\0';
+}
+
+void ble_uuid_from_bytes_be(const uint8_t bytes[16], ble_uuid_t *out) {
+    uint64_t hi = 0, lo = 0;
+    for (int i = 0; i < 8; i++) {
+        hi = (hi << 8) | bytes[i];
+        lo = (lo << 8) | bytes[i + 8];
+    }
+    out->hi = hi;
+    out->lo = lo;
+}
+
+void ble_uuid_to_bytes_be(const ble_uuid_t *uuid, uint8_t bytes[16]) {
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (uint8_t)(uuid->hi >> (56 - 8 * i));
+        bytes[i + 8] = (uint8_t)(uuid->lo >> (56 - 8 * i));
+    }
+}
@@ -0,0 +1,1158 @@
+/* Generated by scripts/gen_uuid_registry.py from the YAML files in core/data. Do not edit. */
+
+#include "ble_uuid.h"
+
+#include <stddef.h>
+
+static const ble_uuid_info_t sig_info[546] = {
+    { "Generic Access", BLE_UUID_KIND_SERVICE },  /* 0x1800 */
+    { "Generic Attribute", BLE_UUID_KIND_SERVICE },  /* 0x1801 */
+    { "Immediate Alert", BLE_UUID_KIND_SERVICE },  /* 0x1802 */
+    { "Link Loss", BLE_UUID_KIND_SERVICE },  /* 0x1803 */
+    { "Tx Power", BLE_UUID_KIND_SERVICE },  /* 0x1804 */
+    { "Current Time", BLE_UUID_KIND_SERVICE },  /* 0x1805 */
+    { "Reference Time Update", BLE_UUID_KIND_SERVICE },  /* 0x1806 */
+    { "Next DST Change", BLE_UUID_KIND_SERVICE },  /* 0x1807 */
+    { "Glucose", BLE_UUID_KIND_SERVICE },  /* 0x1808 */
+    { "Health Thermometer", BLE_UUID_KIND_SERVICE },  /* 0x1809 */
+    { "Device Information", BLE_UUID_KIND_SERVICE },  /* 0x180A */
+    { "Heart Rate", BLE_UUID_KIND_SERVICE },  /* 0x180D */
+    { "Phone Alert Status", BLE_UUID_KIND_SERVICE },  /* 0x180E */
+    { "Battery", BLE_UUID_KIND_SERVICE },  /* 0x180F */
+    { "Blood Pressure", BLE_UUID_KIND_SERVICE },  /* 0x1810 */
+    { "Alert Notification", BLE_UUID_KIND_SERVICE },  /* 0x1811 */
+    { "Human Interface Device", BLE_UUID_KIND_SERVICE },  /* 0x1812 */
+    { "Scan Parameters", BLE_UUID_KIND_SERVICE },  /* 0x1813 */
+    { "Running Speed and Cadence", BLE_UUID_KIND_SERVICE },  /* 0x1814 */
+    { "Automation IO", BLE_UUID_KIND_SERVICE },  /* 0x1815 */
+    { "Cycling Speed and Cadence", BLE_UUID_KIND_SERVICE },  /* 0x1816 */
+    { "Cycling Power", BLE_UUID_KIND_SERVICE },  /* 0x1818 */
+    { "Location and Navigation", BLE_UUID_KIND_SERVICE },  /* 0x1819 */
+    { "Environmental Sensing", BLE_UUID_KIND_SERVICE },  /* 0x181A */
+    { "Body Composition", BLE_UUID_KIND_SERVICE },  /* 0x181B */
+    { "User Data", BLE_UUID_KIND_SERVICE },  /* 0x181C */
+    { "Weight Scale", BLE_UUID_KIND_SERVICE },  /* 0x181D */
+    { "Bond Management", BLE_UUID_KIND_SERVICE },  /* 0x181E */
+    { "Continuous Glucose Monitoring", BLE_UUID_KIND_SERVICE },  /* 0x181F */
+    { "Internet Protocol Support", BLE_UUID_KIND_SERVICE },  /* 0x1820 */
+    { "Indoor Positioning", BLE_UUID_KIND_SERVICE },  /* 0x1821 */
+    { "Pulse Oximeter", BLE_UUID_KIND_SERVICE },  /* 0x1822 */
+    { "HTTP Proxy", BLE_UUID_KIND_SERVICE },  /* 0x1823 */
+    { "Transport Discovery", BLE_UUID_KIND_SERVICE },  /* 0x1824 */
+    { "Object Transfer", BLE_UUID_KIND_SERVICE },  /* 0x1825 */
+    { "Fitness Machine", BLE_UUID_KIND_SERVICE },  /* 0x1826 */
+    { "Mesh Provisioning", BLE_UUID_KIND_SERVICE },  /* 0x1827 */
+    { "Mesh Proxy", BLE_UUID_KIND_SERVICE },  /* 0x1828 */
+    { "Reconnection Configuration", BLE_UUID_KIND_SERVICE },  /* 0x1829 */
+    { "Insulin Delivery", BLE_UUID_KIND_SERVICE },  /* 0x183A */
+    { "Binary Sensor", BLE_UUID_KIND_SERVICE },  /* 0x183B */
+    { "Emergency Configuration", BLE_UUID_KIND_SERVICE },  /* 0x183C */
+    { "Authorization Control", BLE_UUID_KIND_SERVICE },  /* 0x183D */
+    { "Physical Activity Monitor", BLE_UUID_KIND_SERVICE },  /* 0x183E */
+    { "Elapsed Time", BLE_UUID_KIND_SERVICE },  /* 0x183F */
+    { "Generic Health Sensor", BLE_UUID_KIND_SERVICE },  /* 0x1840 */
+    { "Audio Input Control", BLE_UUID_KIND_SERVICE },  /* 0x1843 */
+    { "Volume Control", BLE_UUID_KIND_SERVICE },  /* 0x1844 */
+    { "Volume Offset Control", BLE_UUID_KIND_SERVICE },  /* 0x1845 */
+    { "Coordinated Set Identification", BLE_UUID_KIND_SERVICE },  /* 0x1846 */
+    { "Device Time", BLE_UUID_KIND_SERVICE },  /* 0x1847 */
+    { "Media Control", BLE_UUID_KIND_SERVICE },  /* 0x1848 */
+    { "Generic Media Control", BLE_UUID_KIND_SERVICE },  /* 0x1849 */
+    { "Constant Tone Extension", BLE_UUID_KIND_SERVICE },  /* 0x184A */
+    { "Telephone Bearer", BLE_UUID_KIND_SERVICE },  /* 0x184B */
+    { "Generic Telephone Bearer", BLE_UUID_KIND_SERVICE },  /* 0x184C */
+    { "Microphone Control", BLE_UUID_KIND_SERVICE },  /* 0x184D */
+    { "Audio Stream Control", BLE_UUID_KIND_SERVICE },  /* 0x184E */
+    { "Broadcast Audio Scan", BLE_UUID_KIND_SERVICE },  /* 0x184F */
+    { "Published Audio Capabilities", BLE_UUID_KIND_SERVICE },  /* 0x1850 */
+    { "Basic Audio Announcement", BLE_UUID_KIND_SERVICE },  /* 0x1851 */
+    { "Broadcast Audio Announcement", BLE_UUID_KIND_SERVICE },  /* 0x1852 */
+    { "Common Audio", BLE_UUID_KIND_SERVICE },  /* 0x1853 */
+    { "Hearing Access", BLE_UUID_KIND_SERVICE },  /* 0x1854 */
+    { "Telephony and Media Audio", BLE_UUID_KIND_SERVICE },  /* 0x1855 */
+    { "Public Broadcast Announcement", BLE_UUID_KIND_SERVICE },  /* 0x1856 */
+    { "Electronic Shelf Label", BLE_UUID_KIND_SERVICE },  /* 0x1857 */
+    { "Gaming Audio", BLE_UUID_KIND_SERVICE },  /* 0x1858 */
+    { "Mesh Proxy Solicitation", BLE_UUID_KIND_SERVICE },  /* 0x1859 */
+    { "Industrial Measurement Device", BLE_UUID_KIND_SERVICE },  /* 0x185A */
+    { "Ranging", BLE_UUID_KIND_SERVICE },  /* 0x185B */
+    { "Primary Service", BLE_UUID_KIND_DECLARATION },  /* 0x2800 */
+    { "Secondary Service", BLE_UUID_KIND_DECLARATION },  /* 0x2801 */
+    { "Include", BLE_UUID_KIND_DECLARATION },  /* 0x2802 */
+    { "Characteristic", BLE_UUID_KIND_DECLARATION },  /* 0x2803 */
+    { "Characteristic Extended Properties", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2900 */
+    { "Characteristic User Description", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2901 */
+    { "Client Characteristic Configuration", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2902 */
+    { "Server Characteristic Configuration", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2903 */
+    { "Characteristic Presentation Format", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2904 */
+    { "Characteristic Aggregate Format", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2905 */
+    { "Valid Range", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2906 */
+    { "External Report Reference", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2907 */
+    { "Report Reference", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2908 */
+    { "Number of Digitals", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2909 */
+    { "Value Trigger Setting", BLE_UUID_KIND_DESCRIPTOR },  /* 0x290A */
+    { "Environmental Sensing Configuration", BLE_UUID_KIND_DESCRIPTOR },  /* 0x290B */
+    { "Environmental Sensing Measurement", BLE_UUID_KIND_DESCRIPTOR },  /* 0x290C */
+    { "Environmental Sensing Trigger Setting", BLE_UUID_KIND_DESCRIPTOR },  /* 0x290D */
+    { "Time Trigger Setting", BLE_UUID_KIND_DESCRIPTOR },  /* 0x290E */
+    { "Complete BR-EDR Transport Block Data", BLE_UUID_KIND_DESCRIPTOR },  /* 0x290F */
+    { "Observation Schedule", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2910 */
+    { "Valid Range and Accuracy", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2911 */
+    { "Measurement Description", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2912 */
+    { "Manufacturer Limits", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2913 */
+    { "Process Tolerances", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2914 */
+    { "IMD Trigger Setting", BLE_UUID_KIND_DESCRIPTOR },  /* 0x2915 */
+    { "Device Name", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A00 */
+    { "Appearance", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A01 */
+    { "Peripheral Privacy Flag", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A02 */
+    { "Reconnection Address", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A03 */
+    { "Peripheral Preferred Connection Parameters", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A04 */
+    { "Service Changed", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A05 */
+    { "Alert Level", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A06 */
+    { "Tx Power Level", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A07 */
+    { "Date Time", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A08 */
+    { "Day of Week", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A09 */
+    { "Day Date Time", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A0A */
+    { "Exact Time 256", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A0C */
+    { "DST Offset", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A0D */
+    { "Time Zone", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A0E */
+    { "Local Time Information", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A0F */
+    { "Time with DST", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A11 */
+    { "Time Accuracy", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A12 */
+    { "Time Source", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A13 */
+    { "Reference Time Information", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A14 */
+    { "Time Update Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A16 */
+    { "Time Update State", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A17 */
+    { "Glucose Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A18 */
+    { "Battery Level", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A19 */
+    { "Temperature Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A1C */
+    { "Temperature Type", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A1D */
+    { "Intermediate Temperature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A1E */
+    { "Measurement Interval", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A21 */
+    { "Boot Keyboard Input Report", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A22 */
+    { "System ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A23 */
+    { "Model Number String", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A24 */
+    { "Serial Number String", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A25 */
+    { "Firmware Revision String", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A26 */
+    { "Hardware Revision String", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A27 */
+    { "Software Revision String", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A28 */
+    { "Manufacturer Name String", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A29 */
+    { "IEEE 11073-20601 Regulatory Certification Data List", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A2A */
+    { "Current Time", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A2B */
+    { "Magnetic Declination", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A2C */
+    { "Scan Refresh", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A31 */
+    { "Boot Keyboard Output Report", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A32 */
+    { "Boot Mouse Input Report", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A33 */
+    { "Glucose Measurement Context", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A34 */
+    { "Blood Pressure Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A35 */
+    { "Intermediate Cuff Pressure", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A36 */
+    { "Heart Rate Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A37 */
+    { "Body Sensor Location", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A38 */
+    { "Heart Rate Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A39 */
+    { "Alert Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A3F */
+    { "Ringer Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A40 */
+    { "Ringer Setting", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A41 */
+    { "Alert Category ID Bit Mask", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A42 */
+    { "Alert Category ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A43 */
+    { "Alert Notification Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A44 */
+    { "Unread Alert Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A45 */
+    { "New Alert", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A46 */
+    { "Supported New Alert Category", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A47 */
+    { "Supported Unread Alert Category", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A48 */
+    { "Blood Pressure Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A49 */
+    { "HID Information", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A4A */
+    { "Report Map", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A4B */
+    { "HID Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A4C */
+    { "Report", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A4D */
+    { "Protocol Mode", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A4E */
+    { "Scan Interval Window", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A4F */
+    { "PnP ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A50 */
+    { "Glucose Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A51 */
+    { "Record Access Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A52 */
+    { "RSC Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A53 */
+    { "RSC Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A54 */
+    { "SC Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A55 */
+    { "Aggregate", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A5A */
+    { "CSC Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A5B */
+    { "CSC Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A5C */
+    { "Sensor Location", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A5D */
+    { "PLX Spot-Check Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A5E */
+    { "PLX Continuous Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A5F */
+    { "PLX Features", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A60 */
+    { "Cycling Power Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A63 */
+    { "Cycling Power Vector", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A64 */
+    { "Cycling Power Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A65 */
+    { "Cycling Power Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A66 */
+    { "Location and Speed", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A67 */
+    { "Navigation", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A68 */
+    { "Position Quality", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A69 */
+    { "LN Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A6A */
+    { "LN Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A6B */
+    { "Elevation", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A6C */
+    { "Pressure", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A6D */
+    { "Temperature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A6E */
+    { "Humidity", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A6F */
+    { "True Wind Speed", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A70 */
+    { "True Wind Direction", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A71 */
+    { "Apparent Wind Speed", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A72 */
+    { "Apparent Wind Direction", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A73 */
+    { "Gust Factor", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A74 */
+    { "Pollen Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A75 */
+    { "UV Index", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A76 */
+    { "Irradiance", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A77 */
+    { "Rainfall", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A78 */
+    { "Wind Chill", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A79 */
+    { "Heat Index", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A7A */
+    { "Dew Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A7B */
+    { "Descriptor Value Changed", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A7D */
+    { "Aerobic Heart Rate Lower Limit", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A7E */
+    { "Aerobic Threshold", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A7F */
+    { "Age", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A80 */
+    { "Anaerobic Heart Rate Lower Limit", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A81 */
+    { "Anaerobic Heart Rate Upper Limit", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A82 */
+    { "Anaerobic Threshold", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A83 */
+    { "Aerobic Heart Rate Upper Limit", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A84 */
+    { "Date of Birth", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A85 */
+    { "Date of Threshold Assessment", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A86 */
+    { "Email Address", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A87 */
+    { "Fat Burn Heart Rate Lower Limit", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A88 */
+    { "Fat Burn Heart Rate Upper Limit", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A89 */
+    { "First Name", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A8A */
+    { "Five Zone Heart Rate Limits", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A8B */
+    { "Gender", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A8C */
+    { "Heart Rate Max", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A8D */
+    { "Height", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A8E */
+    { "Hip Circumference", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A8F */
+    { "Last Name", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A90 */
+    { "Maximum Recommended Heart Rate", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A91 */
+    { "Resting Heart Rate", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A92 */
+    { "Sport Type for Aerobic and Anaerobic Thresholds", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A93 */
+    { "Three Zone Heart Rate Limits", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A94 */
+    { "Two Zone Heart Rate Limits", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A95 */
+    { "VO2 Max", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A96 */
+    { "Waist Circumference", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A97 */
+    { "Weight", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A98 */
+    { "Database Change Increment", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A99 */
+    { "User Index", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A9A */
+    { "Body Composition Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A9B */
+    { "Body Composition Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A9C */
+    { "Weight Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A9D */
+    { "Weight Scale Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A9E */
+    { "User Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2A9F */
+    { "Magnetic Flux Density - 2D", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AA0 */
+    { "Magnetic Flux Density - 3D", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AA1 */
+    { "Language", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AA2 */
+    { "Barometric Pressure Trend", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AA3 */
+    { "Bond Management Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AA4 */
+    { "Bond Management Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AA5 */
+    { "Central Address Resolution", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AA6 */
+    { "CGM Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AA7 */
+    { "CGM Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AA8 */
+    { "CGM Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AA9 */
+    { "CGM Session Start Time", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AAA */
+    { "CGM Session Run Time", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AAB */
+    { "CGM Specific Ops Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AAC */
+    { "Indoor Positioning Configuration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AAD */
+    { "Latitude", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AAE */
+    { "Longitude", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AAF */
+    { "Local North Coordinate", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AB0 */
+    { "Local East Coordinate", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AB1 */
+    { "Floor Number", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AB2 */
+    { "Altitude", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AB3 */
+    { "Uncertainty", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AB4 */
+    { "Location Name", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AB5 */
+    { "URI", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AB6 */
+    { "HTTP Headers", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AB7 */
+    { "HTTP Status Code", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AB8 */
+    { "HTTP Entity Body", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AB9 */
+    { "HTTP Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ABA */
+    { "HTTPS Security", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ABB */
+    { "TDS Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ABC */
+    { "OTS Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ABD */
+    { "Object Name", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ABE */
+    { "Object Type", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ABF */
+    { "Object Size", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AC0 */
+    { "Object First-Created", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AC1 */
+    { "Object Last-Modified", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AC2 */
+    { "Object ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AC3 */
+    { "Object Properties", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AC4 */
+    { "Object Action Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AC5 */
+    { "Object List Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AC6 */
+    { "Object List Filter", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AC7 */
+    { "Object Changed", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AC8 */
+    { "Resolvable Private Address Only", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AC9 */
+    { "Fitness Machine Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ACC */
+    { "Treadmill Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ACD */
+    { "Cross Trainer Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ACE */
+    { "Step Climber Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ACF */
+    { "Stair Climber Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AD0 */
+    { "Rower Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AD1 */
+    { "Indoor Bike Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AD2 */
+    { "Training Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AD3 */
+    { "Supported Speed Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AD4 */
+    { "Supported Inclination Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AD5 */
+    { "Supported Resistance Level Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AD6 */
+    { "Supported Heart Rate Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AD7 */
+    { "Supported Power Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AD8 */
+    { "Fitness Machine Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AD9 */
+    { "Fitness Machine Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ADA */
+    { "Mesh Provisioning Data In", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ADB */
+    { "Mesh Provisioning Data Out", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ADC */
+    { "Mesh Proxy Data In", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ADD */
+    { "Mesh Proxy Data Out", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2ADE */
+    { "Average Current", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AE0 */
+    { "Average Voltage", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AE1 */
+    { "Boolean", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AE2 */
+    { "Chromatic Distance from Planckian", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AE3 */
+    { "Chromaticity Coordinates", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AE4 */
+    { "Chromaticity in CCT and Duv Values", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AE5 */
+    { "Chromaticity Tolerance", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AE6 */
+    { "CIE 13.3-1995 Color Rendering Index", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AE7 */
+    { "Coefficient", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AE8 */
+    { "Correlated Color Temperature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AE9 */
+    { "Count 16", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AEA */
+    { "Count 24", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AEB */
+    { "Country Code", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AEC */
+    { "Date UTC", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AED */
+    { "Electric Current", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AEE */
+    { "Electric Current Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AEF */
+    { "Electric Current Specification", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AF0 */
+    { "Electric Current Statistics", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AF1 */
+    { "Energy", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AF2 */
+    { "Energy in a Period of Day", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AF3 */
+    { "Event Statistics", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AF4 */
+    { "Fixed String 16", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AF5 */
+    { "Fixed String 24", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AF6 */
+    { "Fixed String 36", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AF7 */
+    { "Fixed String 8", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AF8 */
+    { "Generic Level", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AF9 */
+    { "Global Trade Item Number", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AFA */
+    { "Illuminance", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AFB */
+    { "Luminous Efficacy", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AFC */
+    { "Luminous Energy", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AFD */
+    { "Luminous Exposure", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AFE */
+    { "Luminous Flux", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2AFF */
+    { "Luminous Flux Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B00 */
+    { "Luminous Intensity", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B01 */
+    { "Mass Flow", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B02 */
+    { "Perceived Lightness", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B03 */
+    { "Percentage 8", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B04 */
+    { "Power", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B05 */
+    { "Power Specification", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B06 */
+    { "Relative Runtime in a Current Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B07 */
+    { "Relative Runtime in a Generic Level Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B08 */
+    { "Relative Value in a Voltage Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B09 */
+    { "Relative Value in an Illuminance Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B0A */
+    { "Relative Value in a Period of Day", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B0B */
+    { "Relative Value in a Temperature Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B0C */
+    { "Temperature 8", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B0D */
+    { "Temperature 8 in a Period of Day", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B0E */
+    { "Temperature 8 Statistics", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B0F */
+    { "Temperature Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B10 */
+    { "Temperature Statistics", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B11 */
+    { "Time Decihour 8", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B12 */
+    { "Time Exponential 8", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B13 */
+    { "Time Hour 24", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B14 */
+    { "Time Millisecond 24", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B15 */
+    { "Time Second 16", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B16 */
+    { "Time Second 8", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B17 */
+    { "Voltage", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B18 */
+    { "Voltage Specification", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B19 */
+    { "Voltage Statistics", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B1A */
+    { "Volume Flow", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B1B */
+    { "Chromaticity Coordinate", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B1C */
+    { "RC Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B1D */
+    { "RC Settings", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B1E */
+    { "Reconnection Configuration Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B1F */
+    { "IDD Status Changed", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B20 */
+    { "IDD Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B21 */
+    { "IDD Annunciation Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B22 */
+    { "IDD Features", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B23 */
+    { "IDD Status Reader Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B24 */
+    { "IDD Command Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B25 */
+    { "IDD Command Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B26 */
+    { "IDD Record Access Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B27 */
+    { "IDD History Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B28 */
+    { "Client Supported Features", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B29 */
+    { "Database Hash", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B2A */
+    { "BSS Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B2B */
+    { "BSS Response", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B2C */
+    { "Emergency ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B2D */
+    { "Emergency Text", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B2E */
+    { "ACS Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B2F */
+    { "ACS Data In", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B30 */
+    { "ACS Data Out Notify", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B31 */
+    { "ACS Data Out Indicate", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B32 */
+    { "ACS Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B33 */
+    { "Enhanced Blood Pressure Measurement", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B34 */
+    { "Enhanced Intermediate Cuff Pressure", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B35 */
+    { "Blood Pressure Record", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B36 */
+    { "Registered User", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B37 */
+    { "BR-EDR Handover Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B38 */
+    { "Bluetooth SIG Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B39 */
+    { "Server Supported Features", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B3A */
+    { "Physical Activity Monitor Features", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B3B */
+    { "General Activity Instantaneous Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B3C */
+    { "General Activity Summary Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B3D */
+    { "CardioRespiratory Activity Instantaneous Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B3E */
+    { "CardioRespiratory Activity Summary Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B3F */
+    { "Step Counter Activity Summary Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B40 */
+    { "Sleep Activity Instantaneous Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B41 */
+    { "Sleep Activity Summary Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B42 */
+    { "Physical Activity Monitor Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B43 */
+    { "Physical Activity Current Session", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B44 */
+    { "Physical Activity Session Descriptor", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B45 */
+    { "Preferred Units", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B46 */
+    { "High Resolution Height", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B47 */
+    { "Middle Name", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B48 */
+    { "Stride Length", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B49 */
+    { "Handedness", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B4A */
+    { "Device Wearing Position", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B4B */
+    { "Four Zone Heart Rate Limits", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B4C */
+    { "High Intensity Exercise Threshold", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B4D */
+    { "Activity Goal", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B4E */
+    { "Sedentary Interval Notification", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B4F */
+    { "Caloric Intake", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B50 */
+    { "TMAP Role", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B51 */
+    { "Audio Input State", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B77 */
+    { "Gain Settings Attribute", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B78 */
+    { "Audio Input Type", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B79 */
+    { "Audio Input Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B7A */
+    { "Audio Input Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B7B */
+    { "Audio Input Description", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B7C */
+    { "Volume State", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B7D */
+    { "Volume Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B7E */
+    { "Volume Flags", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B7F */
+    { "Volume Offset State", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B80 */
+    { "Audio Location", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B81 */
+    { "Volume Offset Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B82 */
+    { "Audio Output Description", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B83 */
+    { "Set Identity Resolving Key", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B84 */
+    { "Coordinated Set Size", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B85 */
+    { "Set Member Lock", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B86 */
+    { "Set Member Rank", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B87 */
+    { "Encrypted Data Key Material", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B88 */
+    { "Apparent Energy 32", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B89 */
+    { "Apparent Power", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B8A */
+    { "Live Health Observations", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B8B */
+    { "CO2 Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B8C */
+    { "Cosine of the Angle", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B8D */
+    { "Device Time Feature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B8E */
+    { "Device Time Parameters", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B8F */
+    { "Device Time", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B90 */
+    { "Device Time Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B91 */
+    { "Time Change Log Data", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B92 */
+    { "Media Player Name", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B93 */
+    { "Media Player Icon Object ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B94 */
+    { "Media Player Icon URL", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B95 */
+    { "Track Changed", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B96 */
+    { "Track Title", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B97 */
+    { "Track Duration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B98 */
+    { "Track Position", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B99 */
+    { "Playback Speed", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B9A */
+    { "Seeking Speed", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B9B */
+    { "Current Track Segments Object ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B9C */
+    { "Current Track Object ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B9D */
+    { "Next Track Object ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B9E */
+    { "Parent Group Object ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2B9F */
+    { "Current Group Object ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BA0 */
+    { "Playing Order", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BA1 */
+    { "Playing Orders Supported", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BA2 */
+    { "Media State", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BA3 */
+    { "Media Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BA4 */
+    { "Media Control Point Opcodes Supported", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BA5 */
+    { "Search Results Object ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BA6 */
+    { "Search Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BA7 */
+    { "Energy 32", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BA8 */
+    { "Media Player Icon Object Type", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BA9 */
+    { "Track Segments Object Type", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BAA */
+    { "Track Object Type", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BAB */
+    { "Group Object Type", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BAC */
+    { "Constant Tone Extension Enable", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BAD */
+    { "Advertising Constant Tone Extension Minimum Length", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BAE */
+    { "Advertising Constant Tone Extension Minimum Transmit Count", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BAF */
+    { "Advertising Constant Tone Extension Transmit Duration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BB0 */
+    { "Advertising Constant Tone Extension Interval", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BB1 */
+    { "Advertising Constant Tone Extension PHY", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BB2 */
+    { "Bearer Provider Name", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BB3 */
+    { "Bearer UCI", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BB4 */
+    { "Bearer Technology", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BB5 */
+    { "Bearer URI Schemes Supported List", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BB6 */
+    { "Bearer Signal Strength", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BB7 */
+    { "Bearer Signal Strength Reporting Interval", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BB8 */
+    { "Bearer List Current Calls", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BB9 */
+    { "Content Control ID", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BBA */
+    { "Status Flags", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BBB */
+    { "Incoming Call Target Bearer URI", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BBC */
+    { "Call State", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BBD */
+    { "Call Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BBE */
+    { "Call Control Point Optional Opcodes", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BBF */
+    { "Termination Reason", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BC0 */
+    { "Incoming Call", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BC1 */
+    { "Call Friendly Name", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BC2 */
+    { "Mute", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BC3 */
+    { "Sink ASE", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BC4 */
+    { "Source ASE", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BC5 */
+    { "ASE Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BC6 */
+    { "Broadcast Audio Scan Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BC7 */
+    { "Broadcast Receive State", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BC8 */
+    { "Sink PAC", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BC9 */
+    { "Sink Audio Locations", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BCA */
+    { "Source PAC", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BCB */
+    { "Source Audio Locations", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BCC */
+    { "Available Audio Contexts", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BCD */
+    { "Supported Audio Contexts", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BCE */
+    { "Ammonia Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BCF */
+    { "Carbon Monoxide Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BD0 */
+    { "Methane Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BD1 */
+    { "Nitrogen Dioxide Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BD2 */
+    { "Non-Methane Volatile Organic Compounds Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BD3 */
+    { "Ozone Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BD4 */
+    { "Particulate Matter - PM1 Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BD5 */
+    { "Particulate Matter - PM2.5 Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BD6 */
+    { "Particulate Matter - PM10 Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BD7 */
+    { "Sulfur Dioxide Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BD8 */
+    { "Sulfur Hexafluoride Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BD9 */
+    { "Hearing Aid Features", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BDA */
+    { "Hearing Aid Preset Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BDB */
+    { "Active Preset Index", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BDC */
+    { "Stored Health Observations", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BDD */
+    { "Fixed String 64", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BDE */
+    { "High Temperature", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BDF */
+    { "High Voltage", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BE0 */
+    { "Light Distribution", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BE1 */
+    { "Light Output", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BE2 */
+    { "Light Source Type", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BE3 */
+    { "Noise", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BE4 */
+    { "Relative Runtime in a Correlated Color Temperature Range", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BE5 */
+    { "Time Second 32", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BE6 */
+    { "VOC Concentration", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BE7 */
+    { "Voltage Frequency", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BE8 */
+    { "Battery Critical Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BE9 */
+    { "Battery Health Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BEA */
+    { "Battery Health Information", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BEB */
+    { "Battery Information", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BEC */
+    { "Battery Level Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BED */
+    { "Battery Time Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BEE */
+    { "Estimated Service Date", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BEF */
+    { "Battery Energy Status", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BF0 */
+    { "Observation Schedule Changed", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BF1 */
+    { "Current Elapsed Time", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BF2 */
+    { "Health Sensor Features", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BF3 */
+    { "GHS Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BF4 */
+    { "LE GATT Security Levels", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BF5 */
+    { "ESL Address", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BF6 */
+    { "AP Sync Key Material", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BF7 */
+    { "ESL Response Key Material", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BF8 */
+    { "ESL Current Absolute Time", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BF9 */
+    { "ESL Display Information", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BFA */
+    { "ESL Image Information", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BFB */
+    { "ESL Sensor Information", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BFC */
+    { "ESL LED Information", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BFD */
+    { "ESL Control Point", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BFE */
+    { "UDI for Medical Devices", BLE_UUID_KIND_CHARACTERISTIC },  /* 0x2BFF */
+};
+
+static const uint16_t sig_page_18[256] = {
+    [0x00] = 1,
+    [0x01] = 2,
+    [0x02] = 3,
+    [0x03] = 4,
+    [0x04] = 5,
+    [0x05] = 6,
+    [0x06] = 7,
+    [0x07] = 8,
+    [0x08] = 9,
+    [0x09] = 10,
+    [0x0A] = 11,
+    [0x0D] = 12,
+    [0x0E] = 13,
+    [0x0F] = 14,
+    [0x10] = 15,
+    [0x11] = 16,
+    [0x12] = 17,
+    [0x13] = 18,
+    [0x14] = 19,
+    [0x15] = 20,
+    [0x16] = 21,
+    [0x18] = 22,
+    [0x19] = 23,
+    [0x1A] = 24,
+    [0x1B] = 25,
+    [0x1C] = 26,
+    [0x1D] = 27,
+    [0x1E] = 28,
+    [0x1F] = 29,
+    [0x20] = 30,
+    [0x21] = 31,
+    [0x22] = 32,
+    [0x23] = 33,
+    [0x24] = 34,
+    [0x25] = 35,
+    [0x26] = 36,
+    [0x27] = 37,
+    [0x28] = 38,
+    [0x29] = 39,
+    [0x3A] = 40,
+    [0x3B] = 41,
+    [0x3C] = 42,
+    [0x3D] = 43,
+    [0x3E] = 44,
+    [0x3F] = 45,
+    [0x40] = 46,
+    [0x43] = 47,
+    [0x44] = 48,
+    [0x45] = 49,
+    [0x46] = 50,
+    [0x47] = 51,
+    [0x48] = 52,
+    [0x49] = 53,
+    [0x4A] = 54,
+    [0x4B] = 55,
+    [0x4C] = 56,
+    [0x4D] = 57,
+    [0x4E] = 58,
+    [0x4F] = 59,
+    [0x50] = 60,
+    [0x51] = 61,
+    [0x52] = 62,
+    [0x53] = 63,
+    [0x54] = 64,
+    [0x55] = 65,
+    [0x56] = 66,
+    [0x57] = 67,
+    [0x58] = 68,
+    [0x59] = 69,
+    [0x5A] = 70,
+    [0x5B] = 71,
+};
+
+static const uint16_t sig_page_28[256] = {
+    [0x00] = 72,
+    [0x01] = 73,
+    [0x02] = 74,
+    [0x03] = 75,
+};
+
+static const uint16_t sig_page_29[256] = {
+    [0x00] = 76,
+    [0x01] = 77,
+    [0x02] = 78,
+    [0x03] = 79,
+    [0x04] = 80,
+    [0x05] = 81,
+    [0x06] = 82,
+    [0x07] = 83,
+    [0x08] = 84,
+    [0x09] = 85,
+    [0x0A] = 86,
+    [0x0B] = 87,
+    [0x0C] = 88,
+    [0x0D] = 89,
+    [0x0E] = 90,
+    [0x0F] = 91,
+    [0x10] = 92,
+    [0x11] = 93,
+    [0x12] = 94,
+    [0x13] = 95,
+    [0x14] = 96,
+    [0x15] = 97,
+};
+
+static const uint16_t sig_page_2a[256] = {
+    [0x00] = 98,
+    [0x01] = 99,
+    [0x02] = 100,
+    [0x03] = 101,
+    [0x04] = 102,
+    [0x05] = 103,
+    [0x06] = 104,
+    [0x07] = 105,
+    [0x08] = 106,
+    [0x09] = 107,
+    [0x0A] = 108,
+    [0x0C] = 109,
+    [0x0D] = 110,
+    [0x0E] = 111,
+    [0x0F] = 112,
+    [0x11] = 113,
+    [0x12] = 114,
+    [0x13] = 115,
+    [0x14] = 116,
+    [0x16] = 117,
+    [0x17] = 118,
+    [0x18] = 119,
+    [0x19] = 120,
+    [0x1C] = 121,
+    [0x1D] = 122,
+    [0x1E] = 123,
+    [0x21] = 124,
+    [0x22] = 125,
+    [0x23] = 126,
+    [0x24] = 127,
+    [0x25] = 128,
+    [0x26] = 129,
+    [0x27] = 130,
+    [0x28] = 131,
+    [0x29] = 132,
+    [0x2A] = 133,
+    [0x2B] = 134,
+    [0x2C] = 135,
+    [0x31] = 136,
+    [0x32] = 137,
+    [0x33] = 138,
+    [0x34] = 139,
+    [0x35] = 140,
+    [0x36] = 141,
+    [0x37] = 142,
+    [0x38] = 143,
+    [0x39] = 144,
+    [0x3F] = 145,
+    [0x40] = 146,
+    [0x41] = 147,
+    [0x42] = 148,
+    [0x43] = 149,
+    [0x44] = 150,
+    [0x45] = 151,
+    [0x46] = 152,
+    [0x47] = 153,
+    [0x48] = 154,
+    [0x49] = 155,
+    [0x4A] = 156,
+    [0x4B] = 157,
+    [0x4C] = 158,
+    [0x4D] = 159,
+    [0x4E] = 160,
+    [0x4F] = 161,
+    [0x50] = 162,
+    [0x51] = 163,
+    [0x52] = 164,
+    [0x53] = 165,
+    [0x54] = 166,
+    [0x55] = 167,
+    [0x5A] = 168,
+    [0x5B] = 169,
+    [0x5C] = 170,
+    [0x5D] = 171,
+    [0x5E] = 172,
+    [0x5F] = 173,
+    [0x60] = 174,
+    [0x63] = 175,
+    [0x64] = 176,
+    [0x65] = 177,
+    [0x66] = 178,
+    [0x67] = 179,
+    [0x68] = 180,
+    [0x69] = 181,
+    [0x6A] = 182,
+    [0x6B] = 183,
+    [0x6C] = 184,
+    [0x6D] = 185,
+    [0x6E] = 186,
+    [0x6F] = 187,
+    [0x70] = 188,
+    [0x71] = 189,
+    [0x72] = 190,
+    [0x73] = 191,
+    [0x74] = 192,
+    [0x75] = 193,
+    [0x76] = 194,
+    [0x77] = 195,
+    [0x78] = 196,
+    [0x79] = 197,
+    [0x7A] = 198,
+    [0x7B] = 199,
+    [0x7D] = 200,
+    [0x7E] = 201,
+    [0x7F] = 202,
+    [0x80] = 203,
+    [0x81] = 204,
+    [0x82] = 205,
+    [0x83] = 206,
+    [0x84] = 207,
+    [0x85] = 208,
+    [0x86] = 209,
+    [0x87] = 210,
+    [0x88] = 211,
+    [0x89] = 212,
+    [0x8A] = 213,
+    [0x8B] = 214,
+    [0x8C] = 215,
+    [0x8D] = 216,
+    [0x8E] = 217,
+    [0x8F] = 218,
+    [0x90] = 219,
+    [0x91] = 220,
+    [0x92] = 221,
+    [0x93] = 222,
+    [0x94] = 223,
+    [0x95] = 224,
+    [0x96] = 225,
+    [0x97] = 226,
+    [0x98] = 227,
+    [0x99] = 228,
+    [0x9A] = 229,
+    [0x9B] = 230,
+    [0x9C] = 231,
+    [0x9D] = 232,
+    [0x9E] = 233,
+    [0x9F] = 234,
+    [0xA0] = 235,
+    [0xA1] = 236,
+    [0xA2] = 237,
+    [0xA3] = 238,
+    [0xA4] = 239,
+    [0xA5] = 240,
+    [0xA6] = 241,
+    [0xA7] = 242,
+    [0xA8] = 243,
+    [0xA9] = 244,
+    [0xAA] = 245,
+    [0xAB] = 246,
+    [0xAC] = 247,
+    [0xAD] = 248,
+    [0xAE] = 249,
+    [0xAF] = 250,
+    [0xB0] = 251,
+    [0xB1] = 252,
+    [0xB2] = 253,
+    [0xB3] = 254,
+    [0xB4] = 255,
+    [0xB5] = 256,
+    [0xB6] = 257,
+    [0xB7] = 258,
+    [0xB8] = 259,
+    [0xB9] = 260,
+    [0xBA] = 261,
+    [0xBB] = 262,
+    [0xBC] = 263,
+    [0xBD] = 264,
+    [0xBE] = 265,
+    [0xBF] = 266,
+    [0xC0] = 267,
+    [0xC1] = 268,
+    [0xC2] = 269,
+    [0xC3] = 270,
+    [0xC4] = 271,
+    [0xC5] = 272,
+    [0xC6] = 273,
+    [0xC7] = 274,
+    [0xC8] = 275,
+    [0xC9] = 276,
+    [0xCC] = 277,
+    [0xCD] = 278,
+    [0xCE] = 279,
+    [0xCF] = 280,
+    [0xD0] = 281,
+    [0xD1] = 282,
+    [0xD2] = 283,
+    [0xD3] = 284,
+    [0xD4] = 285,
+    [0xD5] = 286,
+    [0xD6] = 287,
+    [0xD7] = 288,
+    [0xD8] = 289,
+    [0xD9] = 290,
+    [0xDA] = 291,
+    [0xDB] = 292,
+    [0xDC] = 293,
+    [0xDD] = 294,
+    [0xDE] = 295,
+    [0xE0] = 296,
+    [0xE1] = 297,
+    [0xE2] = 298,
+    [0xE3] = 299,
+    [0xE4] = 300,
+    [0xE5] = 301,
+    [0xE6] = 302,
+    [0xE7] = 303,
+    [0xE8] = 304,
+    [0xE9] = 305,
+    [0xEA] = 306,
+    [0xEB] = 307,
+    [0xEC] = 308,
+    [0xED] = 309,
+    [0xEE] = 310,
+    [0xEF] = 311,
+    [0xF0] = 312,
+    [0xF1] = 313,
+    [0xF2] = 314,
+    [0xF3] = 315,
+    [0xF4] = 316,
+    [0xF5] = 317,
+    [0xF6] = 318,
+    [0xF7] = 319,
+    [0xF8] = 320,
+    [0xF9] = 321,
+    [0xFA] = 322,
+    [0xFB] = 323,
+    [0xFC] = 324,
+    [0xFD] = 325,
+    [0xFE] = 326,
+    [0xFF] = 327,
+};
+
+static const uint16_t sig_page_2b[256] = {
+    [0x00] = 328,
+    [0x01] = 329,
+    [0x02] = 330,
+    [0x03] = 331,
+    [0x04] = 332,
+    [0x05] = 333,
+    [0x06] = 334,
+    [0x07] = 335,
+    [0x08] = 336,
+    [0x09] = 337,
+    [0x0A] = 338,
+    [0x0B] = 339,
+    [0x0C] = 340,
+    [0x0D] = 341,
+    [0x0E] = 342,
+    [0x0F] = 343,
+    [0x10] = 344,
+    [0x11] = 345,
+    [0x12] = 346,
+    [0x13] = 347,
+    [0x14] = 348,
+    [0x15] = 349,
+    [0x16] = 350,
+    [0x17] = 351,
+    [0x18] = 352,
+    [0x19] = 353,
+    [0x1A] = 354,
+    [0x1B] = 355,
+    [0x1C] = 356,
+    [0x1D] = 357,
+    [0x1E] = 358,
+    [0x1F] = 359,
+    [0x20] = 360,
+    [0x21] = 361,
+    [0x22] = 362,
+    [0x23] = 363,
+    [0x24] = 364,
+    [0x25] = 365,
+    [0x26] = 366,
+    [0x27] = 367,
+    [0x28] = 368,
+    [0x29] = 369,
+    [0x2A] = 370,
+    [0x2B] = 371,
+    [0x2C] = 372,
+    [0x2D] = 373,
+    [0x2E] = 374,
+    [0x2F] = 375,
+    [0x30] = 376,
+    [0x31] = 377,
+    [0x32] = 378,
+    [0x33] = 379,
+    [0x34] = 380,
+    [0x35] = 381,
+    [0x36] = 382,
+    [0x37] = 383,
+    [0x38] = 384,
+    [0x39] = 385,
+    [0x3A] = 386,
+    [0x3B] = 387,
+    [0x3C] = 388,
+    [0x3D] = 389,
+    [0x3E] = 390,
+    [0x3F] = 391,
+    [0x40] = 392,
+    [0x41] = 393,
+    [0x42] = 394,
+    [0x43] = 395,
+    [0x44] = 396,
+    [0x45] = 397,
+    [0x46] = 398,
+    [0x47] = 399,
+    [0x48] = 400,
+    [0x49] = 401,
+    [0x4A] = 402,
+    [0x4B] = 403,
+    [0x4C] = 404,
+    [0x4D] = 405,
+    [0x4E] = 406,
+    [0x4F] = 407,
+    [0x50] = 408,
+    [0x51] = 409,
+    [0x77] = 410,
+    [0x78] = 411,
+    [0x79] = 412,
+    [0x7A] = 413,
+    [0x7B] = 414,
+    [0x7C] = 415,
+    [0x7D] = 416,
+    [0x7E] = 417,
+    [0x7F] = 418,
+    [0x80] = 419,
+    [0x81] = 420,
+    [0x82] = 421,
+    [0x83] = 422,
+    [0x84] = 423,
+    [0x85] = 424,
+    [0x86] = 425,
+    [0x87] = 426,
+    [0x88] = 427,
+    [0x89] = 428,
+    [0x8A] = 429,
+    [0x8B] = 430,
+    [0x8C] = 431,
+    [0x8D] = 432,
+    [0x8E] = 433,
+    [0x8F] = 434,
+    [0x90] = 435,
+    [0x91] = 436,
+    [0x92] = 437,
+    [0x93] = 438,
+    [0x94] = 439,
+    [0x95] = 440,
+    [0x96] = 441,
+    [0x97] = 442,
+    [0x98] = 443,
+    [0x99] = 444,
+    [0x9A] = 445,
+    [0x9B] = 446,
+    [0x9C] = 447,
+    [0x9D] = 448,
+    [0x9E] = 449,
+    [0x9F] = 450,
+    [0xA0] = 451,
+    [0xA1] = 452,
+    [0xA2] = 453,
+    [0xA3] = 454,
+    [0xA4] = 455,
+    [0xA5] = 456,
+    [0xA6] = 457,
+    [0xA7] = 458,
+    [0xA8] = 459,
+    [0xA9] = 460,
+    [0xAA] = 461,
+    [0xAB] = 462,
+    [0xAC] = 463,
+    [0xAD] = 464,
+    [0xAE] = 465,
+    [0xAF] = 466,
+    [0xB0] = 467,
+    [0xB1] = 468,
+    [0xB2] = 469,
+    [0xB3] = 470,
+    [0xB4] = 471,
+    [0xB5] = 472,
+    [0xB6] = 473,
+    [0xB7] = 474,
+    [0xB8] = 475,
+    [0xB9] = 476,
+    [0xBA] = 477,
+    [0xBB] = 478,
+    [0xBC] = 479,
+    [0xBD] = 480,
+    [0xBE] = 481,
+    [0xBF] = 482,
+    [0xC0] = 483,
+    [0xC1] = 484,
+    [0xC2] = 485,
+    [0xC3] = 486,
+    [0xC4] = 487,
+    [0xC5] = 488,
+    [0xC6] = 489,
+    [0xC7] = 490,
+    [0xC8] = 491,
+    [0xC9] = 492,
+    [0xCA] = 493,
+    [0xCB] = 494,
+    [0xCC] = 495,
+    [0xCD] = 496,
+    [0xCE] = 497,
+    [0xCF] = 498,
+    [0xD0] = 499,
+    [0xD1] = 500,
+    [0xD2] = 501,
+    [0xD3] = 502,
+    [0xD4] = 503,
+    [0xD5] = 504,
+    [0xD6] = 505,
+    [0xD7] = 506,
+    [0xD8] = 507,
+    [0xD9] = 508,
+    [0xDA] = 509,
+    [0xDB] = 510,
+    [0xDC] = 511,
+    [0xDD] = 512,
+    [0xDE] = 513,
+    [0xDF] = 514,
+    [0xE0] = 515,
+    [0xE1] = 516,
+    [0xE2] = 517,
+    [0xE3] = 518,
+    [0xE4] = 519,
+    [0xE5] = 520,
+    [0xE6] = 521,
+    [0xE7] = 522,
+    [0xE8] = 523,
+    [0xE9] = 524,
+    [0xEA] = 525,
+    [0xEB] = 526,
+    [0xEC] = 527,
+    [0xED] = 528,
+    [0xEE] = 529,
+    [0xEF] = 530,
+    [0xF0] = 531,
+    [0xF1] = 532,
+    [0xF2] = 533,
+    [0xF3] = 534,
+    [0xF4] = 535,
+    [0xF5] = 536,
+    [0xF6] = 537,
+    [0xF7] = 538,
+    [0xF8] = 539,
+    [0xF9] = 540,
+    [0xFA] = 541,
+    [0xFB] = 542,
+    [0xFC] = 543,
+    [0xFD] = 544,
+    [0xFE] = 545,
+    [0xFF] = 546,
+};
+
+/* High byte of the 16-bit value -> page of 1-based sig_info indices */
+static const uint16_t *const sig_pages[256] = {
+    [0x18] = sig_page_18,
+    [0x28] = sig_page_28,
+    [0x29] = sig_page_29,
+    [0x2A] = sig_page_2a,
+    [0x2B] = sig_page_2b,
+};
+
+typedef struct {
+    ble_uuid_t uuid;
+    ble_uuid_info_t info;
+} vendor_entry_t;
+
+/* Sorted by (hi, lo) */
+static const vendor_entry_t vendor_info[6] = {
+    { { 0x6E400001B5A3F393ULL, 0xE0A9E50E24DCCA9EULL }, { "Nordic UART", BLE_UUID_KIND_SERVICE } },
+    { { 0x6E400002B5A3F393ULL, 0xE0A9E50E24DCCA9EULL }, { "Nordic UART RX", BLE_UUID_KIND_CHARACTERISTIC } },
+    { { 0x6E400003B5A3F393ULL, 0xE0A9E50E24DCCA9EULL }, { "Nordic UART TX", BLE_UUID_KIND_CHARACTERISTIC } },
+    { { 0x8EC90001F3154F60ULL, 0x9FB8838830DAEA50ULL }, { "Nordic Secure DFU Control Point", BLE_UUID_KIND_CHARACTERISTIC } },
+    { { 0x8EC90002F3154F60ULL, 0x9FB8838830DAEA50ULL }, { "Nordic Secure DFU Packet", BLE_UUID_KIND_CHARACTERISTIC } },
+    { { 0x8EC90003F3154F60ULL, 0x9FB8838830DAEA50ULL }, { "Nordic Buttonless DFU", BLE_UUID_KIND_CHARACTERISTIC } },
+};
+
+const ble_uuid_info_t *ble_uuid_lookup(const ble_uuid_t *uuid) {
+    if (ble_uuid_is_sig(uuid)) {
+        uint32_t value = ble_uuid_sig_value(uuid);
+        if (value > 0xFFFF) return NULL;
+        const uint16_t *page = sig_pages[value >> 8];
+        uint16_t idx = page ? page[value & 0xFF] : 0;
+        return idx ? &sig_info[idx - 1] : NULL;
+    }
+
+    size_t lo = 0, hi = sizeof(vendor_info) / sizeof(vendor_info[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int c = ble_uuid_cmp(uuid, &vendor_info[mid].uuid);
+        if (c == 0) return &vendor_info[mid].info;
+        if (c < 0) hi = mid; else lo = mid + 1;
+    }
+    return NULL;
+}
@@ -0,0 +1,453 @@
+#include "ble_value_store.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace ble {
+
+namespace {
+
+constexpr size_t kWords = BLE_GATT_MAX_VALUE_LEN / sizeof(uint64_t);
+
+// Retries before a reader yields to a writer that may have been preempted
+constexpr unsigned kSpins = 64;
+
+// ATT_MTU when BlueZ does not pass "mtu"
+constexpr uint16_t kDefaultMtu = 23;
+
+/// ReadValue/WriteValue options as bluetoothd sends them; strings are borrowed.
+struct RequestOptions {
+    guint16 offset = 0;
+    guint16 mtu = 0;
+    const gchar* device = "";
+    const gchar* type = "";
+    gboolean prepare_authorize = FALSE;
+};
+
+RequestOptions parse_options(GVariant* options) {
+    RequestOptions opts;
+    g_variant_lookup(options, "offset", "q", &opts.offset);
+    g_variant_lookup(options, "mtu", "q", &opts.mtu);
+    g_variant_lookup(options, "device", "&o", &opts.device);
+    g_variant_lookup(options, "type", "&s", &opts.type);
+    g_variant_lookup(options, "prepare-authorize", "b", &opts.prepare_authorize);
+    return opts;
+}
+
+// Value bytes that fit in one Read / Read Blob response
+size_t response_size(guint16 mtu) {
+    return (mtu ? mtu : kDefaultMtu) - 1;
+}
+
+void reply_status(GDBusMethodInvocation* invocation, WriteStatus status) {
+    if (status == WriteStatus::Ok) {
+        g_dbus_method_invocation_return_value(invocation, NULL);
+    } else {
+        g_dbus_method_invocation_return_dbus_error(invocation, write_status_error(status),
+                                                   status == WriteStatus::InvalidOffset
+                                                       ? "Offset past the end of the value"
+                                                       : "Value exceeds 512 bytes");
+    }
+}
+
+}  // namespace
+
+const char* write_status_error(WriteStatus status) {
+    switch (status) {
+    case WriteStatus::Ok: return nullptr;
+    case WriteStatus::InvalidOffset: return "org.bluez.Error.InvalidOffset";
+    case WriteStatus::InvalidLength: return "org.bluez.Error.InvalidValueLength";
+    }
+    return "org.bluez.Error.Failed";
+}
+
+// =============================================================================
+// PreparedWrite
+// =============================================================================
+
+WriteStatus PreparedWrite::stage(size_t offset, const void* data, size_t len, size_t value_len) {
+    if (!fragments_.empty()) value_len = fragments_.back().offset + fragments_.back().len;
+    if (offset > value_len) return WriteStatus::InvalidOffset;
+    if (offset + len > BLE_GATT_MAX_VALUE_LEN) return WriteStatus::InvalidLength;
+    fragments_.push_back(Fragment{offset, bytes_.size(), len});
+    bytes_.insert(bytes_.end(), (const uint8_t*)data, (const uint8_t*)data + len);
+    return WriteStatus::Ok;
+}
+
+void PreparedWrite::clear() {
+    fragments_.clear();
+    bytes_.clear();
+}
+
+// =============================================================================
+// ValueStore
+// =============================================================================
+
+struct ValueStore::Slot {
+    std::atomic<uint64_t> seq{0};           ///< Odd while a writer is storing
+    std::atomic<uint32_t> len{0};
+    std::atomic<uint64_t> words[kWords] = {};
+    std::mutex writer;
+};
+
+ValueStore::ValueStore(size_t capacity) : capacity_(capacity), slots_(new Slot[capacity]) {}
+
+ValueStore::~ValueStore() = default;
+
+bool ValueStore::add(const void* data, size_t len, Id* id) {
+    if (len > BLE_GATT_MAX_VALUE_LEN) return false;
+    std::lock_guard<std::mutex> lock(add_mutex_);
+    size_t n = size_.load(std::memory_order_relaxed);
+    if (n == capacity_) return false;
+    {
+        std::lock_guard<std::mutex> writer(slots_[n].writer);
+        publish(slots_[n], (const uint8_t*)data, len);
+    }
+    size_.store(n + 1, std::memory_order_release);
+    *id = (Id)n;
+    return true;
+}
+
+void ValueStore::publish(Slot& slot, const uint8_t* data, size_t len) {
+    uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t words = (len + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    for (size_t i = 0; i < words; i++) {
+        uint64_t word = 0;
+        size_t n = std::min(sizeof(word), len - i * sizeof(word));
+        memcpy(&word, data + i * sizeof(word), n);
+        slot.words[i].store(word, std::memory_order_relaxed);
+    }
+    slot.len.store((uint32_t)len, std::memory_order_relaxed);
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+// With the writer lock held nothing changes underneath
+void ValueStore::load_locked(const Slot& slot, uint8_t* data, size_t* len) const {
+    *len = slot.len.load(std::memory_order_relaxed);
+    size_t words = (*len + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    for (size_t i = 0; i < words; i++) {
+        uint64_t word = slot.words[i].load(std::memory_order_relaxed);
+        memcpy(data + i * sizeof(word), &word, sizeof(word));
+    }
+}
+
+uint64_t ValueStore::set(Id id, const void* data, size_t len) {
+    if (id >= size() || len > BLE_GATT_MAX_VALUE_LEN) return 0;
+    Slot& slot = slots_[id];
+    std::lock_guard<std::mutex> lock(slot.writer);
+    publish(slot, (const uint8_t*)data, len);
+    return slot.seq.load(std::memory_order_relaxed) / 2;
+}
+
+WriteStatus ValueStore::write(Id id, size_t offset, const void* data, size_t len,
+                              uint64_t* version) {
+    if (id >= size()) return WriteStatus::InvalidLength;
+    Slot& slot = slots_[id];
+    std::lock_guard<std::mutex> lock(slot.writer);
+    uint8_t value[BLE_GATT_MAX_VALUE_LEN];
+    size_t value_len;
+    load_locked(slot, value, &value_len);
+    if (offset > value_len) return WriteStatus::InvalidOffset;
+    if (offset + len > BLE_GATT_MAX_VALUE_LEN) return WriteStatus::InvalidLength;
+
+    memcpy(value + offset, data, len);
+    publish(slot, value, offset + len);
+    if (version) *version = slot.seq.load(std::memory_order_relaxed) / 2;
+    return WriteStatus::Ok;
+}
+
+WriteStatus ValueStore::commit(Id id, const PreparedWrite& prepared, uint64_t* version) {
+    if (id >= size()) return WriteStatus::InvalidLength;
+    Slot& slot = slots_[id];
+    std::lock_guard<std::mutex> lock(slot.writer);
+    uint8_t value[BLE_GATT_MAX_VALUE_LEN];
+    size_t value_len;
+    load_locked(slot, value, &value_len);
+
+    // Fragment lengths were checked when staged; offsets depend on the ones before
+    for (const PreparedWrite::Fragment& f : prepared.fragments_) {
+        if (f.offset > value_len) return WriteStatus::InvalidOffset;
+        memcpy(value + f.offset, prepared.bytes_.data() + f.pos, f.len);
+        value_len = f.offset + f.len;
+    }
+    publish(slot, value, value_len);
+    if (version) *version = slot.seq.load(std::memory_order_relaxed) / 2;
+    return WriteStatus::Ok;
+}
+
+WriteStatus ValueStore::check(Id id, const PreparedWrite& prepared) const {
+    if (id >= size()) return WriteStatus::InvalidLength;
+    // Later fragments were checked against the ones before when staged
+    if (!prepared.empty() && prepared.fragments_.front().offset > length(id)) {
+        return WriteStatus::InvalidOffset;
+    }
+    return WriteStatus::Ok;
+}
+
+uint64_t ValueStore::read(Id id, ValueSnapshot* out) const {
+    if (id >= size()) {
+        out->len = 0;
+        out->version = 0;
+        return 0;
+    }
+    const Slot& slot = slots_[id];
+    for (unsigned attempt = 1;; attempt++) {
+        uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (!(seq & 1)) {
+            size_t len = slot.len.load(std::memory_order_relaxed);
+            size_t words = (len + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+            for (size_t i = 0; i < words; i++) {
+                uint64_t word = slot.words[i].load(std::memory_order_relaxed);
+                memcpy(out->data + i * sizeof(word), &word, sizeof(word));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq) {
+                out->len = len;
+                out->version = seq / 2;
+                return out->version;
+            }
+        }
+        if (attempt % kSpins == 0) std::this_thread::yield();
+    }
+}
+
+GBytes* ValueStore::read_bytes(Id id, size_t offset, uint64_t* version) const {
+    ValueSnapshot snapshot;
+    read(id, &snapshot);
+    if (version) *version = snapshot.version;
+    if (offset > snapshot.len) offset = snapshot.len;
+    return g_bytes_new(snapshot.data + offset, snapshot.len - offset);
+}
+
+uint64_t ValueStore::version(Id id) const {
+    if (id >= size()) return 0;
+    return slots_[id].seq.load(std::memory_order_acquire) / 2;
+}
+
+size_t ValueStore::length(Id id) const {
+    if (id >= size()) return 0;
+    return slots_[id].len.load(std::memory_order_acquire);
+}
+
+// =============================================================================
+// ValueRequests
+// =============================================================================
+
+struct ValueRequests::Timer {
+    ValueRequests* requests;
+    std::string device;
+};
+
+namespace {
+
+void cancel_timer(GSource** timer) {
+    if (!*timer) return;
+    g_source_destroy(*timer);
+    g_source_unref(*timer);
+    *timer = nullptr;
+}
+
+}  // namespace
+
+ValueRequests::ValueRequests(ValueStore& store, GMainContext* context, unsigned commit_delay_ms,
+                             unsigned pin_timeout_ms)
+    : store_(store),
+      context_(context ? g_main_context_ref(context) : g_main_context_ref_thread_default()),
+      commit_delay_ms_(commit_delay_ms),
+      pin_timeout_ms_(pin_timeout_ms) {}
+
+ValueRequests::~ValueRequests() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& kv : sessions_) {
+        // Fragments were already acknowledged to the client
+        commit_locked(kv.second);
+        drop_pins_locked(kv.second);
+    }
+    sessions_.clear();
+    g_main_context_unref(context_);
+}
+
+void ValueRequests::read(ValueStore::Id id, GVariant* parameters,
+                         GDBusMethodInvocation* invocation) {
+    GVariant* options = g_variant_get_child_value(parameters, 0);
+    RequestOptions opts = parse_options(options);
+    size_t chunk = response_size(opts.mtu);
+    GBytes* value = store_.read_bytes(id);
+
+    // Short values read at offset 0 by devices without pending state skip the lock
+    if (opts.offset > 0 || g_bytes_get_size(value) > chunk ||
+        sessions_active_.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sessions_.emplace(opts.device, Session()).first;
+        sessions_active_.store(sessions_.size(), std::memory_order_release);
+        Session& session = it->second;
+
+        // A device reads back its own reliable write
+        if (!session.staged.empty()) {
+            commit_locked(session);
+            g_bytes_unref(value);
+            value = store_.read_bytes(id);
+        }
+
+        auto pin = session.pinned.find(id);
+        if (opts.offset > 0 && pin != session.pinned.end()) {
+            g_bytes_unref(value);
+            value = g_bytes_ref(pin->second);
+        }
+        if (pin != session.pinned.end() && pin->second != value) {
+            g_bytes_unref(pin->second);
+            session.pinned.erase(pin);
+            pin = session.pinned.end();
+        }
+        // Pin until the Read Blob that returns the last slice
+        bool more = opts.offset + chunk < g_bytes_get_size(value);
+        if (more && pin == session.pinned.end()) {
+            session.pinned.emplace(id, g_bytes_ref(value));
+        } else if (!more && pin != session.pinned.end()) {
+            g_bytes_unref(pin->second);
+            session.pinned.erase(pin);
+        }
+        if (session.pinned.empty()) {
+            cancel_timer(&session.pin_timer);
+        } else {
+            arm_timer(it->first, &session.pin_timer, pin_timeout_ms_);
+        }
+        release_if_idle(it);
+    }
+
+    if (opts.offset > g_bytes_get_size(value)) {
+        g_dbus_method_invocation_return_dbus_error(invocation, "org.bluez.Error.InvalidOffset",
+                                                   "Offset past the end of the value");
+    } else {
+        g_dbus_method_invocation_return_value(invocation,
+                                              ble_gatt_value_reply_at(value, opts.offset));
+    }
+    g_bytes_unref(value);
+    g_variant_unref(options);
+}
+
+void ValueRequests::write(ValueStore::Id id, GVariant* parameters,
+                          GDBusMethodInvocation* invocation) {
+    GVariant* options;
+    GBytes* value = ble_gatt_value_from_write(parameters, &options);
+    RequestOptions opts = parse_options(options);
+    gsize len;
+    const void* data = g_bytes_get_data(value, &len);
+    WriteStatus status = WriteStatus::Ok;
+
+    if (opts.prepare_authorize) {
+        // BlueZ only asks whether it may queue the fragment; it comes back
+        // as a reliable write on Execute Write
+    } else if (strcmp(opts.type, "reliable") == 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sessions_.emplace(opts.device, Session()).first;
+        sessions_active_.store(sessions_.size(), std::memory_order_release);
+        Session& session = it->second;
+        if (session.failed != WriteStatus::Ok) {
+            // The rest of a failed Execute Write
+            status = session.failed;
+        } else {
+            auto staged = session.staged.begin();
+            while (staged != session.staged.end() && staged->first != id) ++staged;
+            if (staged == session.staged.end()) {
+                session.staged.emplace_back(id, PreparedWrite());
+                staged = session.staged.end() - 1;
+            }
+            status = staged->second.stage(opts.offset, data, len, store_.length(id));
+            if (status != WriteStatus::Ok) {
+                // All or nothing: none of this Execute Write may commit
+                session.staged.clear();
+                session.failed = status;
+            }
+        }
+        arm_timer(it->first, &session.commit_timer, commit_delay_ms_);
+    } else {
+        // Any other request ends the device's reliable write
+        if (sessions_active_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = sessions_.find(opts.device);
+            if (it != sessions_.end()) {
+                commit_locked(it->second);
+                release_if_idle(it);
+            }
+        }
+        status = store_.write(id, opts.offset, data, len);
+    }
+
+    reply_status(invocation, status);
+    g_bytes_unref(value);
+    g_variant_unref(options);
+}
+
+bool ValueRequests::commit(const std::string& device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(device);
+    if (it == sessions_.end()) return true;
+    bool ok = commit_locked(it->second);
+    release_if_idle(it);
+    return ok;
+}
+
+bool ValueRequests::commit_locked(Session& session) {
+    bool ok = session.failed == WriteStatus::Ok;
+    // All or nothing: every value is checked before any is published
+    for (auto& staged : session.staged) {
+        if (ok && store_.check(staged.first, staged.second) != WriteStatus::Ok) ok = false;
+    }
+    for (auto& staged : session.staged) {
+        if (ok && store_.commit(staged.first, staged.second) != WriteStatus::Ok) ok = false;
+    }
+    session.staged.clear();
+    session.failed = WriteStatus::Ok;
+    cancel_timer(&session.commit_timer);
+    return ok;
+}
+
+void ValueRequests::drop_pins_locked(Session& session) {
+    for (auto& pin : session.pinned) g_bytes_unref(pin.second);
+    session.pinned.clear();
+    cancel_timer(&session.pin_timer);
+}
+
+void ValueRequests::arm_timer(const std::string& device, GSource** timer, unsigned delay_ms) {
+    cancel_timer(timer);
+    *timer = g_timeout_source_new(delay_ms);
+    g_source_set_callback(*timer, on_timer, new Timer{this, device},
+                          [](gpointer data) { delete static_cast<Timer*>(data); });
+    g_source_attach(*timer, context_);
+}
+
+void ValueRequests::release_if_idle(std::map<std::string, Session>::iterator it) {
+    const Session& session = it->second;
+    if (session.pinned.empty() && session.staged.empty() && !session.commit_timer &&
+        !session.pin_timer) {
+        sessions_.erase(it);
+        sessions_active_.store(sessions_.size(), std::memory_order_release);
+    }
+}
+
+gboolean ValueRequests::on_timer(gpointer user_data) {
+    Timer* timer = static_cast<Timer*>(user_data);
+    ValueRequests* self = timer->requests;
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    auto it = self->sessions_.find(timer->device);
+    if (it == self->sessions_.end()) return G_SOURCE_REMOVE;
+
+    // A request that arrived meanwhile replaced the timer that fired
+    GSource* current = g_main_current_source();
+    if (it->second.commit_timer == current) {
+        self->commit_locked(it->second);
+    } else if (it->second.pin_timer == current) {
+        self->drop_pins_locked(it->second);
+    } else {
+        return G_SOURCE_REMOVE;
+    }
+    self->release_if_idle(it);
+    return G_SOURCE_REMOVE;
+}
+
+}  // namespace ble
@@ -3,7 +3,9 @@
  * @brief Simple BLE Peripheral (GATT Server) using BlueZ D-Bus API
  * 
  * Creates a GATT server with a custom service containing:
- * - A readable/writable characteristic
+ * - A readable/writable characteristic of up to 512 bytes, with long
+ *   reads and reliable (prepared) writes; write-without-response traffic
+ *   arrives over an AcquireWrite socket instead of D-Bus calls
  * 
  * Build:
  *   g++ -o simple_peripheral simple_peripheral.cpp \
@@ -11,6 +13,19 @@
  * 
  * Run:
  *   sudo ./simple_peripheral
+ *   ./simple_peripheral --bus ADDRESS    # e.g. against mock_bluez
+ *   ./simple_peripheral --metrics 127.0.0.1:9464
+ *   sudo ./simple_peripheral --adapters all [--max-links N]
+ *   ./simple_peripheral --workers 4 [--queue-depth N]
+ *
+ * --adapters (all, or hci0,hci1,...) serves the service and advertisement
+ * on each adapter from its own thread; new connections go to the adapters
+ * with the fewest links, and --max-links caps the links per adapter.
+ * --workers runs ReadValue/WriteValue handlers on a thread pool, in order
+ * per characteristic, so a slow one does not hold up other D-Bus traffic;
+ * with --queue-depth calls pending, further ones fail with InProgress.
+ * Handler latencies are served as org.example.Stats on /org/example/Stats
+ * and, with --metrics, as Prometheus text over HTTP.
  */
 
 #include <gio/gio.h>
@@ -18,28 +33,67 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include "ble_adapter_pool.hpp"
+#include "ble_dbus.h"
+#include "ble_dbus_schema.hpp"
+#include "ble_fd_channel.hpp"
+#include "ble_gatt_database.hpp"
+#include "ble_handler_pool.hpp"
+#include "ble_metrics.hpp"
+#include "ble_uuid.hpp"
+#include "ble_value_store.hpp"
 
-// Custom Service UUID
-#define SERVICE_UUID        "12345678-1234-5678-1234-56789abcdef0"
-#define CHARACTERISTIC_UUID "12345678-1234-5678-1234-56789abcdef1"
+using namespace ble::literals;
+
+// Custom Service UUID (validated at compile time)
+static constexpr ble_uuid_t SERVICE_UUID        = "12345678-1234-5678-1234-56789abcdef0"_uuid;
+static constexpr ble_uuid_t CHARACTERISTIC_UUID = "12345678-1234-5678-1234-56789abcdef1"_uuid;
+
+// String form for the advertisement, rendered at compile time
+static constexpr auto SERVICE_UUID_STR = ble::to_string(SERVICE_UUID);
+
+// LE advertisement interface; introspection and dispatch generated at compile time
+static constexpr ble::InterfaceSchema<1, 4> ADVERT_SCHEMA = {
+    "org.bluez.LEAdvertisement1",
+    {{{"Release"}}},
+    {{{"Type", "s"}, {"ServiceUUIDs", "as"}, {"LocalName", "s"}, {"Includes", "as"}}},
+};
+using Advert = ble::DBusInterface<ADVERT_SCHEMA>;
+using Char = ble::GattCharacteristicInterface;
 
 // D-Bus paths
 #define APP_PATH            "/org/bluez/example"
-#define SERVICE_PATH        "/org/bluez/example/service0"
-#define CHAR_PATH           "/org/bluez/example/service0/char0"
 #define ADVERT_PATH         "/org/bluez/example/advertisement0"
+#define STATS_PATH          "/org/example/Stats"
 
 // Global state
 static GMainLoop *main_loop = NULL;
 static GDBusConnection *connection = NULL;
-static guint app_registration_id = 0;
-static guint service_registration_id = 0;
-static guint char_registration_id = 0;
-static guint advert_registration_id = 0;
+static ble::HandlerPool *handler_pool = NULL;   // --workers; NULL runs handlers inline
 
-// Characteristic value storage
-static char char_value[256] = "Hello BLE!";
-static size_t char_value_len = 10;
+// One GATT application per adapter, served on that adapter's thread
+struct Shard {
+    const char *adapter;
+    
+    // GATT objects; paths and GetManagedObjects are derived from the declarations
+    ble::GattDatabase gatt_db{APP_PATH};
+    std::string char_path;
+    
+    // Long reads and reliable writes in progress, per device
+    std::unique_ptr<ble::ValueRequests> requests;
+    
+    // AcquireWrite socket; open while a client streams write-without-response
+    std::unique_ptr<ble::FdChannel> write_channel;
+    uint64_t write_packets = 0;     // Since the channel was acquired
+    uint64_t write_bytes = 0;
+    
+    guint advert_registration_id = 0;
+};
+
+// Characteristic value, shared by all adapters and handler workers; reads
+// never block on writers
+static ble::ValueStore values(1);
+static ble::ValueStore::Id char_value_id;
 
 // Signal handler for clean shutdown
 static void signal_handler(int sig) {
@@ -50,129 +104,28 @@ static void signal_handler(int sig) {
 }
 
 // =============================================================================
-// Characteristic Implementation
+// AcquireWrite Data Path
 // =============================================================================
 
-static void handle_char_method_call(
-    GDBusConnection *conn,
-    const gchar *sender,
-    const gchar *object_path,
-    const gchar *interface_name,
-    const gchar *method_name,
-    GVariant *parameters,
-    GDBusMethodInvocation *invocation,
-    gpointer user_data)
-{
-    if (g_strcmp0(method_name, "ReadValue") == 0) {
-        printf("📖 Read request received\n");
-        printf("   Value: \"%s\"\n", char_value);
-        
-        GVariantBuilder *builder = g_variant_builder_new(G_VARIANT_TYPE("ay"));
-        for (size_t i = 0; i < char_value_len; i++) {
-            g_variant_builder_add(builder, "y", (guchar)char_value[i]);
-        }
-        
-        GVariant *result = g_variant_new("(ay)", builder);
-        g_variant_builder_unref(builder);
-        g_dbus_method_invocation_return_value(invocation, result);
-    }
-    else if (g_strcmp0(method_name, "WriteValue") == 0) {
-        GVariant *value_variant;
-        GVariant *options;
-        g_variant_get(parameters, "(@aya{sv})", &value_variant, &options);
-        
-        gsize n_elements;
-        const guchar *value = (const guchar *)g_variant_get_fixed_array(
-            value_variant, &n_elements, sizeof(guchar));
-        
-        // Store the new value
-        char_value_len = n_elements < sizeof(char_value) - 1 ? n_elements : sizeof(char_value) - 1;
-        memcpy(char_value, value, char_value_len);
-        char_value[char_value_len] = '\0';
-        
-        printf("✏️  Write request received\n");
-        printf("   New value: \"%s\"\n", char_value);
-        
-        g_variant_unref(value_variant);
-        g_variant_unref(options);
-        g_dbus_method_invocation_return_value(invocation, NULL);
-    }
-    else {
-        g_dbus_method_invocation_return_error(invocation,
-            G_DBUS_ERROR, G_DBUS_ERROR_NOT_SUPPORTED,
-            "Method %s not supported", method_name);
-    }
-}
-
-static GVariant* handle_char_get_property(
-    GDBusConnection *conn,
-    const gchar *sender,
-    const gchar *object_path,
-    const gchar *interface_name,
-    const gchar *property_name,
-    GError **error,
-    gpointer user_data)
-{
-    if (g_strcmp0(property_name, "UUID") == 0) {
-        return g_variant_new_string(CHARACTERISTIC_UUID);
-    }
-    else if (g_strcmp0(property_name, "Service") == 0) {
-        return g_variant_new_object_path(SERVICE_PATH);
-    }
-    else if (g_strcmp0(property_name, "Flags") == 0) {
-        const gchar *flags[] = {"read", "write", NULL};
-        return g_variant_new_strv(flags, -1);
-    }
-    
-    return NULL;
+static void on_write_packet(Shard *shard, const uint8_t *data, size_t len) {
+    // Hot path: no terminal output per packet, totals are printed on release
+    values.set(char_value_id, data, len);
+    shard->write_packets++;
+    shard->write_bytes += len;
 }
 
-static const GDBusInterfaceVTable char_vtable = {
-    handle_char_method_call,
-    handle_char_get_property,
-    NULL
-};
-
-// =============================================================================
-// Service Implementation
-// =============================================================================
-
-static GVariant* handle_service_get_property(
-    GDBusConnection *conn,
-    const gchar *sender,
-    const gchar *object_path,
-    const gchar *interface_name,
-    const gchar *property_name,
-    GError **error,
-    gpointer user_data)
-{
-    if (g_strcmp0(property_name, "UUID") == 0) {
-        return g_variant_new_string(SERVICE_UUID);
-    }
-    else if (g_strcmp0(property_name, "Primary") == 0) {
-        return g_variant_new_boolean(TRUE);
-    }
-    else if (g_strcmp0(property_name, "Characteristics") == 0) {
-        GVariantBuilder builder;
-        g_variant_builder_init(&builder, G_VARIANT_TYPE("ao"));
-        g_variant_builder_add(&builder, "o", CHAR_PATH);
-        return g_variant_builder_end(&builder);
-    }
-    
-    return NULL;
+static void on_write_channel_closed(Shard *shard) {
+    printf("🔌 Write channel released (%s): %llu packets, %llu bytes\n", shard->adapter,
+           (unsigned long long)shard->write_packets, (unsigned long long)shard->write_bytes);
+    shard->write_channel.reset();
+    shard->gatt_db.set_property(shard->char_path, "WriteAcquired", g_variant_new_boolean(FALSE));
 }
 
-static const GDBusInterfaceVTable service_vtable = {
-    NULL,
-    handle_service_get_property,
-    NULL
-};
-
 // =============================================================================
-// Application (Object Manager)
+// Characteristic Implementation
 // =============================================================================
 
-static void handle_app_method_call(
+static void handle_char_method_call(
     GDBusConnection *conn,
     const gchar *sender,
     const gchar *object_path,
@@ -182,40 +135,45 @@ static void handle_app_method_call(
     GDBusMethodInvocation *invocation,
     gpointer user_data)
 {
-    if (g_strcmp0(method_name, "GetManagedObjects") == 0) {
-        GVariantBuilder *builder = g_variant_builder_new(G_VARIANT_TYPE("a{oa{sa{sv}}}"));
-        
-        // Add Service
-        GVariantBuilder *service_props = g_variant_builder_new(G_VARIANT_TYPE("a{sv}"));
-        g_variant_builder_add(service_props, "{sv}", "UUID", g_variant_new_string(SERVICE_UUID));
-        g_variant_builder_add(service_props, "{sv}", "Primary", g_variant_new_boolean(TRUE));
-        
-        GVariantBuilder *service_ifaces = g_variant_builder_new(G_VARIANT_TYPE("a{sa{sv}}"));
-        g_variant_builder_add(service_ifaces, "{sa{sv}}", "org.bluez.GattService1", service_props);
-        g_variant_builder_add(builder, "{oa{sa{sv}}}", SERVICE_PATH, service_ifaces);
-        
-        // Add Characteristic
-        GVariantBuilder *char_props = g_variant_builder_new(G_VARIANT_TYPE("a{sv}"));
-        g_variant_builder_add(char_props, "{sv}", "UUID", g_variant_new_string(CHARACTERISTIC_UUID));
-        g_variant_builder_add(char_props, "{sv}", "Service", g_variant_new_object_path(SERVICE_PATH));
-        const gchar *flags[] = {"read", "write", NULL};
-        g_variant_builder_add(char_props, "{sv}", "Flags", g_variant_new_strv(flags, -1));
+    Shard *shard = (Shard *)user_data;
+    
+    switch (Char::find_method(method_name)) {
+    // Hot path: no terminal output per request, latencies are on /org/example/Stats
+    case Char::method("ReadValue"):
+        // Serves offset/mtu; Read Blob slices come from one snapshot
+        shard->requests->read(char_value_id, parameters, invocation);
+        break;
+    case Char::method("WriteValue"):
+        // Applies offset and type; reliable writes are staged, then committed at once
+        shard->requests->write(char_value_id, parameters, invocation);
+        break;
+    case Char::method("AcquireWrite"):
+        if (shard->write_channel) {
+            g_dbus_method_invocation_return_dbus_error(invocation,
+                "org.bluez.Error.NotPermitted", "Write already acquired");
+            return;
+        }
         
-        GVariantBuilder *char_ifaces = g_variant_builder_new(G_VARIANT_TYPE("a{sa{sv}}"));
-        g_variant_builder_add(char_ifaces, "{sa{sv}}", "org.bluez.GattCharacteristic1", char_props);
-        g_variant_builder_add(builder, "{oa{sa{sv}}}", CHAR_PATH, char_ifaces);
+        shard->write_channel = ble::FdChannel::acquire(invocation, parameters);
+        if (!shard->write_channel) return;
         
-        GVariant *result = g_variant_new("(a{oa{sa{sv}}})", builder);
-        g_dbus_method_invocation_return_value(invocation, result);
+        shard->write_packets = 0;
+        shard->write_bytes = 0;
+        shard->write_channel->set_handlers(
+            [shard](const uint8_t *data, size_t len) { on_write_packet(shard, data, len); },
+            [shard]() { on_write_channel_closed(shard); });
+        // Serviced on this adapter's thread
+        shard->write_channel->attach(g_main_context_get_thread_default());
+        shard->gatt_db.set_property(shard->char_path, "WriteAcquired", g_variant_new_boolean(TRUE));
+        printf("🔌 Write channel acquired (%s, MTU %u)\n", shard->adapter, shard->write_channel->mtu());
+        break;
+    default:
+        g_dbus_method_invocation_return_error(invocation,
+            G_DBUS_ERROR, G_DBUS_ERROR_NOT_SUPPORTED,
+            "Method %s not supported", method_name);
     }
 }
 
-static const GDBusInterfaceVTable app_vtable = {
-    handle_app_method_call,
-    NULL,
-    NULL
-};
-
 // =============================================================================
 // Advertisement
 // =============================================================================
@@ -230,10 +188,9 @@ static void handle_advert_method_call(
     GDBusMethodInvocation *invocation,
     gpointer user_data)
 {
-    if (g_strcmp0(method_name, "Release") == 0) {
-        printf("📢 Advertisement released\n");
-        g_dbus_method_invocation_return_value(invocation, NULL);
-    }
+    // Release is the only method; GDBus rejects undeclared ones
+    printf("📢 Advertisement released (%s)\n", ((Shard *)user_data)->adapter);
+    g_dbus_method_invocation_return_value(invocation, NULL);
 }
 
 static GVariant* handle_advert_get_property(
@@ -245,20 +202,20 @@ static GVariant* handle_advert_get_property(
     GError **error,
     gpointer user_data)
 {
-    if (g_strcmp0(property_name, "Type") == 0) {
+    switch (Advert::find_property(property_name)) {
+    case Advert::property("Type"):
         return g_variant_new_string("peripheral");
-    }
-    else if (g_strcmp0(property_name, "ServiceUUIDs") == 0) {
-        const gchar *uuids[] = {SERVICE_UUID, NULL};
+    case Advert::property("ServiceUUIDs"): {
+        const gchar *uuids[] = {SERVICE_UUID_STR.data(), NULL};
         return g_variant_new_strv(uuids, -1);
     }
-    else if (g_strcmp0(property_name, "LocalName") == 0) {
+    case Advert::property("LocalName"):
         return g_variant_new_string("Simple-Peripheral");
-    }
-    else if (g_strcmp0(property_name, "Includes") == 0) {
+    case Advert::property("Includes"): {
         const gchar *includes[] = {"tx-power", NULL};
         return g_variant_new_strv(includes, -1);
     }
+    }
     
     return NULL;
 }
@@ -270,90 +227,80 @@ static const GDBusInterfaceVTable advert_vtable = {
 };
 
 // =============================================================================
-// D-Bus Interface XML
-// =============================================================================
-
-static const gchar app_introspection_xml[] =
-    "<node>"
-    "  <interface name='org.freedesktop.DBus.ObjectManager'>"
-    "    <method name='GetManagedObjects'>"
-    "      <arg type='a{oa{sa{sv}}}' direction='out'/>"
-    "    </method>"
-    "  </interface>"
-    "</node>";
-
-static const gchar service_introspection_xml[] =
-    "<node>"
-    "  <interface name='org.bluez.GattService1'>"
-    "    <property name='UUID' type='s' access='read'/>"
-    "    <property name='Primary' type='b' access='read'/>"
-    "    <property name='Characteristics' type='ao' access='read'/>"
-    "  </interface>"
-    "</node>";
-
-static const gchar char_introspection_xml[] =
-    "<node>"
-    "  <interface name='org.bluez.GattCharacteristic1'>"
-    "    <method name='ReadValue'>"
-    "      <arg type='a{sv}' direction='in'/>"
-    "      <arg type='ay' direction='out'/>"
-    "    </method>"
-    "    <method name='WriteValue'>"
-    "      <arg type='ay' direction='in'/>"
-    "      <arg type='a{sv}' direction='in'/>"
-    "    </method>"
-    "    <property name='UUID' type='s' access='read'/>"
-    "    <property name='Service' type='o' access='read'/>"
-    "    <property name='Flags' type='as' access='read'/>"
-    "  </interface>"
-    "</node>";
-
-static const gchar advert_introspection_xml[] =
-    "<node>"
-    "  <interface name='org.bluez.LEAdvertisement1'>"
-    "    <method name='Release'/>"
-    "    <property name='Type' type='s' access='read'/>"
-    "    <property name='ServiceUUIDs' type='as' access='read'/>"
-    "    <property name='LocalName' type='s' access='read'/>"
-    "    <property name='Includes' type='as' access='read'/>"
-    "  </interface>"
-    "</node>";
-
-// =============================================================================
-// Registration Callbacks
+// Adapters
 // =============================================================================
 
-static void on_register_application_reply(GObject *source, GAsyncResult *res, gpointer user_data) {
-    GError *error = NULL;
-    GVariant *result = g_dbus_connection_call_finish(connection, res, &error);
-    
+static void on_register_application_reply(ble::AdapterShard &adapter, const GError *error) {
     if (error) {
-        printf("❌ Failed to register application: %s\n", error->message);
-        g_error_free(error);
+        printf("❌ %s: Failed to register application: %s\n", adapter.adapter().name.c_str(),
+               error->message);
         g_main_loop_quit(main_loop);
         return;
     }
     
-    printf("✅ GATT application registered\n");
-    if (result) g_variant_unref(result);
+    printf("✅ %s: GATT application registered\n", adapter.adapter().name.c_str());
 }
 
-static void on_register_advertisement_reply(GObject *source, GAsyncResult *res, gpointer user_data) {
-    GError *error = NULL;
-    GVariant *result = g_dbus_connection_call_finish(connection, res, &error);
-    
+// Runs again whenever the pool re-advertises on an adapter that lost links
+static void on_register_advertisement_reply(ble::AdapterShard &adapter, const GError *error) {
     if (error) {
-        printf("❌ Failed to register advertisement: %s\n", error->message);
-        g_error_free(error);
+        printf("❌ %s: Failed to register advertisement: %s\n", adapter.adapter().name.c_str(),
+               error->message);
         return;
     }
     
-    printf("✅ Advertisement registered\n");
-    printf("\n📡 Peripheral is now advertising as 'Simple-Peripheral'\n");
-    printf("   Service UUID: %s\n", SERVICE_UUID);
-    printf("\n   Waiting for connections... (Ctrl+C to stop)\n\n");
+    printf("✅ %s: Advertising (%u links)\n", adapter.adapter().name.c_str(), adapter.links());
+}
+
+// On the adapter's thread: export this adapter's objects on its own
+// connection, then register them with BlueZ
+static bool setup_adapter(ble::AdapterShard &adapter, std::string *error) {
+    Shard *shard = new Shard;
+    shard->adapter = adapter.adapter().name.c_str();
+    shard->requests.reset(new ble::ValueRequests(values, adapter.context()));
+    adapter.set_user_data(shard);
+    
+    // Declare the GATT database
+    std::string service_path = shard->gatt_db.add_service(SERVICE_UUID);
+    shard->char_path = shard->gatt_db.add_characteristic(service_path, CHARACTERISTIC_UUID,
+                                                         {"read", "write", "write-without-response"},
+                                                         handle_char_method_call, shard);
+    // ReadValue/WriteValue only use the shared value, so they may run on workers
+    if (handler_pool) shard->gatt_db.set_handler_pool(handler_pool);
+    // Exposing WriteAcquired makes BlueZ use AcquireWrite for write commands
+    shard->gatt_db.set_property(shard->char_path, "WriteAcquired", g_variant_new_boolean(FALSE));
+    
+    // ObjectManager, service and characteristic, then the advertisement
+    GError *gerror = NULL;
+    if (shard->gatt_db.register_objects(adapter.connection(), &gerror)) {
+        shard->advert_registration_id = g_dbus_connection_register_object(
+            adapter.connection(), ADVERT_PATH,
+            Advert::info(),
+            &advert_vtable, shard, NULL, &gerror);
+    }
+    if (gerror) {
+        *error = gerror->message;
+        g_error_free(gerror);
+        return false;
+    }
+    
+    adapter.register_application(APP_PATH, on_register_application_reply);
+    adapter.advertise(ADVERT_PATH, on_register_advertisement_reply);
+    return true;
+}
+
+// On the adapter's thread, after BlueZ registrations are withdrawn
+static void teardown_adapter(ble::AdapterShard &adapter) {
+    Shard *shard = (Shard *)adapter.user_data();
+    if (!shard) return;
     
-    if (result) g_variant_unref(result);
+    shard->write_channel.reset();
+    shard->gatt_db.unregister_objects();
+    if (shard->advert_registration_id) {
+        g_dbus_connection_unregister_object(adapter.connection(), shard->advert_registration_id);
+    }
+    delete shard;
+    adapter.set_user_data(NULL);
 }
 
 // =============================================================================
@@ -362,137 +309,98 @@ static void on_register_advertisement_reply(GObject *source, GAsyncResult *res,
 
 int main(int argc, char *argv[]) {
     GError *error = NULL;
+    const char *bus_address = NULL;
+    const char *metrics_listen = NULL;
+    const char *adapters = NULL;
+    unsigned max_links = 0;
+    unsigned workers = 0;
+    ble::HandlerPoolOptions handler_options;
+    
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--bus") == 0) bus_address = argv[i + 1];
+        else if (strcmp(argv[i], "--metrics") == 0) metrics_listen = argv[i + 1];
+        else if (strcmp(argv[i], "--adapters") == 0) adapters = argv[i + 1];
+        else if (strcmp(argv[i], "--max-links") == 0) max_links = (unsigned)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--workers") == 0) workers = (unsigned)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--queue-depth") == 0) {
+            handler_options.queue_depth = (size_t)atol(argv[i + 1]);
+        }
+    }
     
     printf("╔════════════════════════════════════════════════════════════╗\n");
     printf("║           Simple BLE Peripheral (C++ Version)              ║\n");
     printf("╚════════════════════════════════════════════════════════════╝\n\n");
     
+    values.add("Hello BLE!", 10, &char_value_id);
+    main_loop = g_main_loop_new(NULL, FALSE);
+    
     // Setup signal handler
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
     
-    // Connect to system bus
-    connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    // Connect to the system bus, or the one given by --bus / $BLE_DBUS_ADDRESS
+    connection = ble_dbus_connect(bus_address, &error);
     if (!connection) {
-        printf("❌ Failed to connect to system bus: %s\n", error->message);
+        printf("❌ Failed to connect to D-Bus: %s\n", error->message);
         g_error_free(error);
         return 1;
     }
     printf("✅ Connected to D-Bus\n");
     
-    // Parse introspection data
-    GDBusNodeInfo *app_node = g_dbus_node_info_new_for_xml(app_introspection_xml, &error);
-    GDBusNodeInfo *service_node = g_dbus_node_info_new_for_xml(service_introspection_xml, &error);
-    GDBusNodeInfo *char_node = g_dbus_node_info_new_for_xml(char_introspection_xml, &error);
-    GDBusNodeInfo *advert_node = g_dbus_node_info_new_for_xml(advert_introspection_xml, &error);
-    
-    if (!app_node || !service_node || !char_node || !advert_node) {
-        printf("❌ Failed to parse introspection XML\n");
-        return 1;
+    // Handler latencies, on D-Bus and optionally over HTTP
+    guint stats_registration_id = ble::metrics_register_dbus(connection, STATS_PATH, NULL);
+    ble::MetricsServer metrics;
+    std::string metrics_error;
+    if (metrics_listen && !metrics.start(metrics_listen, &metrics_error)) {
+        printf("⚠️  Metrics endpoint %s: %s\n", metrics_listen, metrics_error.c_str());
     }
     
-    // Register Application (ObjectManager)
-    app_registration_id = g_dbus_connection_register_object(
-        connection, APP_PATH,
-        app_node->interfaces[0],
-        &app_vtable, NULL, NULL, &error);
-    
-    // Register Service
-    service_registration_id = g_dbus_connection_register_object(
-        connection, SERVICE_PATH,
-        service_node->interfaces[0],
-        &service_vtable, NULL, NULL, &error);
-    
-    // Register Characteristic
-    char_registration_id = g_dbus_connection_register_object(
-        connection, CHAR_PATH,
-        char_node->interfaces[0],
-        &char_vtable, NULL, NULL, &error);
+    // Characteristic handlers off the D-Bus threads
+    ble::HandlerPool handlers;
+    if (workers) {
+        std::string handler_error;
+        handler_options.threads = workers;
+        if (!handlers.start(handler_options, &handler_error)) {
+            printf("❌ Failed to start handler workers: %s\n", handler_error.c_str());
+            return 1;
+        }
+        handler_pool = &handlers;
+        printf("✅ %u handler workers, queue depth %zu\n", workers, handler_options.queue_depth);
+    }
     
-    // Register Advertisement
-    advert_registration_id = g_dbus_connection_register_object(
-        connection, ADVERT_PATH,
-        advert_node->interfaces[0],
-        &advert_vtable, NULL, NULL, &error);
+    // GATT application and advertisement on each adapter ($BLE_ADAPTER by default)
+    ble::AdapterPoolOptions pool_options;
+    if (bus_address) pool_options.bus_address = bus_address;
+    pool_options.adapters = adapters ? adapters : ble_dbus_adapter_path();
+    pool_options.max_links = max_links;
     
-    if (error) {
-        printf("❌ Failed to register objects: %s\n", error->message);
-        g_error_free(error);
+    ble::AdapterPool pool;
+    std::string pool_error;
+    if (!pool.start(pool_options, setup_adapter, teardown_adapter, &pool_error)) {
+        printf("❌ Failed to set up adapters: %s\n", pool_error.c_str());
         return 1;
     }
     
-    printf("✅ D-Bus objects registered\n");
-    
-    // Register GATT Application with BlueZ
-    g_dbus_connection_call(
-        connection,
-        "org.bluez",
-        "/org/bluez/hci0",
-        "org.bluez.GattManager1",
-        "RegisterApplication",
-        g_variant_new("(oa{sv})", APP_PATH, NULL),
-        NULL,
-        G_DBUS_CALL_FLAGS_NONE,
-        -1,
-        NULL,
-        on_register_application_reply,
-        NULL);
-    
-    // Register Advertisement with BlueZ
-    g_dbus_connection_call(
-        connection,
-        "org.bluez",
-        "/org/bluez/hci0",
-        "org.bluez.LEAdvertisingManager1",
-        "RegisterAdvertisement",
-        g_variant_new("(oa{sv})", ADVERT_PATH, NULL),
-        NULL,
-        G_DBUS_CALL_FLAGS_NONE,
-        -1,
-        NULL,
-        on_register_advertisement_reply,
-        NULL);
+    printf("✅ D-Bus objects registered on %zu adapter(s):", pool.size());
+    for (size_t i = 0; i < pool.size(); i++) printf(" %s", pool.shard(i).adapter().name.c_str());
+    printf("\n\n📡 Peripheral is advertising as 'Simple-Peripheral'\n");
+    printf("   Service UUID: %s\n", SERVICE_UUID_STR.data());
+    printf("\n   Waiting for connections... (Ctrl+C to stop)\n\n");
     
-    // Run main loop
-    main_loop = g_main_loop_new(NULL, FALSE);
+    // Run main loop; the adapters run on their own threads
     g_main_loop_run(main_loop);
     
     // Cleanup
     printf("\n🧹 Cleaning up...\n");
     
-    // Unregister advertisement
-    g_dbus_connection_call_sync(
-        connection,
-        "org.bluez",
-        "/org/bluez/hci0",
-        "org.bluez.LEAdvertisingManager1",
-        "UnregisterAdvertisement",
-        g_variant_new("(o)", ADVERT_PATH),
-        NULL,
-        G_DBUS_CALL_FLAGS_NONE,
-        -1, NULL, NULL);
-    
-    // Unregister application
-    g_dbus_connection_call_sync(
-        connection,
-        "org.bluez",
-        "/org/bluez/hci0",
-        "org.bluez.GattManager1",
-        "UnregisterApplication",
-        g_variant_new("(o)", APP_PATH),
-        NULL,
-        G_DBUS_CALL_FLAGS_NONE,
-        -1, NULL, NULL);
+    // Finishes queued calls while the adapters' state is still alive
+    handlers.stop();
     
-    g_dbus_connection_unregister_object(connection, app_registration_id);
-    g_dbus_connection_unregister_object(connection, service_registration_id);
-    g_dbus_connection_unregister_object(connection, char_registration_id);
-    g_dbus_connection_unregister_object(connection, advert_registration_id);
+    // Unregisters advertisements and applications from BlueZ
+    pool.stop();
     
-    g_dbus_node_info_unref(app_node);
-    g_dbus_node_info_unref(service_node);
-    g_dbus_node_info_unref(char_node);
-    g_dbus_node_info_unref(advert_node);
+    if (stats_registration_id) g_dbus_connection_unregister_object(connection, stats_registration_id);
+    metrics.stop();
     
     g_main_loop_unref(main_loop);
     g_object_unref(connection);
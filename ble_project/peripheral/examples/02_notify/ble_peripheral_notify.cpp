@@ -1,210 +1,278 @@
 // BLE Peripheral with Notifications
-// Usage: sudo ./ble_peripheral_notify
+// Usage: sudo ./ble_peripheral_notify [--bus ADDRESS] [--metrics LISTEN]
+//                                     [--adapters all|hci0,...] [--max-links N]
+//
+// A simulated sensor thread publishes a counter at 1 kHz; the notification
+// engine coalesces it to the latest value and notifies at most 20 times a
+// second, over D-Bus or an AcquireNotify socket. With --adapters the
+// service is served from every listed adapter, each on its own thread with
+// its own engine, and connections are spread across them. Handler
+// latencies are served as org.example.Stats on /org/example/Stats and,
+// with --metrics, as Prometheus text over HTTP.
 
 #include <gio/gio.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "ble_adapter_pool.hpp"
+#include "ble_dbus.h"
+#include "ble_dbus_schema.hpp"
+#include "ble_fd_channel.hpp"
+#include "ble_gatt_database.hpp"
+#include "ble_notify_engine.hpp"
+#include "ble_gatt_value.h"
+#include "ble_metrics.hpp"
+#include "ble_uuid.hpp"
+
+using namespace ble::literals;
+
+static constexpr ble_uuid_t SERVICE_UUID = "12345678-1234-5678-1234-56789abcdef0"_uuid;
+static constexpr ble_uuid_t CHAR_UUID    = "12345678-1234-5678-1234-56789abcdef1"_uuid;
+static constexpr auto SERVICE_UUID_STR = ble::to_string(SERVICE_UUID);
+static constexpr ble::InterfaceSchema<0, 3> ADVERT_SCHEMA = {
+    "org.bluez.LEAdvertisement1",
+    {},
+    {{{"Type", "s"}, {"ServiceUUIDs", "as"}, {"LocalName", "s"}}},
+};
+using Advert = ble::DBusInterface<ADVERT_SCHEMA>;
+using Char = ble::GattCharacteristicInterface;
 
-#define SERVICE_UUID "12345678-1234-5678-1234-56789abcdef0"
-#define CHAR_UUID    "12345678-1234-5678-1234-56789abcdef1"
 #define APP_PATH     "/org/bluez/example"
-#define SERVICE_PATH "/org/bluez/example/service0"
-#define CHAR_PATH    "/org/bluez/example/service0/char0"
 #define ADVERT_PATH  "/org/bluez/example/advertisement0"
+#define STATS_PATH   "/org/example/Stats"
+
+#define SENSOR_RATE_HZ  1000
+#define NOTIFY_RATE_HZ  20
 
 static GMainLoop *main_loop = NULL;
 static GDBusConnection *connection = NULL;
-static int counter = 0;
+static std::atomic<bool> sensor_running(false);
+
+// One GATT application per adapter; everything but publish() runs on its thread
+struct Shard {
+    const char *adapter;
+    ble::GattDatabase gatt_db{APP_PATH};
+    ble::NotificationEngine notifier{gatt_db, g_main_context_get_thread_default()};
+    ble::NotificationEngine::Id counter_id;
+    std::string char_path;
+    std::unique_ptr<ble::FdChannel> notify_channel;     // AcquireNotify socket
+    guint advert_registration_id = 0;
+};
+static std::vector<Shard *> shards;     // Filled once the pool has started
 
 static void signal_handler(int sig) {
     (void)sig;
     if (main_loop) g_main_loop_quit(main_loop);
 }
 
+static void on_notify_channel_closed(Shard *shard) {
+    printf("Notify channel released (%s)\n", shard->adapter);
+    shard->notifier.stop(shard->counter_id);
+    shard->notifier.set_channel(shard->counter_id, nullptr);
+    shard->notify_channel.reset();
+    shard->gatt_db.set_property(shard->char_path, "NotifyAcquired", g_variant_new_boolean(FALSE));
+}
+
 static void handle_char_method_call(GDBusConnection *conn, const gchar *sender,
     const gchar *object_path, const gchar *interface_name, const gchar *method_name,
     GVariant *parameters, GDBusMethodInvocation *invocation, gpointer user_data) {
+    Shard *shard = (Shard *)user_data;
     
-    if (g_strcmp0(method_name, "ReadValue") == 0) {
-        char value[32];
-        snprintf(value, sizeof(value), "Count: %d", counter);
-        
-        GVariantBuilder *builder = g_variant_builder_new(G_VARIANT_TYPE("ay"));
-        for (size_t i = 0; i < strlen(value); i++) {
-            g_variant_builder_add(builder, "y", (guchar)value[i]);
-        }
-        
-        g_dbus_method_invocation_return_value(invocation, g_variant_new("(ay)", builder));
-        g_variant_builder_unref(builder);
-        printf("Read: %s\n", value);
+    switch (Char::find_method(method_name)) {
+    case Char::method("ReadValue"): {
+        GBytes *value = shard->notifier.value(shard->counter_id);
+        g_dbus_method_invocation_return_value(invocation, ble_gatt_value_reply(value));
+        gsize len;
+        const char *data = (const char *)g_bytes_get_data(value, &len);
+        printf("Read (%s): %.*s\n", shard->adapter, (int)len, data);
+        break;
     }
-    else if (g_strcmp0(method_name, "StartNotify") == 0) {
-        printf("Notifications enabled\n");
+    case Char::method("StartNotify"):
+        printf("Notifications enabled (%s)\n", shard->adapter);
+        shard->notifier.start(shard->counter_id);
         g_dbus_method_invocation_return_value(invocation, NULL);
-    }
-    else if (g_strcmp0(method_name, "StopNotify") == 0) {
-        printf("Notifications disabled\n");
+        break;
+    case Char::method("StopNotify"):
+        printf("Notifications disabled (%s)\n", shard->adapter);
+        shard->notifier.stop(shard->counter_id);
         g_dbus_method_invocation_return_value(invocation, NULL);
+        break;
+    case Char::method("AcquireNotify"):
+        if (shard->notify_channel) {
+            g_dbus_method_invocation_return_dbus_error(invocation,
+                "org.bluez.Error.NotPermitted", "Notify already acquired");
+            return;
+        }
+        shard->notify_channel = ble::FdChannel::acquire(invocation, parameters);
+        if (!shard->notify_channel) return;
+        shard->notify_channel->set_handlers(nullptr, [shard]() { on_notify_channel_closed(shard); });
+        shard->notify_channel->attach(g_main_context_get_thread_default());
+        shard->notifier.set_channel(shard->counter_id, shard->notify_channel.get());
+        shard->notifier.start(shard->counter_id);
+        shard->gatt_db.set_property(shard->char_path, "NotifyAcquired", g_variant_new_boolean(TRUE));
+        printf("Notify channel acquired (%s, MTU %u)\n", shard->adapter, shard->notify_channel->mtu());
+        break;
+    default:
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR,
+            G_DBUS_ERROR_NOT_SUPPORTED, "Method %s not supported", method_name);
     }
 }
 
-static GVariant* handle_char_get_property(GDBusConnection *conn, const gchar *sender,
+static GVariant* handle_advert_get_property(GDBusConnection *conn, const gchar *sender,
     const gchar *object_path, const gchar *interface_name, const gchar *property_name,
     GError **error, gpointer user_data) {
     
-    if (g_strcmp0(property_name, "UUID") == 0) {
-        return g_variant_new_string(CHAR_UUID);
-    }
-    else if (g_strcmp0(property_name, "Service") == 0) {
-        return g_variant_new_object_path(SERVICE_PATH);
+    switch (Advert::find_property(property_name)) {
+    case Advert::property("Type"):
+        return g_variant_new_string("peripheral");
+    case Advert::property("ServiceUUIDs"): {
+        const gchar *uuids[] = {SERVICE_UUID_STR.data(), NULL};
+        return g_variant_new_strv(uuids, -1);
     }
-    else if (g_strcmp0(property_name, "Flags") == 0) {
-        const gchar *flags[] = {"read", "notify", NULL};
-        return g_variant_new_strv(flags, -1);
+    case Advert::property("LocalName"):
+        return g_variant_new_string("BLE-Notify");
     }
     return NULL;
 }
 
-static const GDBusInterfaceVTable char_vtable = {
-    handle_char_method_call, handle_char_get_property, NULL
+static const GDBusInterfaceVTable advert_vtable = {
+    NULL, handle_advert_get_property, NULL
 };
 
-static GVariant* handle_service_get_property(GDBusConnection *conn, const gchar *sender,
-    const gchar *object_path, const gchar *interface_name, const gchar *property_name,
-    GError **error, gpointer user_data) {
-    
-    if (g_strcmp0(property_name, "UUID") == 0) {
-        return g_variant_new_string(SERVICE_UUID);
-    }
-    else if (g_strcmp0(property_name, "Primary") == 0) {
-        return g_variant_new_boolean(TRUE);
+// Simulated sensor: publishes from its own thread, never blocks on the link
+static void sensor_thread() {
+    char value[32];
+    auto next = std::chrono::steady_clock::now();
+    for (int counter = 1; sensor_running.load(std::memory_order_relaxed); counter++) {
+        int len = snprintf(value, sizeof(value), "Count: %d", counter);
+        for (Shard *shard : shards) shard->notifier.publish(shard->counter_id, value, len);
+        next += std::chrono::microseconds(1000000 / SENSOR_RATE_HZ);
+        std::this_thread::sleep_until(next);
     }
-    return NULL;
 }
 
-static const GDBusInterfaceVTable service_vtable = {
-    NULL, handle_service_get_property, NULL
-};
-
-static void handle_app_method_call(GDBusConnection *conn, const gchar *sender,
-    const gchar *object_path, const gchar *interface_name, const gchar *method_name,
-    GVariant *parameters, GDBusMethodInvocation *invocation, gpointer user_data) {
-    
-    if (g_strcmp0(method_name, "GetManagedObjects") == 0) {
-        GVariantBuilder *builder = g_variant_builder_new(G_VARIANT_TYPE("a{oa{sa{sv}}}"));
-        
-        GVariantBuilder *service_props = g_variant_builder_new(G_VARIANT_TYPE("a{sv}"));
-        g_variant_builder_add(service_props, "{sv}", "UUID", g_variant_new_string(SERVICE_UUID));
-        g_variant_builder_add(service_props, "{sv}", "Primary", g_variant_new_boolean(TRUE));
-        
-        GVariantBuilder *service_ifaces = g_variant_builder_new(G_VARIANT_TYPE("a{sa{sv}}"));
-        g_variant_builder_add(service_ifaces, "{sa{sv}}", "org.bluez.GattService1", service_props);
-        g_variant_builder_add(builder, "{oa{sa{sv}}}", SERVICE_PATH, service_ifaces);
-        
-        GVariantBuilder *char_props = g_variant_builder_new(G_VARIANT_TYPE("a{sv}"));
-        g_variant_builder_add(char_props, "{sv}", "UUID", g_variant_new_string(CHAR_UUID));
-        g_variant_builder_add(char_props, "{sv}", "Service", g_variant_new_object_path(SERVICE_PATH));
-        const gchar *flags[] = {"read", "notify", NULL};
-        g_variant_builder_add(char_props, "{sv}", "Flags", g_variant_new_strv(flags, -1));
-        
-        GVariantBuilder *char_ifaces = g_variant_builder_new(G_VARIANT_TYPE("a{sa{sv}}"));
-        g_variant_builder_add(char_ifaces, "{sa{sv}}", "org.bluez.GattCharacteristic1", char_props);
-        g_variant_builder_add(builder, "{oa{sa{sv}}}", CHAR_PATH, char_ifaces);
-        
-        g_dbus_method_invocation_return_value(invocation, g_variant_new("(a{oa{sa{sv}}})", builder));
+static gboolean print_stats(gpointer user_data) {
+    for (Shard *shard : shards) {
+        ble::NotifyStats stats = shard->notifier.stats(shard->counter_id);
+        printf("%s: published %llu, notified %llu, coalesced %llu, dropped %llu\n", shard->adapter,
+               (unsigned long long)stats.published, (unsigned long long)stats.emitted,
+               (unsigned long long)stats.coalesced, (unsigned long long)stats.dropped);
     }
+    return TRUE;
 }
 
-static const GDBusInterfaceVTable app_vtable = {
-    handle_app_method_call, NULL, NULL
-};
+static void on_registered(ble::AdapterShard &adapter, const GError *error) {
+    if (error) fprintf(stderr, "%s: %s\n", adapter.adapter().name.c_str(), error->message);
+}
 
-static GVariant* handle_advert_get_property(GDBusConnection *conn, const gchar *sender,
-    const gchar *object_path, const gchar *interface_name, const gchar *property_name,
-    GError **error, gpointer user_data) {
+// On the adapter's thread, so the engine's timer and handlers run there
+static bool setup_adapter(ble::AdapterShard &adapter, std::string *error) {
+    Shard *shard = new Shard;
+    shard->adapter = adapter.adapter().name.c_str();
+    adapter.set_user_data(shard);
     
-    if (g_strcmp0(property_name, "Type") == 0) {
-        return g_variant_new_string("peripheral");
-    }
-    else if (g_strcmp0(property_name, "ServiceUUIDs") == 0) {
-        const gchar *uuids[] = {SERVICE_UUID, NULL};
-        return g_variant_new_strv(uuids, -1);
+    std::string service_path = shard->gatt_db.add_service(SERVICE_UUID);
+    shard->char_path = shard->gatt_db.add_characteristic(service_path, CHAR_UUID, {"read", "notify"},
+                                                         handle_char_method_call, shard);
+    // Exposing NotifyAcquired makes BlueZ use AcquireNotify instead of StartNotify
+    shard->gatt_db.set_property(shard->char_path, "NotifyAcquired", g_variant_new_boolean(FALSE));
+    shard->counter_id = shard->notifier.add(shard->char_path, NOTIFY_RATE_HZ);
+    shard->notifier.publish(shard->counter_id, "Count: 0", 8);
+    
+    GError *gerror = NULL;
+    if (shard->gatt_db.register_objects(adapter.connection(), &gerror)) {
+        shard->advert_registration_id = g_dbus_connection_register_object(
+            adapter.connection(), ADVERT_PATH, Advert::info(), &advert_vtable, NULL, NULL, &gerror);
     }
-    else if (g_strcmp0(property_name, "LocalName") == 0) {
-        return g_variant_new_string("BLE-Notify");
+    if (gerror) {
+        *error = gerror->message;
+        g_error_free(gerror);
+        return false;
     }
-    return NULL;
+    adapter.register_application(APP_PATH, on_registered);
+    adapter.advertise(ADVERT_PATH, on_registered);
+    return true;
 }
 
-static const GDBusInterfaceVTable advert_vtable = {
-    NULL, handle_advert_get_property, NULL
-};
-
-static gboolean update_counter(gpointer user_data) {
-    counter++;
-    printf("Counter: %d\n", counter);
-    return TRUE;
+static void teardown_adapter(ble::AdapterShard &adapter) {
+    Shard *shard = (Shard *)adapter.user_data();
+    if (!shard) return;
+    shard->notifier.set_channel(shard->counter_id, nullptr);
+    shard->notify_channel.reset();
+    shard->gatt_db.unregister_objects();
+    if (shard->advert_registration_id) {
+        g_dbus_connection_unregister_object(adapter.connection(), shard->advert_registration_id);
+    }
+    delete shard;
+    adapter.set_user_data(NULL);
 }
 
-int main() {
+int main(int argc, char *argv[]) {
     GError *error = NULL;
+    const char *bus_address = NULL;
+    const char *metrics_listen = NULL;
+    const char *adapters = NULL;
+    unsigned max_links = 0;
+    
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--bus") == 0) bus_address = argv[i + 1];
+        else if (strcmp(argv[i], "--metrics") == 0) metrics_listen = argv[i + 1];
+        else if (strcmp(argv[i], "--adapters") == 0) adapters = argv[i + 1];
+        else if (strcmp(argv[i], "--max-links") == 0) max_links = (unsigned)atoi(argv[i + 1]);
+    }
     
     printf("BLE Peripheral with Notifications\n\n");
     
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    main_loop = g_main_loop_new(NULL, FALSE);
     
-    connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    connection = ble_dbus_connect(bus_address, &error);
     if (!connection) {
-        fprintf(stderr, "Failed to connect to D-Bus\n");
+        fprintf(stderr, "Failed to connect to D-Bus: %s\n", error->message);
+        g_error_free(error);
         return 1;
     }
+    ble::metrics_register_dbus(connection, STATS_PATH, NULL);
     
-    const gchar *app_xml = "<node><interface name='org.freedesktop.DBus.ObjectManager'>"
-        "<method name='GetManagedObjects'><arg type='a{oa{sa{sv}}}' direction='out'/></method>"
-        "</interface></node>";
-    
-    const gchar *service_xml = "<node><interface name='org.bluez.GattService1'>"
-        "<property name='UUID' type='s' access='read'/>"
-        "<property name='Primary' type='b' access='read'/></interface></node>";
-    
-    const gchar *char_xml = "<node><interface name='org.bluez.GattCharacteristic1'>"
-        "<method name='ReadValue'><arg type='a{sv}' direction='in'/><arg type='ay' direction='out'/></method>"
-        "<method name='StartNotify'/><method name='StopNotify'/>"
-        "<property name='UUID' type='s' access='read'/>"
-        "<property name='Service' type='o' access='read'/>"
-        "<property name='Flags' type='as' access='read'/></interface></node>";
-    
-    const gchar *advert_xml = "<node><interface name='org.bluez.LEAdvertisement1'>"
-        "<property name='Type' type='s' access='read'/>"
-        "<property name='ServiceUUIDs' type='as' access='read'/>"
-        "<property name='LocalName' type='s' access='read'/></interface></node>";
-    
-    GDBusNodeInfo *app_node = g_dbus_node_info_new_for_xml(app_xml, NULL);
-    GDBusNodeInfo *service_node = g_dbus_node_info_new_for_xml(service_xml, NULL);
-    GDBusNodeInfo *char_node = g_dbus_node_info_new_for_xml(char_xml, NULL);
-    GDBusNodeInfo *advert_node = g_dbus_node_info_new_for_xml(advert_xml, NULL);
-    
-    g_dbus_connection_register_object(connection, APP_PATH, app_node->interfaces[0], &app_vtable, NULL, NULL, NULL);
-    g_dbus_connection_register_object(connection, SERVICE_PATH, service_node->interfaces[0], &service_vtable, NULL, NULL, NULL);
-    g_dbus_connection_register_object(connection, CHAR_PATH, char_node->interfaces[0], &char_vtable, NULL, NULL, NULL);
-    g_dbus_connection_register_object(connection, ADVERT_PATH, advert_node->interfaces[0], &advert_vtable, NULL, NULL, NULL);
+    ble::MetricsServer metrics;
+    std::string metrics_error;
+    if (metrics_listen && !metrics.start(metrics_listen, &metrics_error)) {
+        fprintf(stderr, "Metrics endpoint %s: %s\n", metrics_listen, metrics_error.c_str());
+    }
     
-    g_dbus_connection_call_sync(connection, "org.bluez", "/org/bluez/hci0", "org.bluez.GattManager1",
-        "RegisterApplication", g_variant_new("(oa{sv})", APP_PATH, NULL), NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+    ble::AdapterPoolOptions pool_options;
+    if (bus_address) pool_options.bus_address = bus_address;
+    pool_options.adapters = adapters ? adapters : ble_dbus_adapter_path();
+    pool_options.max_links = max_links;
     
-    g_dbus_connection_call_sync(connection, "org.bluez", "/org/bluez/hci0", "org.bluez.LEAdvertisingManager1",
-        "RegisterAdvertisement", g_variant_new("(oa{sv})", ADVERT_PATH, NULL), NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+    ble::AdapterPool pool;
+    std::string pool_error;
+    if (!pool.start(pool_options, setup_adapter, teardown_adapter, &pool_error)) {
+        fprintf(stderr, "Failed to set up adapters: %s\n", pool_error.c_str());
+        return 1;
+    }
+    for (size_t i = 0; i < pool.size(); i++) shards.push_back((Shard *)pool.shard(i).user_data());
     
-    printf("Advertising as 'BLE-Notify'\n");
-    printf("Service: %s\n\n", SERVICE_UUID);
+    printf("Advertising as 'BLE-Notify' on %zu adapter(s)\n", pool.size());
+    printf("Service: %s\n\n", SERVICE_UUID_STR.data());
     
-    g_timeout_add_seconds(2, update_counter, NULL);
+    sensor_running = true;
+    std::thread sensor(sensor_thread);
+    g_timeout_add_seconds(2, print_stats, NULL);
     
-    main_loop = g_main_loop_new(NULL, FALSE);
     g_main_loop_run(main_loop);
     
+    sensor_running = false;
+    sensor.join();
+    shards.clear();
+    pool.stop();
+    metrics.stop();
     g_main_loop_unref(main_loop);
     g_object_unref(connection);
     
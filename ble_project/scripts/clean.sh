@@ -2,7 +2,7 @@
 
 echo "Cleaning BLE project..."
 
-rm -rf build/
+rm -rf build/ build-sim/
 find . -name "*.o" -delete
 find . -name "*.a" -delete
 find . -name "*.so" -delete
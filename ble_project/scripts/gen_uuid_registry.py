@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Generate core/src/ble_uuid_registry.c from the assigned-numbers YAML.
+
+The 16-bit SIG UUIDs are laid out as 256-entry pages indexed by the high
+byte of the value, so a lookup is two array loads. Vendor 128-bit UUIDs go
+into a table sorted by (hi, lo) for binary search.
+
+Usage: ./scripts/gen_uuid_registry.py   (run from the project root)
+"""
+
+import os
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DATA = os.path.join(ROOT, "core", "data")
+OUTPUT = os.path.join(ROOT, "core", "src", "ble_uuid_registry.c")
+
+SIG_SOURCES = [
+    ("declarations.yaml", "BLE_UUID_KIND_DECLARATION"),
+    ("service_uuids.yaml", "BLE_UUID_KIND_SERVICE"),
+    ("characteristic_uuids.yaml", "BLE_UUID_KIND_CHARACTERISTIC"),
+    ("descriptors.yaml", "BLE_UUID_KIND_DESCRIPTOR"),
+]
+
+VENDOR_KINDS = {
+    "service": "BLE_UUID_KIND_SERVICE",
+    "characteristic": "BLE_UUID_KIND_CHARACTERISTIC",
+    "descriptor": "BLE_UUID_KIND_DESCRIPTOR",
+}
+
+
+def read_entries(path):
+    """Minimal reader for the flat `uuids: - key: value` YAML layout."""
+    entries = []
+    with open(path) as f:
+        for raw in f:
+            line = raw.split("#", 1)[0].rstrip()
+            if not line.strip() or line.strip() == "uuids:":
+                continue
+            stripped = line.strip()
+            if stripped.startswith("- "):
+                entries.append({})
+                stripped = stripped[2:]
+            key, _, value = stripped.partition(":")
+            entries[-1][key.strip()] = value.strip()
+    return entries
+
+
+def c_string(s):
+    return '"' + s.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def main():
+    sig = {}
+    for filename, kind in SIG_SOURCES:
+        for e in read_entries(os.path.join(DATA, filename)):
+            value = int(e["uuid"], 16)
+            if value in sig:
+                sys.exit("duplicate UUID 0x%04X in %s" % (value, filename))
+            sig[value] = (e["name"], kind)
+
+    vendor = []
+    for e in read_entries(os.path.join(DATA, "vendor_uuids.yaml")):
+        digits = e["uuid"].replace("-", "")
+        vendor.append((int(digits[:16], 16), int(digits[16:], 16),
+                       e["name"], VENDOR_KINDS[e["kind"]]))
+    vendor.sort()
+
+    values = sorted(sig)
+    pages = sorted({v >> 8 for v in values})
+
+    out = []
+    out.append("/* Generated by scripts/gen_uuid_registry.py from the YAML files in core/data. Do not edit. */")
+    out.append("")
+    out.append('#include "ble_uuid.h"')
+    out.append("")
+    out.append("#include <stddef.h>")
+    out.append("")
+    out.append("static const ble_uuid_info_t sig_info[%d] = {" % len(values))
+    for v in values:
+        name, kind = sig[v]
+        out.append("    { %s, %s },  /* 0x%04X */" % (c_string(name), kind, v))
+    out.append("};")
+    out.append("")
+
+    index = {v: i + 1 for i, v in enumerate(values)}
+    for page in pages:
+        out.append("static const uint16_t sig_page_%02x[256] = {" % page)
+        for v in values:
+            if v >> 8 == page:
+                out.append("    [0x%02X] = %d," % (v & 0xFF, index[v]))
+        out.append("};")
+        out.append("")
+
+    out.append("/* High byte of the 16-bit value -> page of 1-based sig_info indices */")
+    out.append("static const uint16_t *const sig_pages[256] = {")
+    for page in pages:
+        out.append("    [0x%02X] = sig_page_%02x," % (page, page))
+    out.append("};")
+    out.append("")
+
+    out.append("typedef struct {")
+    out.append("    ble_uuid_t uuid;")
+    out.append("    ble_uuid_info_t info;")
+    out.append("} vendor_entry_t;")
+    out.append("")
+    out.append("/* Sorted by (hi, lo) */")
+    out.append("static const vendor_entry_t vendor_info[%d] = {" % len(vendor))
+    for hi, lo, name, kind in vendor:
+        out.append("    { { 0x%016XULL, 0x%016XULL }, { %s, %s } }," % (hi, lo, c_string(name), kind))
+    out.append("};")
+    out.append("")
+
+    out.append("const ble_uuid_info_t *ble_uuid_lookup(const ble_uuid_t *uuid) {")
+    out.append("    if (ble_uuid_is_sig(uuid)) {")
+    out.append("        uint32_t value = ble_uuid_sig_value(uuid);")
+    out.append("        if (value > 0xFFFF) return NULL;")
+    out.append("        const uint16_t *page = sig_pages[value >> 8];")
+    out.append("        uint16_t idx = page ? page[value & 0xFF] : 0;")
+    out.append("        return idx ? &sig_info[idx - 1] : NULL;")
+    out.append("    }")
+    out.append("")
+    out.append("    size_t lo = 0, hi = sizeof(vendor_info) / sizeof(vendor_info[0]);")
+    out.append("    while (lo < hi) {")
+    out.append("        size_t mid = (lo + hi) / 2;")
+    out.append("        int c = ble_uuid_cmp(uuid, &vendor_info[mid].uuid);")
+    out.append("        if (c == 0) return &vendor_info[mid].info;")
+    out.append("        if (c < 0) hi = mid; else lo = mid + 1;")
+    out.append("    }")
+    out.append("    return NULL;")
+    out.append("}")
+
+    with open(OUTPUT, "w") as f:
+        f.write("\n".join(out) + "\n")
+    print("wrote %s (%d SIG UUIDs in %d pages, %d vendor UUIDs)"
+          % (os.path.relpath(OUTPUT, ROOT), len(values), len(pages), len(vendor)))
+
+
+if __name__ == "__main__":
+    main()
@@ -1,18 +1,110 @@
 #!/bin/bash
+#
+# Starts a private dbus-daemon with mock_bluez on it, registers
+# simple_peripheral against the mock and load-tests it with ble_bench,
+# sharded over two mock adapters and with handler workers.
+# Needs neither a Bluetooth controller nor root. Extra arguments go to
+# ble_bench, e.g. --max-p99 5 --min-rate 20000 to fail on a regression.
 
 set -e
 
+cd "$(dirname "$0")/.."
+BIN=build/bin
+
 echo "Running BLE project tests..."
 
-if [ ! -d "build" ]; then
-    echo "Build directory not found. Building project..."
-    make build
+if [ ! -x "$BIN/mock_bluez" ] || [ ! -x "$BIN/simple_peripheral" ] || [ ! -x "$BIN/ble_bench" ] || [ ! -x "$BIN/handler_pool_bench" ]; then
+    echo "Building peripheral examples, tools and benchmarks..."
+    mkdir -p build && (cd build && cmake -DBUILD_CENTRAL=OFF -DBUILD_BENCHMARKS=ON .. && make)
 fi
 
-echo "Testing central examples..."
-cd build/central/examples 2>/dev/null || echo "Central examples not built"
+WORK_DIR=$(mktemp -d)
+PIDS=()
+
+cleanup() {
+    for pid in "${PIDS[@]}"; do kill "$pid" 2>/dev/null || true; done
+    wait 2>/dev/null || true
+    rm -rf "$WORK_DIR"
+}
+trap cleanup EXIT
+
+# Waits up to 5 s for a line matching $2 in log file $1
+wait_for() {
+    for _ in $(seq 50); do
+        grep -q "$2" "$1" 2>/dev/null && return 0
+        sleep 0.1
+    done
+    echo "Timed out waiting for '$2' in $(basename "$1"):"
+    cat "$1"
+    return 1
+}
+
+export BLE_DBUS_ADDRESS="unix:path=$WORK_DIR/bus"
+
+echo "Starting private bus and mock BlueZ..."
+dbus-daemon --session --nofork --address="$BLE_DBUS_ADDRESS" > "$WORK_DIR/dbus.log" 2>&1 &
+PIDS+=($!)
+for _ in $(seq 50); do [ -S "$WORK_DIR/bus" ] && break; sleep 0.1; done
+
+"$BIN/mock_bluez" > "$WORK_DIR/mock_bluez.log" 2>&1 &
+PIDS+=($!)
+wait_for "$WORK_DIR/mock_bluez.log" "Mock BlueZ ready"
 
 echo "Testing peripheral examples..."
-cd ../../peripheral/examples 2>/dev/null || echo "Peripheral examples not built"
+"$BIN/simple_peripheral" > "$WORK_DIR/simple_peripheral.log" 2>&1 &
+PIDS+=($!)
+wait_for "$WORK_DIR/mock_bluez.log" "GattManager1: registered"
+wait_for "$WORK_DIR/mock_bluez.log" "LEAdvertisingManager1: registered"
+
+echo "Load-testing simple_peripheral..."
+if ! "$BIN/ble_bench" "$@"; then
+    echo "ble_bench failed; mock_bluez log:"
+    cat "$WORK_DIR/mock_bluez.log"
+    exit 1
+fi
+
+echo "Testing adapter sharding..."
+kill "${PIDS[@]:1}" 2>/dev/null || true
+wait "${PIDS[@]:1}" 2>/dev/null || true
+PIDS=("${PIDS[0]}")
+
+"$BIN/mock_bluez" --adapters 2 > "$WORK_DIR/mock_bluez_pool.log" 2>&1 &
+PIDS+=($!)
+wait_for "$WORK_DIR/mock_bluez_pool.log" "Mock BlueZ ready"
+
+"$BIN/simple_peripheral" --adapters all > "$WORK_DIR/simple_peripheral_pool.log" 2>&1 &
+PIDS+=($!)
+for adapter in hci0 hci1; do
+    wait_for "$WORK_DIR/mock_bluez_pool.log" "LEAdvertisingManager1: registered .* on $adapter"
+done
+
+for adapter in hci0 hci1; do
+    if ! BLE_ADAPTER=$adapter "$BIN/ble_bench" --calls 5000; then
+        echo "ble_bench failed on $adapter; mock_bluez log:"
+        cat "$WORK_DIR/mock_bluez_pool.log"
+        exit 1
+    fi
+done
+
+echo "Testing handler workers..."
+kill "${PIDS[@]:1}" 2>/dev/null || true
+wait "${PIDS[@]:1}" 2>/dev/null || true
+PIDS=("${PIDS[0]}")
+
+"$BIN/mock_bluez" > "$WORK_DIR/mock_bluez_workers.log" 2>&1 &
+PIDS+=($!)
+wait_for "$WORK_DIR/mock_bluez_workers.log" "Mock BlueZ ready"
+
+# Deep enough for ble_bench's 1000 calls in flight; a shallower queue rejects
+"$BIN/simple_peripheral" --workers 4 --queue-depth 1000 > "$WORK_DIR/simple_peripheral_workers.log" 2>&1 &
+PIDS+=($!)
+wait_for "$WORK_DIR/mock_bluez_workers.log" "LEAdvertisingManager1: registered"
+
+if ! "$BIN/ble_bench" --calls 20000; then
+    echo "ble_bench failed with handler workers; mock_bluez log:"
+    cat "$WORK_DIR/mock_bluez_workers.log"
+    exit 1
+fi
+"$BIN/handler_pool_bench"
 
 echo "All tests completed!"
@@ -0,0 +1,141 @@
+#ifndef GATTLIB_H
+#define GATTLIB_H
+
+/*
+ * gattlib 0.7 API subset implemented by the simulated backend
+ * (-DGATTLIB_BACKEND=sim). Types, constants and signatures match the real
+ * header, so the central code builds unchanged against either.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GATTLIB_SUCCESS                 0
+#define GATTLIB_INVALID_PARAMETER       1
+#define GATTLIB_NOT_FOUND               2
+#define GATTLIB_TIMEOUT                 3
+#define GATTLIB_OUT_OF_MEMORY           4
+#define GATTLIB_NOT_SUPPORTED           5
+#define GATTLIB_DEVICE_ERROR            6
+#define GATTLIB_DEVICE_NOT_CONNECTED    7
+#define GATTLIB_NO_ADAPTER              8
+#define GATTLIB_BUSY                    9
+#define GATTLIB_UNEXPECTED              10
+#define GATTLIB_ADAPTER_CLOSE           11
+#define GATTLIB_DEVICE_DISCONNECTED     12
+
+#define GATTLIB_CONNECTION_OPTIONS_NONE 0
+
+#define GATTLIB_CHARACTERISTIC_BROADCAST            0x01
+#define GATTLIB_CHARACTERISTIC_READ                 0x02
+#define GATTLIB_CHARACTERISTIC_WRITE_WITHOUT_RESP   0x04
+#define GATTLIB_CHARACTERISTIC_WRITE                0x08
+#define GATTLIB_CHARACTERISTIC_NOTIFY               0x10
+#define GATTLIB_CHARACTERISTIC_INDICATE             0x20
+
+#define SDP_UUID16  0x19
+#define SDP_UUID32  0x1A
+#define SDP_UUID128 0x1C
+
+#define MAX_LEN_UUID_STR 37
+
+typedef struct {
+    uint8_t data[16];
+} uint128_t;
+
+typedef struct {
+    uint8_t type;
+    union {
+        uint16_t uuid16;
+        uint32_t uuid32;
+        uint128_t uuid128;      /* Big-endian */
+    } value;
+} uuid_t;
+
+typedef struct _gattlib_adapter gattlib_adapter_t;
+typedef struct _gattlib_connection gattlib_connection_t;
+
+typedef struct {
+    uint16_t attr_handle_start;
+    uint16_t attr_handle_end;
+    uuid_t uuid;
+} gattlib_primary_service_t;
+
+typedef struct {
+    uint16_t handle;
+    uint8_t properties;
+    uint16_t value_handle;
+    uuid_t uuid;
+} gattlib_characteristic_t;
+
+typedef void (*gattlib_discovered_device_t)(gattlib_adapter_t *adapter, const char *addr,
+                                            const char *name, void *user_data);
+typedef void (*gatt_connect_cb_t)(gattlib_adapter_t *adapter, const char *dst,
+                                  gattlib_connection_t *connection, int error, void *user_data);
+typedef void (*gattlib_disconnection_handler_t)(gattlib_connection_t *connection, void *user_data);
+typedef void (*gattlib_event_handler_t)(const uuid_t *uuid, const uint8_t *data,
+                                        size_t data_length, void *user_data);
+
+/* Adapter and scanning */
+int gattlib_adapter_open(const char *adapter_name, gattlib_adapter_t **adapter);
+const char *gattlib_adapter_get_name(gattlib_adapter_t *adapter);
+int gattlib_adapter_close(gattlib_adapter_t *adapter);
+int gattlib_adapter_scan_enable(gattlib_adapter_t *adapter, gattlib_discovered_device_t discovered_device_cb,
+                                size_t timeout, void *user_data);
+int gattlib_adapter_scan_disable(gattlib_adapter_t *adapter);
+int gattlib_get_rssi_from_mac(gattlib_adapter_t *adapter, const char *mac_address, int16_t *rssi);
+
+/* Connections */
+int gattlib_connect(gattlib_adapter_t *adapter, const char *dst, unsigned long options,
+                    gatt_connect_cb_t connect_cb, void *user_data);
+int gattlib_disconnect(gattlib_connection_t *connection, bool wait_disconnection);
+int gattlib_register_on_disconnect(gattlib_connection_t *connection,
+                                   gattlib_disconnection_handler_t handler, void *user_data);
+
+/* Discovery; free the returned arrays with free() */
+int gattlib_discover_primary(gattlib_connection_t *connection, gattlib_primary_service_t **services,
+                             int *services_count);
+int gattlib_discover_char(gattlib_connection_t *connection, gattlib_characteristic_t **characteristics,
+                          int *characteristics_count);
+
+/* Reads and writes */
+int gattlib_read_char_by_uuid(gattlib_connection_t *connection, uuid_t *uuid, void **buffer,
+                              size_t *buffer_len);
+void gattlib_characteristic_free_value(void *ptr);
+int gattlib_write_char_by_uuid(gattlib_connection_t *connection, uuid_t *uuid, const void *buffer,
+                               size_t buffer_len);
+int gattlib_write_char_by_handle(gattlib_connection_t *connection, uint16_t handle, const void *buffer,
+                                 size_t buffer_len);
+int gattlib_write_without_response_char_by_uuid(gattlib_connection_t *connection, uuid_t *uuid,
+                                                const void *buffer, size_t buffer_len);
+int gattlib_write_without_response_char_by_handle(gattlib_connection_t *connection, uint16_t handle,
+                                                  const void *buffer, size_t buffer_len);
+
+/* Notifications */
+int gattlib_notification_start(gattlib_connection_t *connection, const uuid_t *uuid);
+int gattlib_notification_stop(gattlib_connection_t *connection, const uuid_t *uuid);
+int gattlib_register_notification(gattlib_connection_t *connection,
+                                  gattlib_event_handler_t notification_handler, void *user_data);
+
+/* Link */
+int gattlib_get_rssi(gattlib_connection_t *connection, int16_t *rssi);
+int gattlib_get_mtu(gattlib_connection_t *connection, uint16_t *mtu);
+
+/* Runs task(arg) to completion; simulator callbacks come from its own thread */
+int gattlib_mainloop(void *(*task)(void *arg), void *arg);
+
+/* UUID helpers */
+int gattlib_string_to_uuid(const char *str, size_t size, uuid_t *uuid);
+int gattlib_uuid_to_string(const uuid_t *uuid, char *str, size_t size);
+int gattlib_uuid_cmp(const uuid_t *uuid1, const uuid_t *uuid2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
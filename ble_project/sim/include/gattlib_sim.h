@@ -0,0 +1,82 @@
+#ifndef GATTLIB_SIM_H
+#define GATTLIB_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Control interface of the simulated gattlib backend. Device i has the
+ * static random address C0:00:00:xx:xx:xx (i in the low 24 bits) and the
+ * name "Sim-<i>". Every random choice (advertising phase, connect latency,
+ * injected failures) comes from a per-device generator seeded from seed and
+ * the device index, so a run is reproducible for a given configuration.
+ *
+ * Configure before gattlib_adapter_open(). Without an explicit
+ * configuration the adapter loads $GATTLIB_SIM_CONFIG if set, otherwise the
+ * defaults below.
+ */
+
+#define GATTLIB_SIM_CONFIG_ENV "GATTLIB_SIM_CONFIG"
+
+typedef struct {
+    unsigned devices;               /* Virtual devices (default 1000) */
+    unsigned adv_interval_ms;       /* Per device, plus 0-10 ms advDelay; 0 floods (default 100) */
+    unsigned connect_latency_ms;    /* Connection setup time (default 30) */
+    unsigned connect_jitter_ms;     /* Added uniformly at random (default 20) */
+    unsigned att_latency_us;        /* Read/write request round trip (default 0) */
+    unsigned notify_interval_ms;    /* Per subscribed characteristic; 0 disables (default 100) */
+    uint16_t mtu;                   /* Negotiated ATT_MTU (default 247) */
+    double connect_failure_rate;    /* Share of connects failing with GATTLIB_TIMEOUT */
+    double att_failure_rate;        /* Share of reads/writes failing with GATTLIB_DEVICE_ERROR */
+    double link_loss_per_s;         /* Per connection; delivered to the disconnect handler */
+    uint64_t seed;                  /* Default 1 */
+} gattlib_sim_config_t;
+
+typedef struct {
+    uint64_t adverts;
+    uint64_t connects;
+    uint64_t connect_failures;
+    uint64_t link_losses;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t att_failures;
+    uint64_t notifications;
+} gattlib_sim_stats_t;
+
+void gattlib_sim_config_default(gattlib_sim_config_t *config);
+
+/* Replaces the configuration; fails with GATTLIB_BUSY while an adapter is open */
+int gattlib_sim_configure(const gattlib_sim_config_t *config);
+
+/*
+ * Reads "key = value" lines ('#' starts a comment). Keys are the config
+ * field names plus "service = UUID" and "characteristic = UUID FLAGS [HEX]"
+ * (FLAGS: comma-separated read, write, write-without-response, notify,
+ * indicate), which replace the default GATT table.
+ */
+int gattlib_sim_load_config(const char *path);
+
+/*
+ * GATT table shared by all devices. The default has GAP (Device Name),
+ * GATT (Database Hash), Battery, Heart Rate and the Nordic UART Service.
+ * Characteristics go into the most recently added service.
+ */
+void gattlib_sim_clear_services(void);
+int gattlib_sim_add_service(const char *uuid);
+int gattlib_sim_add_characteristic(const char *uuid, uint8_t properties,
+                                   const void *value, size_t len);
+
+/* "C0:00:00:xx:xx:xx" for device index; out holds 18 bytes */
+void gattlib_sim_device_address(unsigned index, char *out);
+
+void gattlib_sim_get_stats(gattlib_sim_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1053 @@
+#include "gattlib.h"
+#include "gattlib_sim.h"
+
+#include "ble_addr.h"
+#include "ble_common.h"
+#include "ble_gattlib.hpp"
+#include "ble_nus_stream.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct _gattlib_adapter {
+    char name[8];
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint64_t kAddressBase = 0xC00000000000ULL;   // static random, index in the low 24 bits
+constexpr unsigned kMaxDevices = 1u << 24;
+constexpr uint64_t kAdvDelayMaxNs = 10000000;           // advDelay, Core Vol 6 Part B 4.4.2.2.1
+constexpr size_t kMaxValueLen = 512;
+constexpr ble_uuid_t kDeviceName = ble::uuid16(0x2A00);
+constexpr ble_uuid_t kDatabaseHash = ble::uuid16(0x2B2A);
+constexpr ble_uuid_t kHeartRateMeasurement = ble::uuid16(0x2A37);
+
+uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+}
+
+// splitmix64; one per device so its choices do not depend on thread timing
+struct Rng {
+    uint64_t state;
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    double uniform() { return (double)(next() >> 11) * 0x1.0p-53; }
+    uint64_t below(uint64_t n) { return n ? next() % n : 0; }
+};
+
+struct SimService {
+    ble_uuid_t uuid;
+    uint16_t start_handle;
+    uint16_t end_handle;
+};
+
+struct SimCharacteristic {
+    ble_uuid_t uuid;
+    uuid_t gattlib_uuid;
+    size_t service;
+    uint8_t properties;
+    uint16_t handle;
+    uint16_t value_handle;
+    bool periodic;                  ///< Notifies on its own; NUS TX only echoes
+    std::vector<uint8_t> value;     ///< Initial value
+};
+
+enum class EventType : uint8_t { Advert, Connect, Notify, Echo, LinkLoss };
+
+struct Event {
+    uint64_t when;
+    uint64_t order;                 ///< Tie-break so equal times replay in push order
+    uint64_t generation;
+    uint32_t device;
+    EventType type;
+    uint16_t characteristic;
+};
+
+struct Later {
+    bool operator()(const Event& a, const Event& b) const {
+        return a.when != b.when ? a.when > b.when : a.order > b.order;
+    }
+};
+
+}  // namespace
+
+// A virtual device doubles as its (single) connection handle. It outlives
+// every connection, so handles held by the caller never dangle; calls on a
+// disconnected handle fail with GATTLIB_DEVICE_NOT_CONNECTED.
+struct _gattlib_connection {
+    uint32_t index;
+    char address[BLE_ADDR_SIZE];
+    char name[16];
+    Rng rng;
+
+    bool connecting = false;
+    bool connected = false;
+    uint64_t generation = 0;        ///< Bumped on connect and disconnect; stale events drop
+    gatt_connect_cb_t connect_cb = nullptr;
+    void* connect_data = nullptr;
+    gattlib_disconnection_handler_t on_disconnect = nullptr;
+    void* disconnect_data = nullptr;
+    gattlib_event_handler_t on_notify = nullptr;
+    void* notify_data = nullptr;
+
+    std::vector<std::vector<uint8_t>> values;   ///< Per characteristic; kept across connections
+    std::vector<uint8_t> subscribed;
+    std::vector<uint16_t> sequence;
+    std::deque<std::vector<uint8_t>> echo;      ///< NUS RX writes waiting to go out on TX
+};
+
+namespace {
+
+using Device = _gattlib_connection;
+
+struct Sim {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable scan_done;
+
+    gattlib_sim_config_t config;
+    bool configured = false;
+
+    std::vector<SimService> services;
+    std::vector<SimCharacteristic> characteristics;
+    std::array<uint8_t, 16> hash;
+
+    std::vector<std::unique_ptr<Device>> devices;
+    std::priority_queue<Event, std::vector<Event>, Later> events;
+    uint64_t next_order = 0;
+
+    std::thread thread;
+    bool running = false;
+    unsigned open_count = 0;
+
+    bool scanning = false;
+    uint64_t scan_generation = 0;
+    gattlib_discovered_device_t scan_cb = nullptr;
+    void* scan_data = nullptr;
+    unsigned scan_callbacks = 0;    ///< Scan callbacks running right now
+    size_t flood_next = 0;
+
+    std::atomic<uint64_t> adverts{0};
+    std::atomic<uint64_t> connects{0};
+    std::atomic<uint64_t> connect_failures{0};
+    std::atomic<uint64_t> link_losses{0};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> writes{0};
+    std::atomic<uint64_t> att_failures{0};
+    std::atomic<uint64_t> notifications{0};
+};
+
+Sim& sim() {
+    static Sim s;
+    return s;
+}
+
+_gattlib_adapter g_adapter = {"sim0"};
+
+void push(Sim& s, uint64_t when, EventType type, const Device& d, uint16_t characteristic = 0) {
+    s.events.push(Event{when, s.next_order++, d.generation, d.index, type, characteristic});
+}
+
+// =============================================================================
+// GATT table
+// =============================================================================
+
+bool add_service(Sim& s, const ble_uuid_t& uuid) {
+    s.services.push_back(SimService{uuid, 0, 0});
+    return true;
+}
+
+bool add_characteristic(Sim& s, const ble_uuid_t& uuid, uint8_t properties,
+                        const void* value, size_t len) {
+    if (s.services.empty()) return false;
+    SimCharacteristic c;
+    c.uuid = uuid;
+    c.gattlib_uuid = ble::to_gattlib(uuid);
+    c.service = s.services.size() - 1;
+    c.properties = properties;
+    c.handle = c.value_handle = 0;
+    c.periodic = !ble_uuid_equal(&uuid, &ble::kNusTx);
+    const uint8_t* p = static_cast<const uint8_t*>(value);
+    c.value.assign(p, p + std::min(len, kMaxValueLen));
+    s.characteristics.push_back(std::move(c));
+    return true;
+}
+
+void default_table(Sim& s) {
+    const uint8_t battery = 100, body_sensor_location = 1;
+    const uint8_t rw_nr = GATTLIB_CHARACTERISTIC_WRITE | GATTLIB_CHARACTERISTIC_WRITE_WITHOUT_RESP;
+    s.services.clear();
+    s.characteristics.clear();
+    add_service(s, ble::uuid16(0x1800));
+    add_characteristic(s, kDeviceName, GATTLIB_CHARACTERISTIC_READ, nullptr, 0);
+    add_service(s, ble::uuid16(0x1801));
+    add_characteristic(s, kDatabaseHash, GATTLIB_CHARACTERISTIC_READ, nullptr, 0);
+    add_service(s, ble::uuid16(0x180F));
+    add_characteristic(s, ble::uuid16(0x2A19),
+                       GATTLIB_CHARACTERISTIC_READ | GATTLIB_CHARACTERISTIC_NOTIFY, &battery, 1);
+    add_service(s, ble::uuid16(0x180D));
+    add_characteristic(s, kHeartRateMeasurement, GATTLIB_CHARACTERISTIC_NOTIFY,
+                       nullptr, 0);
+    add_characteristic(s, ble::uuid16(0x2A38), GATTLIB_CHARACTERISTIC_READ,
+                       &body_sensor_location, 1);
+    add_service(s, ble::kNusService);
+    add_characteristic(s, ble::kNusRx, rw_nr, nullptr, 0);
+    add_characteristic(s, ble::kNusTx, GATTLIB_CHARACTERISTIC_NOTIFY, nullptr, 0);
+}
+
+// Declaration, value and (for notify/indicate) CCCD handle per characteristic
+void assign_handles(Sim& s) {
+    uint16_t handle = 1;
+    uint64_t h1 = 0xCBF29CE484222325ULL, h2 = 0x84222325CBF29CE4ULL;
+    auto mix = [&](uint64_t v) {
+        h1 = (h1 ^ v) * 0x100000001B3ULL;
+        h2 = (h2 ^ (v + 0x9E37)) * 0x100000001B3ULL;
+    };
+    for (size_t i = 0; i < s.services.size(); i++) {
+        SimService& service = s.services[i];
+        service.start_handle = handle++;
+        mix(service.uuid.hi);
+        mix(service.uuid.lo);
+        for (SimCharacteristic& c : s.characteristics) {
+            if (c.service != i) continue;
+            c.handle = handle++;
+            c.value_handle = handle++;
+            if (c.properties & (GATTLIB_CHARACTERISTIC_NOTIFY | GATTLIB_CHARACTERISTIC_INDICATE)) {
+                handle++;
+            }
+            mix(c.uuid.hi);
+            mix(c.uuid.lo ^ c.properties);
+        }
+        service.end_handle = handle - 1;
+    }
+    memcpy(&s.hash[0], &h1, 8);
+    memcpy(&s.hash[8], &h2, 8);
+}
+
+void build_devices(Sim& s) {
+    if (s.devices.size() != s.config.devices) {
+        s.devices.clear();
+        for (unsigned i = 0; i < s.config.devices; i++) {
+            std::unique_ptr<Device> d(new Device);
+            d->index = i;
+            gattlib_sim_device_address(i, d->address);
+            snprintf(d->name, sizeof(d->name), "Sim-%05u", i);
+            s.devices.push_back(std::move(d));
+        }
+    }
+    for (auto& d : s.devices) {
+        d->rng.state = s.config.seed * 0x9E3779B97F4A7C15ULL + d->index;
+        d->connecting = d->connected = false;
+        d->values.clear();
+        for (const SimCharacteristic& c : s.characteristics) d->values.push_back(c.value);
+        d->subscribed.assign(s.characteristics.size(), 0);
+        d->sequence.assign(s.characteristics.size(), 0);
+        d->echo.clear();
+    }
+}
+
+// =============================================================================
+// Scheduler thread (all callbacks run here, like gattlib's main loop)
+// =============================================================================
+
+size_t notification_payload(Sim& s, Device& d, size_t c, uint8_t* out) {
+    const SimCharacteristic& chr = s.characteristics[c];
+    size_t max = s.config.mtu > 3 ? s.config.mtu - 3u : 20;
+
+    if (ble_uuid_equal(&chr.uuid, &kHeartRateMeasurement)) {
+        // 8-bit BPM with two RR intervals
+        uint8_t bpm = (uint8_t)(60 + d.rng.below(40));
+        uint16_t rr = (uint16_t)(60 * 1024 / bpm + d.rng.below(40));
+        uint8_t hrm[] = {0x10, bpm, (uint8_t)rr, (uint8_t)(rr >> 8),
+                         (uint8_t)(rr + 7), (uint8_t)((rr + 7) >> 8)};
+        memcpy(out, hrm, sizeof(hrm));
+        return sizeof(hrm);
+    }
+
+    // 16-bit little-endian sequence number, then the current value
+    uint16_t seq = d.sequence[c]++;
+    out[0] = (uint8_t)seq;
+    out[1] = (uint8_t)(seq >> 8);
+    size_t len = std::min(d.values[c].size(), max - 2);
+    memcpy(out + 2, d.values[c].data(), len);
+    return len + 2;
+}
+
+void deliver(std::unique_lock<std::mutex>& lock, Sim& s, Device& d, size_t c,
+             const uint8_t* data, size_t len) {
+    gattlib_event_handler_t handler = d.on_notify;
+    void* user_data = d.notify_data;
+    if (!handler) return;
+    s.notifications.fetch_add(1, std::memory_order_relaxed);
+    lock.unlock();
+    handler(&s.characteristics[c].gattlib_uuid, data, len, user_data);
+    lock.lock();
+}
+
+void emit_advert(std::unique_lock<std::mutex>& lock, Sim& s, Device& d) {
+    gattlib_discovered_device_t cb = s.scan_cb;
+    void* user_data = s.scan_data;
+    s.scan_callbacks++;
+    s.adverts.fetch_add(1, std::memory_order_relaxed);
+    lock.unlock();
+    cb(&g_adapter, d.address, d.name, user_data);
+    lock.lock();
+    if (--s.scan_callbacks == 0 && !s.scanning) s.scan_done.notify_all();
+}
+
+void dispatch(std::unique_lock<std::mutex>& lock, Sim& s, const Event& e) {
+    Device& d = *s.devices[e.device];
+    uint8_t payload[kMaxValueLen];
+
+    switch (e.type) {
+    case EventType::Advert: {
+        if (!s.scanning || e.generation != s.scan_generation) return;
+        uint64_t interval = s.config.adv_interval_ms * 1000000ULL;
+        s.events.push(Event{e.when + interval + d.rng.below(kAdvDelayMaxNs), s.next_order++,
+                            e.generation, e.device, EventType::Advert, 0});
+        emit_advert(lock, s, d);
+        return;
+    }
+    case EventType::Connect: {
+        if (!d.connecting || e.generation != d.generation) return;
+        d.connecting = false;
+        gatt_connect_cb_t cb = d.connect_cb;
+        void* user_data = d.connect_data;
+        if (d.rng.uniform() < s.config.connect_failure_rate) {
+            s.connect_failures.fetch_add(1, std::memory_order_relaxed);
+            lock.unlock();
+            cb(&g_adapter, d.address, nullptr, GATTLIB_TIMEOUT, user_data);
+            lock.lock();
+            return;
+        }
+        d.connected = true;
+        d.generation++;
+        d.on_disconnect = nullptr;
+        d.on_notify = nullptr;
+        s.connects.fetch_add(1, std::memory_order_relaxed);
+        if (s.config.link_loss_per_s > 0) {
+            double after_s = -std::log(1.0 - d.rng.uniform()) / s.config.link_loss_per_s;
+            push(s, now_ns() + (uint64_t)(after_s * 1e9), EventType::LinkLoss, d);
+        }
+        lock.unlock();
+        cb(&g_adapter, d.address, &d, GATTLIB_SUCCESS, user_data);
+        lock.lock();
+        return;
+    }
+    case EventType::Notify: {
+        if (!d.connected || e.generation != d.generation || !d.subscribed[e.characteristic]) return;
+        push(s, e.when + s.config.notify_interval_ms * 1000000ULL, EventType::Notify, d,
+             e.characteristic);
+        size_t len = notification_payload(s, d, e.characteristic, payload);
+        deliver(lock, s, d, e.characteristic, payload, len);
+        return;
+    }
+    case EventType::Echo: {
+        if (!d.connected || e.generation != d.generation || d.echo.empty()) return;
+        std::vector<uint8_t> chunk = std::move(d.echo.front());
+        d.echo.pop_front();
+        if (d.subscribed[e.characteristic]) {
+            deliver(lock, s, d, e.characteristic, chunk.data(), chunk.size());
+        }
+        return;
+    }
+    case EventType::LinkLoss: {
+        if (!d.connected || e.generation != d.generation) return;
+        d.connected = false;
+        d.generation++;
+        std::fill(d.subscribed.begin(), d.subscribed.end(), 0);
+        d.echo.clear();
+        gattlib_disconnection_handler_t handler = d.on_disconnect;
+        void* user_data = d.disconnect_data;
+        s.link_losses.fetch_add(1, std::memory_order_relaxed);
+        if (handler) {
+            lock.unlock();
+            handler(&d, user_data);
+            lock.lock();
+        }
+        return;
+    }
+    }
+}
+
+void run(Sim& s) {
+    std::unique_lock<std::mutex> lock(s.mutex);
+    while (s.running) {
+        // Flood mode: advertise round-robin as fast as the callback returns
+        bool flood = s.scanning && s.config.adv_interval_ms == 0 && !s.devices.empty();
+        if (flood) {
+            emit_advert(lock, s, *s.devices[s.flood_next++ % s.devices.size()]);
+        }
+
+        if (s.events.empty()) {
+            if (!flood) s.wake.wait(lock);
+            continue;
+        }
+        Event e = s.events.top();
+        if (e.when > now_ns()) {
+            if (!flood) s.wake.wait_until(lock, Clock::time_point(std::chrono::nanoseconds(e.when)));
+            continue;
+        }
+        s.events.pop();
+        dispatch(lock, s, e);
+    }
+}
+
+// =============================================================================
+// Helpers for the synchronous (ATT) calls
+// =============================================================================
+
+ssize_t find_characteristic(const Sim& s, const uuid_t* uuid) {
+    ble_uuid_t u = ble::from_gattlib(*uuid);
+    for (size_t i = 0; i < s.characteristics.size(); i++) {
+        if (ble_uuid_equal(&s.characteristics[i].uuid, &u)) return (ssize_t)i;
+    }
+    return -1;
+}
+
+ssize_t find_characteristic(const Sim& s, uint16_t handle) {
+    for (size_t i = 0; i < s.characteristics.size(); i++) {
+        if (s.characteristics[i].value_handle == handle) return (ssize_t)i;
+    }
+    return -1;
+}
+
+// Waits out one request/response round trip, then checks the link and rolls
+// for an injected failure. Returns with the lock held on success.
+int begin_request(Sim& s, Device* d, std::unique_lock<std::mutex>& lock, unsigned round_trips = 1) {
+    unsigned latency_us = 0;
+    {
+        std::lock_guard<std::mutex> guard(s.mutex);
+        latency_us = s.config.att_latency_us;
+    }
+    if (latency_us) std::this_thread::sleep_for(std::chrono::microseconds(latency_us * round_trips));
+
+    lock = std::unique_lock<std::mutex>(s.mutex);
+    if (!d->connected) return GATTLIB_DEVICE_NOT_CONNECTED;
+    if (d->rng.uniform() < s.config.att_failure_rate) {
+        s.att_failures.fetch_add(1, std::memory_order_relaxed);
+        return GATTLIB_DEVICE_ERROR;
+    }
+    return GATTLIB_SUCCESS;
+}
+
+int write_value(Device* d, ssize_t c, const void* buffer, size_t len, bool with_response) {
+    Sim& s = sim();
+    if (!d || !buffer) return GATTLIB_INVALID_PARAMETER;
+    if (c < 0) return GATTLIB_NOT_FOUND;
+    uint8_t needed = with_response ? GATTLIB_CHARACTERISTIC_WRITE
+                                   : GATTLIB_CHARACTERISTIC_WRITE_WITHOUT_RESP;
+    if (!(s.characteristics[c].properties & needed)) return GATTLIB_NOT_SUPPORTED;
+
+    std::unique_lock<std::mutex> lock;
+    if (with_response) {
+        int ret = begin_request(s, d, lock);
+        if (ret != GATTLIB_SUCCESS) return ret;
+    } else {
+        // Write commands have no response and cannot fail remotely
+        lock = std::unique_lock<std::mutex>(s.mutex);
+        if (!d->connected) return GATTLIB_DEVICE_NOT_CONNECTED;
+    }
+
+    const uint8_t* p = static_cast<const uint8_t*>(buffer);
+    d->values[c].assign(p, p + std::min(len, kMaxValueLen));
+    s.writes.fetch_add(1, std::memory_order_relaxed);
+
+    // NUS loopback: RX writes come back as TX notifications
+    if (ble_uuid_equal(&s.characteristics[c].uuid, &ble::kNusRx)) {
+        uuid_t tx = ble::to_gattlib(ble::kNusTx);
+        ssize_t t = find_characteristic(s, &tx);
+        if (t >= 0 && d->subscribed[t]) {
+            size_t chunk = s.config.mtu > 3 ? s.config.mtu - 3u : 20;
+            for (size_t off = 0; off < len; off += chunk) {
+                d->echo.emplace_back(p + off, p + std::min(len, off + chunk));
+                push(s, now_ns(), EventType::Echo, *d, (uint16_t)t);
+            }
+            s.wake.notify_one();
+        }
+    }
+    return GATTLIB_SUCCESS;
+}
+
+bool parse_properties(const char* str, uint8_t* out) {
+    static const struct { const char* name; uint8_t bit; } kFlags[] = {
+        {"broadcast", GATTLIB_CHARACTERISTIC_BROADCAST},
+        {"read", GATTLIB_CHARACTERISTIC_READ},
+        {"write-without-response", GATTLIB_CHARACTERISTIC_WRITE_WITHOUT_RESP},
+        {"write", GATTLIB_CHARACTERISTIC_WRITE},
+        {"notify", GATTLIB_CHARACTERISTIC_NOTIFY},
+        {"indicate", GATTLIB_CHARACTERISTIC_INDICATE},
+    };
+    *out = 0;
+    std::string flags(str);
+    size_t pos = 0;
+    while (pos <= flags.size()) {
+        size_t end = flags.find(',', pos);
+        if (end == std::string::npos) end = flags.size();
+        std::string flag = flags.substr(pos, end - pos);
+        bool known = false;
+        for (const auto& f : kFlags) {
+            if (flag == f.name) {
+                *out |= f.bit;
+                known = true;
+            }
+        }
+        if (!known) return false;
+        pos = end + 1;
+    }
+    return true;
+}
+
+bool parse_hex_value(const char* str, std::vector<uint8_t>* out) {
+    size_t len = strlen(str);
+    if (len % 2) return false;
+    for (size_t i = 0; i < len; i += 2) {
+        char byte[3] = {str[i], str[i + 1], 0};
+        char* end;
+        unsigned long v = strtoul(byte, &end, 16);
+        if (*end) return false;
+        out->push_back((uint8_t)v);
+    }
+    return true;
+}
+
+}  // namespace
+
+// =============================================================================
+// Simulator control
+// =============================================================================
+
+extern "C" {
+
+void gattlib_sim_config_default(gattlib_sim_config_t* config) {
+    memset(config, 0, sizeof(*config));
+    config->devices = 1000;
+    config->adv_interval_ms = 100;
+    config->connect_latency_ms = 30;
+    config->connect_jitter_ms = 20;
+    config->notify_interval_ms = 100;
+    config->mtu = 247;
+    config->seed = 1;
+}
+
+int gattlib_sim_configure(const gattlib_sim_config_t* config) {
+    Sim& s = sim();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.open_count) return GATTLIB_BUSY;
+    if (config->devices > kMaxDevices) return GATTLIB_INVALID_PARAMETER;
+    s.config = *config;
+    s.configured = true;
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_sim_load_config(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return GATTLIB_NOT_FOUND;
+
+    gattlib_sim_config_t config;
+    gattlib_sim_config_default(&config);
+    bool custom_table = false;
+    int ret = GATTLIB_SUCCESS;
+    char line[1024];
+    unsigned line_no = 0;
+
+    while (ret == GATTLIB_SUCCESS && fgets(line, sizeof(line), f)) {
+        line_no++;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char key[64], arg1[128], arg2[128], arg3[600];
+        int n = sscanf(line, " %63[a-z_] = %127s %127s %599s", key, arg1, arg2, arg3);
+        if (n <= 0) continue;
+        if (n < 2) {
+            ret = GATTLIB_INVALID_PARAMETER;
+            break;
+        }
+
+        if (strcmp(key, "devices") == 0) config.devices = (unsigned)atol(arg1);
+        else if (strcmp(key, "adv_interval_ms") == 0) config.adv_interval_ms = (unsigned)atol(arg1);
+        else if (strcmp(key, "connect_latency_ms") == 0) config.connect_latency_ms = (unsigned)atol(arg1);
+        else if (strcmp(key, "connect_jitter_ms") == 0) config.connect_jitter_ms = (unsigned)atol(arg1);
+        else if (strcmp(key, "att_latency_us") == 0) config.att_latency_us = (unsigned)atol(arg1);
+        else if (strcmp(key, "notify_interval_ms") == 0) config.notify_interval_ms = (unsigned)atol(arg1);
+        else if (strcmp(key, "mtu") == 0) config.mtu = (uint16_t)atol(arg1);
+        else if (strcmp(key, "connect_failure_rate") == 0) config.connect_failure_rate = atof(arg1);
+        else if (strcmp(key, "att_failure_rate") == 0) config.att_failure_rate = atof(arg1);
+        else if (strcmp(key, "link_loss_per_s") == 0) config.link_loss_per_s = atof(arg1);
+        else if (strcmp(key, "seed") == 0) config.seed = strtoull(arg1, nullptr, 0);
+        else if (strcmp(key, "service") == 0) {
+            if (!custom_table) gattlib_sim_clear_services();
+            custom_table = true;
+            ret = gattlib_sim_add_service(arg1);
+        } else if (strcmp(key, "characteristic") == 0) {
+            uint8_t properties;
+            std::vector<uint8_t> value;
+            if (n < 3 || !parse_properties(arg2, &properties) ||
+                (n == 4 && !parse_hex_value(arg3, &value))) {
+                ret = GATTLIB_INVALID_PARAMETER;
+            } else {
+                ret = gattlib_sim_add_characteristic(arg1, properties, value.data(), value.size());
+            }
+        } else {
+            ret = GATTLIB_INVALID_PARAMETER;
+        }
+    }
+    fclose(f);
+
+    if (ret != GATTLIB_SUCCESS) {
+        fprintf(stderr, "%s:%u: invalid simulator setting\n", path, line_no);
+        return ret;
+    }
+    return gattlib_sim_configure(&config);
+}
+
+void gattlib_sim_clear_services(void) {
+    Sim& s = sim();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.open_count) return;
+    s.services.clear();
+    s.characteristics.clear();
+}
+
+int gattlib_sim_add_service(const char* uuid) {
+    Sim& s = sim();
+    ble_uuid_t u;
+    if (!uuid || !ble_uuid_parse(uuid, &u)) return GATTLIB_INVALID_PARAMETER;
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.open_count) return GATTLIB_BUSY;
+    add_service(s, u);
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_sim_add_characteristic(const char* uuid, uint8_t properties,
+                                   const void* value, size_t len) {
+    Sim& s = sim();
+    ble_uuid_t u;
+    if (!uuid || !ble_uuid_parse(uuid, &u)) return GATTLIB_INVALID_PARAMETER;
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.open_count) return GATTLIB_BUSY;
+    return add_characteristic(s, u, properties, value, len) ? GATTLIB_SUCCESS : GATTLIB_INVALID_PARAMETER;
+}
+
+void gattlib_sim_device_address(unsigned index, char* out) {
+    ble_addr_format(ble_addr_make(kAddressBase | (index & (kMaxDevices - 1)), BLE_ADDR_RANDOM), out);
+}
+
+void gattlib_sim_get_stats(gattlib_sim_stats_t* stats) {
+    Sim& s = sim();
+    stats->adverts = s.adverts.load(std::memory_order_relaxed);
+    stats->connects = s.connects.load(std::memory_order_relaxed);
+    stats->connect_failures = s.connect_failures.load(std::memory_order_relaxed);
+    stats->link_losses = s.link_losses.load(std::memory_order_relaxed);
+    stats->reads = s.reads.load(std::memory_order_relaxed);
+    stats->writes = s.writes.load(std::memory_order_relaxed);
+    stats->att_failures = s.att_failures.load(std::memory_order_relaxed);
+    stats->notifications = s.notifications.load(std::memory_order_relaxed);
+}
+
+// =============================================================================
+// Adapter and scanning
+// =============================================================================
+
+int gattlib_adapter_open(const char* adapter_name, gattlib_adapter_t** adapter) {
+    (void)adapter_name;
+    Sim& s = sim();
+    if (!adapter) return GATTLIB_INVALID_PARAMETER;
+
+    bool configured;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        configured = s.configured || s.open_count;
+    }
+    if (!configured) {
+        const char* path = getenv(GATTLIB_SIM_CONFIG_ENV);
+        if (!path || gattlib_sim_load_config(path) != GATTLIB_SUCCESS) {
+            if (path) fprintf(stderr, "gattlib-sim: using defaults, cannot load %s\n", path);
+            gattlib_sim_config_t config;
+            gattlib_sim_config_default(&config);
+            gattlib_sim_configure(&config);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.open_count++ == 0) {
+        if (s.services.empty()) default_table(s);
+        assign_handles(s);
+        build_devices(s);
+        s.running = true;
+        s.thread = std::thread(run, std::ref(s));
+    }
+    *adapter = &g_adapter;
+    return GATTLIB_SUCCESS;
+}
+
+const char* gattlib_adapter_get_name(gattlib_adapter_t* adapter) {
+    return adapter ? adapter->name : nullptr;
+}
+
+int gattlib_adapter_close(gattlib_adapter_t* adapter) {
+    Sim& s = sim();
+    if (!adapter) return GATTLIB_INVALID_PARAMETER;
+    gattlib_adapter_scan_disable(adapter);
+
+    std::unique_lock<std::mutex> lock(s.mutex);
+    if (s.open_count == 0 || --s.open_count > 0) return GATTLIB_SUCCESS;
+    s.running = false;
+    s.wake.notify_all();
+    lock.unlock();
+    s.thread.join();
+    lock.lock();
+
+    s.events = decltype(s.events)();
+    for (auto& d : s.devices) {
+        d->connected = d->connecting = false;
+        d->generation++;
+    }
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_adapter_scan_enable(gattlib_adapter_t* adapter, gattlib_discovered_device_t discovered_device_cb,
+                                size_t timeout, void* user_data) {
+    Sim& s = sim();
+    if (!adapter || !discovered_device_cb) return GATTLIB_INVALID_PARAMETER;
+
+    std::unique_lock<std::mutex> lock(s.mutex);
+    if (s.scanning) return GATTLIB_BUSY;
+    s.scanning = true;
+    s.scan_generation++;
+    s.scan_cb = discovered_device_cb;
+    s.scan_data = user_data;
+
+    if (s.config.adv_interval_ms > 0) {
+        uint64_t now = now_ns();
+        uint64_t interval = s.config.adv_interval_ms * 1000000ULL;
+        for (auto& d : s.devices) {
+            s.events.push(Event{now + d->rng.below(interval), s.next_order++, s.scan_generation,
+                                d->index, EventType::Advert, 0});
+        }
+    }
+    s.wake.notify_one();
+
+    // Blocks for the scan like gattlib does; 0 scans until scan_disable()
+    auto stopped = [&s] { return !s.scanning; };
+    if (timeout) {
+        s.scan_done.wait_for(lock, std::chrono::seconds(timeout), stopped);
+    } else {
+        s.scan_done.wait(lock, stopped);
+    }
+    s.scanning = false;
+    s.scan_done.wait(lock, [&s] { return s.scan_callbacks == 0; });
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_adapter_scan_disable(gattlib_adapter_t* adapter) {
+    Sim& s = sim();
+    if (!adapter) return GATTLIB_INVALID_PARAMETER;
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.scanning = false;
+    s.scan_done.notify_all();
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_get_rssi_from_mac(gattlib_adapter_t* adapter, const char* mac_address, int16_t* rssi) {
+    ble_addr_t addr;
+    if (!adapter || !rssi || !ble_addr_parse(mac_address, &addr)) return GATTLIB_INVALID_PARAMETER;
+    uint64_t index = ble_addr_bits(addr) - kAddressBase;
+    if (ble_addr_bits(addr) < kAddressBase || index >= sim().devices.size()) return GATTLIB_NOT_FOUND;
+    *rssi = (int16_t)(-40 - (int)(index % 50));
+    return GATTLIB_SUCCESS;
+}
+
+// =============================================================================
+// Connections
+// =============================================================================
+
+int gattlib_connect(gattlib_adapter_t* adapter, const char* dst, unsigned long options,
+                    gatt_connect_cb_t connect_cb, void* user_data) {
+    (void)options;
+    Sim& s = sim();
+    ble_addr_t addr;
+    if (!adapter || !dst || !connect_cb || !ble_addr_parse(dst, &addr)) {
+        return GATTLIB_INVALID_PARAMETER;
+    }
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    uint64_t index = ble_addr_bits(addr) - kAddressBase;
+    if (ble_addr_bits(addr) < kAddressBase || index >= s.devices.size()) return GATTLIB_NOT_FOUND;
+    Device& d = *s.devices[index];
+    if (d.connecting || d.connected) return GATTLIB_BUSY;
+
+    d.connecting = true;
+    d.connect_cb = connect_cb;
+    d.connect_data = user_data;
+    uint64_t latency_ns = (s.config.connect_latency_ms +
+                           d.rng.below(s.config.connect_jitter_ms + 1)) * 1000000ULL;
+    push(s, now_ns() + latency_ns, EventType::Connect, d);
+    s.wake.notify_one();
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_disconnect(gattlib_connection_t* connection, bool wait_disconnection) {
+    (void)wait_disconnection;
+    Sim& s = sim();
+    if (!connection) return GATTLIB_INVALID_PARAMETER;
+
+    // Local disconnects do not call the disconnect handler; link loss does
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!connection->connected) return GATTLIB_SUCCESS;
+    connection->connected = false;
+    connection->generation++;
+    connection->on_disconnect = nullptr;
+    connection->on_notify = nullptr;
+    std::fill(connection->subscribed.begin(), connection->subscribed.end(), 0);
+    connection->echo.clear();
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_register_on_disconnect(gattlib_connection_t* connection,
+                                   gattlib_disconnection_handler_t handler, void* user_data) {
+    Sim& s = sim();
+    if (!connection) return GATTLIB_INVALID_PARAMETER;
+    std::lock_guard<std::mutex> lock(s.mutex);
+    connection->on_disconnect = handler;
+    connection->disconnect_data = user_data;
+    return GATTLIB_SUCCESS;
+}
+
+// =============================================================================
+// Discovery
+// =============================================================================
+
+int gattlib_discover_primary(gattlib_connection_t* connection, gattlib_primary_service_t** services,
+                             int* services_count) {
+    Sim& s = sim();
+    if (!connection || !services || !services_count) return GATTLIB_INVALID_PARAMETER;
+
+    std::unique_lock<std::mutex> lock;
+    int ret = begin_request(s, connection, lock, (unsigned)s.services.size() + 1);
+    if (ret != GATTLIB_SUCCESS) return ret;
+
+    size_t n = s.services.size();
+    *services = (gattlib_primary_service_t*)calloc(n ? n : 1, sizeof(gattlib_primary_service_t));
+    if (!*services) return GATTLIB_OUT_OF_MEMORY;
+    for (size_t i = 0; i < n; i++) {
+        (*services)[i].attr_handle_start = s.services[i].start_handle;
+        (*services)[i].attr_handle_end = s.services[i].end_handle;
+        (*services)[i].uuid = ble::to_gattlib(s.services[i].uuid);
+    }
+    *services_count = (int)n;
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_discover_char(gattlib_connection_t* connection, gattlib_characteristic_t** characteristics,
+                          int* characteristics_count) {
+    Sim& s = sim();
+    if (!connection || !characteristics || !characteristics_count) return GATTLIB_INVALID_PARAMETER;
+
+    std::unique_lock<std::mutex> lock;
+    int ret = begin_request(s, connection, lock, (unsigned)s.characteristics.size() + 1);
+    if (ret != GATTLIB_SUCCESS) return ret;
+
+    size_t n = s.characteristics.size();
+    *characteristics = (gattlib_characteristic_t*)calloc(n ? n : 1, sizeof(gattlib_characteristic_t));
+    if (!*characteristics) return GATTLIB_OUT_OF_MEMORY;
+    for (size_t i = 0; i < n; i++) {
+        const SimCharacteristic& c = s.characteristics[i];
+        (*characteristics)[i].handle = c.handle;
+        (*characteristics)[i].properties = c.properties;
+        (*characteristics)[i].value_handle = c.value_handle;
+        (*characteristics)[i].uuid = c.gattlib_uuid;
+    }
+    *characteristics_count = (int)n;
+    return GATTLIB_SUCCESS;
+}
+
+// =============================================================================
+// Reads and writes
+// =============================================================================
+
+int gattlib_read_char_by_uuid(gattlib_connection_t* connection, uuid_t* uuid, void** buffer,
+                              size_t* buffer_len) {
+    Sim& s = sim();
+    if (!connection || !uuid || !buffer || !buffer_len) return GATTLIB_INVALID_PARAMETER;
+    ssize_t c = find_characteristic(s, uuid);
+    if (c < 0) return GATTLIB_NOT_FOUND;
+    if (!(s.characteristics[c].properties & GATTLIB_CHARACTERISTIC_READ)) return GATTLIB_NOT_SUPPORTED;
+
+    std::unique_lock<std::mutex> lock;
+    int ret = begin_request(s, connection, lock);
+    if (ret != GATTLIB_SUCCESS) return ret;
+
+    const ble_uuid_t& u = s.characteristics[c].uuid;
+    const uint8_t* data = connection->values[c].data();
+    size_t len = connection->values[c].size();
+    if (ble_uuid_equal(&u, &kDeviceName)) {
+        data = (const uint8_t*)connection->name;
+        len = strlen(connection->name);
+    } else if (ble_uuid_equal(&u, &kDatabaseHash)) {
+        data = s.hash.data();
+        len = s.hash.size();
+    }
+
+    *buffer = malloc(len ? len : 1);
+    if (!*buffer) return GATTLIB_OUT_OF_MEMORY;
+    memcpy(*buffer, data, len);
+    *buffer_len = len;
+    s.reads.fetch_add(1, std::memory_order_relaxed);
+    return GATTLIB_SUCCESS;
+}
+
+void gattlib_characteristic_free_value(void* ptr) {
+    free(ptr);
+}
+
+int gattlib_write_char_by_uuid(gattlib_connection_t* connection, uuid_t* uuid, const void* buffer,
+                               size_t buffer_len) {
+    if (!uuid) return GATTLIB_INVALID_PARAMETER;
+    return write_value(connection, find_characteristic(sim(), uuid), buffer, buffer_len, true);
+}
+
+int gattlib_write_char_by_handle(gattlib_connection_t* connection, uint16_t handle, const void* buffer,
+                                 size_t buffer_len) {
+    return write_value(connection, find_characteristic(sim(), handle), buffer, buffer_len, true);
+}
+
+int gattlib_write_without_response_char_by_uuid(gattlib_connection_t* connection, uuid_t* uuid,
+                                                const void* buffer, size_t buffer_len) {
+    if (!uuid) return GATTLIB_INVALID_PARAMETER;
+    return write_value(connection, find_characteristic(sim(), uuid), buffer, buffer_len, false);
+}
+
+int gattlib_write_without_response_char_by_handle(gattlib_connection_t* connection, uint16_t handle,
+                                                  const void* buffer, size_t buffer_len) {
+    return write_value(connection, find_characteristic(sim(), handle), buffer, buffer_len, false);
+}
+
+// =============================================================================
+// Notifications
+// =============================================================================
+
+int gattlib_notification_start(gattlib_connection_t* connection, const uuid_t* uuid) {
+    Sim& s = sim();
+    if (!connection || !uuid) return GATTLIB_INVALID_PARAMETER;
+    ssize_t c = find_characteristic(s, uuid);
+    if (c < 0) return GATTLIB_NOT_FOUND;
+    const SimCharacteristic& chr = s.characteristics[c];
+    if (!(chr.properties & (GATTLIB_CHARACTERISTIC_NOTIFY | GATTLIB_CHARACTERISTIC_INDICATE))) {
+        return GATTLIB_NOT_SUPPORTED;
+    }
+
+    std::unique_lock<std::mutex> lock;
+    int ret = begin_request(s, connection, lock);    // CCCD write
+    if (ret != GATTLIB_SUCCESS) return ret;
+    if (connection->subscribed[c]) return GATTLIB_SUCCESS;
+
+    connection->subscribed[c] = 1;
+    if (chr.periodic && s.config.notify_interval_ms) {
+        uint64_t interval = s.config.notify_interval_ms * 1000000ULL;
+        push(s, now_ns() + connection->rng.below(interval), EventType::Notify, *connection,
+             (uint16_t)c);
+        s.wake.notify_one();
+    }
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_notification_stop(gattlib_connection_t* connection, const uuid_t* uuid) {
+    Sim& s = sim();
+    if (!connection || !uuid) return GATTLIB_INVALID_PARAMETER;
+    ssize_t c = find_characteristic(s, uuid);
+    if (c < 0) return GATTLIB_NOT_FOUND;
+    std::lock_guard<std::mutex> lock(s.mutex);
+    connection->subscribed[c] = 0;
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_register_notification(gattlib_connection_t* connection,
+                                  gattlib_event_handler_t notification_handler, void* user_data) {
+    Sim& s = sim();
+    if (!connection) return GATTLIB_INVALID_PARAMETER;
+    std::lock_guard<std::mutex> lock(s.mutex);
+    connection->on_notify = notification_handler;
+    connection->notify_data = user_data;
+    return GATTLIB_SUCCESS;
+}
+
+// =============================================================================
+// Link, main loop and UUID helpers
+// =============================================================================
+
+int gattlib_get_rssi(gattlib_connection_t* connection, int16_t* rssi) {
+    if (!connection || !rssi) return GATTLIB_INVALID_PARAMETER;
+    *rssi = (int16_t)(-40 - (int)(connection->index % 50));
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_get_mtu(gattlib_connection_t* connection, uint16_t* mtu) {
+    Sim& s = sim();
+    if (!connection || !mtu) return GATTLIB_INVALID_PARAMETER;
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!connection->connected) return GATTLIB_DEVICE_NOT_CONNECTED;
+    *mtu = s.config.mtu;
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_mainloop(void* (*task)(void* arg), void* arg) {
+    if (!task) return GATTLIB_INVALID_PARAMETER;
+    task(arg);
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_string_to_uuid(const char* str, size_t size, uuid_t* uuid) {
+    if (!str || !uuid) return GATTLIB_INVALID_PARAMETER;
+    std::string text(str, strnlen(str, size));
+    if (text.compare(0, 2, "0x") == 0) text.erase(0, 2);
+    ble_uuid_t u;
+    if (!ble_uuid_parse(text.c_str(), &u)) return GATTLIB_INVALID_PARAMETER;
+    *uuid = ble::to_gattlib(u);
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_uuid_to_string(const uuid_t* uuid, char* str, size_t size) {
+    if (!uuid || !str) return GATTLIB_INVALID_PARAMETER;
+    if (uuid->type == SDP_UUID16) {
+        snprintf(str, size, "0x%04x", uuid->value.uuid16);
+    } else if (uuid->type == SDP_UUID32) {
+        snprintf(str, size, "0x%08x", uuid->value.uuid32);
+    } else {
+        char text[BLE_UUID_SIZE];
+        ble_uuid_t u = ble::from_gattlib(*uuid);
+        ble_uuid_format(&u, text);
+        snprintf(str, size, "%s", text);
+    }
+    return GATTLIB_SUCCESS;
+}
+
+int gattlib_uuid_cmp(const uuid_t* uuid1, const uuid_t* uuid2) {
+    ble_uuid_t a = ble::from_gattlib(*uuid1);
+    ble_uuid_t b = ble::from_gattlib(*uuid2);
+    return ble_uuid_equal(&a, &b) ? GATTLIB_SUCCESS : GATTLIB_NOT_FOUND;
+}
+
+}  // extern "C"
@@ -0,0 +1,595 @@
+/**
+ * @file mock_bluez.cpp
+ * @brief Stand-in for bluetoothd on a private D-Bus bus
+ *
+ * Owns org.bluez and exports one adapter object, or --adapters N of them,
+ * each with:
+ * - org.bluez.GattManager1: RegisterApplication fetches the application's
+ *   GetManagedObjects reply and validates it the way BlueZ does
+ * - org.bluez.LEAdvertisingManager1: RegisterAdvertisement reads the
+ *   advertisement's properties and enforces the instance limit
+ * - org.bluez.Mock1: lists registered applications so test drivers such as
+ *   ble_bench can call into them the way bluetoothd would, and connects or
+ *   disconnects simulated centrals
+ *
+ * "/" implements ObjectManager for the adapters and connected devices, as
+ * bluetoothd does. Registrations are dropped when their owner leaves the
+ * bus. No controller
+ * or root access is needed, so the peripherals can be exercised on build
+ * machines.
+ *
+ * Run:
+ *   dbus-daemon --session --nofork --address=unix:path=/tmp/ble.bus &
+ *   ./mock_bluez --bus unix:path=/tmp/ble.bus &
+ *   ./simple_peripheral --bus unix:path=/tmp/ble.bus
+ *   ./mock_bluez --bus unix:path=/tmp/ble.bus --adapters 4
+ */
+
+#include <gio/gio.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "ble_dbus.h"
+
+#define BLUEZ_NAME              "org.bluez"
+#define MAX_ADVERTISEMENTS      5
+#define REGISTER_TIMEOUT_MS     5000
+
+struct Registration {
+    std::string owner;          ///< Unique bus name of the registering process
+    std::string path;
+    unsigned services;
+    unsigned characteristics;
+};
+
+struct Adapter {
+    std::string path;
+    std::string name;
+    std::string address;
+    std::vector<Registration> applications;
+    std::vector<Registration> advertisements;
+    std::set<std::string> connected;    ///< Device paths of simulated centrals
+};
+
+static GMainLoop *main_loop = NULL;
+static GDBusConnection *connection = NULL;
+static std::vector<std::unique_ptr<Adapter>> adapters;
+
+static void signal_handler(int sig) {
+    (void)sig;
+    if (main_loop) g_main_loop_quit(main_loop);
+}
+
+static std::vector<Registration>::iterator find_registration(std::vector<Registration> &list,
+                                                              const char *owner, const char *path) {
+    for (auto it = list.begin(); it != list.end(); ++it) {
+        if (it->owner == owner && it->path == path) return it;
+    }
+    return list.end();
+}
+
+// Outstanding Register* call waiting for the registrant's reply
+struct PendingRegistration {
+    Adapter *adapter;
+    GDBusMethodInvocation *invocation;
+    std::string owner;
+    std::string path;
+};
+
+// =============================================================================
+// GattManager1
+// =============================================================================
+
+// Counts services and characteristics below the application path; fails
+// like BlueZ on objects without a UUID or characteristics without a service.
+static bool parse_application(GVariant *objects, const std::string &app_path,
+                              Registration *app, const char **reason) {
+    GVariantIter iter;
+    const gchar *path;
+    GVariant *interfaces;
+    std::vector<std::string> services;
+    std::vector<std::string> char_services;
+
+    g_variant_iter_init(&iter, objects);
+    while (g_variant_iter_next(&iter, "{&o@a{sa{sv}}}", &path, &interfaces)) {
+        if (!g_str_has_prefix(path, app_path.c_str())) {
+            g_variant_unref(interfaces);
+            continue;
+        }
+        GVariant *props;
+        if ((props = g_variant_lookup_value(interfaces, "org.bluez.GattService1",
+                                            G_VARIANT_TYPE("a{sv}")))) {
+            if (!g_variant_lookup(props, "UUID", "&s", NULL)) *reason = "Service without UUID";
+            services.push_back(path);
+            g_variant_unref(props);
+        }
+        if ((props = g_variant_lookup_value(interfaces, "org.bluez.GattCharacteristic1",
+                                            G_VARIANT_TYPE("a{sv}")))) {
+            const gchar *service;
+            if (!g_variant_lookup(props, "UUID", "&s", NULL)) *reason = "Characteristic without UUID";
+            if (!g_variant_lookup(props, "Service", "&o", &service)) {
+                *reason = "Characteristic without Service";
+            } else {
+                char_services.push_back(service);
+            }
+            g_variant_unref(props);
+        }
+        g_variant_unref(interfaces);
+    }
+
+    for (const std::string &service : char_services) {
+        bool known = false;
+        for (const std::string &s : services) known = known || s == service;
+        if (!known) *reason = "Characteristic refers to an unknown service";
+    }
+    if (services.empty() && !*reason) *reason = "No object received";
+
+    app->services = services.size();
+    app->characteristics = char_services.size();
+    return *reason == NULL;
+}
+
+static void on_managed_objects_reply(GObject *source, GAsyncResult *res, gpointer user_data) {
+    PendingRegistration *pending = (PendingRegistration *)user_data;
+    GError *error = NULL;
+    GVariant *result = g_dbus_connection_call_finish(connection, res, &error);
+
+    if (!result) {
+        printf("GattManager1: %s %s: %s\n", pending->owner.c_str(), pending->path.c_str(),
+               error->message);
+        g_dbus_method_invocation_return_dbus_error(pending->invocation,
+            "org.bluez.Error.Failed", "Failed to read application objects");
+        g_error_free(error);
+        delete pending;
+        return;
+    }
+
+    Registration app = {pending->owner, pending->path, 0, 0};
+    const char *reason = NULL;
+    GVariant *objects = g_variant_get_child_value(result, 0);
+    if (parse_application(objects, pending->path, &app, &reason)) {
+        pending->adapter->applications.push_back(app);
+        printf("GattManager1: registered %s %s on %s (%u services, %u characteristics)\n",
+               app.owner.c_str(), app.path.c_str(), pending->adapter->name.c_str(),
+               app.services, app.characteristics);
+        g_dbus_method_invocation_return_value(pending->invocation, NULL);
+    } else {
+        printf("GattManager1: rejected %s %s: %s\n", app.owner.c_str(), app.path.c_str(), reason);
+        g_dbus_method_invocation_return_dbus_error(pending->invocation,
+            "org.bluez.Error.InvalidArguments", reason);
+    }
+
+    g_variant_unref(objects);
+    g_variant_unref(result);
+    delete pending;
+}
+
+static void register_application(Adapter *adapter, const gchar *sender, GVariant *parameters,
+                                 GDBusMethodInvocation *invocation) {
+    const gchar *path;
+    g_variant_get(parameters, "(&o@a{sv})", &path, NULL);
+
+    if (find_registration(adapter->applications, sender, path) != adapter->applications.end()) {
+        g_dbus_method_invocation_return_dbus_error(invocation,
+            "org.bluez.Error.AlreadyExists", "Already Exists");
+        return;
+    }
+
+    PendingRegistration *pending = new PendingRegistration{adapter, invocation, sender, path};
+    g_dbus_connection_call(connection, sender, path, "org.freedesktop.DBus.ObjectManager",
+        "GetManagedObjects", NULL, G_VARIANT_TYPE("(a{oa{sa{sv}}})"),
+        G_DBUS_CALL_FLAGS_NONE, REGISTER_TIMEOUT_MS, NULL, on_managed_objects_reply, pending);
+}
+
+// =============================================================================
+// LEAdvertisingManager1
+// =============================================================================
+
+static void on_advertisement_reply(GObject *source, GAsyncResult *res, gpointer user_data) {
+    PendingRegistration *pending = (PendingRegistration *)user_data;
+    GError *error = NULL;
+    GVariant *result = g_dbus_connection_call_finish(connection, res, &error);
+
+    if (!result) {
+        printf("LEAdvertisingManager1: %s %s: %s\n", pending->owner.c_str(),
+               pending->path.c_str(), error->message);
+        g_dbus_method_invocation_return_dbus_error(pending->invocation,
+            "org.bluez.Error.Failed", "Failed to parse advertisement");
+        g_error_free(error);
+        delete pending;
+        return;
+    }
+
+    GVariant *props = g_variant_get_child_value(result, 0);
+    const gchar *type = NULL;
+    g_variant_lookup(props, "Type", "&s", &type);
+    if (!type || (strcmp(type, "peripheral") != 0 && strcmp(type, "broadcast") != 0)) {
+        printf("LEAdvertisingManager1: rejected %s %s: bad Type\n", pending->owner.c_str(),
+               pending->path.c_str());
+        g_dbus_method_invocation_return_dbus_error(pending->invocation,
+            "org.bluez.Error.InvalidArguments", "Invalid Type");
+    } else {
+        pending->adapter->advertisements.push_back(Registration{pending->owner, pending->path, 0, 0});
+        printf("LEAdvertisingManager1: registered %s %s on %s (%s)\n", pending->owner.c_str(),
+               pending->path.c_str(), pending->adapter->name.c_str(), type);
+        g_dbus_method_invocation_return_value(pending->invocation, NULL);
+    }
+
+    g_variant_unref(props);
+    g_variant_unref(result);
+    delete pending;
+}
+
+static void register_advertisement(Adapter *adapter, const gchar *sender, GVariant *parameters,
+                                   GDBusMethodInvocation *invocation) {
+    const gchar *path;
+    g_variant_get(parameters, "(&o@a{sv})", &path, NULL);
+
+    if (find_registration(adapter->advertisements, sender, path) != adapter->advertisements.end()) {
+        g_dbus_method_invocation_return_dbus_error(invocation,
+            "org.bluez.Error.AlreadyExists", "Already Exists");
+        return;
+    }
+    if (adapter->advertisements.size() >= MAX_ADVERTISEMENTS) {
+        g_dbus_method_invocation_return_dbus_error(invocation,
+            "org.bluez.Error.NotPermitted", "Maximum advertisements reached");
+        return;
+    }
+
+    PendingRegistration *pending = new PendingRegistration{adapter, invocation, sender, path};
+    g_dbus_connection_call(connection, sender, path, "org.freedesktop.DBus.Properties",
+        "GetAll", g_variant_new("(s)", "org.bluez.LEAdvertisement1"),
+        G_VARIANT_TYPE("(a{sv})"), G_DBUS_CALL_FLAGS_NONE, REGISTER_TIMEOUT_MS, NULL,
+        on_advertisement_reply, pending);
+}
+
+// =============================================================================
+// Adapter Object
+// =============================================================================
+
+static bool unregister(std::vector<Registration> &list, const gchar *sender,
+                       GVariant *parameters, GDBusMethodInvocation *invocation) {
+    const gchar *path;
+    g_variant_get(parameters, "(&o)", &path);
+
+    auto it = find_registration(list, sender, path);
+    if (it == list.end()) {
+        g_dbus_method_invocation_return_dbus_error(invocation,
+            "org.bluez.Error.DoesNotExist", "Does Not Exist");
+        return false;
+    }
+    list.erase(it);
+    g_dbus_method_invocation_return_value(invocation, NULL);
+    return true;
+}
+
+// Simulated central: Device1 object under the adapter, announced like bluetoothd
+static void set_connected(Adapter *adapter, GVariant *parameters,
+                          GDBusMethodInvocation *invocation) {
+    const gchar *address;
+    gboolean connected;
+    g_variant_get(parameters, "(&sb)", &address, &connected);
+
+    std::string path = adapter->path + "/dev_" + address;
+    for (char &c : path) if (c == ':') c = '_';
+    if (!g_variant_is_object_path(path.c_str())) {
+        g_dbus_method_invocation_return_dbus_error(invocation,
+            "org.bluez.Error.InvalidArguments", "Invalid address");
+        return;
+    }
+    
+    bool changed = connected ? adapter->connected.insert(path).second
+                             : adapter->connected.erase(path) > 0;
+    if (changed) {
+        GVariantBuilder props;
+        g_variant_builder_init(&props, G_VARIANT_TYPE("a{sv}"));
+        g_variant_builder_add(&props, "{sv}", "Connected", g_variant_new_boolean(connected));
+        g_dbus_connection_emit_signal(connection, NULL, path.c_str(),
+            "org.freedesktop.DBus.Properties", "PropertiesChanged",
+            g_variant_new("(sa{sv}as)", "org.bluez.Device1", &props, NULL), NULL);
+        printf("Mock1: %s %s %s (%zu links)\n", address, connected ? "connected to" : "disconnected from",
+               adapter->name.c_str(), adapter->connected.size());
+    }
+    g_dbus_method_invocation_return_value(invocation, NULL);
+}
+
+static void handle_adapter_method_call(
+    GDBusConnection *conn,
+    const gchar *sender,
+    const gchar *object_path,
+    const gchar *interface_name,
+    const gchar *method_name,
+    GVariant *parameters,
+    GDBusMethodInvocation *invocation,
+    gpointer user_data)
+{
+    Adapter *adapter = (Adapter *)user_data;
+    
+    if (g_strcmp0(method_name, "RegisterApplication") == 0) {
+        register_application(adapter, sender, parameters, invocation);
+    }
+    else if (g_strcmp0(method_name, "UnregisterApplication") == 0) {
+        if (unregister(adapter->applications, sender, parameters, invocation)) {
+            printf("GattManager1: unregistered %s on %s\n", sender, adapter->name.c_str());
+        }
+    }
+    else if (g_strcmp0(method_name, "RegisterAdvertisement") == 0) {
+        register_advertisement(adapter, sender, parameters, invocation);
+    }
+    else if (g_strcmp0(method_name, "UnregisterAdvertisement") == 0) {
+        if (unregister(adapter->advertisements, sender, parameters, invocation)) {
+            printf("LEAdvertisingManager1: unregistered %s on %s\n", sender, adapter->name.c_str());
+        }
+    }
+    else if (g_strcmp0(method_name, "GetApplications") == 0) {
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE("a(so)"));
+        for (const Registration &app : adapter->applications) {
+            g_variant_builder_add(&builder, "(so)", app.owner.c_str(), app.path.c_str());
+        }
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(a(so))", &builder));
+    }
+    else if (g_strcmp0(method_name, "SetConnected") == 0) {
+        set_connected(adapter, parameters, invocation);
+    }
+    else {
+        g_dbus_method_invocation_return_error(invocation,
+            G_DBUS_ERROR, G_DBUS_ERROR_NOT_SUPPORTED,
+            "Method %s not supported", method_name);
+    }
+}
+
+static GVariant* handle_adapter_get_property(
+    GDBusConnection *conn,
+    const gchar *sender,
+    const gchar *object_path,
+    const gchar *interface_name,
+    const gchar *property_name,
+    GError **error,
+    gpointer user_data)
+{
+    Adapter *adapter = (Adapter *)user_data;
+    
+    if (g_strcmp0(property_name, "Address") == 0) {
+        return g_variant_new_string(adapter->address.c_str());
+    }
+    else if (g_strcmp0(property_name, "Powered") == 0) {
+        return g_variant_new_boolean(TRUE);
+    }
+    else if (g_strcmp0(property_name, "ActiveInstances") == 0) {
+        return g_variant_new_byte((guchar)adapter->advertisements.size());
+    }
+    else if (g_strcmp0(property_name, "SupportedInstances") == 0) {
+        return g_variant_new_byte((guchar)(MAX_ADVERTISEMENTS - adapter->advertisements.size()));
+    }
+    return NULL;
+}
+
+static const GDBusInterfaceVTable adapter_vtable = {
+    handle_adapter_method_call,
+    handle_adapter_get_property,
+    NULL
+};
+
+static const gchar adapter_introspection_xml[] =
+    "<node>"
+    "  <interface name='org.bluez.GattManager1'>"
+    "    <method name='RegisterApplication'>"
+    "      <arg name='application' type='o' direction='in'/>"
+    "      <arg name='options' type='a{sv}' direction='in'/>"
+    "    </method>"
+    "    <method name='UnregisterApplication'>"
+    "      <arg name='application' type='o' direction='in'/>"
+    "    </method>"
+    "  </interface>"
+    "  <interface name='org.bluez.LEAdvertisingManager1'>"
+    "    <method name='RegisterAdvertisement'>"
+    "      <arg name='advertisement' type='o' direction='in'/>"
+    "      <arg name='options' type='a{sv}' direction='in'/>"
+    "    </method>"
+    "    <method name='UnregisterAdvertisement'>"
+    "      <arg name='advertisement' type='o' direction='in'/>"
+    "    </method>"
+    "    <property name='ActiveInstances' type='y' access='read'/>"
+    "    <property name='SupportedInstances' type='y' access='read'/>"
+    "  </interface>"
+    "  <interface name='org.bluez.Adapter1'>"
+    "    <property name='Address' type='s' access='read'/>"
+    "    <property name='Powered' type='b' access='read'/>"
+    "  </interface>"
+    "  <interface name='org.bluez.Mock1'>"
+    "    <method name='GetApplications'>"
+    "      <arg name='applications' type='a(so)' direction='out'/>"
+    "    </method>"
+    "    <method name='SetConnected'>"
+    "      <arg name='address' type='s' direction='in'/>"
+    "      <arg name='connected' type='b' direction='in'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+// =============================================================================
+// Object Manager
+// =============================================================================
+
+static void add_adapter_object(GVariantBuilder *objects, const Adapter &adapter) {
+    GVariantBuilder interfaces, props;
+    g_variant_builder_init(&interfaces, G_VARIANT_TYPE("a{sa{sv}}"));
+    g_variant_builder_init(&props, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&props, "{sv}", "Address", g_variant_new_string(adapter.address.c_str()));
+    g_variant_builder_add(&props, "{sv}", "Powered", g_variant_new_boolean(TRUE));
+    g_variant_builder_add(&interfaces, "{sa{sv}}", "org.bluez.Adapter1", &props);
+    g_variant_builder_add(&interfaces, "{sa{sv}}", "org.bluez.GattManager1", NULL);
+    g_variant_builder_add(&interfaces, "{sa{sv}}", "org.bluez.LEAdvertisingManager1", NULL);
+    g_variant_builder_add(objects, "{oa{sa{sv}}}", adapter.path.c_str(), &interfaces);
+
+    for (const std::string &device : adapter.connected) {
+        g_variant_builder_init(&interfaces, G_VARIANT_TYPE("a{sa{sv}}"));
+        g_variant_builder_init(&props, G_VARIANT_TYPE("a{sv}"));
+        g_variant_builder_add(&props, "{sv}", "Adapter", g_variant_new_object_path(adapter.path.c_str()));
+        g_variant_builder_add(&props, "{sv}", "Connected", g_variant_new_boolean(TRUE));
+        g_variant_builder_add(&interfaces, "{sa{sv}}", "org.bluez.Device1", &props);
+        g_variant_builder_add(objects, "{oa{sa{sv}}}", device.c_str(), &interfaces);
+    }
+}
+
+static void handle_root_method_call(GDBusConnection *conn, const gchar *sender,
+    const gchar *object_path, const gchar *interface_name, const gchar *method_name,
+    GVariant *parameters, GDBusMethodInvocation *invocation, gpointer user_data) {
+    // GetManagedObjects is the only method
+    GVariantBuilder objects;
+    g_variant_builder_init(&objects, G_VARIANT_TYPE("a{oa{sa{sv}}}"));
+    for (const auto &adapter : adapters) add_adapter_object(&objects, *adapter);
+    g_dbus_method_invocation_return_value(invocation,
+        g_variant_new("(a{oa{sa{sv}}})", &objects));
+}
+
+static const GDBusInterfaceVTable root_vtable = {
+    handle_root_method_call,
+    NULL,
+    NULL
+};
+
+static const gchar root_introspection_xml[] =
+    "<node>"
+    "  <interface name='org.freedesktop.DBus.ObjectManager'>"
+    "    <method name='GetManagedObjects'>"
+    "      <arg name='objects' type='a{oa{sa{sv}}}' direction='out'/>"
+    "    </method>"
+    "    <signal name='InterfacesAdded'>"
+    "      <arg name='object' type='o'/>"
+    "      <arg name='interfaces' type='a{sa{sv}}'/>"
+    "    </signal>"
+    "    <signal name='InterfacesRemoved'>"
+    "      <arg name='object' type='o'/>"
+    "      <arg name='interfaces' type='as'/>"
+    "    </signal>"
+    "  </interface>"
+    "</node>";
+
+// =============================================================================
+// Bus Name Tracking
+// =============================================================================
+
+// bluetoothd drops everything a client registered once it leaves the bus
+static void on_name_owner_changed(GDBusConnection *conn, const gchar *sender_name,
+    const gchar *object_path, const gchar *interface_name, const gchar *signal_name,
+    GVariant *parameters, gpointer user_data) {
+    const gchar *name, *old_owner, *new_owner;
+    g_variant_get(parameters, "(&s&s&s)", &name, &old_owner, &new_owner);
+    if (*new_owner || !*old_owner) return;
+
+    for (const auto &adapter : adapters) {
+        for (std::vector<Registration> *list : {&adapter->applications, &adapter->advertisements}) {
+            for (auto it = list->begin(); it != list->end();) {
+                if (it->owner == old_owner) {
+                    printf("Dropping %s %s on %s (owner left the bus)\n", it->owner.c_str(),
+                           it->path.c_str(), adapter->name.c_str());
+                    it = list->erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+}
+
+static void on_name_acquired(GDBusConnection *conn, const gchar *name, gpointer user_data) {
+    std::string paths;
+    for (const auto &adapter : adapters) paths += (paths.empty() ? "" : ", ") + adapter->path;
+    printf("✅ Mock BlueZ ready: %s on %s\n", paths.c_str(), name);
+}
+
+static void on_name_lost(GDBusConnection *conn, const gchar *name, gpointer user_data) {
+    printf("❌ Could not own %s (is bluetoothd running on this bus?)\n", name);
+    g_main_loop_quit(main_loop);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char *argv[]) {
+    GError *error = NULL;
+    const char *bus_address = NULL;
+    unsigned adapter_count = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--bus") == 0) bus_address = argv[i + 1];
+        else if (strcmp(argv[i], "--adapters") == 0) adapter_count = (unsigned)atoi(argv[i + 1]);
+    }
+    if (adapter_count == 0 || adapter_count > 255) {
+        printf("Usage: %s [--bus ADDRESS] [--adapters N]\n", argv[0]);
+        return 1;
+    }
+    
+    // One adapter keeps $BLE_ADAPTER; more are hci0, hci1, ...
+    for (unsigned i = 0; i < adapter_count; i++) {
+        Adapter *adapter = new Adapter;
+        char name[16], address[18];
+        snprintf(name, sizeof(name), "hci%u", i);
+        snprintf(address, sizeof(address), "02:00:00:00:00:%02X", i);
+        adapter->path = adapter_count == 1 ? ble_dbus_adapter_path() : std::string("/org/bluez/") + name;
+        adapter->name = adapter->path.substr(adapter->path.rfind('/') + 1);
+        adapter->address = address;
+        adapters.emplace_back(adapter);
+    }
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    connection = ble_dbus_connect(bus_address, &error);
+    if (!connection) {
+        printf("❌ Failed to connect to D-Bus: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    GDBusNodeInfo *adapter_node = g_dbus_node_info_new_for_xml(adapter_introspection_xml, &error);
+    GDBusNodeInfo *root_node = g_dbus_node_info_new_for_xml(root_introspection_xml, &error);
+    if (!adapter_node || !root_node) {
+        printf("❌ Failed to parse introspection XML\n");
+        return 1;
+    }
+
+    std::vector<guint> registration_ids;
+    registration_ids.push_back(g_dbus_connection_register_object(connection, "/",
+        root_node->interfaces[0], &root_vtable, NULL, NULL, NULL));
+    for (const auto &adapter : adapters) {
+        for (GDBusInterfaceInfo **iface = adapter_node->interfaces; *iface; iface++) {
+            guint id = g_dbus_connection_register_object(connection, adapter->path.c_str(), *iface,
+                                                         &adapter_vtable, adapter.get(), NULL, &error);
+            if (!id) {
+                printf("❌ Failed to register %s: %s\n", (*iface)->name, error->message);
+                g_error_free(error);
+                return 1;
+            }
+            registration_ids.push_back(id);
+        }
+    }
+
+    guint owner_watch = g_dbus_connection_signal_subscribe(connection, "org.freedesktop.DBus",
+        "org.freedesktop.DBus", "NameOwnerChanged", "/org/freedesktop/DBus", NULL,
+        G_DBUS_SIGNAL_FLAGS_NONE, on_name_owner_changed, NULL, NULL);
+
+    main_loop = g_main_loop_new(NULL, FALSE);
+    guint name_id = g_bus_own_name_on_connection(connection, BLUEZ_NAME,
+        G_BUS_NAME_OWNER_FLAGS_DO_NOT_QUEUE, on_name_acquired, on_name_lost, NULL, NULL);
+
+    g_main_loop_run(main_loop);
+
+    g_bus_unown_name(name_id);
+    g_dbus_connection_signal_unsubscribe(connection, owner_watch);
+    for (guint id : registration_ids) g_dbus_connection_unregister_object(connection, id);
+    g_dbus_node_info_unref(adapter_node);
+    g_dbus_node_info_unref(root_node);
+    g_main_loop_unref(main_loop);
+    g_object_unref(connection);
+    return 0;
+}